@@ -0,0 +1,1470 @@
+#include "Benchmark.h"
+#include "ECS.h"
+#include "EventBus.h"
+#include "FrameArena.h"
+#include "GlbModel.h"
+#include "Components.h"
+#include "JobSystem.h"
+#include "LightCulling.h"
+#include "Logger.h"
+#include "MaterialTable.h"
+#include "MathFunctions.h"
+#include "MeshProcessing.h"
+#include "OcclusionCulling.h"
+#include "RootSignatureLayout.h"
+#include "SceneSerializer.h"
+#include "SkeletalAnimation.h"
+#include "Sprite.h"
+#include "SpriteGeometry.h"
+#include "SpritePool.h"
+#include "Task.h"
+#include "TimerWheel.h"
+#include "TriangleBVH.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace Benchmark
+{
+	namespace
+	{
+		// 計測の繰り返し回数(最速値を採用する)
+		constexpr uint32_t kRepeatCount = 10;
+		// 1フレームの経過時間
+		constexpr float kDeltaTime = 1.0f / 60.0f;
+
+		// funcをkRepeatCount回実行して最速の時間(ミリ秒)を返す
+		template <class F>
+		double MeasureBestMilliseconds(F &&func)
+		{
+			double best = 1.0e30;
+			for (uint32_t i = 0; i < kRepeatCount; ++i) {
+				auto begin = std::chrono::steady_clock::now();
+				func();
+				auto end = std::chrono::steady_clock::now();
+				// 1回を1フレームとみなして一時データを巻き戻す
+				FrameArena::ResetAll();
+				best = (std::min)(best, std::chrono::duration<double, std::milli>(end - begin).count());
+			}
+			return best;
+		}
+
+		// ジョブシステムに移って数を数えるだけのタスク
+		Task<void> CountOnJobSystem(std::atomic<uint32_t> &counter)
+		{
+			co_await TaskScheduler::GetInstance()->SwitchToJobSystem();
+			counter.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// 次のフレームまで待つだけのタスク
+		Task<void> WaitNextFrame()
+		{
+			co_await TaskScheduler::GetInstance()->NextFrame();
+		}
+
+		// 待たずに値を返すタスク
+		Task<uint32_t> ReturnValue(uint32_t value)
+		{
+			co_return value;
+		}
+
+		// 待たずに完了するタスクをcount回co_awaitする
+		Task<uint64_t> SumValues(uint32_t count)
+		{
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < count; ++i) {
+				sum += co_await ReturnValue(i);
+			}
+			co_return sum;
+		}
+
+		// 起動済みのタスクを全て待つ
+		Task<void> WhenAll(std::vector<Task<void>> &tasks)
+		{
+			for (Task<void> &task : tasks) {
+				co_await task.WhenReady();
+			}
+		}
+
+		// 比較用: 優先度付きキュー(二分ヒープ)によるタイマー。取り消しは世代を進めるだけで、取り出したときに捨てる
+		class HeapTimerQueue
+		{
+		public:
+			TimerHandle Schedule(uint32_t delayTicks, uint64_t userData)
+			{
+				uint32_t index;
+				if (!freeSlots_.empty()) {
+					index = freeSlots_.back();
+					freeSlots_.pop_back();
+				} else {
+					index = static_cast<uint32_t>(slots_.size());
+					slots_.emplace_back();
+				}
+				Slot &slot = slots_[index];
+				slot.userData = userData;
+				slot.active = true;
+				queue_.push({ currentTick_ + (delayTicks > 0 ? delayTicks - 1 : 0), index, slot.generation });
+				return { index, slot.generation };
+			}
+			bool Cancel(TimerHandle handle)
+			{
+				if (handle.index >= slots_.size() || !slots_[handle.index].active || slots_[handle.index].generation != handle.generation) {
+					return false;
+				}
+				Release(handle.index);
+				return true;
+			}
+			template <class F>
+			void Advance(uint32_t tickCount, F &&func)
+			{
+				for (uint32_t i = 0; i < tickCount; ++i) {
+					uint64_t tick = currentTick_++;
+					while (!queue_.empty() && queue_.top().expireTick <= tick) {
+						Entry entry = queue_.top();
+						queue_.pop();
+						Slot &slot = slots_[entry.index];
+						if (!slot.active || slot.generation != entry.generation) {
+							continue;
+						}
+						uint64_t userData = slot.userData;
+						Release(entry.index);
+						func(TimerHandle { entry.index, entry.generation }, userData);
+					}
+				}
+			}
+			uint64_t GetCurrentTick() const { return currentTick_; }
+
+		private:
+			struct Entry
+			{
+				uint64_t expireTick;
+				uint32_t index;
+				uint32_t generation;
+				bool operator>(const Entry &other) const { return expireTick > other.expireTick; }
+			};
+			struct Slot
+			{
+				uint64_t userData = 0;
+				uint32_t generation = 0;
+				bool active = false;
+			};
+			void Release(uint32_t index)
+			{
+				slots_[index].active = false;
+				++slots_[index].generation;
+				freeSlots_.push_back(index);
+			}
+
+			std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue_;
+			std::vector<Slot> slots_;
+			std::vector<uint32_t> freeSlots_;
+			uint64_t currentTick_ = 0;
+		};
+
+		// イベントバスの計測用のイベント
+		struct BusEvent
+		{
+			uint64_t publishNanoseconds;
+			uint32_t producer;
+			uint32_t sequence;
+		};
+
+		// 書き手と読み手の計測結果
+		struct BusResult
+		{
+			double milliseconds = 0.0;
+			double medianLatencyMicroseconds = 0.0;
+			double p99LatencyMicroseconds = 0.0;
+			uint32_t orderErrors = 0; //!< 同じ書き手のイベントの順番が入れ替わった数
+		};
+
+		uint64_t NowNanoseconds()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		/// <summary>
+		/// producerCount個のスレッドからeventsPerProducer個ずつ出し、呼び出し元スレッドで全て受け取るまでの時間と遅延を計る
+		/// </summary>
+		/// <param name="push">(書き手番号, イベント) 満杯ならfalse</param>
+		/// <param name="drain">届いているイベントを全て関数に渡す</param>
+		template <class Push, class Drain>
+		BusResult MeasureProducersConsumer(uint32_t producerCount, uint32_t eventsPerProducer, Push &&push, Drain &&drain)
+		{
+			uint32_t totalCount = producerCount * eventsPerProducer;
+			std::vector<uint32_t> latencies;
+			latencies.reserve(totalCount);
+			std::vector<uint32_t> nextSequence(producerCount, 0);
+			BusResult result;
+
+			auto begin = std::chrono::steady_clock::now();
+			std::vector<std::thread> producers;
+			for (uint32_t producer = 0; producer < producerCount; ++producer) {
+				producers.emplace_back([&, producer]() {
+					for (uint32_t sequence = 0; sequence < eventsPerProducer; ++sequence) {
+						// 満杯なら読み手が追いつくまで譲る
+						while (!push(producer, BusEvent { NowNanoseconds(), producer, sequence })) {
+							std::this_thread::yield();
+						}
+					}
+					});
+			}
+			while (latencies.size() < totalCount) {
+				size_t received = drain([&](const BusEvent &event) {
+					latencies.push_back(static_cast<uint32_t>((std::min)(NowNanoseconds() - event.publishNanoseconds, uint64_t(UINT32_MAX))));
+					if (event.sequence != nextSequence[event.producer]) {
+						++result.orderErrors;
+					}
+					nextSequence[event.producer] = event.sequence + 1;
+					});
+				if (received == 0) {
+					std::this_thread::yield();
+				}
+			}
+			result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			for (std::thread &producer : producers) {
+				producer.join();
+			}
+
+			auto percentile = [&](double ratio) {
+				auto nth = latencies.begin() + static_cast<ptrdiff_t>((latencies.size() - 1) * ratio);
+				std::nth_element(latencies.begin(), nth, latencies.end());
+				return *nth / 1000.0;
+				};
+			result.medianLatencyMicroseconds = percentile(0.5);
+			result.p99LatencyMicroseconds = percentile(0.99);
+			return result;
+		}
+
+		// 頂点データ(OBJ読み込みの結果)
+		struct VertexData
+		{
+			math::Vector4 position;
+			math::Vector2 texcoord;
+			math::Vector3 normal;
+		};
+
+		// 従来のOBJ読み込み(main.cppのLoadObjFileと同じ処理。マテリアルは読まない)
+		std::vector<VertexData> LoadObjFile(const std::string &filePath)
+		{
+			std::vector<VertexData> vertices;
+			std::vector<math::Vector4> positions;
+			std::vector<math::Vector3> normals;
+			std::vector<math::Vector2> texcoords;
+			std::string line;
+
+			std::ifstream file(filePath);
+			assert(file.is_open());
+
+			while (std::getline(file, line)) {
+				std::string identifier;
+				std::istringstream s(line);
+				s >> identifier;
+
+				if (identifier == "v") {
+					math::Vector4 position;
+					s >> position.x >> position.y >> position.z;
+					position.x *= -1.0f;
+					position.w = 1.0f;
+					positions.push_back(position);
+				} else if (identifier == "vt") {
+					math::Vector2 texcoord;
+					s >> texcoord.x >> texcoord.y;
+					texcoord.y = 1.0f - texcoord.y;
+					texcoords.push_back(texcoord);
+				} else if (identifier == "vn") {
+					math::Vector3 normal;
+					s >> normal.x >> normal.y >> normal.z;
+					normal.x *= -1.0f;
+					normals.push_back(normal);
+				} else if (identifier == "f") {
+					VertexData triangle[3];
+					for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+						std::string vertexDefinition;
+						s >> vertexDefinition;
+						std::istringstream v(vertexDefinition);
+						uint32_t elementIndices[3];
+						for (int32_t element = 0; element < 3; ++element) {
+							std::string index;
+							std::getline(v, index, '/');
+							elementIndices[element] = std::stoi(index);
+						}
+						triangle[faceVertex] = { positions[elementIndices[0] - 1], texcoords[elementIndices[1] - 1], normals[elementIndices[2] - 1] };
+					}
+					vertices.push_back(triangle[2]);
+					vertices.push_back(triangle[1]);
+					vertices.push_back(triangle[0]);
+				}
+			}
+			return vertices;
+		}
+
+		// 計測用の格子状のメッシュをOBJとGLBで書き出す
+		void WriteGridModels(uint32_t gridSize, const std::string &objPath, const std::string &glbPath)
+		{
+			uint32_t vertexCount = (gridSize + 1) * (gridSize + 1);
+			std::vector<float> positions;
+			std::vector<float> normals;
+			std::vector<float> texcoords;
+			std::vector<uint32_t> indices;
+			for (uint32_t y = 0; y <= gridSize; ++y) {
+				for (uint32_t x = 0; x <= gridSize; ++x) {
+					float u = float(x) / float(gridSize);
+					float v = float(y) / float(gridSize);
+					positions.insert(positions.end(), { u * 100.0f, std::sin(u * 20.0f) * std::cos(v * 20.0f), v * 100.0f });
+					normals.insert(normals.end(), { 0.0f, 1.0f, 0.0f });
+					texcoords.insert(texcoords.end(), { u, v });
+				}
+			}
+			for (uint32_t y = 0; y < gridSize; ++y) {
+				for (uint32_t x = 0; x < gridSize; ++x) {
+					uint32_t i = y * (gridSize + 1) + x;
+					indices.insert(indices.end(), { i, i + gridSize + 1, i + 1, i + 1, i + gridSize + 1, i + gridSize + 2 });
+				}
+			}
+
+			std::ofstream obj(objPath);
+			for (uint32_t i = 0; i < vertexCount; ++i) {
+				obj << std::format("v {} {} {}\nvt {} {}\nvn {} {} {}\n", positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2],
+					texcoords[i * 2], texcoords[i * 2 + 1], normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+			}
+			for (size_t i = 0; i < indices.size(); i += 3) {
+				uint32_t a = indices[i] + 1;
+				uint32_t b = indices[i + 1] + 1;
+				uint32_t c = indices[i + 2] + 1;
+				obj << std::format("f {}/{}/{} {}/{}/{} {}/{}/{}\n", a, a, a, b, b, b, c, c, c);
+			}
+
+			// BINチャンク: 位置、法線、UV、インデックスの順に詰める
+			size_t positionBytes = positions.size() * sizeof(float);
+			size_t normalBytes = normals.size() * sizeof(float);
+			size_t texcoordBytes = texcoords.size() * sizeof(float);
+			size_t indexBytes = indices.size() * sizeof(uint32_t);
+			std::vector<char> bin(positionBytes + normalBytes + texcoordBytes + indexBytes);
+			std::memcpy(bin.data(), positions.data(), positionBytes);
+			std::memcpy(bin.data() + positionBytes, normals.data(), normalBytes);
+			std::memcpy(bin.data() + positionBytes + normalBytes, texcoords.data(), texcoordBytes);
+			std::memcpy(bin.data() + positionBytes + normalBytes + texcoordBytes, indices.data(), indexBytes);
+
+			std::string jsonText = std::format(
+				R"({{"asset":{{"version":"2.0"}},"scene":0,"scenes":[{{"nodes":[0]}}],"nodes":[{{"mesh":0}}],)"
+				R"("meshes":[{{"name":"grid","primitives":[{{"attributes":{{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2}},"indices":3}}]}}],)"
+				R"("buffers":[{{"byteLength":{}}}],)"
+				R"("bufferViews":[{{"buffer":0,"byteOffset":0,"byteLength":{}}},{{"buffer":0,"byteOffset":{},"byteLength":{}}},)"
+				R"({{"buffer":0,"byteOffset":{},"byteLength":{}}},{{"buffer":0,"byteOffset":{},"byteLength":{}}}],)"
+				R"("accessors":[{{"bufferView":0,"componentType":5126,"count":{},"type":"VEC3"}},{{"bufferView":1,"componentType":5126,"count":{},"type":"VEC3"}},)"
+				R"({{"bufferView":2,"componentType":5126,"count":{},"type":"VEC2"}},{{"bufferView":3,"componentType":5125,"count":{},"type":"SCALAR"}}]}})",
+				bin.size(), positionBytes, positionBytes, normalBytes, positionBytes + normalBytes, texcoordBytes,
+				positionBytes + normalBytes + texcoordBytes, indexBytes, vertexCount, vertexCount, vertexCount, indices.size());
+			// チャンクは4バイト境界に揃える(JSONは空白で埋める)
+			while (jsonText.size() % 4 != 0) {
+				jsonText.push_back(' ');
+			}
+
+			std::ofstream glb(glbPath, std::ios::binary);
+			auto writeUint32 = [&glb](uint32_t value) { glb.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+			writeUint32(0x46546C67);
+			writeUint32(2);
+			writeUint32(static_cast<uint32_t>(12 + 8 + jsonText.size() + 8 + bin.size()));
+			writeUint32(static_cast<uint32_t>(jsonText.size()));
+			writeUint32(0x4E4F534A);
+			glb.write(jsonText.data(), jsonText.size());
+			writeUint32(static_cast<uint32_t>(bin.size()));
+			writeUint32(0x004E4942);
+			glb.write(bin.data(), bin.size());
+		}
+
+		// 計測用の移動コンポーネント
+		struct VelocityComponent
+		{
+			math::Vector2 velocity;
+		};
+
+		// 従来方式のゲームオブジェクト(1体ずつnewしてポインタで持つ)
+		struct GameObject
+		{
+			ecs::Transform2DComponent transform;
+			VelocityComponent velocity;
+			ecs::AnimationComponent animation;
+			ecs::ColliderComponent collider;
+		};
+
+		// 起伏のある格子(100x100の範囲に gridSize^2 * 2 三角形)
+		void MakeTerrain(uint32_t gridSize, std::vector<math::Vector3> &positions, std::vector<math::Vector2> &texcoords, std::vector<uint32_t> &indices)
+		{
+			positions.clear();
+			texcoords.clear();
+			indices.clear();
+			positions.reserve(size_t(gridSize + 1) * (gridSize + 1));
+			texcoords.reserve(size_t(gridSize + 1) * (gridSize + 1));
+			indices.reserve(size_t(gridSize) * gridSize * 6);
+			for (uint32_t y = 0; y <= gridSize; ++y) {
+				for (uint32_t x = 0; x <= gridSize; ++x) {
+					float u = float(x) / float(gridSize);
+					float v = float(y) / float(gridSize);
+					positions.push_back({ u * 100.0f, std::sin(u * 20.0f) * std::cos(v * 20.0f) * 5.0f, v * 100.0f });
+					texcoords.push_back({ u * 8.0f, v * 8.0f });
+				}
+			}
+			for (uint32_t y = 0; y < gridSize; ++y) {
+				for (uint32_t x = 0; x < gridSize; ++x) {
+					uint32_t i = y * (gridSize + 1) + x;
+					indices.insert(indices.end(), { i, i + gridSize + 1, i + 1, i + 1, i + gridSize + 1, i + gridSize + 2 });
+				}
+			}
+		}
+	}
+
+	void RunAll(std::ostream &os)
+	{
+		Logger::Log(os, "---- Benchmark begin ----");
+		for (uint32_t count : { 1000u, 10000u, 100000u }) {
+			RunECSIteration(os, count);
+		}
+		for (uint32_t count : { 1000u, 10000u }) {
+			RunSpritePoolChurn(os, count);
+		}
+		for (uint32_t count : { 1000u, 10000u }) {
+			RunFrameArena(os, count);
+		}
+		for (uint32_t count : { 1024u, 4096u, 16384u, 65536u }) {
+			RunLightBinning(os, count);
+		}
+		RunSkeletalAnimation(os, 1000);
+		for (uint32_t gridSize : { 128u, 256u }) {
+			RunModelLoading(os, gridSize);
+		}
+		RunMeshProcessing(os, 1024);
+		RunRaycast(os, 1024);
+		for (uint32_t count : { 1000u, 10000u, 100000u }) {
+			RunOcclusionCulling(os, count);
+		}
+		for (uint32_t count : { 1000u, 4096u }) {
+			RunMaterialDedup(os, count);
+		}
+		RunSceneSerialization(os, 1000000);
+		for (uint32_t count : { 10000u, 100000u }) {
+			RunTaskScheduling(os, count);
+		}
+		RunTimers(os, 1000000);
+		for (uint32_t producerCount : { 1u, 4u, 8u }) {
+			RunEventBus(os, producerCount);
+		}
+		for (uint32_t count : { 100u, 1000u }) {
+			RunSpriteSlicing(os, count);
+		}
+		Logger::Log(os, "---- Benchmark end ----");
+	}
+
+	void RunECSIteration(std::ostream &os, uint32_t entityCount)
+	{
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+
+		// 従来方式: 他の確保と混ざって散らばった状態を再現するため、間にダミーの確保を挟む
+		std::vector<std::unique_ptr<GameObject>> objects;
+		std::vector<std::unique_ptr<char[]>> noise;
+		objects.reserve(entityCount);
+		noise.reserve(entityCount);
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			auto object = std::make_unique<GameObject>();
+			object->velocity.velocity = { distribution(random), distribution(random) };
+			objects.push_back(std::move(object));
+			noise.push_back(std::make_unique<char[]>(64 + random() % 256));
+		}
+		// 生成・破棄を繰り返した後の順序を再現する
+		std::shuffle(objects.begin(), objects.end(), random);
+
+		std::vector<GameObject *> pointers;
+		pointers.reserve(entityCount);
+		for (auto &object : objects) {
+			pointers.push_back(object.get());
+		}
+
+		double pointerTime = MeasureBestMilliseconds([&]() {
+			for (GameObject *object : pointers) {
+				object->transform.position.x += object->velocity.velocity.x * kDeltaTime;
+				object->transform.position.y += object->velocity.velocity.y * kDeltaTime;
+			}
+			});
+
+		// ECS方式
+		ecs::World world;
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			world.CreateEntity(
+				ecs::Transform2DComponent {},
+				VelocityComponent { { distribution(random), distribution(random) } },
+				ecs::AnimationComponent {},
+				ecs::ColliderComponent {});
+		}
+		ecs::Query<ecs::Transform2DComponent, VelocityComponent> query(world);
+
+		double ecsTime = MeasureBestMilliseconds([&]() {
+			query.ForEach([](ecs::Entity, ecs::Transform2DComponent &transform, VelocityComponent &velocity) {
+				transform.position.x += velocity.velocity.x * kDeltaTime;
+				transform.position.y += velocity.velocity.y * kDeltaTime;
+				});
+			});
+
+		double parallelTime = MeasureBestMilliseconds([&]() {
+			query.ParallelForEach([](ecs::Entity, ecs::Transform2DComponent &transform, VelocityComponent &velocity) {
+				transform.position.x += velocity.velocity.x * kDeltaTime;
+				transform.position.y += velocity.velocity.y * kDeltaTime;
+				});
+			});
+
+		Logger::Log(os, std::format("[ECS] entities:{} pointer-vector:{:.3f}ms query:{:.3f}ms parallel-query:{:.3f}ms speedup:{:.2f}x",
+			entityCount, pointerTime, ecsTime, parallelTime, pointerTime / (std::max)(ecsTime, 1.0e-6)));
+	}
+
+	void RunSpritePoolChurn(std::ostream &os, uint32_t spriteCount)
+	{
+		// 半数の破棄と再生成を繰り返す。実際のゲームと同様に、間に他の確保も挟む
+		constexpr uint32_t kChurnCount = 8;
+		std::mt19937 random(12345);
+		std::vector<std::unique_ptr<char[]>> noise;
+		noise.reserve(size_t(spriteCount) * (kChurnCount + 1));
+		auto churn = [&](auto &&create, auto &&destroy) {
+			for (uint32_t i = 0; i < kChurnCount; ++i) {
+				for (uint32_t j = i % 2; j < spriteCount; j += 2) {
+					destroy(j);
+					create(j);
+					noise.push_back(std::make_unique<char[]>(64 + random() % 256));
+				}
+			}
+			};
+
+		// 従来方式: 1枚ずつnew/deleteする
+		std::vector<Sprite *> sprites(spriteCount, nullptr);
+		for (Sprite *&sprite : sprites) {
+			sprite = new Sprite();
+		}
+		auto begin = std::chrono::steady_clock::now();
+		churn([&](uint32_t j) { sprites[j] = new Sprite(); }, [&](uint32_t j) { delete sprites[j]; });
+		double newDeleteChurnTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		double newDeleteTraverseTime = MeasureBestMilliseconds([&]() {
+			for (Sprite *sprite : sprites) {
+				sprite->SetRotation(sprite->GetRotation() + kDeltaTime);
+			}
+			});
+		for (Sprite *sprite : sprites) {
+			delete sprite;
+		}
+		noise.clear();
+
+		// プール方式
+		SpritePool pool;
+		std::vector<SpriteHandle> handles(spriteCount);
+		for (SpriteHandle &handle : handles) {
+			handle = pool.Create();
+		}
+		begin = std::chrono::steady_clock::now();
+		churn([&](uint32_t j) { handles[j] = pool.Create(); }, [&](uint32_t j) { pool.Destroy(handles[j]); });
+		double poolChurnTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		double poolTraverseTime = MeasureBestMilliseconds([&]() {
+			pool.ForEach([](Sprite &sprite) { sprite.SetRotation(sprite.GetRotation() + kDeltaTime); });
+			});
+		pool.Clear();
+
+		Logger::Log(os, std::format("[SpritePool] sprites:{} churn new-delete:{:.3f}ms pool:{:.3f}ms / traverse new-delete:{:.3f}ms pool:{:.3f}ms",
+			spriteCount, newDeleteChurnTime, poolChurnTime, newDeleteTraverseTime, poolTraverseTime));
+	}
+
+	void RunFrameArena(std::ostream &os, uint32_t elementCount)
+	{
+		// 1フレームで作って捨てる一時配列(ソートキー、可視リストなど)を模して、積んで並べ替える
+		constexpr uint32_t kListCount = 16;
+		auto buildLists = [elementCount](auto makeVector) {
+			uint64_t sum = 0;
+			for (uint32_t list = 0; list < kListCount; ++list) {
+				auto keys = makeVector();
+				keys.reserve(elementCount);
+				for (uint32_t i = 0; i < elementCount; ++i) {
+					keys.push_back((uint64_t(i) * 2654435761u + list) & 0xFFFFFFFF);
+				}
+				std::sort(keys.begin(), keys.end());
+				sum += keys.front();
+			}
+			volatile uint64_t sink = sum;
+			(void)sink;
+			};
+
+		double heapTime = MeasureBestMilliseconds([&]() {
+			buildLists([]() { return std::vector<uint64_t>(); });
+			});
+		double arenaTime = MeasureBestMilliseconds([&]() {
+			buildLists([]() { return FrameVector<uint64_t>(); });
+			});
+
+		const FrameArena &arena = FrameArena::GetThreadArena();
+		Logger::Log(os, std::format("[FrameArena] elements:{} lists:{} heap:{:.3f}ms arena:{:.3f}ms high-water:{}KB overflow:{}",
+			elementCount, kListCount, heapTime, arenaTime, arena.GetHighWaterMark() / 1024, arena.GetOverflowCount()));
+	}
+
+	void RunLightBinning(std::ostream &os, uint32_t lightCount)
+	{
+		// 視錐台の中に散らばったライト(4つに1つはスポットライト)
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<light::PointLight> pointLights;
+		std::vector<light::SpotLight> spotLights;
+		for (uint32_t i = 0; i < lightCount; ++i) {
+			float z = 1.0f + 99.0f * unit(random);
+			math::Vector3 position = { (unit(random) * 2.0f - 1.0f) * z * 0.8f, (unit(random) * 2.0f - 1.0f) * z * 0.45f, z };
+			float radius = 0.5f + 2.5f * unit(random);
+			if (i % 4 == 3) {
+				light::SpotLight spot {};
+				spot.position = position;
+				spot.direction = { 0.0f, -1.0f, 0.0f };
+				spot.distance = radius * 2.0f;
+				spot.cosAngle = 0.5f + 0.5f * unit(random);
+				spotLights.push_back(spot);
+			} else {
+				light::PointLight point {};
+				point.position = position;
+				point.radius = radius;
+				pointLights.push_back(point);
+			}
+		}
+
+		light::LightCuller culler;
+		culler.Initialize({});
+		math::Matrix4x4 view = math::MakeIdentity4x4();
+
+		culler.SetUseSimd(false);
+		culler.SetUseJobs(false);
+		double scalarTime = MeasureBestMilliseconds([&]() { culler.Cull(view, pointLights, spotLights); });
+		std::vector<uint32_t> scalarIndices = culler.GetLightIndices();
+
+		culler.SetUseSimd(true);
+		double simdTime = MeasureBestMilliseconds([&]() { culler.Cull(view, pointLights, spotLights); });
+		bool simdMatches = culler.GetLightIndices() == scalarIndices;
+
+		culler.SetUseJobs(true);
+		double jobTime = MeasureBestMilliseconds([&]() { culler.Cull(view, pointLights, spotLights); });
+		bool jobMatches = culler.GetLightIndices() == scalarIndices;
+
+		Logger::Log(os, std::format("[LightBinning] lights:{} clusters:{} references:{} scalar:{:.3f}ms simd:{:.3f}ms simd+jobs:{:.3f}ms match:{}",
+			lightCount, culler.GetClusterCount(), scalarIndices.size(), scalarTime, simdTime, jobTime, simdMatches && jobMatches));
+	}
+
+	void RunSkeletalAnimation(std::ostream &os, uint32_t characterCount)
+	{
+		constexpr uint32_t kJointCount = 64;
+		constexpr uint32_t kKeysPerClip = 31;
+		constexpr float kClipDuration = 1.0f;
+
+		// 二分木状のスケルトン(子は親から上に1伸びる)
+		animation::Skeleton skeleton;
+		skeleton.bindPose.Resize(kJointCount);
+		for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+			skeleton.jointNames.push_back(std::format("joint{}", joint));
+			skeleton.parents.push_back(joint == 0 ? -1 : static_cast<int32_t>((joint - 1) / 2));
+			skeleton.bindPose.SetTranslation(joint, { joint % 2 == 0 ? 0.5f : -0.5f, joint == 0 ? 0.0f : 1.0f, 0.0f });
+		}
+		std::vector<math::Matrix4x4> bindMatrices;
+		animation::ComputeModelMatrices(skeleton, skeleton.bindPose, bindMatrices);
+		for (const math::Matrix4x4 &bindMatrix : bindMatrices) {
+			skeleton.inverseBindMatrices.push_back(math::Inverse(bindMatrix));
+		}
+
+		// 全関節に回転のトラック、ルートに平行移動のトラックを持つクリップを2つ作る
+		auto makeClip = [&](const char *name, float speed) {
+			animation::AnimationClip clip;
+			clip.name = name;
+			clip.duration = kClipDuration;
+			for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+				animation::Track track;
+				track.joint = joint;
+				for (uint32_t key = 0; key < kKeysPerClip; ++key) {
+					float time = kClipDuration * float(key) / float(kKeysPerClip - 1);
+					float halfAngle = 0.5f * std::sin(time * speed * 6.2831853f + float(joint));
+					track.times.push_back(time);
+					track.values[0].push_back(joint % 3 == 0 ? std::sin(halfAngle) : 0.0f);
+					track.values[1].push_back(joint % 3 == 1 ? std::sin(halfAngle) : 0.0f);
+					track.values[2].push_back(joint % 3 == 2 ? std::sin(halfAngle) : 0.0f);
+					track.values[3].push_back(std::cos(halfAngle));
+				}
+				clip.rotations.push_back(std::move(track));
+			}
+			animation::Track rootTrack;
+			rootTrack.joint = 0;
+			for (uint32_t key = 0; key < kKeysPerClip; ++key) {
+				float time = kClipDuration * float(key) / float(kKeysPerClip - 1);
+				rootTrack.times.push_back(time);
+				rootTrack.values[0].push_back(0.0f);
+				rootTrack.values[1].push_back(0.1f * std::sin(time * speed * 6.2831853f));
+				rootTrack.values[2].push_back(time * speed);
+			}
+			clip.translations.push_back(std::move(rootTrack));
+			return clip;
+			};
+		animation::AnimationClip walk = makeClip("walk", 1.0f);
+		animation::AnimationClip run = makeClip("run", 2.0f);
+
+		// キャラクターごとの状態
+		struct Character
+		{
+			float time;
+			animation::ClipCursor walkCursor;
+			animation::ClipCursor runCursor;
+			animation::Pose walkPose;
+			animation::Pose runPose;
+			animation::Pose blendedPose;
+			std::vector<math::Matrix4x4> modelMatrices;
+			std::vector<math::Matrix4x4> skinMatrices;
+		};
+		std::vector<Character> characters(characterCount);
+		for (uint32_t i = 0; i < characterCount; ++i) {
+			Character &character = characters[i];
+			character.time = kClipDuration * float(i) / float(characterCount);
+			character.walkCursor.Reset(walk);
+			character.runCursor.Reset(run);
+			character.walkPose = skeleton.bindPose;
+			character.runPose = skeleton.bindPose;
+			character.blendedPose = skeleton.bindPose;
+		}
+
+		constexpr uint32_t kGroupSize = 16;
+		auto sampleAll = [&](bool resetCursors) {
+			JobSystem::GetInstance()->ParallelFor(characterCount, kGroupSize, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					Character &character = characters[i];
+					character.time = std::fmod(character.time + kDeltaTime, kClipDuration);
+					if (resetCursors) {
+						character.walkCursor.Reset(walk);
+						character.runCursor.Reset(run);
+					}
+					animation::SampleClip(walk, character.time, character.walkCursor, character.walkPose);
+					animation::SampleClip(run, character.time, character.runCursor, character.runPose);
+				}
+				});
+			};
+
+		double cachedSampleTime = MeasureBestMilliseconds([&]() { sampleAll(false); });
+		double searchSampleTime = MeasureBestMilliseconds([&]() { sampleAll(true); });
+
+		double blendTime = MeasureBestMilliseconds([&]() {
+			JobSystem::GetInstance()->ParallelFor(characterCount, kGroupSize, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					Character &character = characters[i];
+					animation::BlendPoses(character.walkPose, character.runPose, 0.25f + 0.5f * float(i % 2), character.blendedPose);
+				}
+				});
+			});
+
+		double matrixTime = MeasureBestMilliseconds([&]() {
+			JobSystem::GetInstance()->ParallelFor(characterCount, kGroupSize, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					Character &character = characters[i];
+					animation::ComputeModelMatrices(skeleton, character.blendedPose, character.modelMatrices);
+					animation::ComputeSkinMatrices(skeleton, character.modelMatrices, character.skinMatrices);
+				}
+				});
+			});
+
+		// 検証: バインドポーズでスキニングすると頂点は動かない
+		std::vector<animation::SkinnedVertex> vertices;
+		for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+			const math::Matrix4x4 &bind = bindMatrices[joint];
+			uint32_t parent = joint == 0 ? 0 : static_cast<uint32_t>(skeleton.parents[joint]);
+			vertices.push_back({ { bind.m[3][0] + 0.1f, bind.m[3][1], bind.m[3][2], 1.0f }, { 1.0f,0.0f,0.0f }, { joint, parent, 0, 0 }, { 0.5f, 0.5f, 0.0f, 0.0f } });
+		}
+		std::vector<math::Matrix4x4> bindSkinMatrices;
+		animation::ComputeSkinMatrices(skeleton, bindMatrices, bindSkinMatrices);
+		std::vector<math::Vector4> skinnedPositions;
+		std::vector<math::Vector3> skinnedNormals;
+		animation::SkinVertices(vertices, bindSkinMatrices, skinnedPositions, skinnedNormals);
+		float maxError = 0.0f;
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			maxError = (std::max)(maxError, std::abs(skinnedPositions[i].x - vertices[i].position.x));
+			maxError = (std::max)(maxError, std::abs(skinnedPositions[i].y - vertices[i].position.y));
+			maxError = (std::max)(maxError, std::abs(skinnedPositions[i].z - vertices[i].position.z));
+		}
+
+		// アニメーションした姿勢でのスキニング時間(1キャラクター分)
+		double skinTime = MeasureBestMilliseconds([&]() {
+			animation::SkinVertices(vertices, characters[0].skinMatrices, skinnedPositions, skinnedNormals);
+			});
+
+		Logger::Log(os, std::format("[SkeletalAnimation] characters:{} joints:{} sample(cached):{:.3f}ms sample(search):{:.3f}ms blend:{:.3f}ms matrices:{:.3f}ms skin({} verts):{:.4f}ms bind-pose-error:{:.2e}",
+			characterCount, kJointCount, cachedSampleTime, searchSampleTime, blendTime, matrixTime, vertices.size(), skinTime, maxError));
+	}
+
+	void RunModelLoading(std::ostream &os, uint32_t gridSize)
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path();
+		std::string objPath = (directory / "benchmark_grid.obj").string();
+		std::string glbPath = (directory / "benchmark_grid.glb").string();
+		WriteGridModels(gridSize, objPath, glbPath);
+
+		size_t objVertexCount = 0;
+		double objTime = MeasureBestMilliseconds([&]() {
+			objVertexCount = LoadObjFile(objPath).size();
+			});
+
+		// GLBは読み込んだ後、各属性をアップロード先(ここでは確保済みの配列)へ直接コピーするまでを計る
+		std::vector<std::byte> uploadBuffer;
+		size_t glbIndexCount = 0;
+		double glbTime = MeasureBestMilliseconds([&]() {
+			GlbModel model;
+			bool loaded = model.Load(glbPath);
+			assert(loaded);
+			(void)loaded;
+			const GlbModel::Primitive &primitive = model.GetMeshes()[0].primitives[0];
+			size_t offset = 0;
+			for (const char *attribute : { "POSITION", "NORMAL", "TEXCOORD_0" }) {
+				std::span<const std::byte> bytes = model.GetAccessorBytes(static_cast<uint32_t>(primitive.FindAttribute(attribute)));
+				uploadBuffer.resize((std::max)(uploadBuffer.size(), offset + bytes.size()));
+				std::memcpy(uploadBuffer.data() + offset, bytes.data(), bytes.size());
+				offset += bytes.size();
+			}
+			std::span<const uint32_t> indices = model.GetAccessorSpan<uint32_t>(static_cast<uint32_t>(primitive.indices));
+			uploadBuffer.resize((std::max)(uploadBuffer.size(), offset + indices.size_bytes()));
+			std::memcpy(uploadBuffer.data() + offset, indices.data(), indices.size_bytes());
+			glbIndexCount = indices.size();
+			});
+
+		uintmax_t objFileSize = std::filesystem::file_size(objPath);
+		uintmax_t glbFileSize = std::filesystem::file_size(glbPath);
+		std::filesystem::remove(objPath);
+		std::filesystem::remove(glbPath);
+
+		Logger::Log(os, std::format("[ModelLoading] triangles:{} obj({}KB):{:.3f}ms glb({}KB):{:.3f}ms speedup:{:.1f}x vertices(obj):{} indices(glb):{}",
+			gridSize * gridSize * 2, objFileSize / 1024, objTime, glbFileSize / 1024, glbTime, objTime / (std::max)(glbTime, 1.0e-6), objVertexCount, glbIndexCount));
+	}
+
+	void RunMeshProcessing(std::ostream &os, uint32_t gridSize)
+	{
+		std::vector<math::Vector3> positions;
+		std::vector<math::Vector2> texcoords;
+		std::vector<uint32_t> indices;
+		MakeTerrain(gridSize, positions, texcoords, indices);
+
+		std::vector<math::Vector3> serialNormals;
+		std::vector<math::Vector3> parallelNormals;
+		double serialNormalTime = MeasureBestMilliseconds([&]() {
+			mesh::GenerateNormals(positions, indices, mesh::NormalWeighting::Angle, serialNormals, false);
+			});
+		double parallelNormalTime = MeasureBestMilliseconds([&]() {
+			mesh::GenerateNormals(positions, indices, mesh::NormalWeighting::Angle, parallelNormals, true);
+			});
+
+		std::vector<math::Vector4> serialTangents;
+		std::vector<math::Vector4> parallelTangents;
+		double serialTangentTime = MeasureBestMilliseconds([&]() {
+			mesh::GenerateTangents(positions, serialNormals, texcoords, indices, serialTangents, false);
+			});
+		double parallelTangentTime = MeasureBestMilliseconds([&]() {
+			mesh::GenerateTangents(positions, parallelNormals, texcoords, indices, parallelTangents, true);
+			});
+
+		// スレッド数に依らずビット単位で一致すること
+		bool identical =
+			std::memcmp(serialNormals.data(), parallelNormals.data(), serialNormals.size() * sizeof(math::Vector3)) == 0 &&
+			std::memcmp(serialTangents.data(), parallelTangents.data(), serialTangents.size() * sizeof(math::Vector4)) == 0;
+
+		Logger::Log(os, std::format("[MeshProcessing] triangles:{} workers:{} normals serial:{:.2f}ms parallel:{:.2f}ms tangents serial:{:.2f}ms parallel:{:.2f}ms identical:{}",
+			indices.size() / 3, JobSystem::GetInstance()->GetWorkerCount(), serialNormalTime, parallelNormalTime, serialTangentTime, parallelTangentTime, identical));
+	}
+
+	void RunRaycast(std::ostream &os, uint32_t gridSize)
+	{
+		std::vector<math::Vector3> positions;
+		std::vector<math::Vector2> texcoords;
+		std::vector<uint32_t> indices;
+		MakeTerrain(gridSize, positions, texcoords, indices);
+
+		mesh::TriangleBVH bvh;
+		double serialBuildTime = MeasureBestMilliseconds([&]() {
+			bvh.Build(positions, indices, false);
+			});
+		double parallelBuildTime = MeasureBestMilliseconds([&]() {
+			bvh.Build(positions, indices, true);
+			});
+
+		// 上から見下ろす向きの揃ったレイ(束は隣り合う4本)と、斜め上から散らばった向きのレイ
+		constexpr uint32_t kRayCount = 1 << 18;
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<mesh::Ray> coherentRays(kRayCount);
+		std::vector<mesh::Ray> incoherentRays(kRayCount);
+		for (uint32_t i = 0; i < kRayCount; ++i) {
+			coherentRays[i].origin = { 100.0f * float(i % 512) / 512.0f + 0.01f, 20.0f, 100.0f * float(i / 512) / 512.0f + 0.01f };
+			coherentRays[i].direction = { 0.0f, -1.0f, 0.0f };
+			incoherentRays[i].origin = { unit(random) * 100.0f, 10.0f, unit(random) * 100.0f };
+			incoherentRays[i].direction = { unit(random) * 2.0f - 1.0f, -0.2f - unit(random), unit(random) * 2.0f - 1.0f };
+		}
+
+		std::vector<mesh::RayHit> referenceHits(kRayCount);
+		std::vector<mesh::RayHit> hits(kRayCount);
+		for (const auto &[name, rays] : { std::pair { "coherent", &coherentRays }, std::pair { "incoherent", &incoherentRays } }) {
+			// 1本ずつ(スカラー / SIMD)、4本の束、束+ジョブ
+			bvh.SetUseSimd(false);
+			double scalarTime = MeasureBestMilliseconds([&]() {
+				bvh.IntersectBatch(*rays, referenceHits, false, false);
+				});
+			bvh.SetUseSimd(true);
+			double simdTime = MeasureBestMilliseconds([&]() {
+				bvh.IntersectBatch(*rays, hits, false, false);
+				});
+			double packetTime = MeasureBestMilliseconds([&]() {
+				bvh.IntersectBatch(*rays, hits, true, false);
+				});
+			double parallelTime = MeasureBestMilliseconds([&]() {
+				bvh.IntersectBatch(*rays, hits, true, true);
+				});
+
+			// 三角形の辺上では隣の三角形を返すこともあるので、距離で比べる
+			uint32_t hitCount = 0;
+			uint32_t mismatchCount = 0;
+			for (uint32_t i = 0; i < kRayCount; ++i) {
+				hitCount += referenceHits[i].IsHit() ? 1 : 0;
+				if (referenceHits[i].IsHit() != hits[i].IsHit() ||
+					(hits[i].IsHit() && std::abs(referenceHits[i].distance - hits[i].distance) > 1.0e-3f)) {
+					++mismatchCount;
+				}
+			}
+
+			auto raysPerSecond = [](double milliseconds) { return double(kRayCount) / milliseconds / 1000.0; };
+			Logger::Log(os, std::format("[Raycast] {} rays:{} hits:{} scalar:{:.2f}Mrays/s simd:{:.2f}Mrays/s packet:{:.2f}Mrays/s packet+jobs:{:.2f}Mrays/s mismatches:{}",
+				name, kRayCount, hitCount, raysPerSecond(scalarTime), raysPerSecond(simdTime), raysPerSecond(packetTime), raysPerSecond(parallelTime), mismatchCount));
+		}
+
+		Logger::Log(os, std::format("[Raycast] triangles:{} nodes:{} build serial:{:.2f}ms parallel:{:.2f}ms",
+			bvh.GetTriangleCount(), bvh.GetNodeCount(), serialBuildTime, parallelBuildTime));
+	}
+
+	void RunOcclusionCulling(std::ostream &os, uint32_t objectCount)
+	{
+		// 箱のメッシュ(遮蔽物の壁に使う)
+		const std::vector<math::Vector3> boxPositions = {
+			{ -0.5f,-0.5f,-0.5f }, { 0.5f,-0.5f,-0.5f }, { -0.5f,0.5f,-0.5f }, { 0.5f,0.5f,-0.5f },
+			{ -0.5f,-0.5f,0.5f }, { 0.5f,-0.5f,0.5f }, { -0.5f,0.5f,0.5f }, { 0.5f,0.5f,0.5f } };
+		const std::vector<uint32_t> boxIndices = {
+			0,2,1, 1,2,3, 4,5,6, 5,7,6, 0,1,4, 1,5,4, 2,6,3, 3,6,7, 0,4,2, 2,4,6, 1,3,5, 3,7,5 };
+
+		// 手前に並んだ壁と、その奥まで散らばった小さな物体
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<math::Matrix4x4> walls;
+		for (uint32_t i = 0; i < 16; ++i) {
+			math::Vector3 position = { (unit(random) * 2.0f - 1.0f) * 40.0f, 4.0f, 15.0f + unit(random) * 30.0f };
+			walls.push_back(math::MakeAffineMatrix({ 10.0f + unit(random) * 10.0f, 8.0f, 1.0f }, math::Vector3 { 0.0f, 0.0f, 0.0f }, position));
+		}
+		std::vector<render::BoundingBox> boxes(objectCount);
+		for (render::BoundingBox &box : boxes) {
+			math::Vector3 center = { (unit(random) * 2.0f - 1.0f) * 60.0f, unit(random) * 4.0f, 5.0f + unit(random) * 95.0f };
+			float halfSize = 0.2f + unit(random) * 0.8f;
+			box.min = { center.x - halfSize, center.y - halfSize, center.z - halfSize };
+			box.max = { center.x + halfSize, center.y + halfSize, center.z + halfSize };
+		}
+
+		// 地面近くから奥を見るカメラ
+		math::Matrix4x4 camera = math::MakeAffineMatrix({ 1.0f,1.0f,1.0f }, math::Vector3 { 0.1f, 0.0f, 0.0f }, { 0.0f, 3.0f, -5.0f });
+		math::Matrix4x4 viewProjection = math::Multiply(math::Inverse(camera), math::MakePerspectiveFovMatrix(0.9f, 16.0f / 9.0f, 0.1f, 200.0f));
+
+		render::OcclusionCuller culler;
+		culler.Initialize();
+		std::vector<uint8_t> referenceVisible(objectCount);
+		std::vector<uint8_t> visible(objectCount);
+		auto runFrame = [&](std::vector<uint8_t> &result) {
+			culler.BeginFrame(viewProjection);
+			for (const math::Matrix4x4 &wall : walls) {
+				culler.AddOccluder(boxPositions, boxIndices, wall);
+			}
+			culler.Rasterize();
+			culler.TestVisibility(boxes, result);
+		};
+
+		// スカラー / SIMD / SIMD+ジョブ
+		culler.SetUseSimd(false);
+		culler.SetUseJobs(false);
+		double scalarTime = MeasureBestMilliseconds([&]() { runFrame(referenceVisible); });
+		culler.SetUseSimd(true);
+		double simdTime = MeasureBestMilliseconds([&]() { runFrame(visible); });
+		bool identical = referenceVisible == visible;
+		culler.SetUseJobs(true);
+		double parallelTime = MeasureBestMilliseconds([&]() { runFrame(visible); });
+		identical = identical && referenceVisible == visible;
+
+		// 内訳は最後のフレームのもの
+		const render::OcclusionStatistics &statistics = culler.GetStatistics();
+		Logger::Log(os, std::format("[OcclusionCulling] objects:{} culled:{} ({:.1f}%) occluderTriangles:{} frame scalar:{:.3f}ms simd:{:.3f}ms simd+jobs:{:.3f}ms (setup:{:.3f}ms raster:{:.3f}ms test:{:.3f}ms) identical:{}",
+			objectCount, statistics.culledCount, 100.0 * statistics.culledCount / (std::max)(statistics.testedCount, 1u), statistics.rasterizedTriangleCount,
+			scalarTime, simdTime, parallelTime, statistics.setupMilliseconds, statistics.rasterizeMilliseconds, statistics.testMilliseconds, identical));
+	}
+
+	void RunMaterialDedup(std::ostream &os, uint32_t spriteCount)
+	{
+		// サンプルのシーン: 8色のパレットとスプライトシートの4コマの組み合わせに、1割ほど個別にフェードする物が混ざる
+		std::mt19937 random(12345);
+		std::uniform_int_distribution<uint32_t> paletteIndex(0, 7);
+		std::uniform_int_distribution<uint32_t> frameIndex(0, 3);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<Sprite::Material> materials(spriteCount);
+		for (Sprite::Material &material : materials) {
+			uint32_t palette = paletteIndex(random);
+			material.color = { (palette & 1) ? 1.0f : 0.5f, (palette & 2) ? 1.0f : 0.5f, (palette & 4) ? 1.0f : 0.5f, 1.0f };
+			if (unit(random) < 0.1f) {
+				material.color.w = unit(random);
+			}
+			material.uvTransform = math::MakeAffineMatrix({ 0.25f,1.0f,1.0f }, math::Vector3 { 0.0f,0.0f,0.0f }, { 0.25f * static_cast<float>(frameIndex(random)), 0.0f, 0.0f });
+		}
+
+		render::MaterialTable table;
+		table.Initialize(sizeof(Sprite::Material), spriteCount);
+		std::vector<uint32_t> materialIds(spriteCount);
+		double internTime = MeasureBestMilliseconds([&]() {
+			table.Clear();
+			for (uint32_t i = 0; i < spriteCount; ++i) {
+				materialIds[i] = table.Intern(materials[i]);
+			}
+		});
+
+		// GPU側は1つ256バイトに揃えて置く
+		constexpr uint32_t kMaterialSize = (sizeof(Sprite::Material) + 255) / 256 * 256;
+		const uint32_t materialCount = table.GetMaterialCount();
+
+		// マテリアルのCBVを設定し直す回数(パケットの順 / IDの順)
+		auto countBinds = [&](const std::vector<uint32_t> &order) {
+			render::RootBindingTable bindingTable;
+			bindingTable.Reset(1);
+			for (uint32_t i : order) {
+				bindingTable.Update(0, materialIds[i]);
+			}
+			return bindingTable.GetUpdateCount();
+		};
+		std::vector<uint32_t> order(spriteCount);
+		for (uint32_t i = 0; i < spriteCount; ++i) {
+			order[i] = i;
+		}
+		uint32_t packetOrderBinds = countBinds(order);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return materialIds[a] < materialIds[b]; });
+		uint32_t sortedBinds = countBinds(order);
+
+		Logger::Log(os, std::format("[MaterialDedup] sprites:{} materials:{} constantBytes:{} -> {} (saved {}) materialCBVs saved:{} materialBinds packetOrder:{} sorted:{} intern:{:.3f}ms",
+			spriteCount, materialCount, spriteCount * kMaterialSize, materialCount * kMaterialSize, (spriteCount - materialCount) * kMaterialSize,
+			spriteCount - materialCount, packetOrderBinds, sortedBinds, internTime));
+	}
+
+	void RunSceneSerialization(std::ostream &os, uint32_t entityCount)
+	{
+		using namespace ecs;
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+		auto elapsedMilliseconds = [](std::chrono::steady_clock::time_point begin) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			};
+
+		World world;
+		for (uint32_t i = 0; i < entityCount; ++i) {
+			world.CreateEntity(
+				Transform2DComponent { { distribution(random), distribution(random) }, distribution(random), { 64.0f, 64.0f } },
+				SpriteComponent { {}, { 1.0f, distribution(random), 0.5f, 1.0f } },
+				ColliderComponent { { 32.0f, 32.0f }, i % 4, 0 });
+		}
+		SceneSerializer serializer;
+		serializer.RegisterComponent<Transform2DComponent>("Transform2D");
+		serializer.RegisterComponent<SpriteComponent>("Sprite");
+		serializer.RegisterComponent<ColliderComponent>("Collider");
+
+		std::filesystem::path directory = std::filesystem::temp_directory_path();
+		std::string binaryPath = (directory / "benchmark_scene.ge3s").string();
+		std::string textPath = (directory / "benchmark_scene.txt").string();
+
+		// バイナリ: チャンクをそのまま書き出し、メモリマップしてチャンクごとにコピーする
+		auto begin = std::chrono::steady_clock::now();
+		bool saved = serializer.Save(world, binaryPath);
+		double binarySaveTime = elapsedMilliseconds(begin);
+		assert(saved);
+		(void)saved;
+
+		World binaryWorld;
+		begin = std::chrono::steady_clock::now();
+		bool loaded = serializer.Load(binaryWorld, binaryPath);
+		double binaryLoadTime = elapsedMilliseconds(begin);
+		assert(loaded && binaryWorld.GetEntityCount() == entityCount);
+		(void)loaded;
+
+		// テキスト: 1行に1エンティティ分の値を並べる
+		Query<Transform2DComponent, SpriteComponent, ColliderComponent> query(world);
+		begin = std::chrono::steady_clock::now();
+		{
+			std::string text;
+			char buffer[32];
+			auto append = [&](auto value) {
+				text.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+				text.push_back(' ');
+				};
+			query.ForEach([&](Entity, Transform2DComponent &transform, SpriteComponent &sprite, ColliderComponent &collider) {
+				for (float value : { transform.position.x, transform.position.y, transform.rotation, transform.size.x, transform.size.y,
+					sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w, collider.halfSize.x, collider.halfSize.y }) {
+					append(value);
+				}
+				append(collider.layer);
+				text.back() = '\n';
+				});
+			std::ofstream file(textPath, std::ios::binary);
+			file.write(text.data(), static_cast<std::streamsize>(text.size()));
+		}
+		double textSaveTime = elapsedMilliseconds(begin);
+
+		World textWorld;
+		begin = std::chrono::steady_clock::now();
+		{
+			std::ifstream file(textPath, std::ios::binary);
+			std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			const char *cursor = text.data();
+			const char *end = text.data() + text.size();
+			auto read = [&](auto &value) {
+				cursor = std::from_chars(cursor, end, value).ptr + 1;
+				};
+			while (cursor < end) {
+				Transform2DComponent transform;
+				SpriteComponent sprite;
+				ColliderComponent collider;
+				for (float *value : { &transform.position.x, &transform.position.y, &transform.rotation, &transform.size.x, &transform.size.y,
+					&sprite.color.x, &sprite.color.y, &sprite.color.z, &sprite.color.w, &collider.halfSize.x, &collider.halfSize.y }) {
+					read(*value);
+				}
+				read(collider.layer);
+				textWorld.CreateEntity(transform, sprite, collider);
+			}
+		}
+		double textLoadTime = elapsedMilliseconds(begin);
+		assert(textWorld.GetEntityCount() == entityCount);
+
+		// 1%のエンティティ(生成順に連続した範囲)を動かして差分保存する
+		uint32_t movedCount = 0;
+		query.ForEach([&](Entity, Transform2DComponent &transform, SpriteComponent &, ColliderComponent &) {
+			if (movedCount++ < entityCount / 100) {
+				transform.position.x += 1.0f;
+			}
+			});
+		begin = std::chrono::steady_clock::now();
+		saved = serializer.SaveIncremental(world, binaryPath);
+		double incrementalSaveTime = elapsedMilliseconds(begin);
+		assert(saved);
+		const SceneSerializer::SaveStatistics &statistics = serializer.GetLastSaveStatistics();
+
+		uintmax_t binaryFileSize = std::filesystem::file_size(binaryPath);
+		uintmax_t textFileSize = std::filesystem::file_size(textPath);
+		std::filesystem::remove(binaryPath);
+		std::filesystem::remove(textPath);
+
+		Logger::Log(os, std::format("[SceneSerialization] entities:{} text({}KB) save:{:.3f}ms load:{:.3f}ms binary({}KB) save:{:.3f}ms load:{:.3f}ms load speedup:{:.1f}x",
+			entityCount, textFileSize / 1024, textSaveTime, textLoadTime, binaryFileSize / 1024, binarySaveTime, binaryLoadTime, textLoadTime / (std::max)(binaryLoadTime, 1.0e-6)));
+		Logger::Log(os, std::format("[SceneSerialization] incremental save (1% moved): chunks:{}/{} written:{}KB {:.3f}ms",
+			statistics.writtenChunkCount, statistics.chunkCount, statistics.writtenBytes / 1024, incrementalSaveTime));
+	}
+
+	void RunTaskScheduling(std::ostream &os, uint32_t taskCount)
+	{
+		TaskScheduler *scheduler = TaskScheduler::GetInstance();
+		auto perTaskNanoseconds = [taskCount](double milliseconds) { return milliseconds * 1.0e6 / taskCount; };
+
+		// 比較用: 同じ数のジョブを直接投入する
+		double jobTime = MeasureBestMilliseconds([&]() {
+			std::atomic<uint32_t> counter = 0;
+			JobSystem::Counter jobCounter;
+			for (uint32_t i = 0; i < taskCount; ++i) {
+				JobSystem::GetInstance()->Submit([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); }, &jobCounter);
+			}
+			JobSystem::GetInstance()->Wait(jobCounter);
+			});
+
+		// コルーチンを作ってジョブシステムで再開し、全ての完了を待つ(フレームの確保と破棄を含む)
+		uint32_t hopCount = 0;
+		double hopTime = MeasureBestMilliseconds([&]() {
+			std::atomic<uint32_t> counter = 0;
+			std::vector<Task<void>> tasks;
+			tasks.reserve(taskCount);
+			for (uint32_t i = 0; i < taskCount; ++i) {
+				tasks.push_back(CountOnJobSystem(counter));
+				tasks.back().Start();
+			}
+			scheduler->RunUntilComplete(WhenAll(tasks));
+			hopCount = counter.load();
+			});
+
+		// フレームの境界で待っているコルーチンを再開する
+		double frameTime = 1.0e30;
+		for (uint32_t repeat = 0; repeat < kRepeatCount; ++repeat) {
+			std::vector<Task<void>> tasks;
+			tasks.reserve(taskCount);
+			for (uint32_t i = 0; i < taskCount; ++i) {
+				tasks.push_back(WaitNextFrame());
+				tasks.back().Start();
+			}
+			auto begin = std::chrono::steady_clock::now();
+			scheduler->RunFrameBoundary();
+			frameTime = (std::min)(frameTime, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+		}
+
+		// 待たずに完了するタスクのco_await(中断せずにそのまま続きへ切り替わる)
+		uint64_t sum = 0;
+		double awaitTime = MeasureBestMilliseconds([&]() {
+			sum = scheduler->RunUntilComplete(SumValues(taskCount));
+			});
+
+		Logger::Log(os, std::format("[TaskScheduling] tasks:{} per task: job:{:.1f}ns coroutine-on-job:{:.1f}ns frame-resume:{:.1f}ns ready-co_await:{:.1f}ns (completed:{} sum:{})",
+			taskCount, perTaskNanoseconds(jobTime), perTaskNanoseconds(hopTime), perTaskNanoseconds(frameTime), perTaskNanoseconds(awaitTime), hopCount, sum));
+	}
+
+	void RunTimers(std::ostream &os, uint32_t timerCount)
+	{
+		// 10分(60Hz)先までの遅延で登録し、1割を取り消して登録し直してから、1分ぶん進める
+		// 満了したタイマーは登録し直すので、常にtimerCount個が満了待ち
+		constexpr uint32_t kMaxDelayTicks = 60 * 60 * 10;
+		constexpr uint32_t kAdvanceTicks = 60 * 60;
+		std::vector<uint32_t> delays(timerCount);
+		std::mt19937 random(12345);
+		std::uniform_int_distribution<uint32_t> distribution(1, kMaxDelayTicks);
+		for (uint32_t &delay : delays) {
+			delay = distribution(random);
+		}
+		// 満了時の登録し直しの遅延(満了の順番によらず同じ値になるよう、値と時刻から決める)
+		auto rescheduleDelay = [](uint64_t userData, uint64_t tick) {
+			return static_cast<uint32_t>((userData * 2654435761ull + tick * 40503ull) % kMaxDelayTicks) + 1;
+			};
+		uint32_t cancelCount = timerCount / 10;
+		auto elapsedMilliseconds = [](std::chrono::steady_clock::time_point begin) {
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			};
+
+		// タイミングホイール
+		TimerWheel wheel;
+		uint64_t wheelFired = 0;
+		TimerWheel::CallbackId callback = 0;
+		callback = wheel.RegisterCallback([&](TimerHandle, uint64_t userData) {
+			++wheelFired;
+			wheel.Schedule(rescheduleDelay(userData, wheel.GetCurrentTick()), callback, userData);
+			});
+		std::vector<TimerHandle> handles(timerCount);
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < timerCount; ++i) {
+			handles[i] = wheel.Schedule(delays[i], callback, i);
+		}
+		double wheelInsertTime = elapsedMilliseconds(begin);
+		begin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < cancelCount; ++i) {
+			uint32_t target = i * 10;
+			wheel.Cancel(handles[target]);
+			handles[target] = wheel.Schedule(delays[timerCount - 1 - target], callback, target);
+		}
+		double wheelCancelTime = elapsedMilliseconds(begin);
+		begin = std::chrono::steady_clock::now();
+		wheel.Advance(kAdvanceTicks);
+		double wheelAdvanceTime = elapsedMilliseconds(begin);
+
+		// 優先度付きキュー
+		HeapTimerQueue heap;
+		uint64_t heapFired = 0;
+		auto heapCallback = [&](TimerHandle, uint64_t userData) {
+			++heapFired;
+			heap.Schedule(rescheduleDelay(userData, heap.GetCurrentTick()), userData);
+			};
+		begin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < timerCount; ++i) {
+			handles[i] = heap.Schedule(delays[i], i);
+		}
+		double heapInsertTime = elapsedMilliseconds(begin);
+		begin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < cancelCount; ++i) {
+			uint32_t target = i * 10;
+			heap.Cancel(handles[target]);
+			handles[target] = heap.Schedule(delays[timerCount - 1 - target], target);
+		}
+		double heapCancelTime = elapsedMilliseconds(begin);
+		begin = std::chrono::steady_clock::now();
+		heap.Advance(kAdvanceTicks, heapCallback);
+		double heapAdvanceTime = elapsedMilliseconds(begin);
+
+		Logger::Log(os, std::format("[Timers] timers:{} ticks:{} fired:{}/{} wheel insert:{:.3f}ms cancel+reinsert({}):{:.3f}ms advance:{:.3f}ms heap insert:{:.3f}ms cancel+reinsert:{:.3f}ms advance:{:.3f}ms total speedup:{:.2f}x",
+			timerCount, kAdvanceTicks, wheelFired, heapFired, wheelInsertTime, cancelCount, wheelCancelTime, wheelAdvanceTime, heapInsertTime, heapCancelTime, heapAdvanceTime,
+			(heapInsertTime + heapCancelTime + heapAdvanceTime) / (std::max)(wheelInsertTime + wheelCancelTime + wheelAdvanceTime, 1.0e-6)));
+	}
+
+	void RunEventBus(std::ostream &os, uint32_t producerCount)
+	{
+		constexpr uint32_t kTotalEventCount = 2000000;
+		constexpr uint32_t kCapacity = 4096;
+		uint32_t eventsPerProducer = kTotalEventCount / producerCount;
+		auto log = [&](const char *name, const BusResult &result) {
+			Logger::Log(os, std::format("[EventBus] producers:{} {} events:{} {:.2f}Mevents/s latency p50:{:.2f}us p99:{:.2f}us orderErrors:{}",
+				producerCount, name, eventsPerProducer * producerCount, eventsPerProducer * producerCount / (std::max)(result.milliseconds, 1.0e-6) / 1000.0,
+				result.medianLatencyMicroseconds, result.p99LatencyMicroseconds, result.orderErrors));
+			};
+
+		// 比較用: ミューテックスで守ったdeque(読み手は溜まった分をまとめて入れ替えて取り出す)
+		{
+			std::mutex mutex;
+			std::deque<BusEvent> queue;
+			std::deque<BusEvent> received;
+			BusResult result = MeasureProducersConsumer(producerCount, eventsPerProducer,
+				[&](uint32_t, const BusEvent &event) {
+					std::lock_guard<std::mutex> lock(mutex);
+					// 同じ容量で打ち切る
+					if (queue.size() >= kCapacity) {
+						return false;
+					}
+					queue.push_back(event);
+					return true;
+				},
+				[&](auto &&func) {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						received.swap(queue);
+					}
+					size_t count = received.size();
+					for (const BusEvent &event : received) {
+						func(event);
+					}
+					received.clear();
+					return count;
+				});
+			log("mutex-deque", result);
+		}
+
+		// 書き手が複数でも使えるリングバッファ
+		{
+			event::MpscRingBuffer<BusEvent> ring(kCapacity);
+			BusResult result = MeasureProducersConsumer(producerCount, eventsPerProducer,
+				[&](uint32_t, const BusEvent &event) { return ring.TryPush(event); },
+				[&](auto &&func) {
+					size_t count = 0;
+					BusEvent event;
+					while (ring.TryPop(event)) {
+						func(event);
+						++count;
+					}
+					return count;
+				});
+			log("mpsc-ring", result);
+		}
+
+		// 書き手ごとに1本ずつのリングバッファ(書き手同士の取り合いが無い)
+		{
+			std::vector<std::unique_ptr<event::SpscRingBuffer<BusEvent>>> rings;
+			for (uint32_t producer = 0; producer < producerCount; ++producer) {
+				rings.push_back(std::make_unique<event::SpscRingBuffer<BusEvent>>(kCapacity));
+			}
+			BusResult result = MeasureProducersConsumer(producerCount, eventsPerProducer,
+				[&](uint32_t producer, const BusEvent &event) { return rings[producer]->TryPush(event); },
+				[&](auto &&func) {
+					size_t count = 0;
+					BusEvent event;
+					for (auto &ring : rings) {
+						while (ring->TryPop(event)) {
+							func(event);
+							++count;
+						}
+					}
+					return count;
+				});
+			log("spsc-rings", result);
+		}
+	}
+
+	void RunSpriteSlicing(std::ostream &os, uint32_t panelCount)
+	{
+		// サンプルのUI: 大きさの違うパネル。角は16ピクセル、切り出しは64x64
+		constexpr float kBorder = 16.0f;
+		constexpr float kTextureSize = 64.0f;
+		// 座標変換は1スプライトにつき256バイトに揃えて置く
+		constexpr uint32_t kTransformationMatrixSize = (sizeof(Sprite::TransformationMatrix) + 255) / 256 * 256;
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> position(0.0f, 1280.0f);
+		std::uniform_real_distribution<float> size(64.0f, 512.0f);
+		struct Panel
+		{
+			math::Vector2 position;
+			math::Vector2 size;
+		};
+		std::vector<Panel> panels(panelCount);
+		for (Panel &panel : panels) {
+			panel = { { position(random),position(random) },{ size(random),size(random) } };
+		}
+		math::Matrix4x4 viewProjection = math::MakeOrthographicMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 100.0f);
+
+		// パケットのスプライトを頂点と座標変換に書き出す(描画スレッドのバッチ作成と同じ処理)
+		std::vector<render::SpriteInstance> instances;
+		std::vector<Sprite::VertexData> vertices;
+		std::vector<Sprite::TransformationMatrix> transforms;
+		auto buildBatch = [&]() {
+			uint32_t quadTotal = 0;
+			for (const render::SpriteInstance &instance : instances) {
+				quadTotal += render::GetSpriteQuadCount(instance);
+			}
+			vertices.resize(size_t(quadTotal) * 4);
+			transforms.resize(instances.size());
+			uint32_t quad = 0;
+			for (size_t i = 0; i < instances.size(); ++i) {
+				quad += render::WriteSpriteVertices(instances[i], vertices.data() + size_t(quad) * 4);
+				transforms[i].WVP = math::Multiply(instances[i].world, viewProjection);
+				transforms[i].World = instances[i].world;
+			}
+		};
+		auto makeInstance = [](const math::Vector2 &position, const math::Vector2 &size, const math::Vector4 &uvRect) {
+			render::SpriteInstance instance {};
+			instance.world = math::MakeAffineMatrix({ size.x,size.y,1.0f }, math::Vector3 { 0.0f,0.0f,0.0f }, { position.x,position.y,0.0f });
+			instance.uvTransform = math::MakeIdentity4x4();
+			instance.color = { 1.0f,1.0f,1.0f,1.0f };
+			instance.localRect = { 0.0f,0.0f,1.0f,1.0f };
+			instance.uvRect = uvRect;
+			return instance;
+		};
+
+		// 従来方式: 角・辺・中央を別々のスプライトにする(1パネル9枚)
+		double separateTime = MeasureBestMilliseconds([&]() {
+			instances.clear();
+			const float uvs[4] = { 0.0f, kBorder / kTextureSize, 1.0f - kBorder / kTextureSize, 1.0f };
+			for (const Panel &panel : panels) {
+				const float xs[4] = { panel.position.x, panel.position.x + kBorder, panel.position.x + panel.size.x - kBorder, panel.position.x + panel.size.x };
+				const float ys[4] = { panel.position.y, panel.position.y + kBorder, panel.position.y + panel.size.y - kBorder, panel.position.y + panel.size.y };
+				for (uint32_t row = 0; row < 3; ++row) {
+					for (uint32_t column = 0; column < 3; ++column) {
+						instances.push_back(makeInstance({ xs[column],ys[row] }, { xs[column + 1] - xs[column],ys[row + 1] - ys[row] },
+							{ uvs[column],uvs[row],uvs[column + 1],uvs[row + 1] }));
+					}
+				}
+			}
+			buildBatch();
+			});
+		size_t separateDraws = instances.size();
+		size_t separateBytes = sizeof(Sprite::VertexData) * vertices.size() + size_t(kTransformationMatrixSize) * transforms.size();
+
+		// NineSlice: 1パネル1スプライトで、頂点の展開はバッチ作成で行う
+		double nineSliceTime = MeasureBestMilliseconds([&]() {
+			instances.clear();
+			for (const Panel &panel : panels) {
+				render::SpriteInstance instance = makeInstance(panel.position, panel.size, { 0.0f,0.0f,1.0f,1.0f });
+				instance.drawMode = render::SpriteDrawMode::NineSlice;
+				instance.sliceRect = { kBorder / panel.size.x, kBorder / panel.size.y, kBorder / panel.size.x, kBorder / panel.size.y };
+				instance.sliceUvRect = { kBorder / kTextureSize, kBorder / kTextureSize, kBorder / kTextureSize, kBorder / kTextureSize };
+				instances.push_back(instance);
+			}
+			buildBatch();
+			});
+		size_t nineSliceDraws = instances.size();
+		size_t nineSliceBytes = sizeof(Sprite::VertexData) * vertices.size() + size_t(kTransformationMatrixSize) * transforms.size();
+
+		Logger::Log(os, std::format("[SpriteSlicing] panels:{} separate:{:.3f}ms draws:{} upload:{}KB nine-slice:{:.3f}ms draws:{} upload:{}KB speedup:{:.2f}x",
+			panelCount, separateTime, separateDraws, separateBytes / 1024, nineSliceTime, nineSliceDraws, nineSliceBytes / 1024,
+			separateTime / (std::max)(nineSliceTime, 1.0e-6)));
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+class DirectXCommon;
+
+// 性能計測
+// コマンドライン引数 -benchmark で起動したときに実行し、結果をログに出す
+// D3D・DXCを使わない計測はBenchmark.cppにまとめてあり、tools/HeadlessMain.cppからWindows以外でも実行できる
+namespace Benchmark
+{
+	// 全ての計測を実行
+	void RunAll(std::ostream &os);
+
+	// ECSのクエリとポインタ配列でのエンティティ走査の比較
+	void RunECSIteration(std::ostream &os, uint32_t entityCount);
+
+	// SpritePoolとnew/deleteでのスプライト生成・破棄の繰り返しの比較
+	void RunSpritePoolChurn(std::ostream &os, uint32_t spriteCount);
+
+	// フレームアリーナとヒープでの1フレーム分の一時配列の確保の比較
+	void RunFrameArena(std::ostream &os, uint32_t elementCount);
+
+	// クラスタへのライト割り当て(スカラー / SIMD / SIMD+ジョブ)
+	void RunLightBinning(std::ostream &os, uint32_t lightCount);
+
+	// スケルタルアニメーション(サンプリング、ブレンド、行列計算を別々に計測)
+	void RunSkeletalAnimation(std::ostream &os, uint32_t characterCount);
+
+	// OBJ(テキスト)とGLB(メモリマップ)の読み込み時間の比較
+	void RunModelLoading(std::ostream &os, uint32_t gridSize);
+
+	// 法線・接線の生成(単一スレッドと並列、結果が一致するかも確かめる)
+	void RunMeshProcessing(std::ostream &os, uint32_t gridSize);
+
+	// 三角形BVHの構築時間とレイ判定の速度(1本ずつ / 4本の束 / 並列)
+	void RunRaycast(std::ostream &os, uint32_t gridSize);
+
+	// ソフトウェアオクルージョンカリング(遮蔽物のラスタライズと物体の判定、隠れた割合)
+	void RunOcclusionCulling(std::ostream &os, uint32_t objectCount);
+
+	// 起動時のシェーダーのビルド(Object3Dの全変種を指定したスレッド数で並列にコンパイルし、依存がそろった変種からPSOを作るまで)
+	// デバイスとDXCが必要なのでBenchmarkShader.cppにあり、RunAllには含めない(WinMainの -shaderbuild から、デバイスの初期化後に呼ぶ)
+	void RunShaderBuild(std::ostream &os, DirectXCommon *dxCommon, uint32_t threadCount);
+
+	// マテリアルの重複除去(サンプルのシーンで、減らせた定数バッファのバイト数・CBV数と、ID順に並べたときの設定の回数)
+	void RunMaterialDedup(std::ostream &os, uint32_t spriteCount);
+
+	// シーンの保存・読み込み(テキストとバイナリの比較、1%だけ動かしたときの差分保存で書き直したチャンク数)
+	void RunSceneSerialization(std::ostream &os, uint32_t entityCount);
+
+	// コルーチンの再開にかかる時間(1タスクあたり。ジョブの直接投入との比較、フレームの境界での再開、待たずに完了するco_await)
+	void RunTaskScheduling(std::ostream &os, uint32_t taskCount);
+
+	// ゲーム内タイマー(タイミングホイールと優先度付きキューで、登録・取り消し・満了処理の時間を比較)
+	void RunTimers(std::ostream &os, uint32_t timerCount);
+
+	// スレッド間のイベントの受け渡し(ミューテックス+deque、MPSCリング、書き手ごとのSPSCリングで、書き手の数を変えて処理量と遅延を比較)
+	void RunEventBus(std::ostream &os, uint32_t producerCount);
+
+	// UIのパネルの描画データ作成(角・辺・中央を9枚のスプライトにする場合と、NineSliceの1枚にする場合の時間・描画コール数・転送量)
+	void RunSpriteSlicing(std::ostream &os, uint32_t panelCount);
+}
@@ -0,0 +1,546 @@
+#include "BenchmarkScene.h"
+#include "CommandReplay.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include "MathFunctions.h"
+#include "RootSignatureLayout.h"
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <numbers>
+
+namespace Benchmark
+{
+	namespace
+	{
+		// 1フレームで進める秒数(フレーム時間によらず同じ結果にする)
+		constexpr float kDeltaTime = 1.0f / 60.0f;
+		// パーティクルの発生源の数と大きさ
+		constexpr uint32_t kEmitterCount = 8;
+		constexpr float kParticleSize = 8.0f;
+		constexpr float kParticleLifetime = 2.0f;
+		constexpr float kGravity = 240.0f;
+
+		// 遮蔽物の壁に使う箱のメッシュ
+		const math::Vector3 kBoxPositions[] = {
+			{ -0.5f,-0.5f,-0.5f }, { 0.5f,-0.5f,-0.5f }, { -0.5f,0.5f,-0.5f }, { 0.5f,0.5f,-0.5f },
+			{ -0.5f,-0.5f,0.5f }, { 0.5f,-0.5f,0.5f }, { -0.5f,0.5f,0.5f }, { 0.5f,0.5f,0.5f } };
+		const uint32_t kBoxIndices[] = {
+			0,2,1, 1,2,3, 4,5,6, 5,7,6, 0,1,4, 1,5,4, 2,6,3, 3,6,7, 0,4,2, 2,4,6, 1,3,5, 3,7,5 };
+
+		double ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// 区間の時間を足し込む
+		class ZoneTimer
+		{
+		public:
+			ZoneTimer(SceneResult &result, SceneZone zone)
+				: milliseconds_(result.zoneMilliseconds[static_cast<size_t>(zone)]), start_(std::chrono::steady_clock::now()) {}
+			~ZoneTimer() { milliseconds_ += ElapsedMilliseconds(start_); }
+
+		private:
+			double &milliseconds_;
+			std::chrono::steady_clock::time_point start_;
+		};
+
+		// スプライト1枚分の描画データ(Sprite::Updateと同じ計算。アンカー左上、テクスチャ全体)
+		render::SpriteInstance MakeSpriteInstance(const math::Vector2 &position, float rotation, const math::Vector2 &size, const math::Vector4 &color, uint32_t textureIndex)
+		{
+			render::SpriteInstance instance {};
+			instance.world = math::MakeAffineMatrix({ size.x,size.y,1.0f }, math::Vector3 { 0.0f,0.0f,rotation }, { position.x,position.y,0.0f });
+			instance.uvTransform = math::MakeIdentity4x4();
+			instance.color = color;
+			instance.localRect = { 0.0f,0.0f,1.0f,1.0f };
+			instance.uvRect = { 0.0f,0.0f,1.0f,1.0f };
+			instance.textureIndex = textureIndex;
+			instance.enableLighting = false;
+			return instance;
+		}
+
+		// SpriteRendererと同じバッチ(SpriteBatchBuilder)で描画コマンドを作り、再生先に流す(ヘッドレス用)
+		// 頂点・定数バッファはGPUの代わりにCPU側のメモリに、SpriteRendererと同じ大きさで持つ
+		class NullSpriteRenderer
+		{
+		public:
+			// 再生先でのパイプラインのID(ライティングの有無で別のルートシグネチャとして扱い、切り替えで設定し直す経路も通す)
+			enum ObjectId : uint32_t
+			{
+				kUnlitRootSignature = render::SpriteBatchBuilder::kFirstPipelineObjectId,
+				kLitRootSignature,
+				kUnlitPipeline,
+				kLitPipeline,
+			};
+
+			explicit NullSpriteRenderer(render::CommandBackend &backend)
+				: backend_(backend), vertices_(render::SpriteBatchBuilder::kVertexBufferSize / sizeof(Sprite::VertexData)),
+				constants_(render::SpriteBatchBuilder::kConstantBufferSize)
+			{
+				batchBuilder_.Initialize();
+				// ルートパラメータの並びはリフレクションの結果に似せる(ライティング無しの変種は平行光源を使わない)
+				unlitPipeline_.rootSignatureId = kUnlitRootSignature;
+				unlitPipeline_.pipelineStateId = kUnlitPipeline;
+				unlitPipeline_.slotCount = 3;
+				unlitPipeline_.slots = { 0, 1, 2, render::RootSignatureLayout::kNoSlot };
+				litPipeline_.rootSignatureId = kLitRootSignature;
+				litPipeline_.pipelineStateId = kLitPipeline;
+				litPipeline_.slotCount = 4;
+				litPipeline_.slots = { 0, 1, 2, 3 };
+			}
+
+			void Draw(const render::RenderPacket &packet, SceneResult &result)
+			{
+				backend_.BeginFrame(frameNumber_++);
+				backend_.BeginPass("Sprite");
+				batchBuilder_.Build(packet, vertices_.data(), constants_.data(), backend_, unlitPipeline_, litPipeline_);
+				backend_.EndPass();
+				backend_.EndFrame();
+
+				const render::SpriteBatchBuilder::Statistics &statistics = batchBuilder_.GetStatistics();
+				result.drawCallCount += statistics.drawCount;
+				result.uploadBytes += statistics.uploadBytes;
+				result.droppedQuadCount += statistics.droppedQuadCount;
+			}
+
+		private:
+			render::CommandBackend &backend_;
+			render::SpriteBatchBuilder batchBuilder_;
+			render::SpriteBatchPipeline unlitPipeline_;
+			render::SpriteBatchPipeline litPipeline_;
+			std::vector<Sprite::VertexData> vertices_;
+			std::vector<uint8_t> constants_;
+			uint64_t frameNumber_ = 0;
+		};
+
+		// 小さい順に並べた値のp割の位置(最近傍順位)
+		double Percentile(const std::vector<double> &sorted, double p)
+		{
+			if (sorted.empty()) {
+				return 0.0;
+			}
+			size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+			return sorted[std::clamp(rank, size_t(1), sorted.size()) - 1];
+		}
+
+		// JSONの文字列
+		std::string QuoteJson(std::string_view text)
+		{
+			std::string quoted = "\"";
+			for (char c : text) {
+				switch (c) {
+				case '"': quoted += "\\\""; break;
+				case '\\': quoted += "\\\\"; break;
+				case '\n': quoted += "\\n"; break;
+				case '\t': quoted += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						quoted += std::format("\\u{:04x}", static_cast<unsigned int>(c));
+					} else {
+						quoted += c;
+					}
+					break;
+				}
+			}
+			return quoted + "\"";
+		}
+
+		bool ParseUInt(std::string_view text, uint32_t &value)
+		{
+			const char *end = text.data() + text.size();
+			auto [pointer, error] = std::from_chars(text.data(), end, value);
+			return error == std::errc() && pointer == end;
+		}
+	}
+
+	bool ParseSceneSettings(std::string_view text, SceneSettings &settings)
+	{
+		while (!text.empty()) {
+			size_t comma = text.find(',');
+			std::string_view item = text.substr(0, comma);
+			text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+			if (item.empty()) {
+				continue;
+			}
+
+			size_t equal = item.find('=');
+			if (equal == std::string_view::npos) {
+				return false;
+			}
+			std::string_view key = item.substr(0, equal);
+			std::string_view value = item.substr(equal + 1);
+			if (key == "name") {
+				settings.name = value;
+			} else if (key == "out") {
+				settings.outputPath = value;
+			} else if (key == "sprites") {
+				if (!ParseUInt(value, settings.spriteCount)) { return false; }
+			} else if (key == "particles") {
+				if (!ParseUInt(value, settings.particleCount)) { return false; }
+			} else if (key == "objects") {
+				if (!ParseUInt(value, settings.objectCount)) { return false; }
+			} else if (key == "lights") {
+				if (!ParseUInt(value, settings.lightCount)) { return false; }
+			} else if (key == "textures") {
+				if (!ParseUInt(value, settings.textureCount) || settings.textureCount == 0) { return false; }
+			} else if (key == "frames") {
+				if (!ParseUInt(value, settings.frameCount)) { return false; }
+			} else if (key == "seed") {
+				if (!ParseUInt(value, settings.seed)) { return false; }
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const char *GetSceneZoneName(SceneZone zone)
+	{
+		switch (zone) {
+		case SceneZone::Simulation: return "Simulation";
+		case SceneZone::Particles: return "Particles";
+		case SceneZone::Objects: return "Objects";
+		case SceneZone::Lights: return "Lights";
+		case SceneZone::Collect: return "Collect";
+		case SceneZone::Render: return "Render";
+		default: return "Unknown";
+		}
+	}
+
+	StressScene::StressScene()
+		: motionQuery_(world_), spriteQuery_(world_)
+	{
+	}
+
+	void StressScene::Initialize(const SceneSettings &settings, std::span<const uint32_t> textureIndices, const math::Vector2 &screenSize)
+	{
+		assert(!textureIndices.empty());
+		settings_ = settings;
+		textureIndices_.assign(textureIndices.begin(), textureIndices.end());
+		screenSize_ = screenSize;
+		random_.seed(settings.seed);
+		time_ = 0.0f;
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// スプライト: 画面内に散らばり、端で跳ね返りながら回る
+		for (uint32_t i = 0; i < settings_.spriteCount; ++i) {
+			ecs::Transform2DComponent transform;
+			transform.size = { 16.0f + unit(random_) * 48.0f, 16.0f + unit(random_) * 48.0f };
+			transform.position = { unit(random_) * (screenSize_.x - transform.size.x), unit(random_) * (screenSize_.y - transform.size.y) };
+			transform.rotation = unit(random_) * 2.0f * std::numbers::pi_v<float>;
+			ecs::SpriteComponent sprite;
+			sprite.color = { unit(random_),unit(random_),unit(random_),1.0f };
+			MotionComponent motion;
+			float angle = unit(random_) * 2.0f * std::numbers::pi_v<float>;
+			float speed = 30.0f + unit(random_) * 170.0f;
+			motion.velocity = { std::cos(angle) * speed, std::sin(angle) * speed };
+			motion.angularVelocity = (unit(random_) * 2.0f - 1.0f) * 3.0f;
+			motion.textureIndex = textureIndices_[random_() % textureIndices_.size()];
+			world_.CreateEntity(transform, sprite, motion);
+		}
+
+		scheduler_.AddSystem({
+			"Motion",
+			0,
+			ecs::MakeComponentMask<ecs::Transform2DComponent, MotionComponent>(),
+			[this](ecs::World &, float deltaTime) {
+				math::Vector2 screenSize = screenSize_;
+				motionQuery_.ParallelForEach([deltaTime, screenSize](ecs::Entity, ecs::Transform2DComponent &transform, MotionComponent &motion) {
+					transform.position.x += motion.velocity.x * deltaTime;
+					transform.position.y += motion.velocity.y * deltaTime;
+					transform.rotation += motion.angularVelocity * deltaTime;
+					// 画面の端で跳ね返る
+					if (transform.position.x < 0.0f || transform.position.x + transform.size.x > screenSize.x) {
+						motion.velocity.x = -motion.velocity.x;
+						transform.position.x = std::clamp(transform.position.x, 0.0f, (std::max)(screenSize.x - transform.size.x, 0.0f));
+					}
+					if (transform.position.y < 0.0f || transform.position.y + transform.size.y > screenSize.y) {
+						motion.velocity.y = -motion.velocity.y;
+						transform.position.y = std::clamp(transform.position.y, 0.0f, (std::max)(screenSize.y - transform.size.y, 0.0f));
+					}
+					});
+			}
+			});
+		scheduler_.Build();
+
+		// パーティクル: 発生源から噴き出して重力で落ちる。寿命は最初からばらつかせておく
+		particles_.positions.resize(settings_.particleCount);
+		particles_.velocities.resize(settings_.particleCount);
+		particles_.lifetimes.resize(settings_.particleCount);
+		particles_.colors.resize(settings_.particleCount);
+		for (uint32_t i = 0; i < settings_.particleCount; ++i) {
+			EmitParticle(i);
+			particles_.lifetimes[i] = unit(random_) * kParticleLifetime;
+		}
+
+		// 3Dの物体: 手前の壁の奥まで散らばり、その場で回る
+		objects_.resize(settings_.objectCount);
+		for (Object &object : objects_) {
+			object.position = { (unit(random_) * 2.0f - 1.0f) * 60.0f, unit(random_) * 4.0f, 5.0f + unit(random_) * 95.0f };
+			object.rotation = unit(random_) * 2.0f * std::numbers::pi_v<float>;
+			object.angularVelocity = (unit(random_) * 2.0f - 1.0f) * 2.0f;
+			object.halfSize = 0.2f + unit(random_) * 0.8f;
+		}
+		objectBoxes_.resize(objects_.size());
+		objectVisible_.resize(objects_.size());
+		walls_.clear();
+		if (!objects_.empty()) {
+			for (uint32_t i = 0; i < 16; ++i) {
+				math::Vector3 position = { (unit(random_) * 2.0f - 1.0f) * 40.0f, 4.0f, 15.0f + unit(random_) * 30.0f };
+				walls_.push_back(math::MakeAffineMatrix({ 10.0f + unit(random_) * 10.0f, 8.0f, 1.0f }, math::Vector3 { 0.0f, 0.0f, 0.0f }, position));
+			}
+			occlusionCuller_.Initialize();
+		}
+		math::Matrix4x4 camera = math::MakeAffineMatrix({ 1.0f,1.0f,1.0f }, math::Vector3 { 0.1f, 0.0f, 0.0f }, { 0.0f, 3.0f, -5.0f });
+		objectViewProjection_ = math::Multiply(math::Inverse(camera), math::MakePerspectiveFovMatrix(0.9f, 16.0f / 9.0f, 0.1f, 200.0f));
+
+		// ライト: 視錐台の中で円を描いて動く
+		pointLights_.resize(settings_.lightCount);
+		lightPhases_.resize(settings_.lightCount);
+		for (uint32_t i = 0; i < settings_.lightCount; ++i) {
+			light::PointLight &point = pointLights_[i];
+			point = {};
+			point.color = { unit(random_),unit(random_),unit(random_),1.0f };
+			point.position = { 0.0f, 0.0f, 1.0f + 99.0f * unit(random_) };
+			point.intensity = 1.0f;
+			point.radius = 0.5f + 2.5f * unit(random_);
+			point.decay = 1.0f;
+			lightPhases_[i] = unit(random_) * 2.0f * std::numbers::pi_v<float>;
+		}
+		if (!pointLights_.empty()) {
+			lightCuller_.Initialize({});
+		}
+	}
+
+	void StressScene::EmitParticle(uint32_t index)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		uint32_t emitter = index % kEmitterCount;
+		particles_.positions[index] = { screenSize_.x * (float(emitter) + 0.5f) / float(kEmitterCount), screenSize_.y * 0.75f };
+		particles_.velocities[index] = { (unit(random_) * 2.0f - 1.0f) * 80.0f, -(200.0f + unit(random_) * 200.0f) };
+		particles_.lifetimes[index] = kParticleLifetime;
+		particles_.colors[index] = { 1.0f, 0.5f + 0.5f * unit(random_), 0.2f * unit(random_), 1.0f };
+	}
+
+	void StressScene::Update(render::RenderPacket &packet, SceneResult &result)
+	{
+		time_ += kDeltaTime;
+
+		// スプライト用カメラと平行光源(main.cppのデモと同じ)
+		packet.spriteCamera.view = math::MakeIdentity4x4();
+		packet.spriteCamera.projection = math::MakeOrthographicMatrix(0.0f, 0.0f, screenSize_.x, screenSize_.y, 0.0f, 100.0f);
+		packet.directionalLight = { { 1.0f,1.0f,1.0f,1.0f },{ 0.0f,-1.0f,0.0f },1.0f };
+
+		{
+			ZoneTimer timer(result, SceneZone::Simulation);
+			scheduler_.Run(world_, kDeltaTime);
+		}
+		{
+			ZoneTimer timer(result, SceneZone::Collect);
+			CollectSprites(packet);
+		}
+		{
+			ZoneTimer timer(result, SceneZone::Particles);
+			UpdateParticles(packet);
+		}
+		{
+			ZoneTimer timer(result, SceneZone::Objects);
+			UpdateObjects(result);
+		}
+		{
+			ZoneTimer timer(result, SceneZone::Lights);
+			UpdateLights(result);
+		}
+	}
+
+	void StressScene::UpdateParticles(render::RenderPacket &packet)
+	{
+		uint32_t count = settings_.particleCount;
+		if (count == 0) {
+			return;
+		}
+
+		// 移動は粒ごとに独立なので並列に進める
+		JobSystem::GetInstance()->ParallelFor(count, 1024, [this](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; ++i) {
+				particles_.velocities[i].y += kGravity * kDeltaTime;
+				particles_.positions[i].x += particles_.velocities[i].x * kDeltaTime;
+				particles_.positions[i].y += particles_.velocities[i].y * kDeltaTime;
+				particles_.lifetimes[i] -= kDeltaTime;
+			}
+			});
+
+		// 出し直しは乱数の順序を保つために1つのスレッドで行う
+		for (uint32_t i = 0; i < count; ++i) {
+			if (particles_.lifetimes[i] <= 0.0f) {
+				EmitParticle(i);
+			}
+		}
+
+		// 寿命に合わせて薄くしながらパケットに積む
+		size_t first = packet.sprites.size();
+		packet.sprites.resize(first + count);
+		uint32_t textureIndex = textureIndices_[0];
+		for (uint32_t i = 0; i < count; ++i) {
+			math::Vector4 color = particles_.colors[i];
+			color.w = particles_.lifetimes[i] / kParticleLifetime;
+			packet.sprites[first + i] = MakeSpriteInstance(particles_.positions[i], 0.0f, { kParticleSize,kParticleSize }, color, textureIndex);
+		}
+	}
+
+	void StressScene::UpdateObjects(SceneResult &result)
+	{
+		if (objects_.empty()) {
+			return;
+		}
+
+		// 回転させた箱を囲むAABB(Y軸回りの回転なので水平方向だけ広げる)
+		for (size_t i = 0; i < objects_.size(); ++i) {
+			Object &object = objects_[i];
+			object.rotation += object.angularVelocity * kDeltaTime;
+			float extent = object.halfSize * (std::abs(std::cos(object.rotation)) + std::abs(std::sin(object.rotation)));
+			objectBoxes_[i].min = { object.position.x - extent, object.position.y - object.halfSize, object.position.z - extent };
+			objectBoxes_[i].max = { object.position.x + extent, object.position.y + object.halfSize, object.position.z + extent };
+		}
+
+		occlusionCuller_.BeginFrame(objectViewProjection_);
+		for (const math::Matrix4x4 &wall : walls_) {
+			occlusionCuller_.AddOccluder(kBoxPositions, kBoxIndices, wall);
+		}
+		occlusionCuller_.Rasterize();
+		occlusionCuller_.TestVisibility(objectBoxes_, objectVisible_);
+		const render::OcclusionStatistics &statistics = occlusionCuller_.GetStatistics();
+		result.visibleObjectCount += statistics.testedCount - statistics.culledCount;
+	}
+
+	void StressScene::UpdateLights(SceneResult &result)
+	{
+		if (pointLights_.empty()) {
+			return;
+		}
+
+		// 深度ごとの視野の広さに合わせた円を描く
+		for (size_t i = 0; i < pointLights_.size(); ++i) {
+			light::PointLight &point = pointLights_[i];
+			float angle = lightPhases_[i] + time_;
+			point.position.x = std::cos(angle) * point.position.z * 0.6f;
+			point.position.y = std::sin(angle) * point.position.z * 0.35f;
+		}
+		lightCuller_.Cull(math::MakeIdentity4x4(), pointLights_, {});
+		result.lightReferenceCount += lightCuller_.GetLightIndices().size();
+	}
+
+	void StressScene::CollectSprites(render::RenderPacket &packet)
+	{
+		packet.sprites.reserve(packet.sprites.size() + spriteQuery_.Count() + settings_.particleCount);
+		spriteQuery_.ForEach([&packet](ecs::Entity, ecs::Transform2DComponent &transform, ecs::SpriteComponent &sprite, MotionComponent &motion) {
+			packet.sprites.push_back(MakeSpriteInstance(transform.position, transform.rotation, transform.size, sprite.color, motion.textureIndex));
+			});
+	}
+
+	SceneResult RunSceneHeadless(const SceneSettings &requestedSettings)
+	{
+		// スプライトとパーティクルの合計が1フレームに描ける数に収まるように減らす(WinMainと同じ)
+		SceneSettings settings = requestedSettings;
+		settings.particleCount = (std::min)(settings.particleCount, render::SpriteBatchBuilder::kMaxSprites);
+		settings.spriteCount = (std::min)(settings.spriteCount, render::SpriteBatchBuilder::kMaxSprites - settings.particleCount);
+
+		SceneResult result;
+		result.settings = settings;
+		result.frameMilliseconds.reserve(settings.frameCount);
+
+		// テクスチャは番号だけ(Nullの再生先はディスクリプタを引かない)
+		std::vector<uint32_t> textureIndices(settings.textureCount);
+		for (uint32_t i = 0; i < settings.textureCount; ++i) {
+			textureIndices[i] = i;
+		}
+		StressScene scene;
+		scene.Initialize(settings, textureIndices, { 1280.0f,720.0f });
+
+		render::NullCommandBackend backend;
+		NullSpriteRenderer renderer(backend);
+		render::RenderPacket packet;
+		for (uint32_t frame = 0; frame < settings.frameCount; ++frame) {
+			auto start = std::chrono::steady_clock::now();
+			packet.Clear();
+			packet.frameNumber = frame;
+			scene.Update(packet, result);
+			{
+				ZoneTimer timer(result, SceneZone::Render);
+				renderer.Draw(packet, result);
+			}
+			// フレーム内の一時データをまとめて巻き戻す(ジョブは全て完了している)
+			uint64_t arenaOverflowCount = FrameArena::ResetAll();
+			if (frame > 0) {
+				result.arenaOverflowCount += arenaOverflowCount;
+			}
+			result.frameMilliseconds.push_back(ElapsedMilliseconds(start));
+		}
+		result.invalidCommandCount = backend.GetInvalidCommandCount();
+		return result;
+	}
+
+	void LogSceneResult(const SceneResult &result, std::ostream &os)
+	{
+		std::vector<double> sorted = result.frameMilliseconds;
+		std::sort(sorted.begin(), sorted.end());
+		double frameCount = static_cast<double>((std::max)(sorted.size(), size_t(1)));
+		const SceneSettings &settings = result.settings;
+		Logger::Log(os, std::format("[Scene] {} sprites:{} particles:{} objects:{} lights:{} frames:{} seed:{} headless:{}",
+			settings.name, settings.spriteCount, settings.particleCount, settings.objectCount, settings.lightCount, sorted.size(), settings.seed, settings.headless));
+		Logger::Log(os, std::format("[Scene] frame p50:{:.3f}ms p90:{:.3f}ms p99:{:.3f}ms max:{:.3f}ms draws/frame:{:.1f} upload/frame:{:.1f}KB",
+			Percentile(sorted, 0.5), Percentile(sorted, 0.9), Percentile(sorted, 0.99), sorted.empty() ? 0.0 : sorted.back(),
+			static_cast<double>(result.drawCallCount) / frameCount, static_cast<double>(result.uploadBytes) / frameCount / 1024.0));
+		Logger::Log(os, std::format("[Scene] frame arena heap allocations after the first frame: {}", result.arenaOverflowCount));
+		Logger::Log(os, std::format("[Scene] sprite quads dropped by the batch: {}", result.droppedQuadCount));
+		for (uint32_t zone = 0; zone < static_cast<uint32_t>(SceneZone::Count); ++zone) {
+			Logger::Log(os, std::format("[Scene] zone {}: {:.3f}ms/frame", GetSceneZoneName(static_cast<SceneZone>(zone)), result.zoneMilliseconds[zone] / frameCount));
+		}
+	}
+
+	bool WriteSceneResult(const SceneResult &result, const std::string &filePath)
+	{
+		std::ofstream file(filePath);
+		if (!file) {
+			return false;
+		}
+
+		std::vector<double> sorted = result.frameMilliseconds;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		for (double milliseconds : sorted) {
+			total += milliseconds;
+		}
+		double frameCount = static_cast<double>((std::max)(sorted.size(), size_t(1)));
+		const SceneSettings &settings = result.settings;
+
+		file << "{\n";
+		file << std::format("  \"scene\": {{ \"name\": {}, \"sprites\": {}, \"particles\": {}, \"objects\": {}, \"lights\": {}, \"textures\": {}, \"seed\": {}, \"headless\": {} }},\n",
+			QuoteJson(settings.name), settings.spriteCount, settings.particleCount, settings.objectCount, settings.lightCount, settings.textureCount, settings.seed, settings.headless);
+		file << std::format("  \"frames\": {},\n", sorted.size());
+		file << std::format("  \"frameTimeMs\": {{ \"mean\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }},\n",
+			total / frameCount, Percentile(sorted, 0.5), Percentile(sorted, 0.9), Percentile(sorted, 0.99), sorted.empty() ? 0.0 : sorted.back());
+		file << "  \"zonesMsPerFrame\": {";
+		for (uint32_t zone = 0; zone < static_cast<uint32_t>(SceneZone::Count); ++zone) {
+			file << std::format("{} {}: {:.4f}", zone == 0 ? "" : ",", QuoteJson(GetSceneZoneName(static_cast<SceneZone>(zone))), result.zoneMilliseconds[zone] / frameCount);
+		}
+		file << " },\n";
+		file << std::format("  \"drawCalls\": {{ \"total\": {}, \"perFrame\": {:.2f} }},\n", result.drawCallCount, static_cast<double>(result.drawCallCount) / frameCount);
+		file << std::format("  \"uploadBytes\": {{ \"total\": {}, \"perFrame\": {:.1f} }},\n", result.uploadBytes, static_cast<double>(result.uploadBytes) / frameCount);
+		file << std::format("  \"visibleObjectsPerFrame\": {:.2f},\n", static_cast<double>(result.visibleObjectCount) / frameCount);
+		file << std::format("  \"lightReferencesPerFrame\": {:.2f},\n", static_cast<double>(result.lightReferenceCount) / frameCount);
+		file << std::format("  \"invalidCommands\": {},\n", result.invalidCommandCount);
+		file << std::format("  \"droppedQuads\": {},\n", result.droppedQuadCount);
+		file << std::format("  \"arenaHeapAllocations\": {}\n", result.arenaOverflowCount);
+		file << "}\n";
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ECS.h"
+#include "Components.h"
+#include "LightCulling.h"
+#include "OcclusionCulling.h"
+#include "RenderPacket.h"
+
+// 計測用のシーン
+// コマンドライン引数 -scene で起動したときに、スプライト・パーティクル・3Dの物体・ライトの数を指定したシーンを
+// 決まったフレーム数だけ回し、フレーム時間の分布、CPUの区間ごとの時間、描画コール数、アップロード量をJSONに書き出す
+// 乱数はシードから作り、1フレームは常に1/60秒進めるので、同じ設定なら毎回同じシーンになる
+namespace Benchmark
+{
+	// シーンの設定
+	struct SceneSettings
+	{
+		std::string name = "stress";
+		uint32_t spriteCount = 1000;
+		uint32_t particleCount = 0;
+		uint32_t objectCount = 0; //!< 3Dの物体(描画の経路が無いので、更新とオクルージョンカリングまで)
+		uint32_t lightCount = 0; //!< ポイントライト(クラスタへの割り当てまで)
+		uint32_t textureCount = 2; //!< ヘッドレスで使うテクスチャ数(ウィンドウありでは読み込んだテクスチャを使う)
+		uint32_t frameCount = 300;
+		uint32_t seed = 1;
+		bool headless = false; //!< D3Dを使わず、描画コマンドをNullCommandBackendに流す
+		std::string outputPath = "logs/scene.json";
+	};
+
+	/// <summary>
+	/// "sprites=1000,particles=2000,objects=500,lights=256,frames=600,seed=7" の形式の設定を読む
+	/// 他に name, textures, out(JSONの出力先)を指定できる。知らないキーや不正な値があればfalse
+	/// </summary>
+	bool ParseSceneSettings(std::string_view text, SceneSettings &settings);
+
+	// CPUの計測区間
+	enum class SceneZone : uint32_t
+	{
+		Simulation, //!< スプライトの移動(ECS)
+		Particles,
+		Objects, //!< 3Dの物体の更新とオクルージョンカリング
+		Lights, //!< ライトの移動とクラスタへの割り当て
+		Collect, //!< 描画パケットへのスプライトの書き込み
+		Render, //!< ヘッドレスでは描画コマンドの作成、ウィンドウありでは描画スレッドとの受け渡し
+		Count,
+	};
+	const char *GetSceneZoneName(SceneZone zone);
+
+	// 計測結果(区間・描画コール・アップロードは全フレームの合計)
+	struct SceneResult
+	{
+		SceneSettings settings;
+		std::vector<double> frameMilliseconds;
+		std::array<double, static_cast<size_t>(SceneZone::Count)> zoneMilliseconds {};
+		uint64_t drawCallCount = 0;
+		uint64_t uploadBytes = 0;
+		uint64_t droppedQuadCount = 0; //!< バッチに入りきらずに描かなかった四角形(0であること)
+		uint64_t visibleObjectCount = 0;
+		uint64_t lightReferenceCount = 0; //!< クラスタに割り当てたライトの参照数
+		uint32_t invalidCommandCount = 0; //!< NullCommandBackendが不正とみなしたコマンド(ヘッドレスのみ)
+		uint64_t arenaOverflowCount = 0; //!< 最初のフレームを除いて、フレームアリーナが溢れてヒープから確保した回数(0であること)
+	};
+
+	class StressScene
+	{
+	public: // メンバ関数
+		StressScene();
+
+		/// <summary>
+		/// 初期化(シードからシーンを組み立てる)
+		/// </summary>
+		/// <param name="textureIndices">スプライトに割り当てるテクスチャ番号の候補</param>
+		/// <param name="screenSize">スプライトを動かす範囲</param>
+		void Initialize(const SceneSettings &settings, std::span<const uint32_t> textureIndices, const math::Vector2 &screenSize);
+
+		// 1フレーム進めて描画パケットにカメラ・ライト・スプライトを書き込む(区間の時間をresultに足す)
+		void Update(render::RenderPacket &packet, SceneResult &result);
+
+	private:
+		// スプライトの動き
+		struct MotionComponent
+		{
+			math::Vector2 velocity;
+			float angularVelocity;
+			uint32_t textureIndex;
+		};
+
+		// パーティクル(SoA)
+		struct Particles
+		{
+			std::vector<math::Vector2> positions;
+			std::vector<math::Vector2> velocities;
+			std::vector<float> lifetimes; //!< 残り秒数
+			std::vector<math::Vector4> colors;
+		};
+
+		// 3Dの物体
+		struct Object
+		{
+			math::Vector3 position;
+			float rotation;
+			float angularVelocity;
+			float halfSize;
+		};
+
+		// パーティクルを発生源から出し直す
+		void EmitParticle(uint32_t index);
+
+		void UpdateParticles(render::RenderPacket &packet);
+		void UpdateObjects(SceneResult &result);
+		void UpdateLights(SceneResult &result);
+		void CollectSprites(render::RenderPacket &packet);
+
+		SceneSettings settings_;
+		std::vector<uint32_t> textureIndices_;
+		math::Vector2 screenSize_ {};
+		std::mt19937 random_;
+
+		ecs::World world_;
+		ecs::SystemScheduler scheduler_;
+		ecs::Query<ecs::Transform2DComponent, MotionComponent> motionQuery_;
+		ecs::Query<ecs::Transform2DComponent, ecs::SpriteComponent, MotionComponent> spriteQuery_;
+
+		Particles particles_;
+
+		std::vector<Object> objects_;
+		std::vector<render::BoundingBox> objectBoxes_;
+		std::vector<uint8_t> objectVisible_;
+		std::vector<math::Matrix4x4> walls_;
+		math::Matrix4x4 objectViewProjection_ {};
+		render::OcclusionCuller occlusionCuller_;
+
+		std::vector<light::PointLight> pointLights_;
+		std::vector<float> lightPhases_;
+		light::LightCuller lightCuller_;
+
+		// 経過時間(1フレーム1/60秒で進める)
+		float time_ = 0.0f;
+	};
+
+	// D3Dを使わずにシーンを回す。描画はSpriteRendererと同じ手順のコマンドをNullCommandBackendに流して数える
+	SceneResult RunSceneHeadless(const SceneSettings &settings);
+
+	// 結果をログに出す
+	void LogSceneResult(const SceneResult &result, std::ostream &os);
+
+	// 結果をJSONで書き出す(書けなければfalse)
+	bool WriteSceneResult(const SceneResult &result, const std::string &filePath);
+}
@@ -0,0 +1,27 @@
+#include "Benchmark.h"
+#include "Logger.h"
+#include "ShaderPermutation.h"
+#include "SpriteCommon.h"
+#include <format>
+#include <vector>
+
+// D3DとDXCを使う計測(Windowsでのみビルドする。他の計測はBenchmark.cpp)
+namespace Benchmark
+{
+	void RunShaderBuild(std::ostream &os, DirectXCommon *dxCommon, uint32_t threadCount)
+	{
+		// 機能の全ての組み合わせのパイプラインを起動時と同じ経路で作る
+		// (変種を並列にコンパイルし、そろったものからルートシグネチャとPSOを作る。頂点シェーダーは頂点カラーの有無の2種類に重複が除かれる)
+		// スプライト共通部は毎回作り直し、シェーダーのキャッシュもルートシグネチャも空から始める
+		std::vector<render::ShaderFeatureMask> featuresList;
+		for (render::ShaderFeatureMask features = 0; features <= render::kAllShaderFeatures; ++features) {
+			featuresList.push_back(features);
+		}
+		SpriteCommon spriteCommon;
+		spriteCommon.Initialize(dxCommon, threadCount, featuresList);
+
+		Logger::Log(os, std::format("[ShaderBuild] threads:{} shaders:{} pipelines:{} rootSignatures:{} time:{:.3f}ms",
+			threadCount, spriteCommon.GetBuildShaderCount(), spriteCommon.GetPipelineCount(), spriteCommon.GetRootSignatureCount(),
+			spriteCommon.GetBuildMilliseconds()));
+	}
+}
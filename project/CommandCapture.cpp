@@ -0,0 +1,229 @@
+#include "CommandCapture.h"
+#include <cassert>
+
+namespace render
+{
+	CommandCapture *CommandCapture::instance = nullptr;
+
+	CommandCapture *CommandCapture::GetInstance()
+	{
+		if (instance == nullptr) {
+			instance = new CommandCapture;
+		}
+		return instance;
+	}
+
+	void CommandCapture::Finalize()
+	{
+		// 描画スレッドは止まっているので、書きかけのフレームは捨ててファイルを閉じる
+		if (file_.is_open()) {
+			file_.close();
+		}
+
+		delete instance;
+		instance = nullptr;
+	}
+
+	bool CommandCapture::Start(const std::string &filePath, uint32_t frameCount, bool includeUploadData)
+	{
+		if (frameCount == 0) {
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(requestMutex_);
+		requestedPath_ = filePath;
+		requestedFrameCount_ = frameCount;
+		requestedUploadData_ = includeUploadData;
+		requested_.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void CommandCapture::BeginFrame(uint64_t frameNumber)
+	{
+		// 要求があればファイルを開いて記録を始める
+		if (!file_.is_open() && requested_.exchange(false, std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lock(requestMutex_);
+			file_.open(requestedPath_, std::ios::binary);
+			if (file_.is_open()) {
+				const char version[4] = {
+					static_cast<char>(kCaptureVersion & 0xFF), static_cast<char>((kCaptureVersion >> 8) & 0xFF),
+					static_cast<char>((kCaptureVersion >> 16) & 0xFF), static_cast<char>(kCaptureVersion >> 24) };
+				file_.write(kCaptureMagic, sizeof(kCaptureMagic));
+				file_.write(version, sizeof(version));
+				remainingFrameCount_ = requestedFrameCount_;
+				includeUploadData_ = requestedUploadData_;
+				objectIds_.clear();
+			}
+		}
+		if (!file_.is_open()) {
+			return;
+		}
+
+		recording_ = true;
+		frameBuffer_.clear();
+		WriteCommand(CaptureCommand::BeginFrame);
+		WriteUint64(frameNumber);
+	}
+
+	void CommandCapture::EndFrame()
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::EndFrame);
+
+		// フレーム単位でまとめて書き出す(途中で止まってもフレームの途中で切れない)
+		file_.write(reinterpret_cast<const char *>(frameBuffer_.data()), static_cast<std::streamsize>(frameBuffer_.size()));
+		recording_ = false;
+		if (--remainingFrameCount_ == 0) {
+			file_.close();
+		}
+	}
+
+	void CommandCapture::BeginPass(std::string_view name)
+	{
+		if (!recording_) {
+			return;
+		}
+		assert(name.size() <= 255);
+		uint8_t length = static_cast<uint8_t>(name.size() < 255 ? name.size() : 255);
+		WriteCommand(CaptureCommand::BeginPass);
+		WriteBytes(&length, 1);
+		WriteBytes(name.data(), length);
+	}
+
+	void CommandCapture::EndPass()
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::EndPass);
+	}
+
+	void CommandCapture::Clear()
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::Clear);
+	}
+
+	void CommandCapture::SetRootSignature(const void *rootSignature)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::SetRootSignature);
+		WriteUint32(GetObjectId(rootSignature));
+	}
+
+	void CommandCapture::SetPipelineState(const void *pipelineState)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::SetPipelineState);
+		WriteUint32(GetObjectId(pipelineState));
+	}
+
+	void CommandCapture::SetRootConstantBuffer(uint32_t slot, const void *buffer, uint32_t offset)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::SetRootConstantBuffer);
+		WriteUint32(slot);
+		WriteUint32(GetObjectId(buffer));
+		WriteUint32(offset);
+	}
+
+	void CommandCapture::SetRootDescriptorTable(uint32_t slot, uint32_t descriptorIndex)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::SetRootDescriptorTable);
+		WriteUint32(slot);
+		WriteUint32(descriptorIndex);
+	}
+
+	void CommandCapture::SetVertexBuffer(const void *buffer, uint32_t offset, uint32_t size, uint32_t stride)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::SetVertexBuffer);
+		WriteUint32(GetObjectId(buffer));
+		WriteUint32(offset);
+		WriteUint32(size);
+		WriteUint32(stride);
+	}
+
+	void CommandCapture::SetIndexBuffer(const void *buffer, uint32_t size)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::SetIndexBuffer);
+		WriteUint32(GetObjectId(buffer));
+		WriteUint32(size);
+	}
+
+	void CommandCapture::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::DrawIndexed);
+		WriteUint32(indexCount);
+		WriteUint32(instanceCount);
+		WriteUint32(startIndex);
+		WriteUint32(static_cast<uint32_t>(baseVertex));
+	}
+
+	void CommandCapture::Upload(const void *buffer, uint32_t offset, const void *data, uint32_t size)
+	{
+		if (!recording_) {
+			return;
+		}
+		WriteCommand(CaptureCommand::Upload);
+		WriteUint32(GetObjectId(buffer));
+		WriteUint32(offset);
+		WriteUint32(size);
+		uint8_t hasData = (includeUploadData_ && data != nullptr) ? 1 : 0;
+		WriteBytes(&hasData, 1);
+		if (hasData) {
+			WriteBytes(data, size);
+		}
+	}
+
+	uint32_t CommandCapture::GetObjectId(const void *object)
+	{
+		auto result = objectIds_.emplace(object, static_cast<uint32_t>(objectIds_.size()));
+		return result.first->second;
+	}
+
+	void CommandCapture::WriteCommand(CaptureCommand command)
+	{
+		frameBuffer_.push_back(static_cast<uint8_t>(command));
+	}
+
+	void CommandCapture::WriteUint32(uint32_t value)
+	{
+		// エンディアンに依らないよう1バイトずつ書く
+		for (uint32_t shift = 0; shift < 32; shift += 8) {
+			frameBuffer_.push_back(static_cast<uint8_t>(value >> shift));
+		}
+	}
+
+	void CommandCapture::WriteUint64(uint64_t value)
+	{
+		WriteUint32(static_cast<uint32_t>(value));
+		WriteUint32(static_cast<uint32_t>(value >> 32));
+	}
+
+	void CommandCapture::WriteBytes(const void *data, size_t size)
+	{
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+		frameBuffer_.insert(frameBuffer_.end(), bytes, bytes + size);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 描画コマンドのキャプチャ
+// 描画スレッドが積んだコマンドとアップロードしたデータを、D3Dに依存しない小さなバイナリ形式でファイルに書き出す。
+// 重いフレームを後からCommandReplayで再生し、パスごとのコマンド数・バイト数・CPU時間を調べる
+//
+// ファイルの形式(数値は全てリトルエンディアン)
+//   ヘッダ: "GE3C" + uint32 バージョン
+//   レコード: uint8 種類 + 種類ごとの固定長の値(Uploadはデータ、BeginPassは名前が続く)
+// D3Dのオブジェクトはキャプチャ内で振った通し番号(オブジェクトID)で表す
+namespace render
+{
+	// コマンドの種類
+	enum class CaptureCommand : uint8_t
+	{
+		BeginFrame, //!< uint64 フレーム番号
+		EndFrame,
+		BeginPass, //!< uint8 名前の長さ + 名前
+		EndPass,
+		Clear, //!< レンダーターゲット・深度のクリア
+		SetRootSignature, //!< uint32 オブジェクトID
+		SetPipelineState, //!< uint32 オブジェクトID
+		SetRootConstantBuffer, //!< uint32 スロット, uint32 バッファのオブジェクトID, uint32 オフセット
+		SetRootDescriptorTable, //!< uint32 スロット, uint32 ディスクリプタ番号
+		SetVertexBuffer, //!< uint32 バッファのオブジェクトID, uint32 オフセット, uint32 サイズ, uint32 ストライド
+		SetIndexBuffer, //!< uint32 バッファのオブジェクトID, uint32 サイズ
+		DrawIndexed, //!< uint32 インデックス数, uint32 インスタンス数, uint32 開始インデックス, int32 ベース頂点
+		Upload, //!< uint32 バッファのオブジェクトID, uint32 オフセット, uint32 サイズ, uint8 データの有無 + データ
+		Count,
+	};
+
+	// ファイルの先頭
+	constexpr char kCaptureMagic[4] = { 'G','E','3','C' };
+	constexpr uint32_t kCaptureVersion = 1;
+
+	class CommandCapture
+	{
+	public: // メンバ関数
+		// シングルトンインスタンスの取得
+		static CommandCapture *GetInstance();
+		// 終了(キャプチャ中なら書きかけのファイルを閉じる)
+		void Finalize();
+
+		/// <summary>
+		/// キャプチャを始める。次のBeginFrameからframeCountフレーム分を書き出す(どのスレッドから呼んでもよい)
+		/// </summary>
+		/// <param name="includeUploadData">アップロードしたデータの中身も書き出すか(falseならサイズだけ)</param>
+		bool Start(const std::string &filePath, uint32_t frameCount, bool includeUploadData = true);
+
+		// キャプチャ中のフレームか(記録の関数はキャプチャ中でなければ何もしないので、呼び出し側で確かめなくてよい)
+		bool IsRecording() const { return recording_; }
+
+		// 以下は描画スレッドから呼ぶ
+		void BeginFrame(uint64_t frameNumber);
+		void EndFrame();
+		void BeginPass(std::string_view name);
+		void EndPass();
+		void Clear();
+		void SetRootSignature(const void *rootSignature);
+		void SetPipelineState(const void *pipelineState);
+		void SetRootConstantBuffer(uint32_t slot, const void *buffer, uint32_t offset);
+		void SetRootDescriptorTable(uint32_t slot, uint32_t descriptorIndex);
+		void SetVertexBuffer(const void *buffer, uint32_t offset, uint32_t size, uint32_t stride);
+		void SetIndexBuffer(const void *buffer, uint32_t size);
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex);
+		// data がnullptrならサイズだけ記録する
+		void Upload(const void *buffer, uint32_t offset, const void *data, uint32_t size);
+
+	private:
+		static CommandCapture *instance;
+
+		CommandCapture() = default;
+		~CommandCapture() = default;
+		CommandCapture(CommandCapture &) = delete;
+		CommandCapture &operator=(CommandCapture &) = delete;
+
+	private:
+		// D3Dのオブジェクトを通し番号にする
+		uint32_t GetObjectId(const void *object);
+
+		void WriteCommand(CaptureCommand command);
+		void WriteUint32(uint32_t value);
+		void WriteUint64(uint64_t value);
+		void WriteBytes(const void *data, size_t size);
+
+		// Startの要求(描画スレッドがBeginFrameで受け取る)
+		std::mutex requestMutex_;
+		std::string requestedPath_;
+		uint32_t requestedFrameCount_ = 0;
+		bool requestedUploadData_ = true;
+		std::atomic<bool> requested_ = false;
+
+		// 以下は描画スレッドだけが触る
+		std::ofstream file_;
+		std::vector<uint8_t> frameBuffer_; //!< 書き出し前の1フレーム分
+		std::unordered_map<const void *, uint32_t> objectIds_;
+		uint32_t remainingFrameCount_ = 0;
+		bool includeUploadData_ = true;
+		bool recording_ = false;
+	};
+}
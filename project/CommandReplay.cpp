@@ -0,0 +1,341 @@
+#include "CommandReplay.h"
+#include <chrono>
+#include <cstring>
+#include <format>
+
+namespace render
+{
+	namespace
+	{
+		// キャプチャのバイト列を先頭から読む(範囲外を読もうとしたら失敗として止める)
+		class CaptureReader
+		{
+		public:
+			explicit CaptureReader(std::span<const uint8_t> bytes) : bytes_(bytes) {}
+
+			bool IsEnd() const { return offset_ >= bytes_.size(); }
+			bool IsFailed() const { return failed_; }
+			size_t GetOffset() const { return offset_; }
+
+			uint8_t ReadUint8()
+			{
+				if (!Require(1)) {
+					return 0;
+				}
+				return bytes_[offset_++];
+			}
+
+			uint32_t ReadUint32()
+			{
+				if (!Require(4)) {
+					return 0;
+				}
+				uint32_t value = 0;
+				for (uint32_t shift = 0; shift < 32; shift += 8) {
+					value |= static_cast<uint32_t>(bytes_[offset_++]) << shift;
+				}
+				return value;
+			}
+
+			uint64_t ReadUint64()
+			{
+				uint64_t low = ReadUint32();
+				uint64_t high = ReadUint32();
+				return low | (high << 32);
+			}
+
+			std::span<const uint8_t> ReadBytes(size_t size)
+			{
+				if (!Require(size)) {
+					return {};
+				}
+				std::span<const uint8_t> result = bytes_.subspan(offset_, size);
+				offset_ += size;
+				return result;
+			}
+
+		private:
+			bool Require(size_t size)
+			{
+				if (failed_ || bytes_.size() - offset_ < size) {
+					failed_ = true;
+					return false;
+				}
+				return true;
+			}
+
+			std::span<const uint8_t> bytes_;
+			size_t offset_ = 0;
+			bool failed_ = false;
+		};
+
+		constexpr size_t kHeaderSize = sizeof(kCaptureMagic) + sizeof(uint32_t);
+	}
+
+	void NullCommandBackend::BeginFrame(uint64_t)
+	{
+		// コマンドリストはフレームごとに作り直すので状態も戻る
+		rootSignature_ = kNone;
+		pipelineState_ = kNone;
+		vertexBuffer_ = kNone;
+		indexBuffer_ = kNone;
+	}
+
+	void NullCommandBackend::SetRootSignature(uint32_t objectId)
+	{
+		rootSignature_ = objectId;
+	}
+
+	void NullCommandBackend::SetPipelineState(uint32_t objectId)
+	{
+		pipelineState_ = objectId;
+	}
+
+	void NullCommandBackend::SetVertexBuffer(uint32_t bufferId, uint32_t, uint32_t, uint32_t)
+	{
+		vertexBuffer_ = bufferId;
+	}
+
+	void NullCommandBackend::SetIndexBuffer(uint32_t bufferId, uint32_t)
+	{
+		indexBuffer_ = bufferId;
+	}
+
+	void NullCommandBackend::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t, int32_t)
+	{
+		if (rootSignature_ == kNone || pipelineState_ == kNone || vertexBuffer_ == kNone || indexBuffer_ == kNone) {
+			++invalidCommandCount_;
+		}
+		indexCount_ += uint64_t(indexCount) * instanceCount;
+	}
+
+	void NullCommandBackend::Upload(uint32_t, uint32_t, uint32_t, std::span<const uint8_t> data)
+	{
+		// 8バイトずつ読むだけ(GPUへの転送の代わりにメモリを一通り触る)
+		size_t offset = 0;
+		for (; offset + sizeof(uint64_t) <= data.size(); offset += sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, data.data() + offset, sizeof(word));
+			checksum_ += word;
+		}
+		for (; offset < data.size(); ++offset) {
+			checksum_ += data[offset];
+		}
+	}
+
+	uint32_t ReplayPassStatistics::GetCommandCount() const
+	{
+		uint32_t count = 0;
+		for (uint32_t commandCount : commandCounts) {
+			count += commandCount;
+		}
+		return count;
+	}
+
+	bool CommandReplay::Load(const std::string &filePath)
+	{
+		file_.Close();
+		if (!file_.Open(filePath)) {
+			return false;
+		}
+		std::span<const std::byte> bytes = file_.GetBytes();
+		if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+			file_.Close();
+			return false;
+		}
+		CaptureReader reader({ reinterpret_cast<const uint8_t *>(bytes.data()) + sizeof(kCaptureMagic), sizeof(uint32_t) });
+		if (reader.ReadUint32() != kCaptureVersion) {
+			file_.Close();
+			return false;
+		}
+		return true;
+	}
+
+	ReplayResult CommandReplay::Run(CommandBackend &backend) const
+	{
+		ReplayResult result;
+		if (!file_.IsOpen()) {
+			return result;
+		}
+		std::span<const std::byte> bytes = file_.GetBytes();
+		CaptureReader reader({ reinterpret_cast<const uint8_t *>(bytes.data()) + kHeaderSize, bytes.size() - kHeaderSize });
+
+		// パスの外のコマンド(フレームの区切りなど)は名前の無いパスに数える
+		auto findPass = [&](std::string_view name) -> size_t {
+			for (size_t i = 0; i < result.passes.size(); ++i) {
+				if (result.passes[i].name == name) {
+					return i;
+				}
+			}
+			result.passes.push_back({});
+			result.passes.back().name = name;
+			return result.passes.size() - 1;
+		};
+		size_t currentPass = findPass("(none)");
+		auto passBegin = std::chrono::steady_clock::now();
+		auto replayBegin = passBegin;
+		// パスの区切りまでの時間を今のパスに足す
+		auto closePass = [&]() {
+			auto now = std::chrono::steady_clock::now();
+			result.passes[currentPass].cpuMilliseconds += std::chrono::duration<double, std::milli>(now - passBegin).count();
+			passBegin = now;
+		};
+
+		while (!reader.IsEnd() && !reader.IsFailed()) {
+			size_t commandBegin = reader.GetOffset();
+			uint8_t type = reader.ReadUint8();
+			if (type >= static_cast<uint8_t>(CaptureCommand::Count)) {
+				break;
+			}
+			CaptureCommand command = static_cast<CaptureCommand>(type);
+
+			switch (command) {
+			case CaptureCommand::BeginFrame:
+				backend.BeginFrame(reader.ReadUint64());
+				break;
+			case CaptureCommand::EndFrame:
+				backend.EndFrame();
+				++result.frameCount;
+				break;
+			case CaptureCommand::BeginPass:
+			{
+				uint8_t length = reader.ReadUint8();
+				std::span<const uint8_t> name = reader.ReadBytes(length);
+				std::string_view passName(reinterpret_cast<const char *>(name.data()), name.size());
+				closePass();
+				currentPass = findPass(passName);
+				++result.passes[currentPass].frameCount;
+				backend.BeginPass(passName);
+				break;
+			}
+			case CaptureCommand::EndPass:
+				backend.EndPass();
+				break;
+			case CaptureCommand::Clear:
+				backend.Clear();
+				break;
+			case CaptureCommand::SetRootSignature:
+				backend.SetRootSignature(reader.ReadUint32());
+				break;
+			case CaptureCommand::SetPipelineState:
+				backend.SetPipelineState(reader.ReadUint32());
+				break;
+			case CaptureCommand::SetRootConstantBuffer:
+			{
+				uint32_t slot = reader.ReadUint32();
+				uint32_t bufferId = reader.ReadUint32();
+				uint32_t offset = reader.ReadUint32();
+				backend.SetRootConstantBuffer(slot, bufferId, offset);
+				break;
+			}
+			case CaptureCommand::SetRootDescriptorTable:
+			{
+				uint32_t slot = reader.ReadUint32();
+				uint32_t descriptorIndex = reader.ReadUint32();
+				backend.SetRootDescriptorTable(slot, descriptorIndex);
+				break;
+			}
+			case CaptureCommand::SetVertexBuffer:
+			{
+				uint32_t bufferId = reader.ReadUint32();
+				uint32_t offset = reader.ReadUint32();
+				uint32_t size = reader.ReadUint32();
+				uint32_t stride = reader.ReadUint32();
+				backend.SetVertexBuffer(bufferId, offset, size, stride);
+				break;
+			}
+			case CaptureCommand::SetIndexBuffer:
+			{
+				uint32_t bufferId = reader.ReadUint32();
+				uint32_t size = reader.ReadUint32();
+				backend.SetIndexBuffer(bufferId, size);
+				break;
+			}
+			case CaptureCommand::DrawIndexed:
+			{
+				uint32_t indexCount = reader.ReadUint32();
+				uint32_t instanceCount = reader.ReadUint32();
+				uint32_t startIndex = reader.ReadUint32();
+				int32_t baseVertex = static_cast<int32_t>(reader.ReadUint32());
+				backend.DrawIndexed(indexCount, instanceCount, startIndex, baseVertex);
+				break;
+			}
+			case CaptureCommand::Upload:
+			{
+				uint32_t bufferId = reader.ReadUint32();
+				uint32_t offset = reader.ReadUint32();
+				uint32_t size = reader.ReadUint32();
+				std::span<const uint8_t> data = reader.ReadUint8() ? reader.ReadBytes(size) : std::span<const uint8_t>();
+				backend.Upload(bufferId, offset, size, data);
+				result.passes[currentPass].uploadBytes += size;
+				break;
+			}
+			default:
+				break;
+			}
+
+			ReplayPassStatistics &pass = result.passes[currentPass];
+			++pass.commandCounts[type];
+			pass.commandBytes += reader.GetOffset() - commandBegin;
+
+			// パスの終わりからは名前の無いパスに戻る
+			if (command == CaptureCommand::EndPass) {
+				closePass();
+				currentPass = findPass("(none)");
+			}
+		}
+		closePass();
+
+		result.valid = reader.IsEnd() && !reader.IsFailed();
+		result.totalMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - replayBegin).count();
+		return result;
+	}
+
+	const char *GetCaptureCommandName(CaptureCommand command)
+	{
+		switch (command) {
+		case CaptureCommand::BeginFrame: return "BeginFrame";
+		case CaptureCommand::EndFrame: return "EndFrame";
+		case CaptureCommand::BeginPass: return "BeginPass";
+		case CaptureCommand::EndPass: return "EndPass";
+		case CaptureCommand::Clear: return "Clear";
+		case CaptureCommand::SetRootSignature: return "SetRootSignature";
+		case CaptureCommand::SetPipelineState: return "SetPipelineState";
+		case CaptureCommand::SetRootConstantBuffer: return "SetRootConstantBuffer";
+		case CaptureCommand::SetRootDescriptorTable: return "SetRootDescriptorTable";
+		case CaptureCommand::SetVertexBuffer: return "SetVertexBuffer";
+		case CaptureCommand::SetIndexBuffer: return "SetIndexBuffer";
+		case CaptureCommand::DrawIndexed: return "DrawIndexed";
+		case CaptureCommand::Upload: return "Upload";
+		default: return "Unknown";
+		}
+	}
+
+	bool ReplayCaptureFile(const std::string &filePath, std::ostream &os)
+	{
+		CommandReplay replay;
+		if (!replay.Load(filePath)) {
+			os << std::format("[Replay] failed to open capture: {}", filePath) << '\n';
+			return false;
+		}
+
+		NullCommandBackend backend;
+		ReplayResult result = replay.Run(backend);
+		os << std::format("[Replay] file:{} frames:{} valid:{} total:{:.3f}ms invalidCommands:{} indices:{}",
+			filePath, result.frameCount, result.valid, result.totalMilliseconds, backend.GetInvalidCommandCount(), backend.GetIndexCount()) << '\n';
+
+		// パスごとの1フレームあたりの値
+		const double frames = result.frameCount > 0 ? static_cast<double>(result.frameCount) : 1.0;
+		for (const ReplayPassStatistics &pass : result.passes) {
+			std::string counts;
+			for (size_t i = 0; i < pass.commandCounts.size(); ++i) {
+				if (pass.commandCounts[i] != 0) {
+					counts += std::format(" {}:{:.1f}", GetCaptureCommandName(static_cast<CaptureCommand>(i)), pass.commandCounts[i] / frames);
+				}
+			}
+			os << std::format("[Replay] pass:{} commands/frame:{:.1f} bytes/frame:{:.0f} upload/frame:{:.0f} cpu/frame:{:.3f}ms |{}",
+				pass.name, pass.GetCommandCount() / frames, pass.commandBytes / frames, pass.uploadBytes / frames, pass.cpuMilliseconds / frames, counts) << '\n';
+		}
+		return result.valid;
+	}
+}
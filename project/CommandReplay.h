@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CommandCapture.h"
+#include "MappedFile.h"
+
+// 描画コマンドの再生
+// CommandCaptureが書き出したファイルを読み、コマンドを再生先(CommandBackend)に渡しながらパスごとに集計する
+// D3Dに依存しないので、GPUの無い環境でもNullCommandBackendで再生してコマンド数・バイト数・CPU時間を調べられる
+namespace render
+{
+	// 再生先
+	class CommandBackend
+	{
+	public:
+		virtual ~CommandBackend() = default;
+
+		virtual void BeginFrame(uint64_t /*frameNumber*/) {}
+		virtual void EndFrame() {}
+		virtual void BeginPass(std::string_view /*name*/) {}
+		virtual void EndPass() {}
+		virtual void Clear() {}
+		virtual void SetRootSignature(uint32_t /*objectId*/) {}
+		virtual void SetPipelineState(uint32_t /*objectId*/) {}
+		virtual void SetRootConstantBuffer(uint32_t /*slot*/, uint32_t /*bufferId*/, uint32_t /*offset*/) {}
+		virtual void SetRootDescriptorTable(uint32_t /*slot*/, uint32_t /*descriptorIndex*/) {}
+		virtual void SetVertexBuffer(uint32_t /*bufferId*/, uint32_t /*offset*/, uint32_t /*size*/, uint32_t /*stride*/) {}
+		virtual void SetIndexBuffer(uint32_t /*bufferId*/, uint32_t /*size*/) {}
+		virtual void DrawIndexed(uint32_t /*indexCount*/, uint32_t /*instanceCount*/, uint32_t /*startIndex*/, int32_t /*baseVertex*/) {}
+		// dataはキャプチャにデータが無ければ空
+		virtual void Upload(uint32_t /*bufferId*/, uint32_t /*offset*/, uint32_t /*size*/, std::span<const uint8_t> /*data*/) {}
+	};
+
+	// 何も描かない再生先
+	// 状態だけを追い、ルートシグネチャ・PSO・頂点バッファを設定せずに描画したものを不正なコマンドとして数える
+	class NullCommandBackend : public CommandBackend
+	{
+	public:
+		void BeginFrame(uint64_t frameNumber) override;
+		void SetRootSignature(uint32_t objectId) override;
+		void SetPipelineState(uint32_t objectId) override;
+		void SetVertexBuffer(uint32_t bufferId, uint32_t offset, uint32_t size, uint32_t stride) override;
+		void SetIndexBuffer(uint32_t bufferId, uint32_t size) override;
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex) override;
+		void Upload(uint32_t bufferId, uint32_t offset, uint32_t size, std::span<const uint8_t> data) override;
+
+		uint32_t GetInvalidCommandCount() const { return invalidCommandCount_; }
+		// 描画したインデックスの総数
+		uint64_t GetIndexCount() const { return indexCount_; }
+
+	private:
+		static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+		uint32_t rootSignature_ = kNone;
+		uint32_t pipelineState_ = kNone;
+		uint32_t vertexBuffer_ = kNone;
+		uint32_t indexBuffer_ = kNone;
+		uint32_t invalidCommandCount_ = 0;
+		uint64_t indexCount_ = 0;
+		// 見るだけで捨てる(データを読んだ分の時間も計測に含める)
+		uint64_t checksum_ = 0;
+	};
+
+	// パスごとの集計(全フレームの合計)
+	struct ReplayPassStatistics
+	{
+		std::string name;
+		uint32_t frameCount = 0; //!< パスが現れたフレーム数
+		std::array<uint32_t, static_cast<size_t>(CaptureCommand::Count)> commandCounts {};
+		uint64_t commandBytes = 0; //!< キャプチャ上のバイト数(アップロードのデータを含む)
+		uint64_t uploadBytes = 0; //!< アップロードしたバイト数
+		double cpuMilliseconds = 0.0; //!< 解釈と再生先の処理にかかった時間
+
+		uint32_t GetCommandCount() const;
+	};
+
+	// 再生の結果
+	struct ReplayResult
+	{
+		bool valid = false; //!< 最後まで正しく読めたか
+		uint32_t frameCount = 0;
+		std::vector<ReplayPassStatistics> passes; //!< 初めて現れた順
+		double totalMilliseconds = 0.0;
+	};
+
+	class CommandReplay
+	{
+	public: // メンバ関数
+		// キャプチャファイルを開く(形式が違えばfalse)
+		bool Load(const std::string &filePath);
+
+		// 全てのフレームを再生する
+		ReplayResult Run(CommandBackend &backend) const;
+
+	private:
+		MappedFile file_;
+	};
+
+	// コマンドの名前(ログ用)
+	const char *GetCaptureCommandName(CaptureCommand command);
+
+	// キャプチャをNullCommandBackendで再生し、パスごとの集計をosに書き出す(読めなければfalse。D3DにもWindowsにも依存しない)
+	bool ReplayCaptureFile(const std::string &filePath, std::ostream &os);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include "MathTypes.h"
+#include "SpritePool.h"
+
+// ECSで扱うコンポーネント
+// チャンク間をmemcpyで移動するため、いずれもトリビアルコピー可能な型にしておく
+namespace ecs
+{
+	// 2D座標変換
+	struct Transform2DComponent
+	{
+		math::Vector2 position = { 0.0f,0.0f };
+		float rotation = 0.0f;
+		math::Vector2 size = { 64.0f,64.0f };
+	};
+
+	// 直前のシミュレーションステップでの座標変換(描画時の補間用)
+	struct PreviousTransform2DComponent
+	{
+		Transform2DComponent value;
+	};
+
+	// スプライト描画
+	struct SpriteComponent
+	{
+		SpriteHandle sprite {}; //!< SpritePool内のスプライト
+		math::Vector4 color = { 1.0f,1.0f,1.0f,1.0f };
+	};
+
+	// テクスチャのコマ送りアニメーション
+	struct AnimationComponent
+	{
+		math::Vector2 frameSize = { 64.0f,64.0f }; //!< 1コマの切り出しサイズ
+		uint32_t columns = 1; //!< テクスチャ横方向のコマ数
+		uint32_t frameCount = 1; //!< 総コマ数
+		float frameDuration = 0.1f; //!< 1コマの表示秒数
+		float timer = 0.0f;
+		uint32_t currentFrame = 0;
+	};
+
+	// 矩形コリジョン
+	struct ColliderComponent
+	{
+		math::Vector2 halfSize = { 32.0f,32.0f };
+		uint32_t layer = 0;
+		uint32_t hitCount = 0; //!< 今フレーム重なっている相手の数
+	};
+}
@@ -1,6 +1,9 @@
 #include "DirectXCommon.h"
+#include "CommandCapture.h"
+#include "PerfCounters.h"
 #include <cassert>
-#include <thread>
+#include <cstring>
+#include <vector>
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -21,9 +24,6 @@ const uint32_t DirectXCommon::kMaxSRVCount = 512;
 
 void DirectXCommon::Initialize(WinApp *winApp)
 {
-	// FPS固定初期化
-	InitializeFixFPS();
-
 	// NULL検出
 	assert(winApp);
 
@@ -40,8 +40,8 @@ void DirectXCommon::Initialize(WinApp *winApp)
 	CreateFence();
 	InitializeViewport();
 	InitializeScissorRect();
-	InitializeDXC();
 	InitializeImGui();
+	InitializeGpuTimer();
 }
 
 void DirectXCommon::InitializeDevice()
@@ -94,6 +94,8 @@ void DirectXCommon::InitializeDevice()
 	}
 	// 適切なアダプタが見つからなかったので起動できない
 	assert(useAdapter != nullptr);
+	// メモリの予算を問い合わせるために残しておく
+	adapter = useAdapter;
 
 	/**************************************************
 	 * D3D12Deviceの生成
@@ -371,19 +373,6 @@ void DirectXCommon::InitializeScissorRect()
 	scissorRect.bottom = WinApp::kClientHeight;
 }
 
-void DirectXCommon::InitializeDXC()
-{
-	HRESULT hr;
-
-	hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
-	assert(SUCCEEDED(hr));
-	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
-	assert(SUCCEEDED(hr));
-
-	hr = dxcUtils->CreateDefaultIncludeHandler(&includeHandler);
-	assert(SUCCEEDED(hr));
-}
-
 void DirectXCommon::InitializeImGui()
 {
 #ifdef USE_IMGUI
@@ -402,6 +391,67 @@ void DirectXCommon::InitializeImGui()
 #endif
 }
 
+void DirectXCommon::InitializeGpuTimer()
+{
+	HRESULT hr;
+
+	// タイムスタンプのクエリヒープ(パスごとに開始と終了)
+	D3D12_QUERY_HEAP_DESC queryHeapDesc {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = kMaxGpuPassCount * 2;
+	hr = device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&timestampQueryHeap));
+	assert(SUCCEEDED(hr));
+
+	// 解決したタイムスタンプをCPUから読むためのバッファ
+	D3D12_HEAP_PROPERTIES readbackHeapProperties {};
+	readbackHeapProperties.Type = D3D12_HEAP_TYPE_READBACK;
+	D3D12_RESOURCE_DESC readbackDesc {};
+	readbackDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	readbackDesc.Width = sizeof(uint64_t) * kMaxGpuPassCount * 2;
+	readbackDesc.Height = 1;
+	readbackDesc.DepthOrArraySize = 1;
+	readbackDesc.MipLevels = 1;
+	readbackDesc.SampleDesc.Count = 1;
+	readbackDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	hr = device->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &readbackDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&timestampReadbackResource));
+	assert(SUCCEEDED(hr));
+
+	// タイムスタンプの1秒あたりのカウント
+	hr = commandQueue->GetTimestampFrequency(&timestampFrequency);
+	assert(SUCCEEDED(hr));
+}
+
+void DirectXCommon::BeginGpuPass(PerfCounters::CounterId counter)
+{
+	assert(!gpuPassOpen);
+	// 上限を超えた分は計測しない
+	if (gpuPassCount >= kMaxGpuPassCount) {
+		return;
+	}
+	gpuPassCounters[gpuPassCount] = counter;
+	commandList->EndQuery(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, gpuPassCount * 2);
+	gpuPassOpen = true;
+}
+
+void DirectXCommon::EndGpuPass()
+{
+	if (!gpuPassOpen) {
+		return;
+	}
+	commandList->EndQuery(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, gpuPassCount * 2 + 1);
+	++gpuPassCount;
+	gpuPassOpen = false;
+}
+
+DXGI_QUERY_VIDEO_MEMORY_INFO DirectXCommon::GetVideoMemoryInfo() const
+{
+	DXGI_QUERY_VIDEO_MEMORY_INFO info {};
+	HRESULT hr = adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info);
+	assert(SUCCEEDED(hr));
+	return info;
+}
+
 void DirectXCommon::PreDraw()
 {
 	/**************************************************
@@ -446,6 +496,8 @@ void DirectXCommon::PreDraw()
 	// 描画用のDescriptorHeapの設定
 	ID3D12DescriptorHeap *descriptorHeaps[] = { srvDescriptorHeap.Get() };
 	commandList->SetDescriptorHeaps(1, descriptorHeaps);
+	static const PerfCounters::CounterId kDescriptorHeapBinds = PerfCounters::Register("render.descriptorHeapBinds");
+	PerfCounters::Add(kDescriptorHeapBinds);
 
 	//----コマンドを積む----
 	commandList->RSSetViewports(1, &viewport); // Viewportを設定
@@ -467,6 +519,12 @@ void DirectXCommon::PostDraw()
 	// TransitionBarrierを張る
 	commandList->ResourceBarrier(1, &barrier);
 
+	// 計測したパスのタイムスタンプを読み出し用のバッファに書き出す
+	assert(!gpuPassOpen);
+	if (gpuPassCount > 0) {
+		commandList->ResolveQueryData(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, gpuPassCount * 2, timestampReadbackResource.Get(), 0);
+	}
+
 	//----CommandListを閉じる----
 
 	// コマンドリストの内容を確定させる。すべてのコマンドを積んでからCloseすること
@@ -480,6 +538,8 @@ void DirectXCommon::PostDraw()
 	// GPUにコマンドリストの実行を行わせる
 	ID3D12CommandList *commandLists[] = { commandList.Get() };
 	commandQueue->ExecuteCommandLists(1, commandLists);
+	static const PerfCounters::CounterId kCommandListSubmits = PerfCounters::Register("render.commandListSubmits");
+	PerfCounters::Add(kCommandListSubmits);
 	// GPUとOSに画面の交換を行うよう通知する
 	swapChain->Present(1, 0);
 
@@ -502,8 +562,21 @@ void DirectXCommon::PostDraw()
 		WaitForSingleObject(fenceEvent, INFINITE);
 	}
 
-	// FPS固定
-	UpdateFixFPS();
+	// GPUが終わったので、計測したパスの時間を読む
+	if (gpuPassCount > 0) {
+		D3D12_RANGE readRange { 0, sizeof(uint64_t) * gpuPassCount * 2 };
+		uint64_t *timestamps = nullptr;
+		hr = timestampReadbackResource->Map(0, &readRange, reinterpret_cast<void **>(&timestamps));
+		assert(SUCCEEDED(hr));
+		for (uint32_t i = 0; i < gpuPassCount; ++i) {
+			uint64_t ticks = timestamps[i * 2 + 1] - timestamps[i * 2];
+			PerfCounters::Set(gpuPassCounters[i], static_cast<int64_t>(ticks * 1000000 / timestampFrequency));
+		}
+		// CPUからは書いていない
+		D3D12_RANGE writtenRange { 0, 0 };
+		timestampReadbackResource->Unmap(0, &writtenRange);
+		gpuPassCount = 0;
+	}
 
 	// 次のフレーム用のコマンドリストを準備
 	hr = commandAllocator->Reset();
@@ -512,71 +585,6 @@ void DirectXCommon::PostDraw()
 	assert(SUCCEEDED(hr));
 }
 
-Microsoft::WRL::ComPtr<IDxcBlob> DirectXCommon::CompileShader(const std::wstring &filePath, const wchar_t *profile)
-{
-	//----hlslファイルを読み込む----
-
-	// これからシェーダーをコンパイルする旨をログに出す
-	//Log(os, ConvertString(std::format(L"Begin CompileShader, path:{}, profile:{}\n", filePath, profile)));
-	// hlslファイルを読む
-	IDxcBlobEncoding *shaderSource = nullptr;
-	HRESULT hr = dxcUtils->LoadFile(filePath.c_str(), nullptr, &shaderSource);
-	// 読めなかったら止める
-	assert(SUCCEEDED(hr));
-	// 読み込んだファイルの内容を設定する
-	DxcBuffer shaderSourceBuffer;
-	shaderSourceBuffer.Ptr = shaderSource->GetBufferPointer();
-	shaderSourceBuffer.Size = shaderSource->GetBufferSize();
-	shaderSourceBuffer.Encoding = DXC_CP_UTF8; // UTF8の文字コードであることを通知
-
-	//----Compileする----
-
-	LPCWSTR arguments[] = {
-		filePath.c_str(), // コンパイル対象のhlslファイル名
-		L"-E",L"main", // エントリーポイントの指定。基本的にmain以外にはしない
-		L"-T",profile, // ShaderProfileの設定
-		L"-Zi",L"-Qembed_debug", // デバック用の情報を埋め込む
-		L"-Od",    // 最適化を外しておく
-		L"-Zpr",   // メモリレイアウトは行優先
-	};
-	// 実際にShaderをコンパイルする
-	IDxcResult *shaderResult = nullptr;
-	hr = dxcCompiler->Compile(
-		&shaderSourceBuffer,    // 読み込んだファイル
-		arguments,              // コンパイルオプション
-		_countof(arguments),    // コンパイルオプションの数
-		includeHandler.Get(),         // includeが含まれた諸々
-		IID_PPV_ARGS(&shaderResult) // コンパイル結果
-	);
-	// コンパイルエラーではなくdxcが起動できないなど致命的な状況
-	assert(SUCCEEDED(hr));
-
-	//----警告・エラーがでていないか確認----
-
-	// 警告・エラーが出てたらログに出して止める
-	Microsoft::WRL::ComPtr<IDxcBlobUtf8> shaderError = nullptr;
-	shaderResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&shaderError), nullptr);
-	if (shaderError != nullptr && shaderError->GetStringLength() != 0) {
-		//Log(os, shaderError->GetStringPointer());
-		// 警告・エラーダメゼッタイ
-		assert(false);
-	}
-
-	//----Compile結果を受け取って返す----
-
-	// コンパイル結果から実行用のバイナリ部分を取得
-	Microsoft::WRL::ComPtr<IDxcBlob> shaderBlob = nullptr;
-	hr = shaderResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shaderBlob), nullptr);
-	assert(SUCCEEDED(hr));
-	// 成功したログを出す
-	//Log(os, ConvertString(std::format(L"Compile Succeeded, path:{}, profile:{}\n", filePath, profile)));
-	// もう使わないリソースを解放
-	shaderSource->Release();
-	shaderResult->Release();
-	// 実行用のバイナリを返却
-	return shaderBlob;
-}
-
 Microsoft::WRL::ComPtr<ID3D12Resource> DirectXCommon::CreateBufferResource(size_t sizeInBytes)
 {
 	// 頂点リソース用のヒープの設定
@@ -604,6 +612,20 @@ Microsoft::WRL::ComPtr<ID3D12Resource> DirectXCommon::CreateBufferResource(size_
 	return vertexResource;
 }
 
+Microsoft::WRL::ComPtr<ID3D12Resource> DirectXCommon::CreateBufferResource(std::span<const std::byte> initialData)
+{
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource = CreateBufferResource(initialData.size());
+
+	// 読み込み元(モデルファイルのマップなど)からアップロードヒープへ1回でコピーする
+	void *mappedData = nullptr;
+	HRESULT hr = resource->Map(0, nullptr, &mappedData);
+	assert(SUCCEEDED(hr));
+	std::memcpy(mappedData, initialData.data(), initialData.size());
+	resource->Unmap(0, nullptr);
+
+	return resource;
+}
+
 Microsoft::WRL::ComPtr<ID3D12Resource> DirectXCommon::CreateTextureResource(const DirectX::TexMetadata &metadata)
 {
 	// metadataを基にResourceの設定
@@ -640,6 +662,16 @@ Microsoft::WRL::ComPtr<ID3D12Resource> DirectXCommon::UploadTextureData(const Mi
 	uint64_t intermediateSize = GetRequiredIntermediateSize(texture.Get(), 0, UINT(subresources.size()));
 	Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource = CreateBufferResource(intermediateSize);
 	UpdateSubresources(commandList.Get(), texture.Get(), intermediateResource.Get(), 0, 0, UINT(subresources.size()), subresources.data());
+	// キャプチャにはサブリソースのピクセルデータを、テクスチャへの転送として並べて記録する
+	render::CommandCapture *capture = render::CommandCapture::GetInstance();
+	if (capture->IsRecording()) {
+		uint32_t offset = 0;
+		for (const D3D12_SUBRESOURCE_DATA &subresource : subresources) {
+			uint32_t size = static_cast<uint32_t>(subresource.SlicePitch);
+			capture->Upload(texture.Get(), offset, subresource.pData, size);
+			offset += size;
+		}
+	}
 	// Tetureへの転送後は利用できるよう、D3D12_RESOURCE_STATE_COPY_DESTからD3D12_RESOURCE_STATE_GENERIC_READへResourceStateを変更する
 	D3D12_RESOURCE_BARRIER barrier {};
 	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
@@ -664,35 +696,4 @@ D3D12_GPU_DESCRIPTOR_HANDLE DirectXCommon::GetGPUDescriptorHandle(const Microsof
 	D3D12_GPU_DESCRIPTOR_HANDLE handleGPU = descriptorHeap->GetGPUDescriptorHandleForHeapStart();
 	handleGPU.ptr += (descriptorSize * index);
 	return handleGPU;
-}
-
-void DirectXCommon::InitializeFixFPS()
-{
-	// 現在時刻を記録する
-	reference_ = std::chrono::steady_clock::now();
-}
-
-void DirectXCommon::UpdateFixFPS()
-{
-	// 1/60秒ぴったりの時間
-	const std::chrono::microseconds kMinTime(uint64_t(1000000.0f / 60.0f));
-	// 1/60秒よりわずかに短い時間
-	const std::chrono::microseconds kMinCheckTime(uint64_t(1000000.0f / 65.0f));
-
-	// 現在時刻を取得する
-	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-	// 前回記録からの経過時間を取得する
-	std::chrono::microseconds elapsed =
-		std::chrono::duration_cast<std::chrono::microseconds>(now - reference_);
-
-	// 1/60秒（よりわずかに短い時間）経っていない場合
-	if (elapsed < kMinCheckTime) {
-		// 1/60秒経過するまで微小なスリープを繰り返す
-		while (std::chrono::steady_clock::now() - reference_ < kMinTime) {
-			// 1マイクロ秒スリープ
-			std::this_thread::sleep_for(std::chrono::microseconds(1));
-		}
-	}
-	// 現在の時間を記録する
-	reference_ = std::chrono::steady_clock::now();
 }
\ No newline at end of file
@@ -3,10 +3,11 @@
 #include <dxgi1_6.h>
 #include <wrl.h>
 #include <array>
-#include <dxcapi.h>
+#include <span>
 #include <string>
 #include <chrono>
 #include "WinApp.h"
+#include "PerfCounters.h"
 
 #include "externals/DirectXTex/DirectXTex.h"
 #include "externals/DirectXTex/d3dx12.h"
@@ -83,47 +84,64 @@ public: // メンバ関数
 	// シザリング矩形の初期化
 	void InitializeScissorRect();
 
-	// DXCコンパイラの生成
-	void InitializeDXC();
-
 	// ImGuiの初期化
 	void InitializeImGui();
 
+	// GPU時間計測用のクエリの初期化
+	void InitializeGpuTimer();
+
 	// 描画前処理
 	void PreDraw();
 	// 描画後処理
 	void PostDraw();
 
+	/// <summary>
+	/// GPUのパスの計測を始める(PreDrawとPostDrawの間で、入れ子にせずEndGpuPassと対で呼ぶ)
+	/// 結果はPostDrawでGPUを待った後に、counterへマイクロ秒で設定する(ゲージで登録しておくこと)
+	/// </summary>
+	void BeginGpuPass(PerfCounters::CounterId counter);
+	// GPUのパスの計測を終える
+	void EndGpuPass();
+
+	// アダプタのローカルメモリの使用量と予算(OSが割り当てた目安)
+	DXGI_QUERY_VIDEO_MEMORY_INFO GetVideoMemoryInfo() const;
+
 	// getter
 	ID3D12Device *GetDevice() const { return device.Get(); }
 	ID3D12GraphicsCommandList *GetCommandList() const { return commandList.Get(); }
 
-	// シェーダーのコンパイル
-	Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(const std::wstring &filePath, const wchar_t *profile);
-
 	/// <summary>
 	/// バッファリソースの生成
 	/// </summary>
 	Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(size_t sizeInBytes);
 
+	/// <summary>
+	/// 初期データ入りのバッファリソースの生成(データはマップ先へ直接コピーする)
+	/// </summary>
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(std::span<const std::byte> initialData);
+
 	/// <summary>
 	/// テクスチャリソースの生成
 	/// </summary>
 	Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(const DirectX::TexMetadata &metadata);
 
 	/// <summary>
-	/// テクスチャデータの転送
+	/// テクスチャデータの転送(キャプチャ中なら、サブリソースごとの転送をキャプチャにも記録する)
 	/// </summary>
 	[[nodiscard]] Microsoft::WRL::ComPtr<ID3D12Resource> UploadTextureData(const Microsoft::WRL::ComPtr<ID3D12Resource> &texture, const DirectX::ScratchImage &mipImages);
 
 	// 最大SRV数（最大テクスチャ枚数)
 	static const uint32_t kMaxSRVCount;
+	// 1フレームで計測できるGPUのパス数
+	static const uint32_t kMaxGpuPassCount = 8;
 
 private:
 	// DirectX12デバイス
 	Microsoft::WRL::ComPtr<ID3D12Device> device = nullptr;
 	// DXGIファクトリ
 	Microsoft::WRL::ComPtr<IDXGIFactory7> dxgiFactory = nullptr;
+	// 使用するアダプタ
+	Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter = nullptr;
 	// コマンドキューを生成する
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue = nullptr;
 	// コマンドアロケータを生成する
@@ -170,20 +188,13 @@ private:
 	D3D12_VIEWPORT viewport {};
 	// シザー矩形
 	D3D12_RECT scissorRect {};
-	// dxcCompilerを初期化
-	Microsoft::WRL::ComPtr<IDxcUtils> dxcUtils = nullptr;
-	Microsoft::WRL::ComPtr<IDxcCompiler3> dxcCompiler = nullptr;
-	// 現時点でincludeはしないが、includeに対応するための設定を行っておく
-	Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler = nullptr;
 	// TransitionBarrierの設定
 	D3D12_RESOURCE_BARRIER barrier {};
-
-private: // メンバ関数
-	// FPS固定初期化
-	void InitializeFixFPS();
-	// FPS固定更新
-	void UpdateFixFPS();
-
-	// 記録時間(FPS固定用)
-	std::chrono::steady_clock::time_point reference_;
+	// GPU時間計測用(パスごとに開始・終了の2つのタイムスタンプ)
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> timestampQueryHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource> timestampReadbackResource;
+	uint64_t timestampFrequency = 0;
+	std::array<PerfCounters::CounterId, kMaxGpuPassCount> gpuPassCounters {};
+	uint32_t gpuPassCount = 0;
+	bool gpuPassOpen = false;
 };
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include "ECS.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+
+namespace ecs
+{
+	namespace
+	{
+		// 登録済みコンポーネント型の一覧
+		std::vector<ComponentInfo> &GetComponentInfos()
+		{
+			// 要素の参照を返すので再確保が起きないよう上限分を確保しておく
+			static std::vector<ComponentInfo> infos = []() {
+				std::vector<ComponentInfo> result;
+				result.reserve(kMaxComponentTypes);
+				return result;
+			}();
+			return infos;
+		}
+
+		std::mutex &GetRegistryMutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		// alignmentの倍数に切り上げる
+		size_t AlignUp(size_t value, size_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	uint32_t RegisterComponentType(size_t size, size_t alignment, const char *name)
+	{
+		std::lock_guard<std::mutex> lock(GetRegistryMutex());
+		std::vector<ComponentInfo> &infos = GetComponentInfos();
+		// マスクのビット数を超えて登録できない
+		assert(infos.size() < kMaxComponentTypes);
+		infos.push_back({ size, alignment, name });
+		return static_cast<uint32_t>(infos.size() - 1);
+	}
+
+	const ComponentInfo &GetComponentInfo(uint32_t typeId)
+	{
+		std::lock_guard<std::mutex> lock(GetRegistryMutex());
+		assert(typeId < GetComponentInfos().size());
+		return GetComponentInfos()[typeId];
+	}
+
+#pragma region Archetype
+
+	Archetype::Archetype(ComponentMask mask) : mask_(mask)
+	{
+		for (uint32_t typeId = 0; typeId < kMaxComponentTypes; ++typeId) {
+			if ((mask >> typeId) & 1) {
+				typeIds_.push_back(typeId);
+			}
+		}
+
+		// 1エンティティあたりのバイト数から大まかな容量を出す
+		size_t bytesPerEntity = sizeof(Entity);
+		for (uint32_t typeId : typeIds_) {
+			bytesPerEntity += GetComponentInfo(typeId).size;
+		}
+		size_t capacity = kChunkSize / bytesPerEntity;
+
+		// アラインメントの詰め物で溢れる場合は1つずつ減らして収まる容量を探す
+		while (capacity > 0) {
+			size_t offset = sizeof(Entity) * capacity;
+			for (uint32_t typeId : typeIds_) {
+				const ComponentInfo &info = GetComponentInfo(typeId);
+				offset = AlignUp(offset, info.alignment);
+				offsets_[typeId] = static_cast<uint32_t>(offset);
+				sizes_[typeId] = static_cast<uint32_t>(info.size);
+				offset += info.size * capacity;
+			}
+			if (offset <= kChunkSize) {
+				break;
+			}
+			--capacity;
+		}
+		// 1つも入らないほど大きな構成は扱えない
+		assert(capacity > 0);
+		capacity_ = static_cast<uint32_t>(capacity);
+	}
+
+	void *Archetype::GetComponent(uint32_t chunkIndex, uint32_t row, uint32_t typeId)
+	{
+		assert(HasComponent(typeId));
+		return chunks_[chunkIndex]->data + offsets_[typeId] + size_t(sizes_[typeId]) * row;
+	}
+
+	void Archetype::AllocateRow(Entity entity, uint32_t &chunkIndex, uint32_t &row)
+	{
+		// 末尾のチャンクが埋まっていれば新しいチャンクを足す
+		if (chunks_.empty() || chunks_.back()->count == capacity_) {
+			chunks_.push_back(std::make_unique<Chunk>());
+		}
+
+		chunkIndex = static_cast<uint32_t>(chunks_.size() - 1);
+		Chunk &chunk = *chunks_.back();
+		row = chunk.count++;
+		GetEntities(chunkIndex)[row] = entity;
+		++entityCount_;
+	}
+
+	Entity Archetype::RemoveRow(uint32_t chunkIndex, uint32_t row)
+	{
+		uint32_t lastChunkIndex = static_cast<uint32_t>(chunks_.size() - 1);
+		Chunk &lastChunk = *chunks_[lastChunkIndex];
+		uint32_t lastRow = lastChunk.count - 1;
+
+		Entity moved {};
+		// 末尾以外を消す場合は末尾の行を穴に移して密に保つ
+		if (chunkIndex != lastChunkIndex || row != lastRow) {
+			moved = GetEntities(lastChunkIndex)[lastRow];
+			GetEntities(chunkIndex)[row] = moved;
+			for (uint32_t typeId : typeIds_) {
+				std::memcpy(GetComponent(chunkIndex, row, typeId), GetComponent(lastChunkIndex, lastRow, typeId), sizes_[typeId]);
+			}
+		}
+
+		--lastChunk.count;
+		--entityCount_;
+		// 空になったチャンクは解放する
+		if (lastChunk.count == 0) {
+			chunks_.pop_back();
+		}
+		return moved;
+	}
+
+	uint32_t Archetype::AppendChunk(uint32_t count)
+	{
+		assert(count <= capacity_);
+		chunks_.push_back(std::make_unique<Chunk>());
+		chunks_.back()->count = count;
+		entityCount_ += count;
+		return static_cast<uint32_t>(chunks_.size() - 1);
+	}
+
+#pragma endregion
+
+#pragma region CommandBuffer
+
+	void CommandBuffer::DestroyEntity(Entity entity)
+	{
+		Record([=](World &world) {
+			if (world.IsAlive(entity)) {
+				world.DestroyEntity(entity);
+			}
+			});
+	}
+
+	void CommandBuffer::Playback(World &world)
+	{
+		std::vector<std::function<void(World &)>> executing;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			executing.swap(commands);
+		}
+		for (std::function<void(World &)> &command : executing) {
+			command(world);
+		}
+	}
+
+	void CommandBuffer::Record(std::function<void(World &)> command)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		commands.push_back(std::move(command));
+	}
+
+#pragma endregion
+
+#pragma region World
+
+	uint64_t World::AllocateId()
+	{
+		// 0は未設定のクエリと区別するため使わない
+		static std::atomic<uint64_t> nextId { 1 };
+		return nextId.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void World::DestroyEntity(Entity entity)
+	{
+		assert(IsAlive(entity));
+
+		EntityRecord &record = records[entity.index];
+		Entity moved = record.archetype->RemoveRow(record.chunk, record.row);
+		// 穴埋めで移動したエンティティの所在を更新
+		if (moved.IsValid()) {
+			records[moved.index].chunk = record.chunk;
+			records[moved.index].row = record.row;
+		}
+
+		// 世代を進めて古いハンドルを無効にする
+		record.archetype = nullptr;
+		++record.generation;
+		freeIndices.push_back(entity.index);
+	}
+
+	bool World::IsAlive(Entity entity) const
+	{
+		return entity.index < records.size() &&
+			records[entity.index].archetype != nullptr &&
+			records[entity.index].generation == entity.generation;
+	}
+
+	Entity World::AllocateEntity(ComponentMask mask)
+	{
+		Entity entity {};
+		if (!freeIndices.empty()) {
+			entity.index = freeIndices.back();
+			freeIndices.pop_back();
+		} else {
+			entity.index = static_cast<uint32_t>(records.size());
+			records.emplace_back();
+		}
+
+		EntityRecord &record = records[entity.index];
+		entity.generation = record.generation;
+		record.archetype = GetOrCreateArchetype(mask);
+		record.archetype->AllocateRow(entity, record.chunk, record.row);
+		return entity;
+	}
+
+	void World::MoveEntity(Entity entity, ComponentMask newMask)
+	{
+		EntityRecord &record = records[entity.index];
+		Archetype *src = record.archetype;
+		Archetype *dst = GetOrCreateArchetype(newMask);
+
+		uint32_t dstChunk = 0;
+		uint32_t dstRow = 0;
+		dst->AllocateRow(entity, dstChunk, dstRow);
+
+		// 共通するコンポーネントをコピー
+		for (uint32_t typeId : dst->GetTypeIds()) {
+			if (src->HasComponent(typeId)) {
+				std::memcpy(dst->GetComponent(dstChunk, dstRow, typeId),
+					src->GetComponent(record.chunk, record.row, typeId),
+					dst->GetComponentSize(typeId));
+			}
+		}
+
+		Entity moved = src->RemoveRow(record.chunk, record.row);
+		if (moved.IsValid()) {
+			records[moved.index].chunk = record.chunk;
+			records[moved.index].row = record.row;
+		}
+
+		record.archetype = dst;
+		record.chunk = dstChunk;
+		record.row = dstRow;
+	}
+
+	void World::RegisterChunkEntities(Archetype &archetype, uint32_t chunkIndex)
+	{
+		const Entity *entities = archetype.GetEntities(chunkIndex);
+		uint32_t count = archetype.GetChunk(chunkIndex).count;
+		for (uint32_t row = 0; row < count; ++row) {
+			const Entity &entity = entities[row];
+			if (entity.index >= records.size()) {
+				records.resize(size_t(entity.index) + 1);
+			}
+			EntityRecord &record = records[entity.index];
+			// 同じ番号のエンティティが2つあってはならない
+			assert(record.archetype == nullptr);
+			record.archetype = &archetype;
+			record.chunk = chunkIndex;
+			record.row = row;
+			record.generation = entity.generation;
+		}
+	}
+
+	void World::RebuildFreeIndices()
+	{
+		freeIndices.clear();
+		for (uint32_t index = 0; index < records.size(); ++index) {
+			if (records[index].archetype == nullptr) {
+				freeIndices.push_back(index);
+			}
+		}
+	}
+
+	Archetype *World::GetOrCreateArchetype(ComponentMask mask)
+	{
+		auto it = archetypeMap.find(mask);
+		if (it != archetypeMap.end()) {
+			return it->second;
+		}
+
+		archetypes.push_back(std::make_unique<Archetype>(mask));
+		Archetype *archetype = archetypes.back().get();
+		archetypeMap.emplace(mask, archetype);
+		return archetype;
+	}
+
+#pragma endregion
+
+#pragma region SystemScheduler
+
+	void SystemScheduler::AddSystem(const System &system)
+	{
+		systems.push_back(system);
+		dirty = true;
+	}
+
+	void SystemScheduler::Build()
+	{
+		stages.clear();
+
+		// 各システムは、競合する先行システムの入ったステージより後ろの最も早いステージに置く
+		std::vector<uint32_t> stageOf(systems.size(), 0);
+		for (uint32_t i = 0; i < systems.size(); ++i) {
+			uint32_t stage = 0;
+			for (uint32_t j = 0; j < i; ++j) {
+				if (Conflicts(systems[i], systems[j])) {
+					stage = (std::max)(stage, stageOf[j] + 1);
+				}
+			}
+			stageOf[i] = stage;
+			if (stages.size() <= stage) {
+				stages.resize(stage + 1);
+			}
+			stages[stage].push_back(i);
+		}
+		dirty = false;
+	}
+
+	void SystemScheduler::Run(World &world, float deltaTime)
+	{
+		if (dirty) {
+			Build();
+		}
+
+		for (const std::vector<uint32_t> &stage : stages) {
+			if (stage.size() == 1) {
+				systems[stage[0]].update(world, deltaTime);
+				continue;
+			}
+
+			// 同じステージのシステムは並列に実行する
+			JobSystem::Counter counter;
+			for (size_t i = 1; i < stage.size(); ++i) {
+				System *system = &systems[stage[i]];
+				JobSystem::GetInstance()->Submit([system, &world, deltaTime]() { system->update(world, deltaTime); }, &counter);
+			}
+			systems[stage[0]].update(world, deltaTime);
+			JobSystem::GetInstance()->Wait(counter);
+		}
+
+		// システム中に積まれた構造変更を反映
+		world.GetCommandBuffer().Playback(world);
+	}
+
+	bool SystemScheduler::Conflicts(const System &a, const System &b)
+	{
+		// どちらかが書き込むコンポーネントを、もう一方が読み書きしていれば競合
+		return (a.writeMask & (b.readMask | b.writeMask)) != 0 ||
+			(b.writeMask & (a.readMask | a.writeMask)) != 0;
+	}
+
+#pragma endregion
+}
@@ -0,0 +1,439 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// アーキタイプ方式のエンティティコンポーネントシステム
+namespace ecs
+{
+	// チャンク1つ分のサイズ
+	constexpr size_t kChunkSize = 16 * 1024;
+	// 登録できるコンポーネント型の上限(マスクのビット数)
+	constexpr uint32_t kMaxComponentTypes = 64;
+	// 無効なインデックス
+	constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+	// コンポーネントの組み合わせを表すビットマスク
+	using ComponentMask = uint64_t;
+
+	// エンティティ(インデックス + 世代番号)
+	struct Entity
+	{
+		uint32_t index = kInvalidIndex;
+		uint32_t generation = 0;
+
+		bool IsValid() const { return index != kInvalidIndex; }
+		bool operator==(const Entity &other) const = default;
+	};
+
+	// コンポーネント型の情報
+	struct ComponentInfo
+	{
+		size_t size;
+		size_t alignment;
+		std::string name;
+	};
+
+	// コンポーネント型を登録してIDを返す
+	uint32_t RegisterComponentType(size_t size, size_t alignment, const char *name);
+	// IDからコンポーネント型の情報を取得
+	const ComponentInfo &GetComponentInfo(uint32_t typeId);
+
+	// コンポーネント型ごとのID
+	template <class T>
+	uint32_t GetComponentTypeId()
+	{
+		// チャンク間の移動はmemcpyで行うため、トリビアルコピー可能な型に限る
+		static_assert(std::is_trivially_copyable_v<T>, "component must be trivially copyable");
+		static const uint32_t id = RegisterComponentType(sizeof(T), alignof(T), typeid(T).name());
+		return id;
+	}
+
+	// コンポーネント型の並びからマスクを作る
+	template <class... Ts>
+	ComponentMask MakeComponentMask()
+	{
+		return (ComponentMask(0) | ... | (ComponentMask(1) << GetComponentTypeId<Ts>()));
+	}
+
+	// 16KB固定長のチャンク
+	struct Chunk
+	{
+		alignas(64) std::byte data[kChunkSize];
+		uint32_t count = 0;
+	};
+
+	// 同じコンポーネント構成を持つエンティティの集まり
+	class Archetype
+	{
+	public:
+		explicit Archetype(ComponentMask mask);
+
+		ComponentMask GetMask() const { return mask_; }
+		const std::vector<uint32_t> &GetTypeIds() const { return typeIds_; }
+		// チャンク1つに入るエンティティ数
+		uint32_t GetChunkCapacity() const { return capacity_; }
+		size_t GetChunkCount() const { return chunks_.size(); }
+		Chunk &GetChunk(size_t chunkIndex) { return *chunks_[chunkIndex]; }
+		size_t GetEntityCount() const { return entityCount_; }
+		bool HasComponent(uint32_t typeId) const { return (mask_ >> typeId) & 1; }
+		uint32_t GetComponentSize(uint32_t typeId) const { return sizes_[typeId]; }
+
+		// チャンク内のエンティティ配列
+		Entity *GetEntities(size_t chunkIndex) { return reinterpret_cast<Entity *>(chunks_[chunkIndex]->data); }
+		// チャンク内のコンポーネント配列の先頭
+		void *GetComponentArray(size_t chunkIndex, uint32_t typeId) { return chunks_[chunkIndex]->data + offsets_[typeId]; }
+		template <class T>
+		T *GetComponentArray(size_t chunkIndex) { return reinterpret_cast<T *>(GetComponentArray(chunkIndex, GetComponentTypeId<T>())); }
+		// 指定行のコンポーネント
+		void *GetComponent(uint32_t chunkIndex, uint32_t row, uint32_t typeId);
+
+		// 末尾に1行確保してチャンク番号と行番号を返す
+		void AllocateRow(Entity entity, uint32_t &chunkIndex, uint32_t &row);
+		/// <summary>
+		/// 行を削除する。末尾の行で穴を埋めるので、移動したエンティティを返す
+		/// </summary>
+		Entity RemoveRow(uint32_t chunkIndex, uint32_t row);
+		/// <summary>
+		/// 末尾にcount行分のチャンクを足してチャンク番号を返す(中身は呼び出し側が直接書き込む。シーンの読み込み用)
+		/// </summary>
+		uint32_t AppendChunk(uint32_t count);
+		// 型IDのチャンク内オフセット
+		uint32_t GetComponentOffset(uint32_t typeId) const { return offsets_[typeId]; }
+
+	private:
+		ComponentMask mask_;
+		std::vector<uint32_t> typeIds_;
+		// 型IDごとのチャンク内オフセットとサイズ
+		uint32_t offsets_[kMaxComponentTypes] = {};
+		uint32_t sizes_[kMaxComponentTypes] = {};
+		uint32_t capacity_ = 0;
+		std::vector<std::unique_ptr<Chunk>> chunks_;
+		size_t entityCount_ = 0;
+	};
+
+	class World;
+
+	// 構造変更(生成・破棄・コンポーネントの追加削除)を遅延させるバッファ
+	class CommandBuffer
+	{
+	public:
+		template <class... Ts>
+		void CreateEntity(const Ts &...components);
+		void DestroyEntity(Entity entity);
+		template <class T>
+		void AddComponent(Entity entity, const T &component);
+		template <class T>
+		void RemoveComponent(Entity entity);
+
+		// 記録したコマンドを順番に実行する
+		void Playback(World &world);
+		bool IsEmpty() const { return commands.empty(); }
+
+	private:
+		// 複数のシステムから同時に積まれる可能性があるので排他する
+		void Record(std::function<void(World &)> command);
+
+		std::mutex mutex;
+		std::vector<std::function<void(World &)>> commands;
+	};
+
+	// エンティティとアーキタイプを管理するワールド
+	class World
+	{
+	public:
+		// エンティティ生成
+		template <class... Ts>
+		Entity CreateEntity(const Ts &...components)
+		{
+			Entity entity = AllocateEntity(MakeComponentMask<Ts...>());
+			(SetComponent(entity, components), ...);
+			return entity;
+		}
+		// エンティティ破棄
+		void DestroyEntity(Entity entity);
+		// 生存確認
+		bool IsAlive(Entity entity) const;
+
+		// コンポーネントを追加(既にあれば上書き)
+		template <class T>
+		void AddComponent(Entity entity, const T &component)
+		{
+			uint32_t typeId = GetComponentTypeId<T>();
+			ComponentMask mask = records[entity.index].archetype->GetMask();
+			if (!((mask >> typeId) & 1)) {
+				MoveEntity(entity, mask | (ComponentMask(1) << typeId));
+			}
+			SetComponent(entity, component);
+		}
+		// コンポーネントを削除
+		template <class T>
+		void RemoveComponent(Entity entity)
+		{
+			uint32_t typeId = GetComponentTypeId<T>();
+			ComponentMask mask = records[entity.index].archetype->GetMask();
+			if ((mask >> typeId) & 1) {
+				MoveEntity(entity, mask & ~(ComponentMask(1) << typeId));
+			}
+		}
+		// コンポーネントを取得(持っていなければnullptr)
+		template <class T>
+		T *GetComponent(Entity entity)
+		{
+			if (!IsAlive(entity)) {
+				return nullptr;
+			}
+			EntityRecord &record = records[entity.index];
+			uint32_t typeId = GetComponentTypeId<T>();
+			if (!record.archetype->HasComponent(typeId)) {
+				return nullptr;
+			}
+			return static_cast<T *>(record.archetype->GetComponent(record.chunk, record.row, typeId));
+		}
+		template <class T>
+		bool HasComponent(Entity entity) const
+		{
+			return IsAlive(entity) && records[entity.index].archetype->HasComponent(GetComponentTypeId<T>());
+		}
+
+		// ワールドごとに異なる番号(クエリが別のワールドに使われたことを見分ける)
+		uint64_t GetId() const { return id; }
+
+		// 生きているエンティティ数
+		size_t GetEntityCount() const { return records.size() - freeIndices.size(); }
+		// アーキタイプ一覧(クエリのキャッシュ更新用。追加のみで順番は変わらない)
+		const std::vector<std::unique_ptr<Archetype>> &GetArchetypes() const { return archetypes; }
+
+		// システム実行中の構造変更用バッファ
+		CommandBuffer &GetCommandBuffer() { return commandBuffer; }
+
+		// 以下はシーンの保存・読み込み用
+		// 指定構成のアーキタイプ(無ければ作る)
+		Archetype &GetArchetype(ComponentMask mask) { return *GetOrCreateArchetype(mask); }
+		/// <summary>
+		/// チャンクに直接書き込んだエンティティを登録する(番号・世代はチャンク内の値をそのまま使う)
+		/// 全て登録し終えたらRebuildFreeIndicesを呼ぶ
+		/// </summary>
+		void RegisterChunkEntities(Archetype &archetype, uint32_t chunkIndex);
+		// エンティティ番号の範囲(使われていない番号も含む。番号は全てこれより小さい)
+		size_t GetEntityIndexCount() const { return records.size(); }
+		// 使われていないエンティティ番号の一覧を作り直す
+		void RebuildFreeIndices();
+
+	private:
+		// エンティティ1つ分の所在
+		struct EntityRecord
+		{
+			Archetype *archetype = nullptr;
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+			uint32_t generation = 0;
+		};
+
+		// 指定の構成でエンティティを確保する
+		Entity AllocateEntity(ComponentMask mask);
+		// 構成の違うアーキタイプへ移動する(共通するコンポーネントはコピー)
+		void MoveEntity(Entity entity, ComponentMask newMask);
+		Archetype *GetOrCreateArchetype(ComponentMask mask);
+
+		template <class T>
+		void SetComponent(Entity entity, const T &component)
+		{
+			EntityRecord &record = records[entity.index];
+			*static_cast<T *>(record.archetype->GetComponent(record.chunk, record.row, GetComponentTypeId<T>())) = component;
+		}
+
+		// 次のワールドの番号を払い出す
+		static uint64_t AllocateId();
+
+		uint64_t id = AllocateId();
+		std::vector<EntityRecord> records;
+		std::vector<uint32_t> freeIndices;
+		std::vector<std::unique_ptr<Archetype>> archetypes;
+		std::unordered_map<ComponentMask, Archetype *> archetypeMap;
+		CommandBuffer commandBuffer;
+	};
+
+	// 指定のコンポーネントを全て持つエンティティを列挙するクエリ
+	// 一致するアーキタイプはキャッシュし、新しく増えたアーキタイプだけを判定する
+	// システムのように呼び出しごとにワールドが渡される場所では、Bindで対象のワールドを切り替える
+	template <class... Ts>
+	class Query
+	{
+	public:
+		explicit Query(ComponentMask excludeMask = 0)
+			: mask_(MakeComponentMask<Ts...>()), excludeMask_(excludeMask) {}
+		explicit Query(World &world, ComponentMask excludeMask = 0)
+			: Query(excludeMask) { Bind(world); }
+
+		// 対象のワールドを設定する(前と別のワールドならキャッシュを捨てて集め直す)
+		void Bind(World &world)
+		{
+			if (world_ == &world && worldId_ == world.GetId()) {
+				return;
+			}
+			world_ = &world;
+			worldId_ = world.GetId();
+			matched_.clear();
+			checkedCount_ = 0;
+		}
+
+		// func(Entity, Ts&...) を全エンティティに対して呼ぶ
+		template <class F>
+		void ForEach(F &&func)
+		{
+			Refresh();
+			for (Archetype *archetype : matched_) {
+				for (size_t c = 0; c < archetype->GetChunkCount(); ++c) {
+					ForEachInChunk(archetype, c, func);
+				}
+			}
+		}
+
+		// チャンク単位でジョブシステムに分配して並列に処理する
+		template <class F>
+		void ParallelForEach(F &&func);
+
+		// 一致するエンティティ数
+		size_t Count()
+		{
+			Refresh();
+			size_t count = 0;
+			for (Archetype *archetype : matched_) {
+				count += archetype->GetEntityCount();
+			}
+			return count;
+		}
+
+	private:
+		void Refresh()
+		{
+			assert(world_);
+			const auto &archetypes = world_->GetArchetypes();
+			for (; checkedCount_ < archetypes.size(); ++checkedCount_) {
+				ComponentMask mask = archetypes[checkedCount_]->GetMask();
+				if ((mask & mask_) == mask_ && (mask & excludeMask_) == 0) {
+					matched_.push_back(archetypes[checkedCount_].get());
+				}
+			}
+		}
+
+		template <class F>
+		static void ForEachInChunk(Archetype *archetype, size_t chunkIndex, F &func)
+		{
+			Entity *entities = archetype->GetEntities(chunkIndex);
+			std::tuple<Ts *...> arrays(archetype->template GetComponentArray<Ts>(chunkIndex)...);
+			uint32_t count = archetype->GetChunk(chunkIndex).count;
+			for (uint32_t i = 0; i < count; ++i) {
+				std::apply([&](Ts *...array) { func(entities[i], array[i]...); }, arrays);
+			}
+		}
+
+		World *world_ = nullptr;
+		uint64_t worldId_ = 0;
+		ComponentMask mask_;
+		ComponentMask excludeMask_;
+		std::vector<Archetype *> matched_;
+		size_t checkedCount_ = 0;
+	};
+
+	// システム(読み書きするコンポーネントを宣言しておき、競合しないもの同士を並列に実行する)
+	struct System
+	{
+		std::string name;
+		ComponentMask readMask = 0;
+		ComponentMask writeMask = 0;
+		std::function<void(World &world, float deltaTime)> update;
+	};
+
+	// システムの実行順序を決めるスケジューラ
+	class SystemScheduler
+	{
+	public:
+		/// <summary>
+		/// システムを登録する。登録順が依存順になる
+		/// </summary>
+		void AddSystem(const System &system);
+
+		// 読み書きの競合からステージを組み立てる
+		void Build();
+
+		// ステージ順に実行し、最後にコマンドバッファを反映する
+		void Run(World &world, float deltaTime);
+
+		// ステージ(同時に実行できるシステムのまとまり)
+		const std::vector<std::vector<uint32_t>> &GetStages() const { return stages; }
+		const std::vector<System> &GetSystems() const { return systems; }
+
+	private:
+		// 2つのシステムが同時に実行できないか
+		static bool Conflicts(const System &a, const System &b);
+
+		std::vector<System> systems;
+		std::vector<std::vector<uint32_t>> stages;
+		bool dirty = true;
+	};
+}
+
+#include "FrameArena.h"
+#include "JobSystem.h"
+
+namespace ecs
+{
+	template <class... Ts>
+	void CommandBuffer::CreateEntity(const Ts &...components)
+	{
+		Record([=](World &world) { world.CreateEntity(components...); });
+	}
+
+	template <class T>
+	void CommandBuffer::AddComponent(Entity entity, const T &component)
+	{
+		Record([=](World &world) {
+			if (world.IsAlive(entity)) {
+				world.AddComponent(entity, component);
+			}
+			});
+	}
+
+	template <class T>
+	void CommandBuffer::RemoveComponent(Entity entity)
+	{
+		Record([=](World &world) {
+			if (world.IsAlive(entity)) {
+				world.RemoveComponent<T>(entity);
+			}
+			});
+	}
+
+	template <class... Ts>
+	template <class F>
+	void Query<Ts...>::ParallelForEach(F &&func)
+	{
+		Refresh();
+
+		// 処理するチャンクを平らに並べる(フレームアリーナから確保する)
+		FrameVector<std::pair<Archetype *, size_t>> chunks;
+		for (Archetype *archetype : matched_) {
+			for (size_t c = 0; c < archetype->GetChunkCount(); ++c) {
+				chunks.emplace_back(archetype, c);
+			}
+		}
+
+		JobSystem::GetInstance()->ParallelFor(static_cast<uint32_t>(chunks.size()), 1,
+			[&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					ForEachInChunk(chunks[i].first, chunks[i].second, func);
+				}
+			});
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+
+// サブシステム間でEventBusを通して受け渡すイベント
+// リングバッファにそのままコピーするので、いずれもトリビアルコピー可能な型にしておく
+
+// ウィンドウのクライアント領域の大きさが変わった(ウィンドウのスレッドから出す)
+struct WindowResizedEvent
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+};
+
+// 非同期のテクスチャの読み込みが終わり、GPUへの転送コマンドを積んだ(描画スレッドから出す)
+struct TextureLoadedEvent
+{
+	uint32_t textureIndex = 0;
+};
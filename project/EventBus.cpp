@@ -0,0 +1,34 @@
+#include "EventBus.h"
+
+EventBus *EventBus::instance = nullptr;
+
+EventBus *EventBus::GetInstance()
+{
+	if (instance == nullptr) {
+		instance = new EventBus;
+	}
+	return instance;
+}
+
+void EventBus::Finalize()
+{
+	delete instance;
+	instance = nullptr;
+}
+
+void EventBus::Drain(event::DrainPoint drainPoint)
+{
+	for (std::unique_ptr<event::ChannelBase> &channel : channels_) {
+		if (channel && channel->GetDrainPoint() == drainPoint) {
+			channel->Drain();
+		}
+	}
+}
+
+uint32_t EventBus::AllocateChannelId()
+{
+	static std::atomic<uint32_t> nextId { 0 };
+	uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+	assert(id < kMaxChannelCount);
+	return id;
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+#include "RingBuffer.h"
+
+// スレッド間のメッセージ(イベント)の受け渡し
+// イベントの型ごとにチャンネルを作り、どのスレッドからでもPublishでき、
+// 決まったフレームの位置(DrainPoint)でそのスレッドがまとめて取り出して購読者に渡す
+// チャンネルのバッファは作成時に確保するので、イベント1つごとの確保は無い(満杯なら捨てて数える)
+//
+//   EventBus::GetInstance()->CreateChannel<WindowResizedEvent>(16, event::DrainPoint::MainFrame);
+//   EventBus::GetInstance()->Subscribe<WindowResizedEvent>([](std::span<const WindowResizedEvent> events) { ... });
+//   EventBus::GetInstance()->Publish(WindowResizedEvent { width, height }); // 任意のスレッド
+//   EventBus::GetInstance()->Drain(event::DrainPoint::MainFrame); // メインスレッドのフレームの先頭
+namespace event
+{
+	// イベントを取り出して購読者に渡す位置
+	enum class DrainPoint
+	{
+		MainFrame, //!< メインスレッドのフレームの先頭
+		RenderFrame, //!< 描画スレッドのフレームの先頭
+	};
+
+	// 書き手のスレッド数
+	enum class ProducerMode
+	{
+		Multiple, //!< どのスレッドからでもPublishできる
+		Single, //!< 決まった1スレッドだけがPublishする(位置の取り合いが無い分速い)
+	};
+
+	// 型を問わないチャンネルの共通部分
+	class ChannelBase
+	{
+	public:
+		ChannelBase(DrainPoint drainPoint) : drainPoint_(drainPoint) {}
+		virtual ~ChannelBase() = default;
+
+		// 溜まっているイベントを取り出して購読者に渡す
+		virtual void Drain() = 0;
+
+		DrainPoint GetDrainPoint() const { return drainPoint_; }
+		// 満杯で捨てたイベント数
+		uint64_t GetDroppedCount() const { return droppedCount_.load(std::memory_order_relaxed); }
+
+	protected:
+		DrainPoint drainPoint_;
+		std::atomic<uint64_t> droppedCount_ { 0 };
+	};
+
+	// イベントの型ごとのチャンネル
+	template <class T>
+	class Channel : public ChannelBase
+	{
+	public:
+		// 購読者(1回のDrainで取り出したイベントをまとめて渡す)
+		using Handler = std::function<void(std::span<const T> events)>;
+
+		Channel(uint32_t capacity, DrainPoint drainPoint, ProducerMode producerMode)
+			: ChannelBase(drainPoint)
+		{
+			if (producerMode == ProducerMode::Single) {
+				spscBuffer_ = std::make_unique<SpscRingBuffer<T>>(capacity);
+			} else {
+				mpscBuffer_ = std::make_unique<MpscRingBuffer<T>>(capacity);
+			}
+			batch_.reserve(capacity);
+		}
+
+		bool Publish(const T &value)
+		{
+			bool pushed = spscBuffer_ ? spscBuffer_->TryPush(value) : mpscBuffer_->TryPush(value);
+			if (!pushed) {
+				droppedCount_.fetch_add(1, std::memory_order_relaxed);
+			}
+			return pushed;
+		}
+
+		void Subscribe(Handler handler) { handlers_.push_back(std::move(handler)); }
+
+		void Drain() override
+		{
+			// 取り出し始めた時点までに書かれたものだけを渡す(購読者が同じチャンネルに出したものは次のフレームに回る)
+			// 容量分しか溜まらないので、作業用の配列が伸びることはない
+			batch_.clear();
+			uint64_t end = spscBuffer_ ? spscBuffer_->GetPushedCount() : mpscBuffer_->GetPushedCount();
+			T value;
+			while (drainedCount_ < end && (spscBuffer_ ? spscBuffer_->TryPop(value) : mpscBuffer_->TryPop(value))) {
+				batch_.push_back(value);
+				++drainedCount_;
+			}
+			if (batch_.empty()) {
+				return;
+			}
+			for (const Handler &handler : handlers_) {
+				handler(std::span<const T>(batch_));
+			}
+		}
+
+	private:
+		std::unique_ptr<SpscRingBuffer<T>> spscBuffer_;
+		std::unique_ptr<MpscRingBuffer<T>> mpscBuffer_;
+		std::vector<Handler> handlers_;
+		// Drainで取り出したものを購読者に渡すまで置いておく
+		std::vector<T> batch_;
+		uint64_t drainedCount_ = 0;
+	};
+}
+
+// イベントバス
+// チャンネルの作成と購読は起動時(他のスレッドがPublishし始める前)に済ませておく
+class EventBus
+{
+public:
+	// イベントの型の上限
+	static constexpr uint32_t kMaxChannelCount = 64;
+
+public: // メンバ関数
+	// シングルトンインスタンスの取得
+	static EventBus *GetInstance();
+	// 終了
+	void Finalize();
+
+	/// <summary>
+	/// イベントの型Tのチャンネルを作る
+	/// </summary>
+	/// <param name="capacity">1フレームに溜められるイベント数(2の累乗)</param>
+	/// <param name="drainPoint">購読者に渡す位置(購読者はそのスレッドで呼ばれる)</param>
+	template <class T>
+	void CreateChannel(uint32_t capacity, event::DrainPoint drainPoint, event::ProducerMode producerMode = event::ProducerMode::Multiple)
+	{
+		uint32_t id = GetChannelId<T>();
+		assert(!channels_[id]);
+		channels_[id] = std::make_unique<event::Channel<T>>(capacity, drainPoint, producerMode);
+	}
+
+	template <class T>
+	void Subscribe(typename event::Channel<T>::Handler handler)
+	{
+		event::Channel<T> *channel = FindChannel<T>();
+		assert(channel);
+		channel->Subscribe(std::move(handler));
+	}
+
+	// イベントを出す(チャンネルが無い、満杯ならfalseで、イベントは捨てる)
+	template <class T>
+	bool Publish(const T &value)
+	{
+		event::Channel<T> *channel = FindChannel<T>();
+		return channel && channel->Publish(value);
+	}
+
+	// drainPointのチャンネルに溜まっているイベントを購読者に渡す(そのスレッドから呼ぶ)
+	void Drain(event::DrainPoint drainPoint);
+
+	// 満杯で捨てたイベント数
+	template <class T>
+	uint64_t GetDroppedCount()
+	{
+		event::Channel<T> *channel = FindChannel<T>();
+		return channel ? channel->GetDroppedCount() : 0;
+	}
+
+private:
+	static EventBus *instance;
+
+	EventBus() = default;
+	~EventBus() = default;
+	EventBus(EventBus &) = delete;
+	EventBus &operator=(EventBus &) = delete;
+
+private:
+	// 型ごとの番号(最初に使われた順に振る)
+	template <class T>
+	static uint32_t GetChannelId()
+	{
+		static const uint32_t id = AllocateChannelId();
+		return id;
+	}
+	static uint32_t AllocateChannelId();
+
+	template <class T>
+	event::Channel<T> *FindChannel()
+	{
+		return static_cast<event::Channel<T> *>(channels_[GetChannelId<T>()].get());
+	}
+
+	std::array<std::unique_ptr<event::ChannelBase>, kMaxChannelCount> channels_;
+};
@@ -0,0 +1,160 @@
+#include "FrameArena.h"
+#include "Logger.h"
+#include "PerfCounters.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <new>
+
+namespace
+{
+	// キャッシュラインに揃えてスレッド間の偽共有を避ける
+	constexpr size_t kBufferAlignment = 64;
+
+#ifdef _DEBUG
+	// 確保直後と巻き戻し後に埋める値(未初期化読みや解放後の使用を見つけやすくする)
+	constexpr int kAllocatedPattern = 0xCD;
+	constexpr int kFreedPattern = 0xDD;
+#endif
+
+	// 生成済みのアリーナ一覧
+	std::vector<FrameArena *> &GetArenas()
+	{
+		static std::vector<FrameArena *> arenas;
+		return arenas;
+	}
+
+	std::mutex &GetArenasMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+FrameArena::FrameArena(size_t capacity, const char *name) : capacity(capacity), name(name)
+{
+	buffer = static_cast<std::byte *>(::operator new(capacity, std::align_val_t(kBufferAlignment)));
+#ifdef _DEBUG
+	std::memset(buffer, kFreedPattern, capacity);
+#endif
+
+	std::lock_guard<std::mutex> lock(GetArenasMutex());
+	GetArenas().push_back(this);
+}
+
+FrameArena::~FrameArena()
+{
+	{
+		std::lock_guard<std::mutex> lock(GetArenasMutex());
+		std::vector<FrameArena *> &arenas = GetArenas();
+		arenas.erase(std::remove(arenas.begin(), arenas.end(), this), arenas.end());
+	}
+	::operator delete(buffer, std::align_val_t(kBufferAlignment));
+}
+
+void *FrameArena::Allocate(size_t size, size_t alignment)
+{
+	// アラインメントは2のべき乗であること
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	static const PerfCounters::CounterId kAllocations = PerfCounters::Register("memory.frameArenaAllocations");
+	PerfCounters::Add(kAllocations);
+
+	// アリーナ内の位置はバッファ先頭からの相対で揃える(バッファ自体は64バイト境界)
+	size_t begin = AlignUp(offset, (std::min)(alignment, kBufferAlignment));
+	if (alignment <= kBufferAlignment && begin + size <= capacity) {
+		offset = begin + size;
+		highWaterMark = (std::max)(highWaterMark, offset);
+#ifdef _DEBUG
+		std::memset(buffer + begin, kAllocatedPattern, size);
+#endif
+		return buffer + begin;
+	}
+
+	// 溢れた分はヒープから確保する。容量不足の目安として回数と最大要求サイズを残す
+	++overflowCount;
+	largestOverflow = (std::max)(largestOverflow, size);
+	static const PerfCounters::CounterId kHeapAllocations = PerfCounters::Register("memory.frameArenaHeapAllocations");
+	PerfCounters::Add(kHeapAllocations);
+	return ::operator new(size, std::align_val_t((std::max)(alignment, alignof(std::max_align_t))));
+}
+
+void FrameArena::Deallocate(void *pointer, size_t size, size_t alignment)
+{
+	if (pointer == nullptr) {
+		return;
+	}
+	if (!Owns(pointer)) {
+		::operator delete(pointer, std::align_val_t((std::max)(alignment, alignof(std::max_align_t))));
+		return;
+	}
+
+	// 直前の確保なら巻き戻して再利用する(vectorの伸長で古い領域を返す場合など)
+	std::byte *end = static_cast<std::byte *>(pointer) + size;
+	if (end == buffer + offset) {
+		offset = static_cast<size_t>(static_cast<std::byte *>(pointer) - buffer);
+#ifdef _DEBUG
+		std::memset(pointer, kFreedPattern, size);
+#endif
+	}
+}
+
+void FrameArena::Reset()
+{
+#ifdef _DEBUG
+	std::memset(buffer, kFreedPattern, offset);
+#endif
+	offset = 0;
+}
+
+void FrameArena::SetResetWithFrame(bool resetWithFrame)
+{
+	// ResetAllがメインスレッドから読むので一覧と同じロックで守る
+	std::lock_guard<std::mutex> lock(GetArenasMutex());
+	this->resetWithFrame = resetWithFrame;
+}
+
+FrameArena &FrameArena::GetThreadArena()
+{
+	thread_local FrameArena arena(kDefaultCapacity, "Thread");
+	return arena;
+}
+
+uint64_t FrameArena::ResetAll()
+{
+	// 呼び出し元のアリーナは初回なら生成時に一覧のロックを取るので、ロックの前に取得しておく
+	FrameArena &callerArena = GetThreadArena();
+
+	// 他のスレッドのアリーナは持ち主が使っている最中かもしれないので、ワーカーの分だけに限る
+	std::lock_guard<std::mutex> lock(GetArenasMutex());
+	uint64_t frameOverflowCount = 0;
+	for (FrameArena *arena : GetArenas()) {
+		if (arena != &callerArena && !arena->resetWithFrame) {
+			continue;
+		}
+		frameOverflowCount += arena->overflowCount - arena->overflowCountAtFrameStart;
+		arena->overflowCountAtFrameStart = arena->overflowCount;
+		arena->Reset();
+	}
+	return frameOverflowCount;
+}
+
+void FrameArena::Report(std::ostream &os)
+{
+	std::lock_guard<std::mutex> lock(GetArenasMutex());
+	for (FrameArena *arena : GetArenas()) {
+		Logger::Log(os, std::format("FrameArena {} capacity:{}KB high-water:{}KB ({:.0f}%) overflow:{} largest-overflow:{}B",
+			arena->name, arena->capacity / 1024, arena->highWaterMark / 1024,
+			100.0 * double(arena->highWaterMark) / double(arena->capacity), arena->overflowCount, arena->largestOverflow));
+		if (arena->overflowCount != 0) {
+			Logger::Log(os, std::format("FrameArena {} overflowed {} times; raise its capacity", arena->name, arena->overflowCount));
+		}
+	}
+}
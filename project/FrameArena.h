@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// フレームアリーナ(1フレーム分の一時データ用のバンプアロケータ)
+// ソートキー、可視リスト、インスタンス配列などフレーム内で使い捨てるデータをここから確保し、
+// フレーム終端でまとめて巻き戻すことで、定常状態でのヒープ確保を無くす
+// スレッドごとに1つ持ち、確保は持ち主のスレッドからのみ行う
+// ResetAllで巻き戻すのはメインスレッドとジョブのワーカーの分だけで、それ以外のスレッド(描画・I/Oなど)は自分で巻き戻す
+class FrameArena
+{
+public:
+	// スレッドごとのアリーナの既定容量
+	static const size_t kDefaultCapacity = 1024 * 1024;
+
+public: // メンバ関数
+	explicit FrameArena(size_t capacity = kDefaultCapacity, const char *name = "FrameArena");
+	~FrameArena();
+	FrameArena(const FrameArena &) = delete;
+	FrameArena &operator=(const FrameArena &) = delete;
+
+	/// <summary>
+	/// 確保する。容量を超えた場合はヒープから確保して溢れた回数を記録する
+	/// </summary>
+	/// <param name="size">バイト数</param>
+	/// <param name="alignment">アラインメント(2のべき乗)</param>
+	void *Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	// 解放する。アリーナ内のメモリは直前の確保なら巻き戻し、それ以外はReset待ち。溢れた分はヒープに返す
+	void Deallocate(void *pointer, size_t size, size_t alignment);
+
+	// 全て巻き戻す(フレーム終端で呼ぶ)
+	void Reset();
+
+	// アリーナ内のポインタか
+	bool Owns(const void *pointer) const { return pointer >= buffer && pointer < buffer + capacity; }
+
+	// getter
+	const char *GetName() const { return name; }
+	// setter
+	void SetName(const char *name) { this->name = name; }
+	size_t GetCapacity() const { return capacity; }
+	size_t GetUsed() const { return offset; }
+	size_t GetHighWaterMark() const { return highWaterMark; }
+	uint64_t GetOverflowCount() const { return overflowCount; }
+
+	// ResetAllでメインスレッドと一緒に巻き戻すか(ジョブのワーカーが自分のアリーナに設定する)
+	void SetResetWithFrame(bool resetWithFrame);
+
+	// 呼び出し元スレッドのアリーナ(初回呼び出し時に生成)
+	static FrameArena &GetThreadArena();
+	/// <summary>
+	/// 呼び出し元スレッド(メインスレッド)と、SetResetWithFrameを設定したアリーナを巻き戻す(ジョブが走っていないフレーム終端で呼ぶ)
+	/// </summary>
+	/// <returns>巻き戻したアリーナで、前回のResetAllから容量が足りずにヒープから確保した回数(定常状態では0になるはず)</returns>
+	static uint64_t ResetAll();
+	// 全スレッドのアリーナの最大使用量と溢れた回数をログに出す
+	static void Report(std::ostream &os);
+
+private:
+	std::byte *buffer = nullptr;
+	size_t capacity = 0;
+	size_t offset = 0;
+	size_t highWaterMark = 0;
+	uint64_t overflowCount = 0;
+	size_t largestOverflow = 0;
+	// 前回のResetAllの時点のoverflowCount
+	uint64_t overflowCountAtFrameStart = 0;
+	const char *name;
+	bool resetWithFrame = false;
+};
+
+// STLコンテナ用のアロケータ(呼び出し元スレッドのフレームアリーナから確保する)
+// コンテナはフレームをまたいで持ち越さないこと
+template <class T>
+class FrameAllocator
+{
+public:
+	using value_type = T;
+
+	FrameAllocator() : arena(&FrameArena::GetThreadArena()) {}
+	explicit FrameAllocator(FrameArena &arena) : arena(&arena) {}
+	template <class U>
+	FrameAllocator(const FrameAllocator<U> &other) : arena(other.GetArena()) {}
+
+	T *allocate(size_t count) { return static_cast<T *>(arena->Allocate(sizeof(T) * count, alignof(T))); }
+	void deallocate(T *pointer, size_t count) { arena->Deallocate(pointer, sizeof(T) * count, alignof(T)); }
+
+	FrameArena *GetArena() const { return arena; }
+
+	template <class U>
+	bool operator==(const FrameAllocator<U> &other) const { return arena == other.GetArena(); }
+
+private:
+	FrameArena *arena;
+};
+
+// フレームアリーナから確保する配列
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// フレームアリーナから確保する文字列
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
@@ -0,0 +1,57 @@
+#include "GameLoop.h"
+#include <algorithm>
+#include <cassert>
+
+void GameLoop::Initialize(float fixedDeltaTime, uint32_t maxStepsPerFrame)
+{
+	assert(fixedDeltaTime > 0.0f);
+	assert(maxStepsPerFrame > 0);
+
+	fixedDeltaTime_ = fixedDeltaTime;
+	maxStepsPerFrame_ = maxStepsPerFrame;
+
+	// 現在時刻を記録する
+	previousTime_ = std::chrono::steady_clock::now();
+	statisticsTime_ = previousTime_;
+	accumulator_ = 0.0;
+	alpha_ = 0.0f;
+}
+
+uint32_t GameLoop::BeginFrame()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double frameSeconds = std::chrono::duration<double>(now - previousTime_).count();
+	previousTime_ = now;
+
+	// 時間が飛んだ場合に大量のステップを実行しないよう制限する
+	frameSeconds = (std::min)(frameSeconds, kMaxFrameSeconds);
+	accumulator_ += frameSeconds;
+
+	// 蓄積時間から進めるステップ数を決める
+	uint32_t steps = static_cast<uint32_t>(accumulator_ / fixedDeltaTime_);
+	if (steps > maxStepsPerFrame_) {
+		// 追いつけない分は捨てて、ゲームの進行が遅れ続けないようにする
+		double dropped = (steps - maxStepsPerFrame_) * double(fixedDeltaTime_);
+		droppedSeconds_ += dropped;
+		accumulator_ -= dropped;
+		steps = maxStepsPerFrame_;
+	}
+	accumulator_ -= steps * double(fixedDeltaTime_);
+
+	// 残った端数が次のステップまでの割合になる
+	alpha_ = static_cast<float>(accumulator_ / fixedDeltaTime_);
+
+	// 毎秒の計測
+	simulationStepCount_ += steps;
+	++renderFrameCount_;
+	double statisticsSeconds = std::chrono::duration<double>(now - statisticsTime_).count();
+	if (statisticsSeconds >= 1.0) {
+		simulationStepsPerSecond_ = static_cast<float>(simulationStepCount_ / statisticsSeconds);
+		renderFramesPerSecond_ = static_cast<float>(renderFrameCount_ / statisticsSeconds);
+		simulationStepCount_ = 0;
+		renderFrameCount_ = 0;
+		statisticsTime_ = now;
+	}
+
+	return steps;
+}
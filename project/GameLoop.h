@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// 固定ステップのシミュレーションと可変レートの描画を切り離すゲームループ
+class GameLoop
+{
+public: // メンバ関数
+	/// <summary>
+	/// 初期化
+	/// </summary>
+	/// <param name="fixedDeltaTime">シミュレーション1ステップの秒数</param>
+	/// <param name="maxStepsPerFrame">1フレームで追いつきに使う最大ステップ数</param>
+	void Initialize(float fixedDeltaTime = 1.0f / 60.0f, uint32_t maxStepsPerFrame = 5);
+
+	/// <summary>
+	/// フレーム開始。経過時間を蓄積し、このフレームで進めるシミュレーションのステップ数を返す
+	/// </summary>
+	uint32_t BeginFrame();
+
+	// シミュレーション1ステップの秒数
+	float GetFixedDeltaTime() const { return fixedDeltaTime_; }
+	// 直前2回のシミュレーション状態の間の補間係数(0~1)
+	float GetAlpha() const { return alpha_; }
+
+	// 直近1秒間のシミュレーションステップ数
+	float GetSimulationStepsPerSecond() const { return simulationStepsPerSecond_; }
+	// 直近1秒間の描画フレーム数
+	float GetRenderFramesPerSecond() const { return renderFramesPerSecond_; }
+	// 追いつけずに切り捨てた累計秒数
+	double GetDroppedSeconds() const { return droppedSeconds_; }
+
+private:
+	// 1フレームの経過時間の上限(デバッガ停止などで時間が飛んだとき用)
+	static constexpr double kMaxFrameSeconds = 0.25;
+
+	float fixedDeltaTime_ = 1.0f / 60.0f;
+	uint32_t maxStepsPerFrame_ = 5;
+
+	std::chrono::steady_clock::time_point previousTime_;
+	// まだシミュレーションしていない蓄積時間
+	double accumulator_ = 0.0;
+	float alpha_ = 0.0f;
+	double droppedSeconds_ = 0.0;
+
+	// 毎秒の計測用
+	std::chrono::steady_clock::time_point statisticsTime_;
+	uint32_t simulationStepCount_ = 0;
+	uint32_t renderFrameCount_ = 0;
+	float simulationStepsPerSecond_ = 0.0f;
+	float renderFramesPerSecond_ = 0.0f;
+};
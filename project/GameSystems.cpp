@@ -0,0 +1,128 @@
+#include "GameSystems.h"
+#include "Components.h"
+#include "FrameArena.h"
+#include "SpritePool.h"
+#include <cmath>
+
+namespace ecs
+{
+	namespace
+	{
+		float Lerp(float a, float b, float t)
+		{
+			return a + (b - a) * t;
+		}
+	}
+
+	void RegisterSpriteSystems(SystemScheduler &scheduler)
+	{
+		// クエリはシステムごとに持ち、実行のたびに渡されたワールドに合わせる
+		// 前回状態の保存: 座標変換を書き換えるシステムより先に走らせる
+		scheduler.AddSystem({
+			"StorePreviousTransform",
+			MakeComponentMask<Transform2DComponent>(),
+			MakeComponentMask<PreviousTransform2DComponent>(),
+			[query = Query<Transform2DComponent, PreviousTransform2DComponent>()](World &world, float) mutable {
+				query.Bind(world);
+				query.ForEach([](Entity, Transform2DComponent &current, PreviousTransform2DComponent &previous) {
+					previous.value = current;
+					});
+			}
+			});
+
+		// アニメーション: コマを進める
+		scheduler.AddSystem({
+			"Animation",
+			0,
+			MakeComponentMask<AnimationComponent>(),
+			[query = Query<AnimationComponent>()](World &world, float deltaTime) mutable {
+				query.Bind(world);
+				query.ForEach([deltaTime](Entity, AnimationComponent &animation) {
+					animation.timer += deltaTime;
+					while (animation.timer >= animation.frameDuration && animation.frameCount > 1) {
+						animation.timer -= animation.frameDuration;
+						animation.currentFrame = (animation.currentFrame + 1) % animation.frameCount;
+					}
+					});
+			}
+			});
+
+		// コリジョン: 矩形同士の重なりを数える(アニメーションとは競合しないので並列に走る)
+		scheduler.AddSystem({
+			"Collision",
+			MakeComponentMask<Transform2DComponent>(),
+			MakeComponentMask<ColliderComponent>(),
+			[query = Query<Transform2DComponent, ColliderComponent>()](World &world, float) mutable {
+				query.Bind(world);
+
+				// 判定用に位置と大きさを詰めて集める
+				struct Box
+				{
+					math::Vector2 center;
+					math::Vector2 halfSize;
+					uint32_t layer;
+					ColliderComponent *collider;
+				};
+				FrameVector<Box> boxes;
+				boxes.reserve(query.Count());
+				query.ForEach([&boxes](Entity, Transform2DComponent &transform, ColliderComponent &collider) {
+					collider.hitCount = 0;
+					boxes.push_back({ transform.position, collider.halfSize, collider.layer, &collider });
+					});
+
+				for (size_t i = 0; i < boxes.size(); ++i) {
+					for (size_t j = i + 1; j < boxes.size(); ++j) {
+						if (boxes[i].layer != boxes[j].layer) {
+							continue;
+						}
+						if (std::abs(boxes[i].center.x - boxes[j].center.x) <= boxes[i].halfSize.x + boxes[j].halfSize.x &&
+							std::abs(boxes[i].center.y - boxes[j].center.y) <= boxes[i].halfSize.y + boxes[j].halfSize.y) {
+							++boxes[i].collider->hitCount;
+							++boxes[j].collider->hitCount;
+						}
+					}
+				}
+			}
+			});
+	}
+
+	void SyncSprites(World &world, SpritePool &spritePool, float alpha)
+	{
+		// 一致するアーキタイプのキャッシュはワールドが変わったら作り直される
+		static Query<Transform2DComponent, PreviousTransform2DComponent, SpriteComponent> query;
+		query.Bind(world);
+		// スプライトごとに別のバッファを書くので並列に更新できる
+		query.ParallelForEach([&world, &spritePool, alpha](Entity entity, Transform2DComponent &current, PreviousTransform2DComponent &previous, SpriteComponent &spriteComponent) {
+			const Transform2DComponent &from = previous.value;
+			Sprite *sprite = spritePool.Get(spriteComponent.sprite);
+			if (!sprite) {
+				return;
+			}
+			sprite->SetPosition({ Lerp(from.position.x, current.position.x, alpha), Lerp(from.position.y, current.position.y, alpha) });
+			sprite->SetRotation(Lerp(from.rotation, current.rotation, alpha));
+			sprite->SetSize({ Lerp(from.size.x, current.size.x, alpha), Lerp(from.size.y, current.size.y, alpha) });
+			sprite->SetColor(spriteComponent.color);
+
+			// アニメーションを持っていれば切り出し位置を合わせる
+			if (const AnimationComponent *animation = world.GetComponent<AnimationComponent>(entity)) {
+				uint32_t column = animation->currentFrame % animation->columns;
+				uint32_t row = animation->currentFrame / animation->columns;
+				sprite->SetTextureLeftTop({ animation->frameSize.x * float(column), animation->frameSize.y * float(row) });
+				sprite->SetTextureSize(animation->frameSize);
+			}
+			sprite->Update();
+			});
+	}
+
+	void CollectSprites(World &world, SpritePool &spritePool, std::vector<render::SpriteInstance> &sprites)
+	{
+		static Query<SpriteComponent> query;
+		query.Bind(world);
+		sprites.reserve(sprites.size() + query.Count());
+		query.ForEach([&sprites, &spritePool](Entity, SpriteComponent &spriteComponent) {
+			if (const Sprite *sprite = spritePool.Get(spriteComponent.sprite)) {
+				sprites.push_back(sprite->GetRenderInstance());
+			}
+			});
+	}
+}
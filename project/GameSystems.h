@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "ECS.h"
+#include "RenderPacket.h"
+
+class SpritePool;
+
+// スプライト関連のシステム
+namespace ecs
+{
+	// 固定ステップで実行するシミュレーションのシステムを登録する
+	void RegisterSpriteSystems(SystemScheduler &scheduler);
+
+	/// <summary>
+	/// 直前と現在のシミュレーション状態を補間してスプライトに反映する(描画フレームごとに呼ぶ)
+	/// </summary>
+	/// <param name="spritePool">スプライトの実体を持つプール(並列更新中に生成・破棄しないこと)</param>
+	/// <param name="alpha">補間係数(0で直前、1で現在)</param>
+	void SyncSprites(World &world, SpritePool &spritePool, float alpha);
+
+	// スプライトの描画データを描画パケットに集める
+	void CollectSprites(World &world, SpritePool &spritePool, std::vector<render::SpriteInstance> &sprites);
+}
@@ -0,0 +1,351 @@
+#include "GlbModel.h"
+#include "Json.h"
+#include <algorithm>
+#include <format>
+
+namespace
+{
+	// GLBのヘッダとチャンクの識別子
+	constexpr uint32_t kGlbMagic = 0x46546C67; // "glTF"
+	constexpr uint32_t kGlbVersion = 2;
+	constexpr uint32_t kChunkTypeJson = 0x4E4F534A; // "JSON"
+	constexpr uint32_t kChunkTypeBin = 0x004E4942; // "BIN\0"
+	constexpr size_t kHeaderSize = 12;
+	constexpr size_t kChunkHeaderSize = 8;
+
+	uint32_t ReadUint32(std::span<const std::byte> bytes, size_t offset)
+	{
+		uint32_t value = 0;
+		std::memcpy(&value, bytes.data() + offset, sizeof(value));
+		return value;
+	}
+
+	uint32_t GetComponentSize(GlbModel::ComponentType componentType)
+	{
+		switch (componentType) {
+		case GlbModel::ComponentType::Byte:
+		case GlbModel::ComponentType::UnsignedByte:
+			return 1;
+		case GlbModel::ComponentType::Short:
+		case GlbModel::ComponentType::UnsignedShort:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	// アクセサのtypeから成分数を求める(不明なら0)
+	uint32_t GetComponentCount(const std::string &type)
+	{
+		if (type == "SCALAR") { return 1; }
+		if (type == "VEC2") { return 2; }
+		if (type == "VEC3") { return 3; }
+		if (type == "VEC4") { return 4; }
+		if (type == "MAT2") { return 4; }
+		if (type == "MAT3") { return 9; }
+		if (type == "MAT4") { return 16; }
+		return 0;
+	}
+
+	int32_t GetIndex(const json::Value &value)
+	{
+		return value.IsNumber() ? static_cast<int32_t>(value.GetInt()) : -1;
+	}
+}
+
+uint32_t GlbModel::Accessor::GetElementSize() const
+{
+	return GetComponentSize(componentType) * componentCount;
+}
+
+int32_t GlbModel::Primitive::FindAttribute(std::string_view name) const
+{
+	for (const std::pair<std::string, uint32_t> &attribute : attributes) {
+		if (attribute.first == name) {
+			return static_cast<int32_t>(attribute.second);
+		}
+	}
+	return -1;
+}
+
+bool GlbModel::Load(const std::string &filePath)
+{
+	bufferViews.clear();
+	accessors.clear();
+	meshes.clear();
+	nodes.clear();
+	skins.clear();
+	materials.clear();
+	sceneRoots.clear();
+	binChunk = {};
+	error.clear();
+
+	if (!file.Open(filePath)) {
+		return Fail(std::format("cannot open {}", filePath));
+	}
+	std::span<const std::byte> bytes = file.GetBytes();
+
+	// ヘッダ
+	if (bytes.size() < kHeaderSize + kChunkHeaderSize || ReadUint32(bytes, 0) != kGlbMagic) {
+		return Fail("not a GLB file");
+	}
+	if (ReadUint32(bytes, 4) != kGlbVersion) {
+		return Fail("unsupported GLB version");
+	}
+	size_t totalLength = (std::min)(size_t(ReadUint32(bytes, 8)), bytes.size());
+
+	// 1つ目のチャンクはJSON
+	size_t jsonLength = ReadUint32(bytes, kHeaderSize);
+	if (ReadUint32(bytes, kHeaderSize + 4) != kChunkTypeJson || kHeaderSize + kChunkHeaderSize + jsonLength > totalLength) {
+		return Fail("missing JSON chunk");
+	}
+	std::string_view jsonText(reinterpret_cast<const char *>(bytes.data() + kHeaderSize + kChunkHeaderSize), jsonLength);
+
+	// 2つ目のチャンクがあればBIN(チャンクは4バイト境界に揃っている)
+	size_t binHeader = kHeaderSize + kChunkHeaderSize + jsonLength;
+	if (binHeader % 4 != 0) {
+		return Fail("misaligned BIN chunk");
+	}
+	if (binHeader + kChunkHeaderSize <= totalLength && ReadUint32(bytes, binHeader + 4) == kChunkTypeBin) {
+		size_t binLength = ReadUint32(bytes, binHeader);
+		if (binHeader + kChunkHeaderSize + binLength > totalLength) {
+			return Fail("truncated BIN chunk");
+		}
+		binChunk = bytes.subspan(binHeader + kChunkHeaderSize, binLength);
+	}
+
+	return ParseJson(jsonText) && Validate();
+}
+
+bool GlbModel::IsTightlyPacked(uint32_t accessor) const
+{
+	const Accessor &info = accessors[accessor];
+	uint32_t stride = bufferViews[info.bufferView].byteStride;
+	return stride == 0 || stride == info.GetElementSize();
+}
+
+std::span<const std::byte> GlbModel::GetAccessorBytes(uint32_t accessor) const
+{
+	// インターリーブされたアクセサはGetAccessorViewで読む
+	assert(IsTightlyPacked(accessor));
+	const Accessor &info = accessors[accessor];
+	const BufferView &view = bufferViews[info.bufferView];
+	return binChunk.subspan(size_t(view.byteOffset) + info.byteOffset, size_t(info.GetElementSize()) * info.count);
+}
+
+bool GlbModel::ParseJson(std::string_view text)
+{
+	json::Value root;
+	std::string parseError;
+	if (!json::Parse(text, root, &parseError)) {
+		return Fail("JSON: " + parseError);
+	}
+
+	// バッファはGLB内蔵の1つだけ扱う
+	const json::Value &buffers = root["buffers"];
+	for (size_t i = 0; i < buffers.Size(); ++i) {
+		if (buffers[i].Find("uri")) {
+			return Fail("external buffers are not supported");
+		}
+	}
+
+	const json::Value &bufferViewArray = root["bufferViews"];
+	for (size_t i = 0; i < bufferViewArray.Size(); ++i) {
+		const json::Value &value = bufferViewArray[i];
+		if (value["buffer"].GetInt() != 0) {
+			return Fail("buffer views must refer to the GLB BIN chunk");
+		}
+		BufferView view;
+		view.byteOffset = static_cast<uint32_t>(value["byteOffset"].GetInt());
+		view.byteLength = static_cast<uint32_t>(value["byteLength"].GetInt());
+		view.byteStride = static_cast<uint32_t>(value["byteStride"].GetInt());
+		bufferViews.push_back(view);
+	}
+
+	const json::Value &accessorArray = root["accessors"];
+	for (size_t i = 0; i < accessorArray.Size(); ++i) {
+		const json::Value &value = accessorArray[i];
+		if (value.Find("sparse")) {
+			return Fail("sparse accessors are not supported");
+		}
+		Accessor accessor;
+		accessor.bufferView = GetIndex(value["bufferView"]);
+		accessor.byteOffset = static_cast<uint32_t>(value["byteOffset"].GetInt());
+		accessor.componentType = static_cast<ComponentType>(value["componentType"].GetInt());
+		accessor.componentCount = GetComponentCount(value["type"].GetString());
+		accessor.count = static_cast<uint32_t>(value["count"].GetInt());
+		accessor.normalized = value["normalized"].GetBool();
+		if (accessor.componentCount == 0) {
+			return Fail(std::format("accessor {} has unknown type", i));
+		}
+		accessors.push_back(accessor);
+	}
+
+	const json::Value &meshArray = root["meshes"];
+	for (size_t i = 0; i < meshArray.Size(); ++i) {
+		const json::Value &value = meshArray[i];
+		Mesh mesh;
+		mesh.name = value["name"].GetString();
+		const json::Value &primitiveArray = value["primitives"];
+		for (size_t p = 0; p < primitiveArray.Size(); ++p) {
+			const json::Value &primitiveValue = primitiveArray[p];
+			Primitive primitive;
+			for (const auto &[name, accessor] : primitiveValue["attributes"].GetMembers()) {
+				primitive.attributes.emplace_back(name, static_cast<uint32_t>(accessor.GetInt()));
+			}
+			primitive.indices = GetIndex(primitiveValue["indices"]);
+			primitive.material = GetIndex(primitiveValue["material"]);
+			primitive.mode = static_cast<uint32_t>(primitiveValue["mode"].GetInt(4));
+			mesh.primitives.push_back(std::move(primitive));
+		}
+		meshes.push_back(std::move(mesh));
+	}
+
+	const json::Value &nodeArray = root["nodes"];
+	for (size_t i = 0; i < nodeArray.Size(); ++i) {
+		const json::Value &value = nodeArray[i];
+		Node node;
+		node.name = value["name"].GetString();
+		node.mesh = GetIndex(value["mesh"]);
+		node.skin = GetIndex(value["skin"]);
+		const json::Value &children = value["children"];
+		for (size_t c = 0; c < children.Size(); ++c) {
+			node.children.push_back(static_cast<uint32_t>(children[c].GetInt()));
+		}
+		if (value.Find("matrix")) {
+			return Fail("node matrices are not supported; export TRS instead");
+		}
+		const json::Value &translation = value["translation"];
+		if (translation.Size() == 3) {
+			node.translation = { translation[0].GetFloat(), translation[1].GetFloat(), translation[2].GetFloat() };
+		}
+		const json::Value &rotation = value["rotation"];
+		if (rotation.Size() == 4) {
+			node.rotation = { rotation[0].GetFloat(), rotation[1].GetFloat(), rotation[2].GetFloat(), rotation[3].GetFloat() };
+		}
+		const json::Value &scale = value["scale"];
+		if (scale.Size() == 3) {
+			node.scale = { scale[0].GetFloat(), scale[1].GetFloat(), scale[2].GetFloat() };
+		}
+		nodes.push_back(std::move(node));
+	}
+
+	const json::Value &skinArray = root["skins"];
+	for (size_t i = 0; i < skinArray.Size(); ++i) {
+		const json::Value &value = skinArray[i];
+		Skin skin;
+		const json::Value &joints = value["joints"];
+		for (size_t j = 0; j < joints.Size(); ++j) {
+			skin.joints.push_back(static_cast<uint32_t>(joints[j].GetInt()));
+		}
+		skin.inverseBindMatrices = GetIndex(value["inverseBindMatrices"]);
+		skins.push_back(std::move(skin));
+	}
+
+	const json::Value &materialArray = root["materials"];
+	for (size_t i = 0; i < materialArray.Size(); ++i) {
+		const json::Value &value = materialArray[i];
+		Material material;
+		material.name = value["name"].GetString();
+		const json::Value &pbr = value["pbrMetallicRoughness"];
+		const json::Value &baseColor = pbr["baseColorFactor"];
+		if (baseColor.Size() == 4) {
+			material.baseColorFactor = { baseColor[0].GetFloat(), baseColor[1].GetFloat(), baseColor[2].GetFloat(), baseColor[3].GetFloat() };
+		}
+		material.baseColorTexture = GetIndex(pbr["baseColorTexture"]["index"]);
+		materials.push_back(std::move(material));
+	}
+
+	// 既定のシーンのルートノード
+	const json::Value &scene = root["scenes"][static_cast<size_t>(root["scene"].GetInt(0))];
+	const json::Value &roots = scene["nodes"];
+	for (size_t i = 0; i < roots.Size(); ++i) {
+		sceneRoots.push_back(static_cast<uint32_t>(roots[i].GetInt()));
+	}
+	return true;
+}
+
+bool GlbModel::Validate()
+{
+	for (size_t i = 0; i < bufferViews.size(); ++i) {
+		const BufferView &view = bufferViews[i];
+		if (size_t(view.byteOffset) + view.byteLength > binChunk.size()) {
+			return Fail(std::format("buffer view {} is out of the BIN chunk", i));
+		}
+	}
+
+	for (size_t i = 0; i < accessors.size(); ++i) {
+		const Accessor &accessor = accessors[i];
+		if (accessor.bufferView < 0 || accessor.bufferView >= static_cast<int32_t>(bufferViews.size())) {
+			return Fail(std::format("accessor {} has no buffer view", i));
+		}
+		const BufferView &view = bufferViews[accessor.bufferView];
+		uint32_t elementSize = accessor.GetElementSize();
+		uint32_t stride = view.byteStride != 0 ? view.byteStride : elementSize;
+		if (accessor.count > 0 && size_t(accessor.byteOffset) + size_t(stride) * (accessor.count - 1) + elementSize > view.byteLength) {
+			return Fail(std::format("accessor {} is out of its buffer view", i));
+		}
+		// spanで読めるよう成分サイズに揃っていること
+		if ((size_t(view.byteOffset) + accessor.byteOffset) % GetComponentSize(accessor.componentType) != 0) {
+			return Fail(std::format("accessor {} is misaligned", i));
+		}
+	}
+
+	auto isValidAccessor = [this](int32_t index) { return index >= 0 && index < static_cast<int32_t>(accessors.size()); };
+	for (const Mesh &mesh : meshes) {
+		for (const Primitive &primitive : mesh.primitives) {
+			for (const std::pair<std::string, uint32_t> &attribute : primitive.attributes) {
+				if (!isValidAccessor(static_cast<int32_t>(attribute.second))) {
+					return Fail(std::format("mesh {} attribute {} has invalid accessor", mesh.name, attribute.first));
+				}
+			}
+			if (primitive.indices >= 0) {
+				if (!isValidAccessor(primitive.indices)) {
+					return Fail(std::format("mesh {} has invalid index accessor", mesh.name));
+				}
+				const Accessor &indices = accessors[primitive.indices];
+				if (indices.componentCount != 1 || (indices.componentType != ComponentType::UnsignedByte &&
+					indices.componentType != ComponentType::UnsignedShort && indices.componentType != ComponentType::UnsignedInt)) {
+					return Fail(std::format("mesh {} indices must be unsigned scalars", mesh.name));
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const Node &node = nodes[i];
+		if (node.mesh >= static_cast<int32_t>(meshes.size()) || node.skin >= static_cast<int32_t>(skins.size())) {
+			return Fail(std::format("node {} refers to a missing mesh or skin", i));
+		}
+		for (uint32_t child : node.children) {
+			if (child >= nodes.size()) {
+				return Fail(std::format("node {} has an invalid child", i));
+			}
+		}
+	}
+	for (const Skin &skin : skins) {
+		for (uint32_t joint : skin.joints) {
+			if (joint >= nodes.size()) {
+				return Fail("skin has an invalid joint");
+			}
+		}
+		if (skin.inverseBindMatrices >= 0 && (!isValidAccessor(skin.inverseBindMatrices) ||
+			accessors[skin.inverseBindMatrices].componentCount != 16 || accessors[skin.inverseBindMatrices].count < skin.joints.size())) {
+			return Fail("skin has invalid inverse bind matrices");
+		}
+	}
+	for (uint32_t root : sceneRoots) {
+		if (root >= nodes.size()) {
+			return Fail("scene has an invalid root node");
+		}
+	}
+	return true;
+}
+
+bool GlbModel::Fail(std::string message)
+{
+	error = std::move(message);
+	file.Close();
+	binChunk = {};
+	return false;
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "MappedFile.h"
+#include "MathTypes.h"
+
+// glTF 2.0 バイナリ(GLB)モデル
+// ファイルをメモリマップし、JSONチャンクは読み込み時に一度だけ解析する
+// アクセサはBINチャンクを直接指す型付きのspanとして取り出せるので、
+// 頂点・インデックスはそのままアップロード先へコピーできる(中間バッファを作らない)
+class GlbModel
+{
+public:
+	// アクセサの成分の型
+	enum class ComponentType : uint32_t
+	{
+		Byte = 5120,
+		UnsignedByte = 5121,
+		Short = 5122,
+		UnsignedShort = 5123,
+		UnsignedInt = 5125,
+		Float = 5126,
+	};
+
+	struct BufferView
+	{
+		uint32_t byteOffset = 0; //!< BINチャンク先頭からのオフセット
+		uint32_t byteLength = 0;
+		uint32_t byteStride = 0; //!< 0なら要素が詰まっている
+	};
+
+	struct Accessor
+	{
+		int32_t bufferView = -1;
+		uint32_t byteOffset = 0; //!< バッファビュー先頭からのオフセット
+		ComponentType componentType = ComponentType::Float;
+		uint32_t componentCount = 1; //!< SCALAR=1, VEC2=2, VEC3=3, VEC4=4, MAT4=16
+		uint32_t count = 0;
+		bool normalized = false;
+
+		// 1要素のバイト数
+		uint32_t GetElementSize() const;
+	};
+
+	struct Primitive
+	{
+		// 頂点属性名(POSITION, NORMAL, TEXCOORD_0 など)とアクセサ番号
+		std::vector<std::pair<std::string, uint32_t>> attributes;
+		int32_t indices = -1;
+		int32_t material = -1;
+		uint32_t mode = 4; //!< 4 = TRIANGLES
+
+		// 属性のアクセサ番号(無ければ-1)
+		int32_t FindAttribute(std::string_view name) const;
+	};
+
+	struct Mesh
+	{
+		std::string name;
+		std::vector<Primitive> primitives;
+	};
+
+	struct Node
+	{
+		std::string name;
+		int32_t mesh = -1;
+		int32_t skin = -1;
+		std::vector<uint32_t> children;
+		math::Vector3 translation = { 0.0f,0.0f,0.0f };
+		math::Quaternion rotation = { 0.0f,0.0f,0.0f,1.0f };
+		math::Vector3 scale = { 1.0f,1.0f,1.0f };
+	};
+
+	struct Skin
+	{
+		std::vector<uint32_t> joints; //!< 関節のノード番号
+		int32_t inverseBindMatrices = -1; //!< MAT4のアクセサ番号
+	};
+
+	struct Material
+	{
+		std::string name;
+		math::Vector4 baseColorFactor = { 1.0f,1.0f,1.0f,1.0f };
+		int32_t baseColorTexture = -1;
+	};
+
+	// 要素の間隔が要素サイズと異なる(インターリーブされた)アクセサを読むためのビュー
+	template <class T>
+	class StridedView
+	{
+	public:
+		StridedView(const std::byte *data, uint32_t count, uint32_t stride) : data(data), count(count), stride(stride) {}
+
+		uint32_t size() const { return count; }
+		T operator[](uint32_t index) const
+		{
+			T value;
+			std::memcpy(&value, data + size_t(stride) * index, sizeof(T));
+			return value;
+		}
+
+	private:
+		const std::byte *data;
+		uint32_t count;
+		uint32_t stride;
+	};
+
+public: // メンバ関数
+	/// <summary>
+	/// 読み込む
+	/// </summary>
+	/// <returns>成功したか(失敗時の理由はGetError)</returns>
+	bool Load(const std::string &filePath);
+
+	const std::string &GetError() const { return error; }
+
+	const std::vector<BufferView> &GetBufferViews() const { return bufferViews; }
+	const std::vector<Accessor> &GetAccessors() const { return accessors; }
+	const std::vector<Mesh> &GetMeshes() const { return meshes; }
+	const std::vector<Node> &GetNodes() const { return nodes; }
+	const std::vector<Skin> &GetSkins() const { return skins; }
+	const std::vector<Material> &GetMaterials() const { return materials; }
+	const std::vector<uint32_t> &GetSceneRoots() const { return sceneRoots; }
+
+	// アクセサの要素が隙間なく並んでいるか
+	bool IsTightlyPacked(uint32_t accessor) const;
+
+	// アクセサの中身(要素が詰まっていること)。アップロード先へそのままコピーできる
+	std::span<const std::byte> GetAccessorBytes(uint32_t accessor) const;
+
+	// アクセサを型付きの配列として見る(要素が詰まっていて、Tが1要素と同じ大きさであること)
+	template <class T>
+	std::span<const T> GetAccessorSpan(uint32_t accessor) const
+	{
+		assert(accessors[accessor].GetElementSize() == sizeof(T));
+		std::span<const std::byte> bytes = GetAccessorBytes(accessor);
+		// BINチャンク内のオフセットは成分サイズの倍数になる決まりなので、成分単位の型なら揃っている
+		assert(reinterpret_cast<uintptr_t>(bytes.data()) % alignof(T) == 0);
+		return { reinterpret_cast<const T *>(bytes.data()), accessors[accessor].count };
+	}
+
+	// アクセサを間隔付きで見る(インターリーブされていてもよい)
+	template <class T>
+	StridedView<T> GetAccessorView(uint32_t accessor) const
+	{
+		const Accessor &info = accessors[accessor];
+		assert(info.GetElementSize() == sizeof(T));
+		const BufferView &view = bufferViews[info.bufferView];
+		uint32_t stride = view.byteStride != 0 ? view.byteStride : info.GetElementSize();
+		return StridedView<T>(binChunk.data() + view.byteOffset + info.byteOffset, info.count, stride);
+	}
+
+private:
+	// JSONチャンクを解析する
+	bool ParseJson(std::string_view text);
+	// 範囲などを確かめる
+	bool Validate();
+	bool Fail(std::string message);
+
+	MappedFile file;
+	std::span<const std::byte> binChunk;
+
+	std::vector<BufferView> bufferViews;
+	std::vector<Accessor> accessors;
+	std::vector<Mesh> meshes;
+	std::vector<Node> nodes;
+	std::vector<Skin> skins;
+	std::vector<Material> materials;
+	std::vector<uint32_t> sceneRoots;
+
+	std::string error;
+};
@@ -0,0 +1,175 @@
+#include "InitGraph.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <format>
+
+InitGraph::TaskId InitGraph::AddTask(const std::string &name, const std::vector<TaskId> &dependencies, std::function<void()> function, Affinity affinity)
+{
+	TaskId id = static_cast<TaskId>(tasks_.size());
+	Task task;
+	task.name = name;
+	task.dependencies = dependencies;
+	task.function = std::move(function);
+	task.affinity = affinity;
+	tasks_.push_back(std::move(task));
+
+	// 依存先は登録済みのタスクに限るので、循環は起きない
+	for (TaskId dependency : dependencies) {
+		assert(dependency < id);
+		tasks_[dependency].dependents.push_back(id);
+	}
+	return id;
+}
+
+void InitGraph::Run()
+{
+	startTime_ = std::chrono::steady_clock::now();
+	mainThreadId_ = std::this_thread::get_id();
+	completedCount_ = 0;
+	mainThreadQueue_.clear();
+
+	// 依存の無いタスクから始める
+	std::vector<TaskId> ready;
+	for (TaskId id = 0; id < tasks_.size(); ++id) {
+		tasks_[id].remainingDependencies = static_cast<uint32_t>(tasks_[id].dependencies.size());
+		if (tasks_[id].remainingDependencies == 0) {
+			ready.push_back(id);
+		}
+	}
+	for (TaskId id : ready) {
+		Schedule(id);
+	}
+
+	// メインスレッドのタスクを実行しながら、全てのタスクが終わるまで待つ
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (completedCount_ < tasks_.size()) {
+		condition_.wait(lock, [this]() { return !mainThreadQueue_.empty() || completedCount_ == tasks_.size(); });
+		while (!mainThreadQueue_.empty()) {
+			TaskId id = mainThreadQueue_.front();
+			mainThreadQueue_.pop_front();
+			lock.unlock();
+			Execute(id);
+			lock.lock();
+		}
+	}
+	totalMilliseconds_ = GetElapsedMilliseconds();
+}
+
+void InitGraph::Schedule(TaskId task)
+{
+	if (tasks_[task].affinity == Affinity::MainThread) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			mainThreadQueue_.push_back(task);
+		}
+		condition_.notify_all();
+	} else {
+		JobSystem::GetInstance()->Submit([this, task]() { Execute(task); });
+	}
+}
+
+void InitGraph::Execute(TaskId task)
+{
+	Task &current = tasks_[task];
+	current.timing.onMainThread = std::this_thread::get_id() == mainThreadId_;
+	current.timing.startMilliseconds = GetElapsedMilliseconds();
+	current.function();
+	current.timing.endMilliseconds = GetElapsedMilliseconds();
+
+	// 後続のタスクの依存を減らし、揃ったものを実行先に渡す
+	std::vector<TaskId> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (TaskId dependent : current.dependents) {
+			if (--tasks_[dependent].remainingDependencies == 0) {
+				ready.push_back(dependent);
+			}
+		}
+		++completedCount_;
+		// 最後のタスクならRunが戻って破棄されうるので、ロック中に通知する
+		condition_.notify_all();
+	}
+	for (TaskId id : ready) {
+		Schedule(id);
+	}
+}
+
+double InitGraph::GetElapsedMilliseconds() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime_).count();
+}
+
+double InitGraph::GetSerialMilliseconds() const
+{
+	double total = 0.0;
+	for (const Task &task : tasks_) {
+		total += task.timing.endMilliseconds - task.timing.startMilliseconds;
+	}
+	return total;
+}
+
+std::vector<InitGraph::TaskId> InitGraph::GetCriticalPath() const
+{
+	std::vector<TaskId> path;
+	if (tasks_.empty()) {
+		return path;
+	}
+
+	// 最後に終わったタスクから、開始を待たせていた(最後に終わった)依存を辿る
+	auto endsBefore = [this](TaskId a, TaskId b) { return tasks_[a].timing.endMilliseconds < tasks_[b].timing.endMilliseconds; };
+	TaskId current = 0;
+	for (TaskId id = 1; id < tasks_.size(); ++id) {
+		if (endsBefore(current, id)) {
+			current = id;
+		}
+	}
+	while (true) {
+		path.push_back(current);
+		const std::vector<TaskId> &dependencies = tasks_[current].dependencies;
+		if (dependencies.empty()) {
+			break;
+		}
+		current = *std::max_element(dependencies.begin(), dependencies.end(), endsBefore);
+	}
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+void InitGraph::Report(std::ostream &os) const
+{
+	double serialMilliseconds = GetSerialMilliseconds();
+	Logger::Log(os, std::format("[Init] total:{:.2f}ms serial:{:.2f}ms ({:.2f}x) tasks:{}",
+		totalMilliseconds_, serialMilliseconds, serialMilliseconds / (std::max)(totalMilliseconds_, 0.001), tasks_.size()));
+
+	// 開始の早い順
+	std::vector<TaskId> order(tasks_.size());
+	for (TaskId id = 0; id < tasks_.size(); ++id) {
+		order[id] = id;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](TaskId a, TaskId b) {
+		return tasks_[a].timing.startMilliseconds < tasks_[b].timing.startMilliseconds;
+		});
+	for (TaskId id : order) {
+		const TaskTiming &timing = tasks_[id].timing;
+		Logger::Log(os, std::format("[Init]   {:<24} start:{:8.2f}ms time:{:8.2f}ms {}",
+			tasks_[id].name, timing.startMilliseconds, timing.endMilliseconds - timing.startMilliseconds, timing.onMainThread ? "main" : "worker"));
+	}
+
+	// クリティカルパス: タスクの時間と、依存が終わってから始まるまでの待ち
+	std::string path;
+	double previousEnd = 0.0;
+	for (TaskId id : GetCriticalPath()) {
+		const TaskTiming &timing = tasks_[id].timing;
+		if (!path.empty()) {
+			path += " -> ";
+		}
+		path += std::format("{} {:.2f}ms", tasks_[id].name, timing.endMilliseconds - timing.startMilliseconds);
+		if (timing.startMilliseconds - previousEnd >= 0.1) {
+			path += std::format(" (wait {:.2f}ms)", timing.startMilliseconds - previousEnd);
+		}
+		previousEnd = timing.endMilliseconds;
+	}
+	Logger::Log(os, "[Init] critical path: " + path);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 起動処理の依存グラフ
+// サブシステムの初期化を依存関係つきのタスクとして登録し、依存が済んだものからジョブシステムで並列に実行する
+// ウィンドウや入力のようにメインスレッドでなければならない処理は、Runを呼んだスレッドで実行する
+// 終了後は各タスクの開始・終了時刻と、起動時間を決めたタスクの連なり(クリティカルパス)をログに出せる
+class InitGraph
+{
+public:
+	using TaskId = uint32_t;
+
+	// タスクを実行するスレッド
+	enum class Affinity
+	{
+		Any, //!< ジョブシステムのワーカー
+		MainThread, //!< Runを呼んだスレッド
+	};
+
+	// 1タスク分の計測結果(Runの開始からのミリ秒)
+	struct TaskTiming
+	{
+		double startMilliseconds = 0.0;
+		double endMilliseconds = 0.0;
+		bool onMainThread = false;
+	};
+
+public: // メンバ関数
+	/// <summary>
+	/// タスクを登録する
+	/// </summary>
+	/// <param name="dependencies">先に終わっている必要のあるタスク(登録済みのものに限る)</param>
+	TaskId AddTask(const std::string &name, const std::vector<TaskId> &dependencies, std::function<void()> function, Affinity affinity = Affinity::Any);
+
+	// 全てのタスクを依存順に実行し、終わるまで待つ(メインスレッドから呼ぶ)
+	void Run();
+
+	// 起動時間を決めたタスクの並び(最後に終わったタスクから、最後に終わった依存を辿る)
+	std::vector<TaskId> GetCriticalPath() const;
+
+	// 各タスクの時刻とクリティカルパスをログに出す
+	void Report(std::ostream &os) const;
+
+	// getter
+	const std::string &GetName(TaskId task) const { return tasks_[task].name; }
+	const TaskTiming &GetTiming(TaskId task) const { return tasks_[task].timing; }
+	// 全体の時間
+	double GetTotalMilliseconds() const { return totalMilliseconds_; }
+	// 全タスクの時間の合計(順番に実行した場合の目安)
+	double GetSerialMilliseconds() const;
+
+private:
+	struct Task
+	{
+		std::string name;
+		std::vector<TaskId> dependencies;
+		std::vector<TaskId> dependents;
+		std::function<void()> function;
+		Affinity affinity = Affinity::Any;
+		uint32_t remainingDependencies = 0;
+		TaskTiming timing;
+	};
+
+	// 依存が済んだタスクを実行先に渡す
+	void Schedule(TaskId task);
+	// タスクを実行し、後続のタスクの依存を減らす
+	void Execute(TaskId task);
+
+	double GetElapsedMilliseconds() const;
+
+	std::vector<Task> tasks_;
+	std::chrono::steady_clock::time_point startTime_;
+	std::thread::id mainThreadId_;
+	double totalMilliseconds_ = 0.0;
+
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	// メインスレッドで実行を待つタスク
+	std::deque<TaskId> mainThreadQueue_;
+	uint32_t completedCount_ = 0;
+};
@@ -0,0 +1,155 @@
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+JobSystem *JobSystem::instance = nullptr;
+
+JobSystem *JobSystem::GetInstance()
+{
+	if (instance == nullptr) {
+		instance = new JobSystem;
+	}
+	return instance;
+}
+
+void JobSystem::Finalize()
+{
+	// ワーカーに停止を通知して合流する
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	condition.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+
+	delete instance;
+	instance = nullptr;
+}
+
+void JobSystem::Initialize(uint32_t workerCount)
+{
+	// 二重初期化チェック
+	assert(workers.empty());
+
+	if (workerCount == 0) {
+		// メインスレッドの分を1つ空けておく
+		uint32_t hardwareCount = std::thread::hardware_concurrency();
+		workerCount = hardwareCount > 1 ? hardwareCount - 1 : 1;
+	}
+
+	workerStatistics = std::make_unique<WorkerStatistics[]>(workerCount);
+	workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		workers.emplace_back([this, i]() { WorkerMain(i); });
+	}
+}
+
+void JobSystem::Submit(std::function<void()> job, Counter *counter)
+{
+	if (counter) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// 未初期化ならその場で実行する
+	if (workers.empty()) {
+		Job inlineJob { std::move(job), counter };
+		Execute(inlineJob);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back({ std::move(job), counter });
+	}
+	condition.notify_one();
+}
+
+void JobSystem::Wait(Counter &counter)
+{
+	while (counter.pending.load(std::memory_order_acquire) != 0) {
+		// 待っている間も手伝う
+		if (!RunOne()) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t groupSize, const std::function<void(uint32_t begin, uint32_t end)> &func)
+{
+	if (count == 0) {
+		return;
+	}
+	groupSize = (std::max)(groupSize, 1u);
+
+	// 1グループで収まるなら分割しない
+	if (count <= groupSize || workers.empty()) {
+		func(0, count);
+		return;
+	}
+
+	Counter counter;
+	for (uint32_t begin = groupSize; begin < count; begin += groupSize) {
+		uint32_t end = (std::min)(begin + groupSize, count);
+		Submit([&func, begin, end]() { func(begin, end); }, &counter);
+	}
+	// 先頭のグループは呼び出し元スレッドで処理する
+	func(0, groupSize);
+	Wait(counter);
+}
+
+bool JobSystem::RunOne()
+{
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (queue.empty()) {
+			return false;
+		}
+		job = std::move(queue.front());
+		queue.pop_front();
+	}
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Execute(Job &job)
+{
+	job.function();
+	if (job.counter) {
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void JobSystem::WorkerMain(uint32_t workerIndex)
+{
+	WorkerStatistics &statistics = workerStatistics[workerIndex];
+
+	// ワーカーのフレームアリーナはメインスレッドがフレーム終端でまとめて巻き戻す
+	FrameArena &frameArena = FrameArena::GetThreadArena();
+	frameArena.SetName("Worker");
+	frameArena.SetResetWithFrame(true);
+
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stop || !queue.empty(); });
+			if (stop && queue.empty()) {
+				return;
+			}
+			job = std::move(queue.front());
+			queue.pop_front();
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Execute(job);
+		// 書くのはこのワーカーだけなので、読み出して足して書き戻すだけでよい
+		int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		statistics.busyNanoseconds.store(statistics.busyNanoseconds.load(std::memory_order_relaxed) + elapsed, std::memory_order_relaxed);
+		statistics.jobCount.store(statistics.jobCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ジョブシステム(ワーカースレッドプール)
+class JobSystem
+{
+public:
+	// ジョブ完了待ち用のカウンタ
+	struct Counter
+	{
+		std::atomic<uint32_t> pending { 0 };
+	};
+
+public: // メンバ関数
+	// シングルトンインスタンスの取得
+	static JobSystem *GetInstance();
+	// 終了
+	void Finalize();
+
+	/// <summary>
+	/// 初期化
+	/// </summary>
+	/// <param name="workerCount">ワーカースレッド数(0ならハードウェアスレッド数-1)</param>
+	void Initialize(uint32_t workerCount = 0);
+
+	/// <summary>
+	/// ジョブを投入する
+	/// </summary>
+	/// <param name="job">実行する処理</param>
+	/// <param name="counter">完了時にデクリメントされるカウンタ(任意)</param>
+	void Submit(std::function<void()> job, Counter *counter = nullptr);
+
+	// カウンタが0になるまで待つ。待っている間は呼び出し元スレッドもジョブを処理する
+	void Wait(Counter &counter);
+
+	/// <summary>
+	/// [0, count) をgroupSize単位に分割して並列実行し、完了まで待つ
+	/// </summary>
+	void ParallelFor(uint32_t count, uint32_t groupSize, const std::function<void(uint32_t begin, uint32_t end)> &func);
+
+	// ワーカースレッド数
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	// ワーカーがジョブを実行していた時間の累計(ナノ秒。稼働率は呼び出し側で2回の差を取って求める)
+	int64_t GetWorkerBusyNanoseconds(uint32_t worker) const { return workerStatistics[worker].busyNanoseconds.load(std::memory_order_relaxed); }
+	// ワーカーが実行したジョブ数の累計
+	uint64_t GetWorkerJobCount(uint32_t worker) const { return workerStatistics[worker].jobCount.load(std::memory_order_relaxed); }
+
+private:
+	static JobSystem *instance;
+
+	JobSystem() = default;
+	~JobSystem() = default;
+	JobSystem(JobSystem &) = delete;
+	JobSystem &operator=(JobSystem &) = delete;
+
+private:
+	// ジョブ1つ分
+	struct Job
+	{
+		std::function<void()> function;
+		Counter *counter = nullptr;
+	};
+
+	// キューから1つ取り出して実行する。取り出せなければfalse
+	bool RunOne();
+	// ジョブを実行してカウンタを進める
+	static void Execute(Job &job);
+	// ワーカースレッドの処理
+	void WorkerMain(uint32_t workerIndex);
+
+	// ワーカーごとの統計(書くのはそのワーカーだけ)
+	struct alignas(64) WorkerStatistics
+	{
+		std::atomic<int64_t> busyNanoseconds { 0 };
+		std::atomic<uint64_t> jobCount { 0 };
+	};
+
+	std::vector<std::thread> workers;
+	std::unique_ptr<WorkerStatistics[]> workerStatistics;
+	std::deque<Job> queue;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stop = false;
+};
@@ -0,0 +1,304 @@
+#include "Json.h"
+#include <charconv>
+#include <format>
+
+namespace json
+{
+	namespace
+	{
+		const Value &GetNullValue()
+		{
+			static const Value nullValue;
+			return nullValue;
+		}
+
+		// 入れ子の上限(壊れたファイルでスタックを使い切らないように)
+		constexpr uint32_t kMaxDepth = 256;
+	}
+
+	// 再帰下降の解析器
+	class Parser
+	{
+	public:
+		explicit Parser(std::string_view text) : text(text) {}
+
+		bool ParseDocument(Value &out)
+		{
+			SkipWhitespace();
+			if (!ParseValue(out, 0)) {
+				return false;
+			}
+			SkipWhitespace();
+			if (position != text.size()) {
+				return Fail("unexpected trailing characters");
+			}
+			return true;
+		}
+
+		const std::string &GetError() const { return error; }
+
+	private:
+		bool ParseValue(Value &out, uint32_t depth)
+		{
+			if (depth > kMaxDepth) {
+				return Fail("nesting too deep");
+			}
+			if (position >= text.size()) {
+				return Fail("unexpected end");
+			}
+
+			switch (text[position]) {
+			case '{':
+				return ParseObject(out, depth);
+			case '[':
+				return ParseArray(out, depth);
+			case '"':
+				out.type = Value::Type::String;
+				return ParseString(out.string);
+			case 't':
+				out.type = Value::Type::Bool;
+				out.boolean = true;
+				return Expect("true");
+			case 'f':
+				out.type = Value::Type::Bool;
+				out.boolean = false;
+				return Expect("false");
+			case 'n':
+				out.type = Value::Type::Null;
+				return Expect("null");
+			default:
+				return ParseNumber(out);
+			}
+		}
+
+		bool ParseObject(Value &out, uint32_t depth)
+		{
+			out.type = Value::Type::Object;
+			++position;
+			SkipWhitespace();
+			if (Consume('}')) {
+				return true;
+			}
+			while (true) {
+				SkipWhitespace();
+				std::string key;
+				if (position >= text.size() || text[position] != '"' || !ParseString(key)) {
+					return Fail("expected member name");
+				}
+				SkipWhitespace();
+				if (!Consume(':')) {
+					return Fail("expected ':'");
+				}
+				SkipWhitespace();
+				out.object.emplace_back(std::move(key), Value());
+				if (!ParseValue(out.object.back().second, depth + 1)) {
+					return false;
+				}
+				SkipWhitespace();
+				if (Consume('}')) {
+					return true;
+				}
+				if (!Consume(',')) {
+					return Fail("expected ',' or '}'");
+				}
+			}
+		}
+
+		bool ParseArray(Value &out, uint32_t depth)
+		{
+			out.type = Value::Type::Array;
+			++position;
+			SkipWhitespace();
+			if (Consume(']')) {
+				return true;
+			}
+			while (true) {
+				SkipWhitespace();
+				out.array.emplace_back();
+				if (!ParseValue(out.array.back(), depth + 1)) {
+					return false;
+				}
+				SkipWhitespace();
+				if (Consume(']')) {
+					return true;
+				}
+				if (!Consume(',')) {
+					return Fail("expected ',' or ']'");
+				}
+			}
+		}
+
+		bool ParseString(std::string &out)
+		{
+			// 先頭の"を読み飛ばす
+			++position;
+			while (position < text.size()) {
+				char c = text[position++];
+				if (c == '"') {
+					return true;
+				}
+				if (c != '\\') {
+					out.push_back(c);
+					continue;
+				}
+				if (position >= text.size()) {
+					break;
+				}
+				char escaped = text[position++];
+				switch (escaped) {
+				case '"': out.push_back('"'); break;
+				case '\\': out.push_back('\\'); break;
+				case '/': out.push_back('/'); break;
+				case 'b': out.push_back('\b'); break;
+				case 'f': out.push_back('\f'); break;
+				case 'n': out.push_back('\n'); break;
+				case 'r': out.push_back('\r'); break;
+				case 't': out.push_back('\t'); break;
+				case 'u':
+					if (!ParseUnicodeEscape(out)) {
+						return false;
+					}
+					break;
+				default:
+					return Fail("invalid escape");
+				}
+			}
+			return Fail("unterminated string");
+		}
+
+		// \uXXXX(サロゲートペア含む)をUTF-8にする
+		bool ParseUnicodeEscape(std::string &out)
+		{
+			uint32_t codePoint = 0;
+			if (!ParseHex4(codePoint)) {
+				return false;
+			}
+			if (0xD800 <= codePoint && codePoint < 0xDC00) {
+				uint32_t low = 0;
+				if (!Consume('\\') || !Consume('u') || !ParseHex4(low) || low < 0xDC00 || low >= 0xE000) {
+					return Fail("invalid surrogate pair");
+				}
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+			}
+
+			if (codePoint < 0x80) {
+				out.push_back(static_cast<char>(codePoint));
+			} else if (codePoint < 0x800) {
+				out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+				out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			} else if (codePoint < 0x10000) {
+				out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			} else {
+				out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+			}
+			return true;
+		}
+
+		bool ParseHex4(uint32_t &out)
+		{
+			if (position + 4 > text.size()) {
+				return Fail("invalid \\u escape");
+			}
+			auto result = std::from_chars(text.data() + position, text.data() + position + 4, out, 16);
+			if (result.ec != std::errc() || result.ptr != text.data() + position + 4) {
+				return Fail("invalid \\u escape");
+			}
+			position += 4;
+			return true;
+		}
+
+		bool ParseNumber(Value &out)
+		{
+			out.type = Value::Type::Number;
+			const char *begin = text.data() + position;
+			const char *end = text.data() + text.size();
+			auto result = std::from_chars(begin, end, out.number);
+			if (result.ec != std::errc()) {
+				return Fail("invalid value");
+			}
+			position += static_cast<size_t>(result.ptr - begin);
+			return true;
+		}
+
+		bool Expect(std::string_view literal)
+		{
+			if (text.substr(position, literal.size()) != literal) {
+				return Fail("invalid literal");
+			}
+			position += literal.size();
+			return true;
+		}
+
+		bool Consume(char c)
+		{
+			if (position < text.size() && text[position] == c) {
+				++position;
+				return true;
+			}
+			return false;
+		}
+
+		void SkipWhitespace()
+		{
+			while (position < text.size() &&
+				(text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+				++position;
+			}
+		}
+
+		bool Fail(const char *message)
+		{
+			if (error.empty()) {
+				error = std::format("{} at offset {}", message, position);
+			}
+			return false;
+		}
+
+		std::string_view text;
+		size_t position = 0;
+		std::string error;
+	};
+
+	const Value &Value::operator[](size_t index) const
+	{
+		if (type != Type::Array || index >= array.size()) {
+			return GetNullValue();
+		}
+		return array[index];
+	}
+
+	const Value &Value::operator[](std::string_view key) const
+	{
+		const Value *member = Find(key);
+		return member ? *member : GetNullValue();
+	}
+
+	const Value *Value::Find(std::string_view key) const
+	{
+		if (type != Type::Object) {
+			return nullptr;
+		}
+		for (const std::pair<std::string, Value> &member : object) {
+			if (member.first == key) {
+				return &member.second;
+			}
+		}
+		return nullptr;
+	}
+
+	bool Parse(std::string_view text, Value &out, std::string *error)
+	{
+		out = Value();
+		Parser parser(text);
+		bool succeeded = parser.ParseDocument(out);
+		if (!succeeded && error) {
+			*error = parser.GetError();
+		}
+		return succeeded;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// JSON
+// 読み込み時に一度だけ解析して木にする。設定やアセットのメタデータ用
+namespace json
+{
+	class Value
+	{
+	public:
+		enum class Type
+		{
+			Null,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object,
+		};
+
+	public: // メンバ関数
+		Type GetType() const { return type; }
+		bool IsNull() const { return type == Type::Null; }
+		bool IsNumber() const { return type == Type::Number; }
+		bool IsString() const { return type == Type::String; }
+		bool IsArray() const { return type == Type::Array; }
+		bool IsObject() const { return type == Type::Object; }
+
+		// 値の取得(型が違えば既定値)
+		bool GetBool(bool defaultValue = false) const { return type == Type::Bool ? boolean : defaultValue; }
+		double GetNumber(double defaultValue = 0.0) const { return type == Type::Number ? number : defaultValue; }
+		int64_t GetInt(int64_t defaultValue = 0) const { return type == Type::Number ? static_cast<int64_t>(number) : defaultValue; }
+		float GetFloat(float defaultValue = 0.0f) const { return type == Type::Number ? static_cast<float>(number) : defaultValue; }
+		const std::string &GetString() const { return string; }
+
+		// 配列・オブジェクトの要素数
+		size_t Size() const { return type == Type::Array ? array.size() : type == Type::Object ? object.size() : 0; }
+		// 配列の要素(範囲外ならNull)
+		const Value &operator[](size_t index) const;
+		// オブジェクトのメンバ(無ければNull)
+		const Value &operator[](std::string_view key) const;
+		// オブジェクトのメンバ(無ければnullptr)
+		const Value *Find(std::string_view key) const;
+		// オブジェクトのメンバ一覧
+		const std::vector<std::pair<std::string, Value>> &GetMembers() const { return object; }
+
+	private:
+		friend class Parser;
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<Value> array;
+		std::vector<std::pair<std::string, Value>> object;
+	};
+
+	/// <summary>
+	/// JSON文字列を解析する
+	/// </summary>
+	/// <param name="error">失敗時の理由(任意)</param>
+	/// <returns>成功したか</returns>
+	bool Parse(std::string_view text, Value &out, std::string *error = nullptr);
+}
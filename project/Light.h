@@ -1,6 +1,7 @@
 #pragma once
 #include "MathTypes.h"
 
+// シェーダーの定数・構造化バッファと同じ並び(16バイト境界)にしておく
 namespace light
 {
 	struct DirectionalLight
@@ -9,4 +10,27 @@ namespace light
 		math::Vector3 direction; //!< ライトの向き
 		float intensity; //!< 輝度
 	};
-}
\ No newline at end of file
+
+	struct PointLight
+	{
+		math::Vector4 color; //!< ライトの色
+		math::Vector3 position; //!< ライトの位置
+		float intensity; //!< 輝度
+		float radius; //!< ライトの届く最大距離
+		float decay; //!< 減衰率
+		float padding[2];
+	};
+
+	struct SpotLight
+	{
+		math::Vector4 color; //!< ライトの色
+		math::Vector3 position; //!< ライトの位置
+		float intensity; //!< 輝度
+		math::Vector3 direction; //!< ライトの向き(正規化済み)
+		float distance; //!< ライトの届く最大距離
+		float decay; //!< 減衰率
+		float cosAngle; //!< 照らす範囲の余弦(外側)
+		float cosFalloffStart; //!< 減衰し始める角度の余弦(内側)
+		float padding[1];
+	};
+}
@@ -0,0 +1,268 @@
+#include "LightCulling.h"
+#include "JobSystem.h"
+#include "MathFunctions.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LIGHT_CULLING_SSE2
+#endif
+
+namespace light
+{
+	namespace
+	{
+		// SIMDの幅(タイル数をこの倍数に揃える)
+		constexpr uint32_t kSimdWidth = 4;
+		// 詰め物タイルの境界(どの球とも交差しない)
+		constexpr float kEmptyBound = 1.0e30f;
+
+		// 軸1本分の、区間[min, max]から点までの距離
+		float AxisDistance(float value, float min, float max)
+		{
+			return (std::max)((std::max)(min - value, 0.0f), value - max);
+		}
+	}
+
+	void LightCuller::Initialize(const ClusterSettings &settings)
+	{
+		assert(settings.tileCountX > 0 && settings.tileCountY > 0 && settings.sliceCount > 0);
+		assert(0.0f < settings.nearClip && settings.nearClip < settings.farClip);
+		settings_ = settings;
+
+		// スライスの境界は指数分布(手前ほど細かく)
+		sliceDepths_.resize(settings.sliceCount + 1);
+		for (uint32_t s = 0; s <= settings.sliceCount; ++s) {
+			sliceDepths_[s] = settings.nearClip * std::pow(settings.farClip / settings.nearClip, float(s) / float(settings.sliceCount));
+		}
+		logDepthScale_ = float(settings.sliceCount) / std::log(settings.farClip / settings.nearClip);
+
+		// スライスごとに、タイルの錐台片を囲むAABB(xy)を作る
+		uint32_t tileCount = settings.tileCountX * settings.tileCountY;
+		tileStride_ = (tileCount + kSimdWidth - 1) / kSimdWidth * kSimdWidth;
+		size_t boundsCount = size_t(tileStride_) * settings.sliceCount;
+		tileMinX_.assign(boundsCount, kEmptyBound);
+		tileMaxX_.assign(boundsCount, -kEmptyBound);
+		tileMinY_.assign(boundsCount, kEmptyBound);
+		tileMaxY_.assign(boundsCount, -kEmptyBound);
+
+		float tanHalfY = std::tan(settings.fovY * 0.5f);
+		float tanHalfX = tanHalfY * settings.aspectRatio;
+		for (uint32_t s = 0; s < settings.sliceCount; ++s) {
+			float zNear = sliceDepths_[s];
+			float zFar = sliceDepths_[s + 1];
+			for (uint32_t y = 0; y < settings.tileCountY; ++y) {
+				// 上の行から並べる
+				float ndcTop = 1.0f - 2.0f * float(y) / float(settings.tileCountY);
+				float ndcBottom = 1.0f - 2.0f * float(y + 1) / float(settings.tileCountY);
+				for (uint32_t x = 0; x < settings.tileCountX; ++x) {
+					float ndcLeft = -1.0f + 2.0f * float(x) / float(settings.tileCountX);
+					float ndcRight = -1.0f + 2.0f * float(x + 1) / float(settings.tileCountX);
+
+					// 視線から離れる側の辺は奥の面で、近づく側の辺は手前の面で最も外に出る
+					size_t i = size_t(s) * tileStride_ + y * settings.tileCountX + x;
+					tileMinX_[i] = ndcLeft * tanHalfX * (ndcLeft < 0.0f ? zFar : zNear);
+					tileMaxX_[i] = ndcRight * tanHalfX * (ndcRight > 0.0f ? zFar : zNear);
+					tileMinY_[i] = ndcBottom * tanHalfY * (ndcBottom < 0.0f ? zFar : zNear);
+					tileMaxY_[i] = ndcTop * tanHalfY * (ndcTop > 0.0f ? zFar : zNear);
+				}
+			}
+		}
+
+		clusterRanges_.assign(size_t(tileCount) * settings.sliceCount, { 0, 0 });
+		lightIndices_.clear();
+	}
+
+	uint32_t LightCuller::GetSlice(float viewZ) const
+	{
+		if (viewZ <= settings_.nearClip) {
+			return 0;
+		}
+		int32_t slice = static_cast<int32_t>(std::log(viewZ / settings_.nearClip) * logDepthScale_);
+		return static_cast<uint32_t>(std::clamp(slice, 0, static_cast<int32_t>(settings_.sliceCount) - 1));
+	}
+
+	void LightCuller::Cull(const math::Matrix4x4 &view, const std::vector<PointLight> &pointLights, const std::vector<SpotLight> &spotLights)
+	{
+		// 未初期化チェック
+		assert(!clusterRanges_.empty());
+
+		// ライトをビュー空間の境界球にする
+		spheres_.resize(pointLights.size() + spotLights.size());
+		for (size_t i = 0; i < pointLights.size(); ++i) {
+			spheres_[i] = { math::ApplyTransform(pointLights[i].position, view), pointLights[i].radius };
+		}
+		for (size_t i = 0; i < spotLights.size(); ++i) {
+			// 円錐を囲む最小の球。広い円錐は底面の円を、狭い円錐は頂点と底面の縁を通る球になる
+			const SpotLight &spot = spotLights[i];
+			float cosAngle = std::clamp(spot.cosAngle, 0.0f, 1.0f);
+			float sinAngle = std::sqrt(1.0f - cosAngle * cosAngle);
+			float centerDistance = 0.0f;
+			float radius = 0.0f;
+			if (cosAngle < 0.70710678f) {
+				centerDistance = spot.distance * cosAngle;
+				radius = spot.distance * sinAngle;
+			} else {
+				centerDistance = spot.distance / (2.0f * cosAngle);
+				radius = centerDistance;
+			}
+			math::Vector3 center = {
+				spot.position.x + spot.direction.x * centerDistance,
+				spot.position.y + spot.direction.y * centerDistance,
+				spot.position.z + spot.direction.z * centerDistance };
+			spheres_[pointLights.size() + i] = { math::ApplyTransform(center, view), radius };
+		}
+
+		// ライトをグループに分けて判定する。結果はグループごとに持ち、後で順番に詰めるので並び順は毎回同じになる
+		uint32_t lightCount = static_cast<uint32_t>(spheres_.size());
+		uint32_t groupCount = useJobs_ ? JobSystem::GetInstance()->GetWorkerCount() + 1 : 1;
+		groupCount = (std::max)(1u, (std::min)(groupCount, lightCount / 256 + 1));
+		if (bins_.size() < groupCount) {
+			bins_.resize(groupCount);
+		}
+		uint32_t groupSize = (lightCount + groupCount - 1) / groupCount;
+		JobSystem::GetInstance()->ParallelFor(groupCount, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t group = begin; group < end; ++group) {
+				Bin &bin = bins_[group];
+				bin.references.clear();
+				BinLights((std::min)(group * groupSize, lightCount), (std::min)((group + 1) * groupSize, lightCount), bin);
+			}
+			});
+
+		// クラスタごとの数を数えて先頭位置を決める
+		for (ClusterRange &range : clusterRanges_) {
+			range = { 0, 0 };
+		}
+		for (uint32_t group = 0; group < groupCount; ++group) {
+			for (const Reference &reference : bins_[group].references) {
+				++clusterRanges_[reference.cluster].count;
+			}
+		}
+		uint32_t offset = 0;
+		for (ClusterRange &range : clusterRanges_) {
+			range.offset = offset;
+			offset += range.count;
+			range.count = 0;
+		}
+
+		// 詰める
+		lightIndices_.resize(offset);
+		for (uint32_t group = 0; group < groupCount; ++group) {
+			for (const Reference &reference : bins_[group].references) {
+				ClusterRange &range = clusterRanges_[reference.cluster];
+				lightIndices_[range.offset + range.count++] = reference.light;
+			}
+		}
+	}
+
+	void LightCuller::BinLights(uint32_t begin, uint32_t end, Bin &bin) const
+	{
+		for (uint32_t lightIndex = begin; lightIndex < end; ++lightIndex) {
+			const Sphere &sphere = spheres_[lightIndex];
+			// 視錐台の手前・奥から外れていれば判定しない
+			if (sphere.center.z + sphere.radius < settings_.nearClip || sphere.center.z - sphere.radius > settings_.farClip) {
+				continue;
+			}
+
+			uint32_t firstSlice = GetSlice(sphere.center.z - sphere.radius);
+			uint32_t lastSlice = GetSlice(sphere.center.z + sphere.radius);
+			for (uint32_t slice = firstSlice; slice <= lastSlice; ++slice) {
+				if (useSimd_) {
+					TestSliceSimd(sphere, slice, lightIndex, bin);
+				} else {
+					TestSliceScalar(sphere, slice, lightIndex, bin);
+				}
+			}
+		}
+	}
+
+	bool LightCuller::GetTileRange(const Sphere &sphere, uint32_t slice, float &remaining, uint32_t &firstTile, uint32_t &endTile) const
+	{
+		float dz = AxisDistance(sphere.center.z, sliceDepths_[slice], sliceDepths_[slice + 1]);
+		remaining = sphere.radius * sphere.radius - dz * dz;
+		if (remaining < 0.0f) {
+			return false;
+		}
+
+		// 行ごとのyの範囲は同じスライス内なら共通なので、重なる行を先に絞る
+		size_t base = size_t(slice) * tileStride_;
+		uint32_t firstRow = settings_.tileCountY;
+		uint32_t lastRow = 0;
+		for (uint32_t y = 0; y < settings_.tileCountY; ++y) {
+			size_t i = base + size_t(y) * settings_.tileCountX;
+			float dy = AxisDistance(sphere.center.y, tileMinY_[i], tileMaxY_[i]);
+			if (dy * dy <= remaining) {
+				firstRow = (std::min)(firstRow, y);
+				lastRow = y;
+			}
+		}
+		if (firstRow > lastRow) {
+			return false;
+		}
+		firstTile = firstRow * settings_.tileCountX;
+		endTile = (lastRow + 1) * settings_.tileCountX;
+		return true;
+	}
+
+	void LightCuller::TestSliceScalar(const Sphere &sphere, uint32_t slice, uint32_t lightIndex, Bin &bin) const
+	{
+		float remaining = 0.0f;
+		uint32_t firstTile = 0;
+		uint32_t endTile = 0;
+		if (!GetTileRange(sphere, slice, remaining, firstTile, endTile)) {
+			return;
+		}
+
+		uint32_t tileCount = settings_.tileCountX * settings_.tileCountY;
+		size_t base = size_t(slice) * tileStride_;
+		for (uint32_t tile = firstTile; tile < endTile; ++tile) {
+			float dx = AxisDistance(sphere.center.x, tileMinX_[base + tile], tileMaxX_[base + tile]);
+			float dy = AxisDistance(sphere.center.y, tileMinY_[base + tile], tileMaxY_[base + tile]);
+			if (dx * dx + dy * dy <= remaining) {
+				bin.references.push_back({ slice * tileCount + tile, lightIndex });
+			}
+		}
+	}
+
+	void LightCuller::TestSliceSimd(const Sphere &sphere, uint32_t slice, uint32_t lightIndex, Bin &bin) const
+	{
+#ifdef LIGHT_CULLING_SSE2
+		float remaining = 0.0f;
+		uint32_t firstTile = 0;
+		uint32_t endTile = 0;
+		if (!GetTileRange(sphere, slice, remaining, firstTile, endTile)) {
+			return;
+		}
+
+		// 4タイルずつ、球の中心からAABBまでの距離の2乗を求める
+		// 範囲外の行のタイルや詰め物のタイルは縦方向で必ず外れるので、範囲の端はSIMD幅に揃えて読んでよい
+		uint32_t tileCount = settings_.tileCountX * settings_.tileCountY;
+		size_t base = size_t(slice) * tileStride_;
+		const __m128 centerX = _mm_set1_ps(sphere.center.x);
+		const __m128 centerY = _mm_set1_ps(sphere.center.y);
+		const __m128 remainingSquared = _mm_set1_ps(remaining);
+		const __m128 zero = _mm_setzero_ps();
+		for (uint32_t tile = firstTile / kSimdWidth * kSimdWidth; tile < endTile; tile += kSimdWidth) {
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&tileMinX_[base + tile]), centerX), zero),
+				_mm_sub_ps(centerX, _mm_loadu_ps(&tileMaxX_[base + tile])));
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&tileMinY_[base + tile]), centerY), zero),
+				_mm_sub_ps(centerY, _mm_loadu_ps(&tileMaxY_[base + tile])));
+			__m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			int hitMask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, remainingSquared));
+			// 当たったタイルだけ積む(詰め物のタイルは必ず外れる)
+			while (hitMask != 0) {
+				uint32_t lane = 0;
+				while (((hitMask >> lane) & 1) == 0) {
+					++lane;
+				}
+				hitMask &= hitMask - 1;
+				bin.references.push_back({ slice * tileCount + tile + lane, lightIndex });
+			}
+		}
+#else
+		TestSliceScalar(sphere, slice, lightIndex, bin);
+#endif
+	}
+}
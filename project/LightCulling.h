@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Light.h"
+#include "MathTypes.h"
+
+// クラスタードライティング用のライト割り当て(CPU)
+// ビュー空間の視錐台を画面タイル × 深度スライスのクラスタに分割し、
+// 各クラスタに影響するライトの番号を詰めたリストを作る
+namespace light
+{
+	// クラスタ分割の設定
+	struct ClusterSettings
+	{
+		uint32_t tileCountX = 16; //!< 画面横方向の分割数
+		uint32_t tileCountY = 9; //!< 画面縦方向の分割数
+		uint32_t sliceCount = 24; //!< 深度方向の分割数(指数分布)
+		float fovY = 0.45f; //!< 縦画角(ラジアン)
+		float aspectRatio = 16.0f / 9.0f; //!< アスペクト比
+		float nearClip = 0.1f;
+		float farClip = 100.0f;
+	};
+
+	// クラスタ1つ分のライト番号リストの範囲
+	struct ClusterRange
+	{
+		uint32_t offset; //!< ライト番号リスト内の先頭
+		uint32_t count; //!< ライト数
+	};
+
+	class LightCuller
+	{
+	public: // メンバ関数
+		// 初期化(クラスタのAABBを作る。設定を変えたら呼び直す)
+		void Initialize(const ClusterSettings &settings);
+
+		/// <summary>
+		/// ライトをクラスタに割り当てる
+		/// ライト番号はポイントライトが[0, pointLightCount)、スポットライトがpointLightCount以降
+		/// </summary>
+		/// <param name="view">ビュー行列</param>
+		void Cull(const math::Matrix4x4 &view, const std::vector<PointLight> &pointLights, const std::vector<SpotLight> &spotLights);
+
+		// クラスタ番号(タイル横 → タイル縦 → スライスの順)
+		uint32_t GetClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const
+		{
+			return (slice * settings_.tileCountY + tileY) * settings_.tileCountX + tileX;
+		}
+		// ビュー空間の深度が入るスライス
+		uint32_t GetSlice(float viewZ) const;
+
+		// getter
+		const ClusterSettings &GetSettings() const { return settings_; }
+		uint32_t GetClusterCount() const { return static_cast<uint32_t>(clusterRanges_.size()); }
+		const std::vector<ClusterRange> &GetClusterRanges() const { return clusterRanges_; }
+		const std::vector<uint32_t> &GetLightIndices() const { return lightIndices_; }
+
+		// SIMDで判定するか(比較計測用)
+		void SetUseSimd(bool useSimd) { useSimd_ = useSimd; }
+		// ライトをジョブに分けて並列に判定するか
+		void SetUseJobs(bool useJobs) { useJobs_ = useJobs; }
+
+	private:
+		// ビュー空間の境界球
+		struct Sphere
+		{
+			math::Vector3 center;
+			float radius;
+		};
+
+		// クラスタ番号とライト番号の組
+		struct Reference
+		{
+			uint32_t cluster;
+			uint32_t light;
+		};
+		// ライト1グループ分の判定結果
+		struct Bin
+		{
+			std::vector<Reference> references;
+		};
+
+		// [begin, end)のライトを判定してbinに積む
+		void BinLights(uint32_t begin, uint32_t end, Bin &bin) const;
+		// 1スライス内で球と縦方向に重なるタイルの範囲を求める(重ならなければfalse)
+		bool GetTileRange(const Sphere &sphere, uint32_t slice, float &remaining, uint32_t &firstTile, uint32_t &endTile) const;
+		// 1スライス内のタイルと球を判定する
+		void TestSliceScalar(const Sphere &sphere, uint32_t slice, uint32_t lightIndex, Bin &bin) const;
+		void TestSliceSimd(const Sphere &sphere, uint32_t slice, uint32_t lightIndex, Bin &bin) const;
+
+		ClusterSettings settings_;
+		// タイルのビュー空間AABB(スライスごと、SIMD幅に揃えたSoA)
+		uint32_t tileStride_ = 0;
+		std::vector<float> tileMinX_;
+		std::vector<float> tileMaxX_;
+		std::vector<float> tileMinY_;
+		std::vector<float> tileMaxY_;
+		// スライスの境界深度(sliceCount + 1個)
+		std::vector<float> sliceDepths_;
+		float logDepthScale_ = 0.0f;
+
+		// ビュー空間の境界球
+		std::vector<Sphere> spheres_;
+		std::vector<Bin> bins_;
+
+		std::vector<ClusterRange> clusterRanges_;
+		std::vector<uint32_t> lightIndices_;
+
+		bool useSimd_ = true;
+		bool useJobs_ = true;
+	};
+}
@@ -1,10 +1,14 @@
 #include "Logger.h"
 #include <iostream>
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 namespace Logger {
 	void Log(std::ostream &os, const std::string &message) {
 		os << message << std::endl;
+#ifdef _WIN32
 		OutputDebugStringA(message.c_str());
+#endif
 	}
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+
+// 読み取り専用のメモリマップドファイル
+// ファイルの中身をコピーせずにそのままアドレス空間に割り当てる
+class MappedFile
+{
+public: // メンバ関数
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// 開く(失敗したらfalse)
+	bool Open(const std::string &filePath);
+	// 閉じる
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+	// ファイルの中身(閉じるまで有効)
+	std::span<const std::byte> GetBytes() const { return { data, size }; }
+
+private:
+	const std::byte *data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#endif
+};
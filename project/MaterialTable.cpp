@@ -0,0 +1,87 @@
+#include "MaterialTable.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace render
+{
+	void MaterialTable::Initialize(uint32_t blockSize, uint32_t maxMaterials)
+	{
+		assert(blockSize > 0 && maxMaterials > 0);
+		blockSize_ = blockSize;
+		maxMaterials_ = maxMaterials;
+		blocks_.resize(size_t(blockSize) * maxMaterials);
+		hashes_.resize(maxMaterials);
+
+		// 埋まり具合が半分以下になる2のべき乗
+		uint32_t slotCount = 1;
+		while (slotCount < maxMaterials * 2) {
+			slotCount <<= 1;
+		}
+		slots_.assign(slotCount, 0);
+		Clear();
+	}
+
+	void MaterialTable::Clear()
+	{
+		std::fill(slots_.begin(), slots_.end(), 0u);
+		materialCount_ = 0;
+		instanceCount_ = 0;
+	}
+
+	uint32_t MaterialTable::Intern(const void *block, bool *added)
+	{
+		assert(blockSize_ > 0);
+		++instanceCount_;
+
+		uint64_t hash = HashBlock(block);
+		const uint32_t mask = static_cast<uint32_t>(slots_.size()) - 1;
+		for (uint32_t slot = static_cast<uint32_t>(hash) & mask;; slot = (slot + 1) & mask) {
+			uint32_t entry = slots_[slot];
+			if (entry == 0) {
+				// 初めての内容なので登録する
+				if (materialCount_ >= maxMaterials_) {
+					assert(false);
+					return kInvalidId;
+				}
+				uint32_t id = materialCount_++;
+				std::memcpy(blocks_.data() + size_t(id) * blockSize_, block, blockSize_);
+				hashes_[id] = hash;
+				slots_[slot] = id + 1;
+				if (added) {
+					*added = true;
+				}
+				return id;
+			}
+
+			// ハッシュ値が一致したら中身も比べる
+			uint32_t id = entry - 1;
+			if (hashes_[id] == hash && std::memcmp(GetBlock(id), block, blockSize_) == 0) {
+				if (added) {
+					*added = false;
+				}
+				return id;
+			}
+		}
+	}
+
+	uint64_t MaterialTable::HashBlock(const void *block) const
+	{
+		// 8バイトずつFNV-1aで混ぜる(パラメータは小さいので1バイトずつより速く、分布も十分)
+		constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+		constexpr uint64_t kFnvPrime = 1099511628211ull;
+		const uint8_t *bytes = static_cast<const uint8_t *>(block);
+		uint64_t hash = kFnvOffsetBasis;
+		size_t offset = 0;
+		for (; offset + sizeof(uint64_t) <= blockSize_; offset += sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, bytes + offset, sizeof(word));
+			hash = (hash ^ word) * kFnvPrime;
+		}
+		for (; offset < blockSize_; ++offset) {
+			hash = (hash ^ bytes[offset]) * kFnvPrime;
+		}
+		// 下位ビットで表を引くので上位ビットを混ぜ込む
+		return hash ^ (hash >> 32);
+	}
+}
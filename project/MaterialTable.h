@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// マテリアルの重複除去
+// マテリアルのパラメータ(定数バッファ1つ分のバイト列)をハッシュで引き、同じ内容には同じIDを返す。
+// 描画側はIDごとに1つだけ定数バッファへ書き込み、同じIDのインスタンスはそのCBVを共有する
+// IDは最初に現れた順の通し番号なので、描画順をIDで並べればマテリアルの切り替えがまとまる
+// ここはD3Dに依存しないので単体で確かめられる
+namespace render
+{
+	class MaterialTable
+	{
+	public:
+		static constexpr uint32_t kInvalidId = 0xFFFFFFFFu;
+
+	public: // メンバ関数
+		/// <summary>
+		/// 初期化
+		/// </summary>
+		/// <param name="blockSize">パラメータ1つ分のバイト数</param>
+		/// <param name="maxMaterials">登録できるマテリアルの最大数</param>
+		void Initialize(uint32_t blockSize, uint32_t maxMaterials);
+
+		// 全て取り除く(フレームの始めに呼ぶ。確保済みの容量は残す)
+		void Clear();
+
+		/// <summary>
+		/// パラメータを登録してIDを返す。同じ内容が登録済みならそのIDを返す
+		/// </summary>
+		/// <param name="block">blockSizeバイトのパラメータ</param>
+		/// <param name="added">新しく登録したならtrue(描画側はこのときだけGPUのバッファに書き込む)</param>
+		uint32_t Intern(const void *block, bool *added = nullptr);
+
+		template <class T>
+		uint32_t Intern(const T &block, bool *added = nullptr)
+		{
+			return Intern(static_cast<const void *>(&block), added);
+		}
+
+		// 登録したパラメータ(書き込み結合のアップロードバッファは読み戻すと遅いので、比較用にCPU側にも持つ)
+		const void *GetBlock(uint32_t id) const { return blocks_.data() + size_t(id) * blockSize_; }
+
+		uint32_t GetBlockSize() const { return blockSize_; }
+		// 登録された種類の数
+		uint32_t GetMaterialCount() const { return materialCount_; }
+		// Clearからの登録の呼び出し数(インスタンスの数)
+		uint32_t GetInstanceCount() const { return instanceCount_; }
+
+	private:
+		// パラメータのハッシュ値
+		uint64_t HashBlock(const void *block) const;
+
+		uint32_t blockSize_ = 0;
+		uint32_t maxMaterials_ = 0;
+		uint32_t materialCount_ = 0;
+		uint32_t instanceCount_ = 0;
+
+		// 登録したパラメータ(IDの順に詰めて並べる)
+		std::vector<uint8_t> blocks_;
+		// オープンアドレス法のハッシュ表(要素はID + 1。0は空き)と、IDごとのハッシュ値
+		std::vector<uint32_t> slots_;
+		std::vector<uint64_t> hashes_;
+	};
+}
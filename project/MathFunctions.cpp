@@ -183,6 +183,47 @@ namespace math {
 		return result;
 	}
 
+	Matrix4x4 MakeRotateMatrix(const Quaternion &rotation)
+	{
+		Matrix4x4 result = MakeIdentity4x4();
+
+		float x = rotation.x;
+		float y = rotation.y;
+		float z = rotation.z;
+		float w = rotation.w;
+
+		result.m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+		result.m[0][1] = 2.0f * (x * y + w * z);
+		result.m[0][2] = 2.0f * (x * z - w * y);
+
+		result.m[1][0] = 2.0f * (x * y - w * z);
+		result.m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+		result.m[1][2] = 2.0f * (y * z + w * x);
+
+		result.m[2][0] = 2.0f * (x * z + w * y);
+		result.m[2][1] = 2.0f * (y * z - w * x);
+		result.m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+
+		return result;
+	}
+
+	Matrix4x4 MakeAffineMatrix(const Vector3 &scale, const Quaternion &rotate, const Vector3 &translate)
+	{
+		// S * R * T を展開したもの(回転行列の各行を拡大率倍し、最下行に平行移動を置く)
+		Matrix4x4 result = MakeRotateMatrix(rotate);
+
+		for (int col = 0; col < 3; ++col) {
+			result.m[0][col] *= scale.x;
+			result.m[1][col] *= scale.y;
+			result.m[2][col] *= scale.z;
+		}
+		result.m[3][0] = translate.x;
+		result.m[3][1] = translate.y;
+		result.m[3][2] = translate.z;
+
+		return result;
+	}
+
 	Matrix4x4 Inverse(const Matrix4x4 &m)
 	{
 		Matrix4x4 result {};
@@ -27,6 +27,12 @@ namespace math
     // 3次元アフィン変換行列
     Matrix4x4 MakeAffineMatrix(const Vector3 &scale, const Vector3 &rotate, const Vector3 &translate);
 
+    // クォータニオンの回転行列
+    Matrix4x4 MakeRotateMatrix(const Quaternion &rotation);
+
+    // 3次元アフィン変換行列(回転をクォータニオンで指定)
+    Matrix4x4 MakeAffineMatrix(const Vector3 &scale, const Quaternion &rotate, const Vector3 &translate);
+
     // 逆行列
     Matrix4x4 Inverse(const Matrix4x4 &m);
 
@@ -23,6 +23,14 @@ namespace math
         float w;
     };
 
+    struct Quaternion
+    {
+        float x;
+        float y;
+        float z;
+        float w;
+    };
+
     struct Matrix3x3
     {
         float m[3][3];
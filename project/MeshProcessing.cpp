@@ -0,0 +1,201 @@
+#include "MeshProcessing.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <memory>
+
+namespace mesh
+{
+	namespace
+	{
+		// ジョブ1つで処理する三角形・頂点の数
+		constexpr uint32_t kTriangleGroupSize = 16 * 1024;
+		constexpr uint32_t kVertexGroupSize = 32 * 1024;
+		// 固定小数点の1に当たる値(足し込む値は単位ベクトル × 角度(π以下)なので桁は十分余る)
+		constexpr double kFixedScale = 4294967296.0;
+
+		math::Vector3 Subtract(const math::Vector3 &a, const math::Vector3 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		math::Vector3 Scale(const math::Vector3 &v, float s) { return { v.x * s, v.y * s, v.z * s }; }
+		float Dot(const math::Vector3 &a, const math::Vector3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+		math::Vector3 Cross(const math::Vector3 &a, const math::Vector3 &b)
+		{
+			return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		}
+		math::Vector3 Normalize(const math::Vector3 &v)
+		{
+			float length = std::sqrt(Dot(v, v));
+			return length > 0.0f ? Scale(v, 1.0f / length) : math::Vector3 { 0.0f,0.0f,0.0f };
+		}
+
+		// 頂点ごとのベクトルを固定小数点で足し込む入れ物
+		class Accumulator
+		{
+		public:
+			Accumulator(size_t vertexCount, uint32_t componentCount)
+				: values(std::make_unique<std::atomic<int64_t>[]>(vertexCount * componentCount)), componentCount(componentCount)
+			{
+				for (size_t i = 0; i < vertexCount * componentCount; ++i) {
+					values[i].store(0, std::memory_order_relaxed);
+				}
+			}
+
+			void Add(uint32_t vertex, uint32_t component, float value)
+			{
+				// 切り捨ての誤差は2^-32程度なのでfloatの精度には影響しない
+				values[size_t(vertex) * componentCount + component].fetch_add(static_cast<int64_t>(double(value) * kFixedScale), std::memory_order_relaxed);
+			}
+			void Add(uint32_t vertex, uint32_t firstComponent, const math::Vector3 &value)
+			{
+				Add(vertex, firstComponent + 0, value.x);
+				Add(vertex, firstComponent + 1, value.y);
+				Add(vertex, firstComponent + 2, value.z);
+			}
+
+			math::Vector3 Get(uint32_t vertex, uint32_t firstComponent) const
+			{
+				size_t i = size_t(vertex) * componentCount + firstComponent;
+				return {
+					static_cast<float>(double(values[i + 0].load(std::memory_order_relaxed)) / kFixedScale),
+					static_cast<float>(double(values[i + 1].load(std::memory_order_relaxed)) / kFixedScale),
+					static_cast<float>(double(values[i + 2].load(std::memory_order_relaxed)) / kFixedScale) };
+			}
+
+		private:
+			std::unique_ptr<std::atomic<int64_t>[]> values;
+			uint32_t componentCount;
+		};
+
+		float AngleBetween(const math::Vector3 &a, const math::Vector3 &b)
+		{
+			float cosine = Dot(a, b);
+			return std::acos(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+		}
+
+		// 三角形の3つの内角(辺の向きは1回ずつ正規化する)
+		void GetCornerAngles(const math::Vector3 (&p)[3], float (&angles)[3])
+		{
+			math::Vector3 e01 = Normalize(Subtract(p[1], p[0]));
+			math::Vector3 e12 = Normalize(Subtract(p[2], p[1]));
+			math::Vector3 e20 = Normalize(Subtract(p[0], p[2]));
+			angles[0] = AngleBetween(e01, Scale(e20, -1.0f));
+			angles[1] = AngleBetween(e12, Scale(e01, -1.0f));
+			// 内角の和はπ
+			angles[2] = 3.14159265f - angles[0] - angles[1];
+		}
+
+		// [0, count) をgroupSizeごとに(parallelなら並列に)処理する
+		template <class F>
+		void ForRanges(uint32_t count, uint32_t groupSize, bool parallel, F &&func)
+		{
+			if (parallel) {
+				JobSystem::GetInstance()->ParallelFor(count, groupSize, func);
+			} else {
+				func(0u, count);
+			}
+		}
+	}
+
+	void GenerateNormals(std::span<const math::Vector3> positions, std::span<const uint32_t> indices,
+		NormalWeighting weighting, std::vector<math::Vector3> &normals, bool parallel)
+	{
+		assert(indices.size() % 3 == 0);
+		uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+		uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		Accumulator accumulator(vertexCount, 3);
+
+		// 三角形ごとに面法線を求めて3頂点に足し込む
+		ForRanges(triangleCount, kTriangleGroupSize, parallel, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t triangle = begin; triangle < end; ++triangle) {
+				uint32_t vertices[3] = { indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+				assert(vertices[0] < vertexCount && vertices[1] < vertexCount && vertices[2] < vertexCount);
+				math::Vector3 p[3] = { positions[vertices[0]], positions[vertices[1]], positions[vertices[2]] };
+				math::Vector3 faceNormal = Normalize(Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0])));
+				float weights[3] = { 1.0f,1.0f,1.0f };
+				if (weighting == NormalWeighting::Angle) {
+					GetCornerAngles(p, weights);
+				}
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					accumulator.Add(vertices[corner], 0, Scale(faceNormal, weights[corner]));
+				}
+			}
+			});
+
+		normals.resize(vertexCount);
+		ForRanges(vertexCount, kVertexGroupSize, parallel, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t vertex = begin; vertex < end; ++vertex) {
+				normals[vertex] = Normalize(accumulator.Get(vertex, 0));
+			}
+			});
+	}
+
+	void GenerateTangents(std::span<const math::Vector3> positions, std::span<const math::Vector3> normals,
+		std::span<const math::Vector2> texcoords, std::span<const uint32_t> indices,
+		std::vector<math::Vector4> &tangents, bool parallel)
+	{
+		assert(indices.size() % 3 == 0);
+		assert(normals.size() == positions.size() && texcoords.size() == positions.size());
+		uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+		uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+		// 接線(xyz)と従法線(xyz)を足し込む
+		Accumulator accumulator(vertexCount, 6);
+
+		ForRanges(triangleCount, kTriangleGroupSize, parallel, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t triangle = begin; triangle < end; ++triangle) {
+				uint32_t vertices[3] = { indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+				math::Vector3 p[3] = { positions[vertices[0]], positions[vertices[1]], positions[vertices[2]] };
+				math::Vector2 uv[3] = { texcoords[vertices[0]], texcoords[vertices[1]], texcoords[vertices[2]] };
+
+				// UVの変化から面の接線・従法線を求める
+				math::Vector3 edge1 = Subtract(p[1], p[0]);
+				math::Vector3 edge2 = Subtract(p[2], p[0]);
+				float du1 = uv[1].x - uv[0].x;
+				float dv1 = uv[1].y - uv[0].y;
+				float du2 = uv[2].x - uv[0].x;
+				float dv2 = uv[2].y - uv[0].y;
+				float determinant = du1 * dv2 - du2 * dv1;
+				if (std::abs(determinant) < 1.0e-20f) {
+					// UVが潰れている三角形は寄与しない
+					continue;
+				}
+				float inverse = 1.0f / determinant;
+				math::Vector3 faceTangent = {
+					(edge1.x * dv2 - edge2.x * dv1) * inverse,
+					(edge1.y * dv2 - edge2.y * dv1) * inverse,
+					(edge1.z * dv2 - edge2.z * dv1) * inverse };
+				math::Vector3 faceBitangent = {
+					(edge2.x * du1 - edge1.x * du2) * inverse,
+					(edge2.y * du1 - edge1.y * du2) * inverse,
+					(edge2.z * du1 - edge1.z * du2) * inverse };
+
+				float weights[3];
+				GetCornerAngles(p, weights);
+				for (uint32_t corner = 0; corner < 3; ++corner) {
+					// 頂点法線に直交させて正規化し、角度で重み付けする(大きさがUVの縮尺に依らない)
+					const math::Vector3 &n = normals[vertices[corner]];
+					math::Vector3 t = Normalize(Subtract(faceTangent, Scale(n, Dot(n, faceTangent))));
+					math::Vector3 b = Normalize(Subtract(faceBitangent, Scale(n, Dot(n, faceBitangent))));
+					accumulator.Add(vertices[corner], 0, Scale(t, weights[corner]));
+					accumulator.Add(vertices[corner], 3, Scale(b, weights[corner]));
+				}
+			}
+			});
+
+		tangents.resize(vertexCount);
+		ForRanges(vertexCount, kVertexGroupSize, parallel, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t vertex = begin; vertex < end; ++vertex) {
+				const math::Vector3 &n = normals[vertex];
+				math::Vector3 t = accumulator.Get(vertex, 0);
+				math::Vector3 b = accumulator.Get(vertex, 3);
+				// もう一度直交化してから正規化する
+				t = Normalize(Subtract(t, Scale(n, Dot(n, t))));
+				if (Dot(t, t) == 0.0f) {
+					// UVの無い頂点は法線に直交する適当な向きにする
+					t = Normalize(std::abs(n.x) < 0.9f ? Cross(n, { 1.0f,0.0f,0.0f }) : Cross(n, { 0.0f,1.0f,0.0f }));
+				}
+				float handedness = Dot(Cross(n, t), b) < 0.0f ? -1.0f : 1.0f;
+				tangents[vertex] = { t.x, t.y, t.z, handedness };
+			}
+			});
+	}
+}
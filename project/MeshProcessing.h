@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "MathTypes.h"
+
+// メッシュの加工(法線・接線の生成)
+// 三角形の範囲ごとに並列で処理し、頂点への足し込みは固定小数点のアトミック加算で行う
+// 整数の加算は順序に依らないので、スレッド数が変わっても結果はビット単位で同じになる
+namespace mesh
+{
+	// 法線の重み付け
+	enum class NormalWeighting
+	{
+		Uniform, //!< 面法線の単純平均(スムーズ)
+		Angle, //!< 頂点での角度で重み付け
+	};
+
+	/// <summary>
+	/// 頂点法線を生成する
+	/// </summary>
+	/// <param name="indices">三角形リストのインデックス</param>
+	/// <param name="parallel">ジョブシステムで並列に処理するか</param>
+	void GenerateNormals(std::span<const math::Vector3> positions, std::span<const uint32_t> indices,
+		NormalWeighting weighting, std::vector<math::Vector3> &normals, bool parallel = true);
+
+	/// <summary>
+	/// 接線を生成する(MikkTSpaceと同じ規約: wは従法線の向きで、従法線 = w * cross(法線, 接線))
+	/// 面の接線を頂点法線に直交させて角度で重み付けし、頂点ごとに足し合わせる
+	/// </summary>
+	void GenerateTangents(std::span<const math::Vector3> positions, std::span<const math::Vector3> normals,
+		std::span<const math::Vector2> texcoords, std::span<const uint32_t> indices,
+		std::vector<math::Vector4> &tangents, bool parallel = true);
+}
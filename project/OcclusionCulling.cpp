@@ -0,0 +1,499 @@
+#include "OcclusionCulling.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MathFunctions.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OCCLUSION_CULLING_SSE2
+#endif
+
+namespace render
+{
+	namespace
+	{
+		// 何も描かれていない画素の深度
+		constexpr float kClearDepth = 1.0f;
+		// ジョブ1つで判定する物体の数
+		constexpr uint32_t kTestGroupSize = 256;
+
+		// 同次座標
+		struct ClipVertex
+		{
+			float x, y, z, w;
+		};
+
+		ClipVertex TransformToClip(const math::Vector3 &v, const math::Matrix4x4 &m)
+		{
+			return {
+				v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + m.m[3][0],
+				v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + m.m[3][1],
+				v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + m.m[3][2],
+				v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + m.m[3][3] };
+		}
+
+		double ElapsedMilliseconds(std::chrono::steady_clock::time_point begin)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		}
+	}
+
+	void OcclusionCuller::Initialize(uint32_t width, uint32_t height)
+	{
+		assert(width > 0 && width % kTileWidth == 0);
+		assert(height > 0 && height % kTileHeight == 0);
+		width_ = width;
+		height_ = height;
+		tileCountX_ = width / kTileWidth;
+		tileCountY_ = height / kTileHeight;
+		depth_.assign(size_t(width) * height, kClearDepth);
+		tileMaxDepth_.assign(size_t(tileCountX_) * tileCountY_, kClearDepth);
+		tileBins_.resize(size_t(tileCountX_) * tileCountY_);
+	}
+
+	void OcclusionCuller::BeginFrame(const math::Matrix4x4 &viewProjection)
+	{
+		viewProjection_ = viewProjection;
+		std::fill(depth_.begin(), depth_.end(), kClearDepth);
+		std::fill(tileMaxDepth_.begin(), tileMaxDepth_.end(), kClearDepth);
+		triangles_.clear();
+		// 容量は次のフレームでも使う
+		for (std::vector<uint32_t> &bin : tileBins_) {
+			bin.clear();
+		}
+		statistics_ = OcclusionStatistics {};
+	}
+
+	void OcclusionCuller::AddOccluder(std::span<const math::Vector3> positions, std::span<const uint32_t> indices, const math::Matrix4x4 &world)
+	{
+		assert(indices.size() % 3 == 0);
+		auto begin = std::chrono::steady_clock::now();
+		statistics_.occluderTriangleCount += static_cast<uint32_t>(indices.size() / 3);
+
+		math::Matrix4x4 worldViewProjection = math::Multiply(world, viewProjection_);
+		FrameVector<ClipVertex> clipVertices;
+		clipVertices.reserve(positions.size());
+		for (const math::Vector3 &position : positions) {
+			clipVertices.push_back(TransformToClip(position, worldViewProjection));
+		}
+
+		// 同次座標から画面の画素座標と深度へ
+		auto project = [this](const ClipVertex &v) {
+			float inverseW = 1.0f / v.w;
+			return math::Vector3 {
+				(v.x * inverseW * 0.5f + 0.5f) * float(width_),
+				(0.5f - v.y * inverseW * 0.5f) * float(height_),
+				v.z * inverseW };
+		};
+
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			const ClipVertex triangle[3] = { clipVertices[indices[i]], clipVertices[indices[i + 1]], clipVertices[indices[i + 2]] };
+			uint32_t insideCount = 0;
+			for (const ClipVertex &v : triangle) {
+				insideCount += v.z >= 0.0f ? 1 : 0;
+			}
+			if (insideCount == 0) {
+				continue;
+			}
+			if (insideCount == 3) {
+				AddScreenTriangle({ project(triangle[0]), project(triangle[1]), project(triangle[2]) });
+				continue;
+			}
+
+			// ニアクリップ面(z = 0)で切り、できた多角形(最大4頂点)を扇状に分ける
+			ClipVertex polygon[4];
+			uint32_t polygonSize = 0;
+			for (uint32_t corner = 0; corner < 3; ++corner) {
+				const ClipVertex &a = triangle[corner];
+				const ClipVertex &b = triangle[(corner + 1) % 3];
+				if (a.z >= 0.0f) {
+					polygon[polygonSize++] = a;
+				}
+				if ((a.z >= 0.0f) != (b.z >= 0.0f)) {
+					float t = a.z / (a.z - b.z);
+					polygon[polygonSize++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, a.w + (b.w - a.w) * t };
+				}
+			}
+			for (uint32_t corner = 1; corner + 1 < polygonSize; ++corner) {
+				AddScreenTriangle({ project(polygon[0]), project(polygon[corner]), project(polygon[corner + 1]) });
+			}
+		}
+		statistics_.setupMilliseconds += ElapsedMilliseconds(begin);
+	}
+
+	void OcclusionCuller::AddScreenTriangle(const math::Vector3 (&vertices)[3])
+	{
+		const math::Vector3 &v0 = vertices[0];
+		const math::Vector3 &v1 = vertices[1];
+		const math::Vector3 &v2 = vertices[2];
+
+		// 画素の範囲(画面外なら捨てる)
+		int32_t minX = (std::max)(static_cast<int32_t>(std::floor((std::min)({ v0.x, v1.x, v2.x }))), 0);
+		int32_t minY = (std::max)(static_cast<int32_t>(std::floor((std::min)({ v0.y, v1.y, v2.y }))), 0);
+		int32_t maxX = (std::min)(static_cast<int32_t>(std::ceil((std::max)({ v0.x, v1.x, v2.x }))), static_cast<int32_t>(width_));
+		int32_t maxY = (std::min)(static_cast<int32_t>(std::ceil((std::max)({ v0.y, v1.y, v2.y }))), static_cast<int32_t>(height_));
+		if (minX >= maxX || minY >= maxY) {
+			return;
+		}
+
+		// 辺関数(頂点iから頂点i+1への辺)。面積が正になる向きに揃えるので、表裏どちらの面も描く
+		ScreenTriangle triangle;
+		for (uint32_t i = 0; i < 3; ++i) {
+			const math::Vector3 &a = vertices[i];
+			const math::Vector3 &b = vertices[(i + 1) % 3];
+			triangle.edgeA[i] = a.y - b.y;
+			triangle.edgeB[i] = b.x - a.x;
+			triangle.edgeC[i] = a.x * b.y - a.y * b.x;
+		}
+		float area = triangle.edgeA[0] * v2.x + triangle.edgeB[0] * v2.y + triangle.edgeC[0];
+		if (area == 0.0f) {
+			return;
+		}
+		if (area < 0.0f) {
+			for (uint32_t i = 0; i < 3; ++i) {
+				triangle.edgeA[i] = -triangle.edgeA[i];
+				triangle.edgeB[i] = -triangle.edgeB[i];
+				triangle.edgeC[i] = -triangle.edgeC[i];
+			}
+			area = -area;
+		}
+
+		// 深度は画面空間で線形なので、重心座標(辺関数 / 面積)で頂点の深度を混ぜた平面になる
+		// 辺1(頂点1→2)が頂点0の重み、辺2が頂点1、辺0が頂点2の重み
+		float inverseArea = 1.0f / area;
+		triangle.depthA = (triangle.edgeA[1] * v0.z + triangle.edgeA[2] * v1.z + triangle.edgeA[0] * v2.z) * inverseArea;
+		triangle.depthB = (triangle.edgeB[1] * v0.z + triangle.edgeB[2] * v1.z + triangle.edgeB[0] * v2.z) * inverseArea;
+		triangle.depthC = (triangle.edgeC[1] * v0.z + triangle.edgeC[2] * v1.z + triangle.edgeC[0] * v2.z) * inverseArea;
+		triangle.minX = minX;
+		triangle.minY = minY;
+		triangle.maxX = maxX;
+		triangle.maxY = maxY;
+
+		uint32_t index = static_cast<uint32_t>(triangles_.size());
+		triangles_.push_back(triangle);
+		for (int32_t ty = minY / int32_t(kTileHeight); ty <= (maxY - 1) / int32_t(kTileHeight); ++ty) {
+			for (int32_t tx = minX / int32_t(kTileWidth); tx <= (maxX - 1) / int32_t(kTileWidth); ++tx) {
+				tileBins_[ty * tileCountX_ + tx].push_back(index);
+			}
+		}
+	}
+
+	void OcclusionCuller::Rasterize()
+	{
+		auto begin = std::chrono::steady_clock::now();
+		statistics_.rasterizedTriangleCount = static_cast<uint32_t>(triangles_.size());
+
+		// タイルは深度バッファの別々の範囲を書くので、同期せずに並列に描ける
+		uint32_t tileCount = tileCountX_ * tileCountY_;
+		auto rasterizeTiles = [this](uint32_t first, uint32_t last) {
+			for (uint32_t tile = first; tile < last; ++tile) {
+#ifdef OCCLUSION_CULLING_SSE2
+				if (useSimd_) {
+					RasterizeTileSimd(tile);
+					continue;
+				}
+#endif
+				RasterizeTileScalar(tile);
+			}
+		};
+		if (useJobs_) {
+			JobSystem::GetInstance()->ParallelFor(tileCount, 1, rasterizeTiles);
+		} else {
+			rasterizeTiles(0, tileCount);
+		}
+		statistics_.rasterizeMilliseconds += ElapsedMilliseconds(begin);
+	}
+
+	void OcclusionCuller::RasterizeTileScalar(uint32_t tile)
+	{
+		int32_t tileX = static_cast<int32_t>(tile % tileCountX_ * kTileWidth);
+		int32_t tileY = static_cast<int32_t>(tile / tileCountX_ * kTileHeight);
+		float *depth = depth_.data() + size_t(tile) * kTileWidth * kTileHeight;
+
+		for (uint32_t index : tileBins_[tile]) {
+			const ScreenTriangle &triangle = triangles_[index];
+			int32_t minX = (std::max)(triangle.minX, tileX);
+			int32_t maxX = (std::min)(triangle.maxX, tileX + int32_t(kTileWidth));
+			int32_t minY = (std::max)(triangle.minY, tileY);
+			int32_t maxY = (std::min)(triangle.maxY, tileY + int32_t(kTileHeight));
+			for (int32_t y = minY; y < maxY; ++y) {
+				// 画素の中心で判定する。SIMD版と結果が一致するよう、行ごとの項を先にまとめて a * x + (b * y + c) の順で計算する
+				float py = float(y) + 0.5f;
+				float rowEdge0 = triangle.edgeB[0] * py + triangle.edgeC[0];
+				float rowEdge1 = triangle.edgeB[1] * py + triangle.edgeC[1];
+				float rowEdge2 = triangle.edgeB[2] * py + triangle.edgeC[2];
+				float rowDepth = triangle.depthB * py + triangle.depthC;
+				float *row = depth + (y - tileY) * kTileWidth - tileX;
+				for (int32_t x = minX; x < maxX; ++x) {
+					float px = float(x) + 0.5f;
+					if (triangle.edgeA[0] * px + rowEdge0 < 0.0f ||
+						triangle.edgeA[1] * px + rowEdge1 < 0.0f ||
+						triangle.edgeA[2] * px + rowEdge2 < 0.0f) {
+						continue;
+					}
+					float z = triangle.depthA * px + rowDepth;
+					row[x] = (std::min)(row[x], z);
+				}
+			}
+		}
+
+		float maxDepth = 0.0f;
+		for (uint32_t i = 0; i < kTileWidth * kTileHeight; ++i) {
+			maxDepth = (std::max)(maxDepth, depth[i]);
+		}
+		tileMaxDepth_[tile] = maxDepth;
+	}
+
+	bool OcclusionCuller::IsVisible(const BoundingBox &box) const
+	{
+		// 8頂点を変換し、画面上の矩形と最も手前の深度を求める
+		float minX = 1.0e30f, minY = 1.0e30f, maxX = -1.0e30f, maxY = -1.0e30f;
+		float minDepth = 1.0e30f;
+		if (!ProjectBox(box, minX, minY, maxX, maxY, minDepth)) {
+			// ニアクリップ面をまたぐものはカメラの目の前にあるので隠れない
+			return true;
+		}
+
+		// 少しでもかかる画素は全て調べる
+		int32_t rectMinX = (std::max)(static_cast<int32_t>(std::floor(minX)), 0);
+		int32_t rectMinY = (std::max)(static_cast<int32_t>(std::floor(minY)), 0);
+		int32_t rectMaxX = (std::min)(static_cast<int32_t>(std::ceil(maxX)), static_cast<int32_t>(width_));
+		int32_t rectMaxY = (std::min)(static_cast<int32_t>(std::ceil(maxY)), static_cast<int32_t>(height_));
+		if (rectMinX >= rectMaxX || rectMinY >= rectMaxY) {
+			// 画面外(視錐台カリングの役目なので、ここでは隠れたことにしない)
+			return true;
+		}
+
+		for (int32_t ty = rectMinY / int32_t(kTileHeight); ty <= (rectMaxY - 1) / int32_t(kTileHeight); ++ty) {
+			for (int32_t tx = rectMinX / int32_t(kTileWidth); tx <= (rectMaxX - 1) / int32_t(kTileWidth); ++tx) {
+				uint32_t tile = ty * tileCountX_ + tx;
+				// タイルの最も遠い深度より奥なら、タイル内のどの画素でも隠れる
+				if (tileMaxDepth_[tile] < minDepth) {
+					continue;
+				}
+				int32_t tileMinX = (std::max)(rectMinX, tx * int32_t(kTileWidth));
+				int32_t tileMinY = (std::max)(rectMinY, ty * int32_t(kTileHeight));
+				int32_t tileMaxX = (std::min)(rectMaxX, (tx + 1) * int32_t(kTileWidth));
+				int32_t tileMaxY = (std::min)(rectMaxY, (ty + 1) * int32_t(kTileHeight));
+#ifdef OCCLUSION_CULLING_SSE2
+				if (useSimd_) {
+					if (!IsRectOccludedSimd(tile, tileMinX, tileMinY, tileMaxX, tileMaxY, minDepth)) {
+						return true;
+					}
+					continue;
+				}
+#endif
+				if (!IsRectOccludedScalar(tile, tileMinX, tileMinY, tileMaxX, tileMaxY, minDepth)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	bool OcclusionCuller::ProjectBox(const BoundingBox &box, float &minX, float &minY, float &maxX, float &maxY, float &minDepth) const
+	{
+#ifdef OCCLUSION_CULLING_SSE2
+		if (useSimd_) {
+			// 4頂点ずつ(手前の面と奥の面)まとめて変換する
+			const math::Matrix4x4 &m = viewProjection_;
+			const __m128 x = _mm_setr_ps(box.min.x, box.max.x, box.min.x, box.max.x);
+			const __m128 y = _mm_setr_ps(box.min.y, box.min.y, box.max.y, box.max.y);
+			__m128 screenMinX = _mm_set1_ps(1.0e30f), screenMaxX = _mm_set1_ps(-1.0e30f);
+			__m128 screenMinY = _mm_set1_ps(1.0e30f), screenMaxY = _mm_set1_ps(-1.0e30f);
+			__m128 nearest = _mm_set1_ps(1.0e30f);
+			for (float z : { box.min.z, box.max.z }) {
+				__m128 clip[4];
+				for (int c = 0; c < 4; ++c) {
+					clip[c] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m.m[0][c])), _mm_mul_ps(y, _mm_set1_ps(m.m[1][c]))),
+						_mm_set1_ps(z * m.m[2][c] + m.m[3][c]));
+				}
+				if (_mm_movemask_ps(_mm_cmplt_ps(clip[2], _mm_setzero_ps())) != 0) {
+					return false;
+				}
+				__m128 inverseW = _mm_div_ps(_mm_set1_ps(1.0f), clip[3]);
+				__m128 screenX = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0], inverseW), _mm_set1_ps(0.5f)), _mm_set1_ps(0.5f)), _mm_set1_ps(float(width_)));
+				__m128 screenY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(_mm_mul_ps(clip[1], inverseW), _mm_set1_ps(0.5f))), _mm_set1_ps(float(height_)));
+				screenMinX = _mm_min_ps(screenMinX, screenX);
+				screenMaxX = _mm_max_ps(screenMaxX, screenX);
+				screenMinY = _mm_min_ps(screenMinY, screenY);
+				screenMaxY = _mm_max_ps(screenMaxY, screenY);
+				nearest = _mm_min_ps(nearest, _mm_mul_ps(clip[2], inverseW));
+			}
+			// 4レーンを1つにまとめる
+			auto reduce = [](__m128 v, bool isMin) {
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, v);
+				return isMin ? (std::min)((std::min)(lanes[0], lanes[1]), (std::min)(lanes[2], lanes[3]))
+					: (std::max)((std::max)(lanes[0], lanes[1]), (std::max)(lanes[2], lanes[3]));
+			};
+			minX = reduce(screenMinX, true);
+			maxX = reduce(screenMaxX, false);
+			minY = reduce(screenMinY, true);
+			maxY = reduce(screenMaxY, false);
+			minDepth = reduce(nearest, true);
+			return true;
+		}
+#endif
+		for (uint32_t corner = 0; corner < 8; ++corner) {
+			math::Vector3 position = {
+				(corner & 1) ? box.max.x : box.min.x,
+				(corner & 2) ? box.max.y : box.min.y,
+				(corner & 4) ? box.max.z : box.min.z };
+			// SIMD版と結果が一致するよう、同じ順で足す((x, yの項) + (zの項 + 平行移動))
+			const math::Matrix4x4 &m = viewProjection_;
+			ClipVertex v = {
+				(position.x * m.m[0][0] + position.y * m.m[1][0]) + (position.z * m.m[2][0] + m.m[3][0]),
+				(position.x * m.m[0][1] + position.y * m.m[1][1]) + (position.z * m.m[2][1] + m.m[3][1]),
+				(position.x * m.m[0][2] + position.y * m.m[1][2]) + (position.z * m.m[2][2] + m.m[3][2]),
+				(position.x * m.m[0][3] + position.y * m.m[1][3]) + (position.z * m.m[2][3] + m.m[3][3]) };
+			if (v.z < 0.0f) {
+				return false;
+			}
+			float inverseW = 1.0f / v.w;
+			float x = (v.x * inverseW * 0.5f + 0.5f) * float(width_);
+			float y = (0.5f - v.y * inverseW * 0.5f) * float(height_);
+			minX = (std::min)(minX, x);
+			maxX = (std::max)(maxX, x);
+			minY = (std::min)(minY, y);
+			maxY = (std::max)(maxY, y);
+			minDepth = (std::min)(minDepth, v.z * inverseW);
+		}
+		return true;
+	}
+
+	bool OcclusionCuller::IsRectOccludedScalar(uint32_t tile, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float depth) const
+	{
+		int32_t tileX = static_cast<int32_t>(tile % tileCountX_ * kTileWidth);
+		int32_t tileY = static_cast<int32_t>(tile / tileCountX_ * kTileHeight);
+		const float *tileDepth = depth_.data() + size_t(tile) * kTileWidth * kTileHeight;
+		for (int32_t y = minY; y < maxY; ++y) {
+			const float *row = tileDepth + (y - tileY) * kTileWidth - tileX;
+			for (int32_t x = minX; x < maxX; ++x) {
+				if (row[x] >= depth) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void OcclusionCuller::TestVisibility(std::span<const BoundingBox> boxes, std::span<uint8_t> visible)
+	{
+		assert(visible.size() >= boxes.size());
+		auto begin = std::chrono::steady_clock::now();
+		auto test = [&](uint32_t first, uint32_t last) {
+			for (uint32_t i = first; i < last; ++i) {
+				visible[i] = IsVisible(boxes[i]) ? 1 : 0;
+			}
+		};
+		uint32_t count = static_cast<uint32_t>(boxes.size());
+		if (useJobs_ && count > kTestGroupSize) {
+			JobSystem::GetInstance()->ParallelFor(count, kTestGroupSize, test);
+		} else {
+			test(0, count);
+		}
+
+		uint32_t culledCount = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			culledCount += visible[i] ? 0 : 1;
+		}
+		statistics_.testedCount += count;
+		statistics_.culledCount += culledCount;
+		statistics_.testMilliseconds += ElapsedMilliseconds(begin);
+	}
+
+	float OcclusionCuller::GetDepth(uint32_t x, uint32_t y) const
+	{
+		assert(x < width_ && y < height_);
+		uint32_t tile = (y / kTileHeight) * tileCountX_ + x / kTileWidth;
+		return depth_[size_t(tile) * kTileWidth * kTileHeight + (y % kTileHeight) * kTileWidth + x % kTileWidth];
+	}
+
+#ifdef OCCLUSION_CULLING_SSE2
+	void OcclusionCuller::RasterizeTileSimd(uint32_t tile)
+	{
+		int32_t tileX = static_cast<int32_t>(tile % tileCountX_ * kTileWidth);
+		int32_t tileY = static_cast<int32_t>(tile / tileCountX_ * kTileHeight);
+		float *depth = depth_.data() + size_t(tile) * kTileWidth * kTileHeight;
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (uint32_t index : tileBins_[tile]) {
+			const ScreenTriangle &triangle = triangles_[index];
+			// 横は4画素単位に揃える(タイルの幅は4の倍数なのでタイルからははみ出ない。範囲外の画素は辺関数で弾かれる)
+			int32_t minX = (std::max)(triangle.minX, tileX) & ~3;
+			int32_t maxX = (std::min)(triangle.maxX, tileX + int32_t(kTileWidth));
+			int32_t minY = (std::max)(triangle.minY, tileY);
+			int32_t maxY = (std::min)(triangle.maxY, tileY + int32_t(kTileHeight));
+
+			// 辺関数と深度は4画素ごとに a * x + (b * y + c) をそのまま求める
+			// (左端から a * 4 を足し進めると誤差が溜まり、画素の境目でスカラー版と結果が食い違う)
+			const __m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]);
+			const __m128 edgeA1 = _mm_set1_ps(triangle.edgeA[1]);
+			const __m128 edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+			const __m128 depthA = _mm_set1_ps(triangle.depthA);
+
+			for (int32_t y = minY; y < maxY; ++y) {
+				float py = float(y) + 0.5f;
+				const __m128 rowEdge0 = _mm_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+				const __m128 rowEdge1 = _mm_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+				const __m128 rowEdge2 = _mm_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+				const __m128 rowDepth = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+				float *row = depth + (y - tileY) * kTileWidth - tileX;
+				for (int32_t x = minX; x < maxX; x += 4) {
+					__m128 px = _mm_add_ps(_mm_set1_ps(float(x)), laneOffsets);
+					__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, px), rowEdge0);
+					__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, px), rowEdge1);
+					__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, px), rowEdge2);
+					__m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+					__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+					if (_mm_movemask_ps(inside) != 0) {
+						__m128 current = _mm_loadu_ps(row + x);
+						__m128 nearest = _mm_min_ps(current, z);
+						_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+					}
+				}
+			}
+		}
+
+		__m128 maxDepth = _mm_loadu_ps(depth);
+		for (uint32_t i = 4; i < kTileWidth * kTileHeight; i += 4) {
+			maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(depth + i));
+		}
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, maxDepth);
+		tileMaxDepth_[tile] = (std::max)((std::max)(lanes[0], lanes[1]), (std::max)(lanes[2], lanes[3]));
+	}
+
+	bool OcclusionCuller::IsRectOccludedSimd(uint32_t tile, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float depth) const
+	{
+		int32_t tileX = static_cast<int32_t>(tile % tileCountX_ * kTileWidth);
+		int32_t tileY = static_cast<int32_t>(tile / tileCountX_ * kTileHeight);
+		const float *tileDepth = depth_.data() + size_t(tile) * kTileWidth * kTileHeight;
+		const __m128 occludeeDepth = _mm_set1_ps(depth);
+		int32_t alignedMinX = minX & ~3;
+		for (int32_t y = minY; y < maxY; ++y) {
+			const float *row = tileDepth + (y - tileY) * kTileWidth - tileX;
+			for (int32_t x = alignedMinX; x < maxX; x += 4) {
+				// 矩形の外の画素は見ない
+				int laneMask = 0xF;
+				if (x < minX) {
+					laneMask &= 0xF << (minX - x);
+				}
+				if (x + 4 > maxX) {
+					laneMask &= 0xF >> (x + 4 - maxX);
+				}
+				if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), occludeeDepth)) & laneMask) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+#endif
+}
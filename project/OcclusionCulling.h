@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "MathTypes.h"
+
+// CPUのソフトウェアオクルージョンカリング
+// 遮蔽物(大きな壁や地形など)の三角形を低解像度の深度バッファにラスタライズし、
+// 描画する物体のAABBがその奥に完全に隠れていれば描画の投入を省く
+// 深度バッファはタイルごとに区切って持ち、ラスタライズはタイル単位でジョブに分ける。
+// タイルごとの最も遠い深度(階層Z)で、多くの物体は画素を見ずに判定できる
+namespace render
+{
+	// ワールド空間のAABB
+	struct BoundingBox
+	{
+		math::Vector3 min;
+		math::Vector3 max;
+	};
+
+	// 1フレーム分の統計(効果とコストの確認用)
+	struct OcclusionStatistics
+	{
+		uint32_t occluderTriangleCount = 0; //!< 投入された遮蔽物の三角形数
+		uint32_t rasterizedTriangleCount = 0; //!< クリップ・画面外の除去後にラスタライズした三角形数
+		uint32_t testedCount = 0; //!< 判定した物体数
+		uint32_t culledCount = 0; //!< 隠れていると判定した物体数
+		double setupMilliseconds = 0.0; //!< 遮蔽物の変換・タイルへの振り分け
+		double rasterizeMilliseconds = 0.0;
+		double testMilliseconds = 0.0;
+	};
+
+	class OcclusionCuller
+	{
+	public:
+		// 深度バッファのタイルの大きさ(画素)
+		static constexpr uint32_t kTileWidth = 32;
+		static constexpr uint32_t kTileHeight = 16;
+
+	public: // メンバ関数
+		/// <summary>
+		/// 初期化
+		/// </summary>
+		/// <param name="width">深度バッファの幅(kTileWidthの倍数)</param>
+		/// <param name="height">深度バッファの高さ(kTileHeightの倍数)</param>
+		void Initialize(uint32_t width = 320, uint32_t height = 192);
+
+		// フレームの開始(深度バッファと統計をクリアする)
+		void BeginFrame(const math::Matrix4x4 &viewProjection);
+
+		/// <summary>
+		/// 遮蔽物を追加する(変換してタイルに振り分けるだけで、ラスタライズはRasterizeで行う)
+		/// 遮蔽物は中身の詰まった(向こうが透けない)メッシュであること
+		/// </summary>
+		void AddOccluder(std::span<const math::Vector3> positions, std::span<const uint32_t> indices, const math::Matrix4x4 &world);
+
+		// 振り分けた遮蔽物を深度バッファに描く
+		void Rasterize();
+
+		// AABBが見えうるか(完全に隠れていればfalse)。Rasterizeの後に呼ぶ
+		bool IsVisible(const BoundingBox &box) const;
+
+		/// <summary>
+		/// まとめて判定し、統計を更新する
+		/// </summary>
+		/// <param name="visible">見えうるなら1、隠れていれば0(boxesと同じ数)</param>
+		void TestVisibility(std::span<const BoundingBox> boxes, std::span<uint8_t> visible);
+
+		// 画素の深度(0が手前、1が奥。デバッグ表示用)
+		float GetDepth(uint32_t x, uint32_t y) const;
+
+		const OcclusionStatistics &GetStatistics() const { return statistics_; }
+		uint32_t GetWidth() const { return width_; }
+		uint32_t GetHeight() const { return height_; }
+
+		// SIMDでラスタライズ・判定するか(比較計測用)
+		void SetUseSimd(bool useSimd) { useSimd_ = useSimd; }
+		// タイル・物体をジョブに分けて並列に処理するか
+		void SetUseJobs(bool useJobs) { useJobs_ = useJobs; }
+
+	private:
+		// 画面空間の三角形(辺関数と深度の平面を求めたもの)
+		struct ScreenTriangle
+		{
+			// 辺ごとの a * x + b * y + c (内側が正)
+			float edgeA[3];
+			float edgeB[3];
+			float edgeC[3];
+			// 深度 = depthA * x + depthB * y + depthC
+			float depthA;
+			float depthB;
+			float depthC;
+			// 画素単位の範囲 [min, max)
+			int32_t minX, minY, maxX, maxY;
+		};
+
+		// 画面空間の3頂点(x, y, 深度)から三角形を作ってタイルに振り分ける
+		void AddScreenTriangle(const math::Vector3 (&vertices)[3]);
+		// 1タイル分をラスタライズし、タイルの最も遠い深度を求める
+		void RasterizeTileScalar(uint32_t tile);
+		void RasterizeTileSimd(uint32_t tile);
+		// AABBの画面上の範囲と最も手前の深度を求める(ニアクリップ面をまたげばfalse)
+		bool ProjectBox(const BoundingBox &box, float &minX, float &minY, float &maxX, float &maxY, float &minDepth) const;
+		// タイルの中の矩形[minX, maxX) × [minY, maxY)の画素が全てdepthより手前か
+		bool IsRectOccludedScalar(uint32_t tile, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float depth) const;
+		bool IsRectOccludedSimd(uint32_t tile, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, float depth) const;
+
+		uint32_t width_ = 0;
+		uint32_t height_ = 0;
+		uint32_t tileCountX_ = 0;
+		uint32_t tileCountY_ = 0;
+
+		math::Matrix4x4 viewProjection_ {};
+		// 深度(タイルごとに連続して並べる)
+		std::vector<float> depth_;
+		// タイルごとの最も遠い深度
+		std::vector<float> tileMaxDepth_;
+		// 振り分けた三角形と、タイルごとの三角形番号
+		std::vector<ScreenTriangle> triangles_;
+		std::vector<std::vector<uint32_t>> tileBins_;
+
+		OcclusionStatistics statistics_;
+		bool useSimd_ = true;
+		bool useJobs_ = true;
+	};
+}
@@ -0,0 +1,190 @@
+#include "PerfCounters.h"
+#include <cassert>
+#include <format>
+#include <fstream>
+
+std::atomic<PerfCounters *> PerfCounters::instance = nullptr;
+std::mutex PerfCounters::instanceMutex;
+
+namespace
+{
+	// インスタンスを作り直したときに、スレッドが古い領域を使い続けないための世代
+	std::atomic<uint64_t> instanceGeneration { 0 };
+
+	// スレッドごとの領域の参照
+	struct ThreadCountersCache
+	{
+		uint64_t generation = UINT64_MAX;
+		void *counters = nullptr;
+	};
+	thread_local ThreadCountersCache threadCountersCache;
+
+	// CSV・JSONの列名にそのまま使える名前か
+	bool IsValidCounterName(const std::string &name)
+	{
+		if (name.empty()) {
+			return false;
+		}
+		for (char c : name) {
+			bool alphanumeric = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+			if (!alphanumeric && c != '.' && c != '_') {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+PerfCounters *PerfCounters::GetInstance()
+{
+	PerfCounters *self = instance.load(std::memory_order_acquire);
+	if (self == nullptr) {
+		// 同時に呼ばれても1つだけ作る
+		std::lock_guard<std::mutex> lock(instanceMutex);
+		self = instance.load(std::memory_order_relaxed);
+		if (self == nullptr) {
+			self = new PerfCounters;
+			instanceGeneration.fetch_add(1, std::memory_order_relaxed);
+			instance.store(self, std::memory_order_release);
+		}
+	}
+	return self;
+}
+
+void PerfCounters::Finalize()
+{
+	std::lock_guard<std::mutex> lock(instanceMutex);
+	delete instance.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+PerfCounters::CounterId PerfCounters::Register(const std::string &name, Kind kind)
+{
+	assert(IsValidCounterName(name));
+	PerfCounters *self = GetInstance();
+	std::lock_guard<std::mutex> lock(self->mutex_);
+	uint32_t count = self->counterCount_.load(std::memory_order_relaxed);
+	for (CounterId counter = 0; counter < count; ++counter) {
+		if (self->counters_[counter].name == name) {
+			// 同じ名前を別の種類で登録してはならない
+			assert(self->counters_[counter].kind == kind);
+			return counter;
+		}
+	}
+	assert(count < kMaxCounters);
+	self->counters_[count] = { name, kind };
+	self->counterCount_.store(count + 1, std::memory_order_release);
+	return count;
+}
+
+void PerfCounters::Add(CounterId counter, int64_t value)
+{
+	assert(counter < kMaxCounters);
+	// 書くのは持ち主のスレッドだけなので、読み出して足して書き戻すだけでよい(読み手は途中の値を見ない)
+	std::atomic<int64_t> &total = GetInstance()->GetThreadCounters().totals[counter];
+	total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void PerfCounters::Set(CounterId counter, int64_t value)
+{
+	assert(counter < kMaxCounters);
+	GetInstance()->gauges_[counter].store(value, std::memory_order_relaxed);
+}
+
+PerfCounters::ThreadCounters &PerfCounters::GetThreadCounters()
+{
+	uint64_t generation = instanceGeneration.load(std::memory_order_relaxed);
+	if (threadCountersCache.generation != generation) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		threadCounters_.push_back(std::make_unique<ThreadCounters>());
+		threadCountersCache.generation = generation;
+		threadCountersCache.counters = threadCounters_.back().get();
+	}
+	return *static_cast<ThreadCounters *>(threadCountersCache.counters);
+}
+
+void PerfCounters::EndFrame(double frameMilliseconds)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	uint32_t count = counterCount_.load(std::memory_order_acquire);
+
+	// 全スレッドの累計から前回の累計を引いて1フレーム分にする
+	std::array<int64_t, kMaxCounters> totals {};
+	for (const std::unique_ptr<ThreadCounters> &threadCounters : threadCounters_) {
+		for (CounterId counter = 0; counter < count; ++counter) {
+			totals[counter] += threadCounters->totals[counter].load(std::memory_order_relaxed);
+		}
+	}
+
+	Snapshot &snapshot = history_[historyHead_];
+	snapshot.frameNumber = frameCount_;
+	snapshot.frameMilliseconds = frameMilliseconds;
+	snapshot.values.fill(0);
+	for (CounterId counter = 0; counter < count; ++counter) {
+		if (counters_[counter].kind == Kind::Gauge) {
+			snapshot.values[counter] = gauges_[counter].load(std::memory_order_relaxed);
+		} else {
+			snapshot.values[counter] = totals[counter] - previousTotals_[counter];
+			previousTotals_[counter] = totals[counter];
+		}
+	}
+	historyHead_ = (historyHead_ + 1) % kHistoryFrameCount;
+	++frameCount_;
+}
+
+const PerfCounters::Snapshot &PerfCounters::GetLatest() const
+{
+	static const Snapshot kEmpty {};
+	if (frameCount_ == 0) {
+		return kEmpty;
+	}
+	return history_[(historyHead_ + kHistoryFrameCount - 1) % kHistoryFrameCount];
+}
+
+bool PerfCounters::ExportCsv(const std::string &filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		return false;
+	}
+	uint32_t count = GetCounterCount();
+	file << "frame,frameMs";
+	for (CounterId counter = 0; counter < count; ++counter) {
+		file << ',' << counters_[counter].name;
+	}
+	file << '\n';
+	ForEachSnapshot([&](const Snapshot &snapshot) {
+		file << std::format("{},{:.4f}", snapshot.frameNumber, snapshot.frameMilliseconds);
+		for (CounterId counter = 0; counter < count; ++counter) {
+			file << ',' << snapshot.values[counter];
+		}
+		file << '\n';
+		});
+	return static_cast<bool>(file);
+}
+
+bool PerfCounters::ExportJson(const std::string &filePath) const
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		return false;
+	}
+	uint32_t count = GetCounterCount();
+	// 名前は英数字と'.'、'_'に限っているので、そのまま引用符で囲めばよい
+	file << "{\n  \"counters\": [";
+	for (CounterId counter = 0; counter < count; ++counter) {
+		file << std::format("{}{{ \"name\": \"{}\", \"kind\": \"{}\" }}", counter == 0 ? "" : ", ",
+			counters_[counter].name, counters_[counter].kind == Kind::Gauge ? "gauge" : "perFrame");
+	}
+	file << "],\n  \"frames\": [";
+	bool first = true;
+	ForEachSnapshot([&](const Snapshot &snapshot) {
+		file << std::format("{}\n    {{ \"frame\": {}, \"frameMs\": {:.4f}, \"values\": [", first ? "" : ",", snapshot.frameNumber, snapshot.frameMilliseconds);
+		for (CounterId counter = 0; counter < count; ++counter) {
+			file << (counter == 0 ? "" : ", ") << snapshot.values[counter];
+		}
+		file << "] }";
+		first = false;
+		});
+	file << "\n  ]\n}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 1フレームごとの性能カウンタ(描画コール数、バインド数、転送量、確保回数など)
+// カウンタは名前で登録して番号で加算する。加算はスレッドごとの領域に書くだけなので、ロックも共有キャッシュラインの取り合いも無い
+// EndFrameで全スレッドの合計を集めて1フレーム分のスナップショットにし、直近kHistoryFrameCountフレーム分を
+// リングに残してCSV・JSONに書き出せる
+//
+//   static const PerfCounters::CounterId kDrawCalls = PerfCounters::Register("render.drawCalls");
+//   PerfCounters::Add(kDrawCalls, drawCount);
+//
+// 名前が"cpu."で始まるカウンタはCPUの区間の時間、"gpu."で始まるものはGPUのパスの時間(どちらもマイクロ秒)として扱う
+class PerfCounters
+{
+public:
+	using CounterId = uint32_t;
+
+	// カウンタの種類
+	enum class Kind
+	{
+		PerFrame, //!< Addした量の1フレーム分の合計
+		Gauge, //!< Setした最新の値(再生中のボイス数など)
+	};
+
+	// 登録できるカウンタの上限
+	static constexpr uint32_t kMaxCounters = 64;
+	// 残しておくフレーム数
+	static constexpr uint32_t kHistoryFrameCount = 1024;
+
+	// スコープを抜けるまでの時間(マイクロ秒)をカウンタに加算する
+	//   static const PerfCounters::CounterId kSimulation = PerfCounters::Register("cpu.simulation");
+	//   PerfCounters::ScopedTimer timer(kSimulation);
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(CounterId counter) : counter_(counter), start_(std::chrono::steady_clock::now()) {}
+		~ScopedTimer() { Add(counter_, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count()); }
+		ScopedTimer(const ScopedTimer &) = delete;
+		ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+	private:
+		CounterId counter_;
+		std::chrono::steady_clock::time_point start_;
+	};
+
+	// 1フレーム分のスナップショット
+	struct Snapshot
+	{
+		uint64_t frameNumber = 0;
+		double frameMilliseconds = 0.0;
+		std::array<int64_t, kMaxCounters> values {};
+	};
+
+public: // メンバ関数
+	// シングルトンインスタンスの取得(カウンタの加算は全てのスレッドから来るので、初回の生成も複数のスレッドから呼べる)
+	static PerfCounters *GetInstance();
+	// 終了(カウンタを加算するスレッドを全て止めてから呼ぶ)
+	void Finalize();
+
+	/// <summary>
+	/// カウンタを登録して番号を返す(同じ名前なら同じ番号。どのスレッドから呼んでもよい)
+	/// 名前は"分類.名前"の形で、CSV・JSONの列名にそのまま使うので英数字と'.'、'_'に限る
+	/// </summary>
+	static CounterId Register(const std::string &name, Kind kind = Kind::PerFrame);
+
+	// 加算する(呼び出し元スレッドの領域に書く)
+	static void Add(CounterId counter, int64_t value = 1);
+	// ゲージの値を設定する
+	static void Set(CounterId counter, int64_t value);
+
+	/// <summary>
+	/// 1フレーム分を締めてスナップショットを残す(メインスレッドのフレームの終わりで呼ぶ)
+	/// 他のスレッドの加算は集めた時点までの分が入り、残りは次のフレームに回る
+	/// </summary>
+	void EndFrame(double frameMilliseconds);
+
+	// 直近のスナップショット(まだ無ければ全て0)
+	const Snapshot &GetLatest() const;
+	// 残っているスナップショットを古い順に渡す
+	template <class F>
+	void ForEachSnapshot(F &&func) const
+	{
+		uint32_t count = GetSnapshotCount();
+		for (uint32_t i = 0; i < count; ++i) {
+			func(history_[(historyHead_ + kHistoryFrameCount - count + i) % kHistoryFrameCount]);
+		}
+	}
+	uint32_t GetSnapshotCount() const { return static_cast<uint32_t>((std::min)(frameCount_, uint64_t(kHistoryFrameCount))); }
+
+	// 登録済みのカウンタ
+	uint32_t GetCounterCount() const { return counterCount_.load(std::memory_order_acquire); }
+	const std::string &GetCounterName(CounterId counter) const { return counters_[counter].name; }
+	Kind GetCounterKind(CounterId counter) const { return counters_[counter].kind; }
+
+	// 残っているスナップショットを書き出す(1行1フレーム、列はフレーム番号・フレーム時間・各カウンタ)
+	bool ExportCsv(const std::string &filePath) const;
+	// 同じ内容をJSONで書き出す({ "counters": [...], "frames": [{ "frame": n, "frameMs": t, "values": [...] }, ...] })
+	bool ExportJson(const std::string &filePath) const;
+
+private:
+	static std::atomic<PerfCounters *> instance;
+	// 生成と破棄の排他
+	static std::mutex instanceMutex;
+
+	PerfCounters() = default;
+	~PerfCounters() = default;
+	PerfCounters(PerfCounters &) = delete;
+	PerfCounters &operator=(PerfCounters &) = delete;
+
+private:
+	// スレッドごとの累計(書くのは持ち主のスレッドだけ、読むのはEndFrame)
+	struct alignas(64) ThreadCounters
+	{
+		std::array<std::atomic<int64_t>, kMaxCounters> totals {};
+	};
+
+	struct Counter
+	{
+		std::string name;
+		Kind kind = Kind::PerFrame;
+	};
+
+	// 呼び出し元スレッドの領域(初回呼び出し時に作る)
+	ThreadCounters &GetThreadCounters();
+
+	std::mutex mutex_;
+	std::array<Counter, kMaxCounters> counters_;
+	std::atomic<uint32_t> counterCount_ { 0 };
+	// スレッドの領域(スレッドが終わっても累計を残すため、終了まで解放しない)
+	std::deque<std::unique_ptr<ThreadCounters>> threadCounters_;
+	std::array<std::atomic<int64_t>, kMaxCounters> gauges_ {};
+	// 前回のEndFrameでの全スレッドの累計
+	std::array<int64_t, kMaxCounters> previousTotals_ {};
+
+	std::vector<Snapshot> history_ = std::vector<Snapshot>(kHistoryFrameCount);
+	uint32_t historyHead_ = 0; //!< 次に書く位置
+	uint64_t frameCount_ = 0;
+};
@@ -0,0 +1,235 @@
+#include "PerfOverlay.h"
+#include "DirectXCommon.h"
+#include "JobSystem.h"
+#include "PerfCounters.h"
+#include "TextureManager.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+#ifdef USE_IMGUI
+#include "externals/imgui/imgui.h"
+#endif
+
+void PerfOverlay::Initialize(DirectXCommon *dxCommon)
+{
+	dxCommon_ = dxCommon;
+}
+
+void PerfOverlay::SetVisible(bool visible)
+{
+	if (visible && !visible_) {
+		// 非表示の間の分は稼働率に混ぜない
+		previousBusyNanoseconds_.clear();
+		workerUtilization_.clear();
+	}
+	visible_ = visible;
+}
+
+#ifdef USE_IMGUI
+
+namespace
+{
+	// バイト数をMB単位で
+	float ToMegabytes(uint64_t bytes)
+	{
+		return static_cast<float>(static_cast<double>(bytes) / (1024.0 * 1024.0));
+	}
+
+	// 名前がprefixで始まるか
+	bool HasPrefix(const std::string &name, const char *prefix)
+	{
+		return name.compare(0, std::strlen(prefix), prefix) == 0;
+	}
+}
+
+void PerfOverlay::Draw()
+{
+	if (!visible_) {
+		return;
+	}
+
+	ImGui::SetNextWindowSize(ImVec2(420.0f, 0.0f), ImGuiCond_FirstUseEver);
+	bool open = true;
+	if (ImGui::Begin("Performance", &open)) {
+		const PerfCounters::Snapshot &latest = PerfCounters::GetInstance()->GetLatest();
+		DrawFrameTimes();
+		if (ImGui::CollapsingHeader("CPU zones", ImGuiTreeNodeFlags_DefaultOpen)) {
+			DrawZones("cpu.", latest.frameMilliseconds);
+		}
+		if (ImGui::CollapsingHeader("GPU passes", ImGuiTreeNodeFlags_DefaultOpen)) {
+			DrawZones("gpu.", latest.frameMilliseconds);
+		}
+		if (ImGui::CollapsingHeader("Counters")) {
+			DrawCounters();
+		}
+		if (ImGui::CollapsingHeader("Texture memory", ImGuiTreeNodeFlags_DefaultOpen)) {
+			DrawTextureMemory();
+		}
+		if (ImGui::CollapsingHeader("Job system", ImGuiTreeNodeFlags_DefaultOpen)) {
+			DrawWorkers();
+		}
+	}
+	ImGui::End();
+
+	// ×ボタンで閉じたら次のフレームから何もしない
+	if (!open) {
+		SetVisible(false);
+	}
+}
+
+void PerfOverlay::DrawFrameTimes()
+{
+	PerfCounters *perfCounters = PerfCounters::GetInstance();
+
+	// 直近kGraphFrameCountフレーム分を古い順に詰める
+	uint32_t snapshotCount = perfCounters->GetSnapshotCount();
+	uint32_t skip = snapshotCount > kGraphFrameCount ? snapshotCount - kGraphFrameCount : 0;
+	uint32_t frameCount = 0;
+	uint32_t index = 0;
+	histogram_.fill(0.0f);
+	perfCounters->ForEachSnapshot([&](const PerfCounters::Snapshot &snapshot) {
+		if (index++ < skip) {
+			return;
+		}
+		float milliseconds = static_cast<float>(snapshot.frameMilliseconds);
+		frameTimes_[frameCount++] = milliseconds;
+		uint32_t bucket = static_cast<uint32_t>(milliseconds / kHistogramBucketMilliseconds);
+		histogram_[(std::min)(bucket, kHistogramBucketCount - 1)] += 1.0f;
+		});
+	if (frameCount == 0) {
+		ImGui::TextUnformatted("No frames yet");
+		return;
+	}
+
+	// 平均・最大と、遅い方から1%のフレーム時間
+	float total = 0.0f;
+	float maximum = 0.0f;
+	for (uint32_t i = 0; i < frameCount; ++i) {
+		total += frameTimes_[i];
+		maximum = (std::max)(maximum, frameTimes_[i]);
+	}
+	float average = total / static_cast<float>(frameCount);
+	std::array<float, kGraphFrameCount> sorted;
+	std::copy_n(frameTimes_.begin(), frameCount, sorted.begin());
+	uint32_t percentileIndex = frameCount * 99 / 100;
+	std::nth_element(sorted.begin(), sorted.begin() + percentileIndex, sorted.begin() + frameCount);
+	float percentile99 = sorted[percentileIndex];
+
+	ImGui::Text("Frame : %.2f ms (%.1f fps)  p99 : %.2f ms  max : %.2f ms", average, 1000.0f / (std::max)(average, 0.001f), percentile99, maximum);
+	std::string overlay = std::format("{:.2f} ms", frameTimes_[frameCount - 1]);
+	ImGui::PlotLines("##FrameTimes", frameTimes_.data(), static_cast<int>(frameCount), 0, overlay.c_str(), 0.0f, (std::max)(maximum, 1.0f), ImVec2(-FLT_MIN, 60.0f));
+	std::string histogramOverlay = std::format("0 - {:.0f}+ ms", kHistogramBucketMilliseconds * (kHistogramBucketCount - 1));
+	ImGui::PlotHistogram("##FrameHistogram", histogram_.data(), static_cast<int>(kHistogramBucketCount), 0, histogramOverlay.c_str(), 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 60.0f));
+}
+
+void PerfOverlay::DrawZones(const char *prefix, double frameMilliseconds)
+{
+	PerfCounters *perfCounters = PerfCounters::GetInstance();
+	const PerfCounters::Snapshot &latest = perfCounters->GetLatest();
+
+	// prefixで始まるカウンタを集めて長い順に並べる
+	std::array<PerfCounters::CounterId, PerfCounters::kMaxCounters> zones;
+	uint32_t zoneCount = 0;
+	uint32_t counterCount = perfCounters->GetCounterCount();
+	for (PerfCounters::CounterId counter = 0; counter < counterCount; ++counter) {
+		if (HasPrefix(perfCounters->GetCounterName(counter), prefix)) {
+			zones[zoneCount++] = counter;
+		}
+	}
+	if (zoneCount == 0) {
+		ImGui::TextUnformatted("None");
+		return;
+	}
+	uint32_t shownCount = (std::min)(zoneCount, kTopZoneCount);
+	std::partial_sort(zones.begin(), zones.begin() + shownCount, zones.begin() + zoneCount,
+		[&](PerfCounters::CounterId a, PerfCounters::CounterId b) { return latest.values[a] > latest.values[b]; });
+
+	size_t prefixLength = std::strlen(prefix);
+	for (uint32_t i = 0; i < shownCount; ++i) {
+		PerfCounters::CounterId counter = zones[i];
+		double milliseconds = static_cast<double>(latest.values[counter]) / 1000.0;
+		// バーはフレーム時間に対する割合
+		float fraction = frameMilliseconds > 0.0 ? static_cast<float>(milliseconds / frameMilliseconds) : 0.0f;
+		std::string label = std::format("{} : {:.3f} ms", perfCounters->GetCounterName(counter).substr(prefixLength), milliseconds);
+		ImGui::ProgressBar((std::min)(fraction, 1.0f), ImVec2(-FLT_MIN, 0.0f), label.c_str());
+	}
+}
+
+void PerfOverlay::DrawCounters()
+{
+	PerfCounters *perfCounters = PerfCounters::GetInstance();
+	const PerfCounters::Snapshot &latest = perfCounters->GetLatest();
+
+	if (!ImGui::BeginTable("##Counters", 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+		return;
+	}
+	uint32_t counterCount = perfCounters->GetCounterCount();
+	for (PerfCounters::CounterId counter = 0; counter < counterCount; ++counter) {
+		const std::string &name = perfCounters->GetCounterName(counter);
+		// 時間は区間・パスの方で出す
+		if (HasPrefix(name, "cpu.") || HasPrefix(name, "gpu.")) {
+			continue;
+		}
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(name.c_str());
+		ImGui::TableNextColumn();
+		ImGui::Text("%lld", static_cast<long long>(latest.values[counter]));
+	}
+	ImGui::EndTable();
+}
+
+void PerfOverlay::DrawTextureMemory()
+{
+	uint64_t textureBytes = TextureManager::GetInstance()->GetTextureMemoryBytes();
+	if (!dxCommon_) {
+		ImGui::Text("Textures : %.1f MB", ToMegabytes(textureBytes));
+		return;
+	}
+
+	// 予算はOSがこのプロセスに割り当てた目安で、超えると他のプロセスとの取り合いで遅くなる
+	DXGI_QUERY_VIDEO_MEMORY_INFO info = dxCommon_->GetVideoMemoryInfo();
+	float budget = (std::max)(ToMegabytes(info.Budget), 1.0f);
+	std::string textureLabel = std::format("Textures : {:.1f} / {:.0f} MB", ToMegabytes(textureBytes), budget);
+	ImGui::ProgressBar((std::min)(ToMegabytes(textureBytes) / budget, 1.0f), ImVec2(-FLT_MIN, 0.0f), textureLabel.c_str());
+	std::string usageLabel = std::format("Total : {:.1f} / {:.0f} MB", ToMegabytes(info.CurrentUsage), budget);
+	ImGui::ProgressBar((std::min)(ToMegabytes(info.CurrentUsage) / budget, 1.0f), ImVec2(-FLT_MIN, 0.0f), usageLabel.c_str());
+}
+
+void PerfOverlay::DrawWorkers()
+{
+	JobSystem *jobSystem = JobSystem::GetInstance();
+	uint32_t workerCount = jobSystem->GetWorkerCount();
+
+	// 一定間隔ごとに、前回からの稼働時間の差を経過時間で割る
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (previousBusyNanoseconds_.size() != workerCount) {
+		previousBusyNanoseconds_.resize(workerCount);
+		workerUtilization_.assign(workerCount, 0.0f);
+		for (uint32_t i = 0; i < workerCount; ++i) {
+			previousBusyNanoseconds_[i] = jobSystem->GetWorkerBusyNanoseconds(i);
+		}
+		utilizationTime_ = now;
+	}
+	double elapsedSeconds = std::chrono::duration<double>(now - utilizationTime_).count();
+	if (elapsedSeconds >= kUtilizationIntervalSeconds) {
+		for (uint32_t i = 0; i < workerCount; ++i) {
+			int64_t busy = jobSystem->GetWorkerBusyNanoseconds(i);
+			workerUtilization_[i] = static_cast<float>(static_cast<double>(busy - previousBusyNanoseconds_[i]) * 1.0e-9 / elapsedSeconds);
+			previousBusyNanoseconds_[i] = busy;
+		}
+		utilizationTime_ = now;
+	}
+
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		std::string label = std::format("Worker {} : {:.0f}% ({} jobs)", i, workerUtilization_[i] * 100.0f, jobSystem->GetWorkerJobCount(i));
+		ImGui::ProgressBar((std::min)(workerUtilization_[i], 1.0f), ImVec2(-FLT_MIN, 0.0f), label.c_str());
+	}
+}
+
+#else
+
+void PerfOverlay::Draw() {}
+
+#endif
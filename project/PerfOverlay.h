@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+class DirectXCommon;
+
+// 性能のオーバーレイ(ImGuiのウィンドウ)
+// フレーム時間のグラフとヒストグラム、CPUの区間・GPUのパスの上位、カウンタ、テクスチャメモリと予算、
+// ジョブシステムのワーカーごとの稼働率を表示する
+// 値はPerfCountersの直近のスナップショットから読むだけなので、非表示の間はDrawが何もせずに戻る
+class PerfOverlay
+{
+public:
+	// グラフに出すフレーム数
+	static constexpr uint32_t kGraphFrameCount = 240;
+	// ヒストグラムの区切り(1区切りkHistogramBucketMilliseconds。最後の区切りはそれより遅いもの全て)
+	static constexpr uint32_t kHistogramBucketCount = 34;
+	static constexpr float kHistogramBucketMilliseconds = 1.0f;
+	// 区間・パスを時間の長い順に出す数
+	static constexpr uint32_t kTopZoneCount = 8;
+	// ワーカーの稼働率を測り直す間隔
+	static constexpr double kUtilizationIntervalSeconds = 0.5;
+
+public: // メンバ関数
+	// 初期化(テクスチャメモリの予算をdxCommonから問い合わせる。nullptrなら予算は出さない)
+	void Initialize(DirectXCommon *dxCommon);
+
+	// 表示の切り替え
+	void SetVisible(bool visible);
+	void ToggleVisible() { SetVisible(!visible_); }
+	bool IsVisible() const { return visible_; }
+
+	// ウィンドウを描く(ImGuiのNewFrameとRenderの間で呼ぶ。非表示なら何もしない)
+	void Draw();
+
+private:
+	// フレーム時間のグラフとヒストグラム
+	void DrawFrameTimes();
+	// 名前がprefixで始まるカウンタ(マイクロ秒)を長い順に出す
+	void DrawZones(const char *prefix, double frameMilliseconds);
+	// 時間以外のカウンタ
+	void DrawCounters();
+	// テクスチャメモリと予算
+	void DrawTextureMemory();
+	// ワーカーごとの稼働率
+	void DrawWorkers();
+
+	DirectXCommon *dxCommon_ = nullptr;
+	bool visible_ = false;
+
+	// グラフ用の作業領域(表示中だけ毎フレーム詰め直す)
+	std::array<float, kGraphFrameCount> frameTimes_ {};
+	std::array<float, kHistogramBucketCount> histogram_ {};
+
+	// ワーカーの稼働率(前回測った時点の累計との差から求める)
+	std::vector<int64_t> previousBusyNanoseconds_;
+	std::vector<float> workerUtilization_;
+	std::chrono::steady_clock::time_point utilizationTime_;
+};
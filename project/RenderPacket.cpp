@@ -0,0 +1,45 @@
+#include "RenderPacket.h"
+
+namespace render
+{
+#ifdef USE_IMGUI
+	ImGuiDrawSnapshot::~ImGuiDrawSnapshot()
+	{
+		Clear();
+	}
+
+	void ImGuiDrawSnapshot::Capture(const ImDrawData *source)
+	{
+		Clear();
+		if (source == nullptr || !source->Valid) {
+			return;
+		}
+
+		drawData = *source;
+		drawLists.reserve(source->CmdListsCount);
+		for (int i = 0; i < source->CmdListsCount; ++i) {
+			drawLists.push_back(source->CmdLists[i]->CloneOutput());
+		}
+		// 複製したリストを指すようにする
+		drawData.CmdLists = drawLists.data();
+	}
+
+	void ImGuiDrawSnapshot::Clear()
+	{
+		for (ImDrawList *drawList : drawLists) {
+			IM_DELETE(drawList);
+		}
+		drawLists.clear();
+		drawData.Clear();
+	}
+#endif
+
+	void RenderPacket::Clear()
+	{
+		frameNumber = 0;
+		sprites.clear();
+#ifdef USE_IMGUI
+		imgui.Clear();
+#endif
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+#include "Light.h"
+
+#ifdef USE_IMGUI
+#include "externals/imgui/imgui.h"
+#endif
+
+// メインスレッドが作り、描画スレッドが消費する1フレーム分の描画データ
+// 描画スレッドに渡した後はメインスレッドから書き換えない
+namespace render
+{
+	// スプライトの描き方
+	enum class SpriteDrawMode : int32_t
+	{
+		Simple, //!< 切り出し範囲を1枚に引き伸ばす
+		NineSlice, //!< 角は大きさを保ち、辺と中央だけを引き伸ばす(UIのパネルなど)
+		Tiled, //!< 切り出し範囲を元の大きさのまま繰り返し並べる
+	};
+
+	// スプライト1枚分の描画データ
+	struct SpriteInstance
+	{
+		math::Matrix4x4 world; //!< ワールド行列
+		math::Matrix4x4 uvTransform; //!< UV変換行列
+		math::Vector4 color; //!< 色
+		math::Vector4 localRect; //!< アンカー・フリップ適用後の頂点範囲(left, top, right, bottom)
+		math::Vector4 uvRect; //!< テクスチャ座標の範囲(left, top, right, bottom)
+		uint32_t textureIndex; //!< テクスチャ番号
+		int32_t enableLighting; //!< ライティングするか(シェーダーの変種を選ぶ)
+		SpriteDrawMode drawMode; //!< 描き方(Simple以外は描画スレッドで頂点を増やし、1回の描画で描く)
+		math::Vector4 sliceRect; //!< NineSlice: 角の幅のlocalRectに対する割合(left, top, right, bottom) / Tiled: 並べる枚数(x, y)
+		math::Vector4 sliceUvRect; //!< NineSlice: 角の幅のuvRectに対する割合(left, top, right, bottom)
+	};
+
+	// カメラ
+	struct CameraData
+	{
+		math::Matrix4x4 view;
+		math::Matrix4x4 projection;
+	};
+
+#ifdef USE_IMGUI
+	// ImGuiの描画データの複製
+	// ImGuiの描画リストは次のNewFrameで書き換わるため、パケットには複製を持たせる
+	class ImGuiDrawSnapshot
+	{
+	public:
+		ImGuiDrawSnapshot() = default;
+		~ImGuiDrawSnapshot();
+		ImGuiDrawSnapshot(const ImGuiDrawSnapshot &) = delete;
+		ImGuiDrawSnapshot &operator=(const ImGuiDrawSnapshot &) = delete;
+
+		// 描画データを複製する
+		void Capture(const ImDrawData *source);
+		// 複製を破棄する
+		void Clear();
+
+		// 複製した描画データ(未取得ならnullptr)
+		ImDrawData *GetDrawData() { return drawData.Valid ? &drawData : nullptr; }
+
+	private:
+		ImDrawData drawData;
+		std::vector<ImDrawList *> drawLists;
+	};
+#endif
+
+	// 1フレーム分の描画パケット
+	struct RenderPacket
+	{
+		uint64_t frameNumber = 0;
+		// スプライト用カメラ
+		CameraData spriteCamera;
+		// 平行光源
+		light::DirectionalLight directionalLight;
+		// スプライト
+		std::vector<SpriteInstance> sprites;
+#ifdef USE_IMGUI
+		ImGuiDrawSnapshot imgui;
+#endif
+
+		// 再利用のために中身を空にする(確保済みの容量は残す)
+		void Clear();
+	};
+}
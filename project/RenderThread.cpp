@@ -0,0 +1,203 @@
+#include "RenderThread.h"
+#include "CommandCapture.h"
+#include "DirectXCommon.h"
+#include "EventBus.h"
+#include "FrameArena.h"
+#include "PerfCounters.h"
+#include "SpriteRenderer.h"
+#include "Task.h"
+#include "TextureManager.h"
+#include <algorithm>
+#include <cassert>
+
+#ifdef USE_IMGUI
+#include "externals/imgui/imgui_impl_dx12.h"
+#endif
+
+void RenderThread::Initialize(DirectXCommon *dxCommon, SpriteRenderer *spriteRenderer)
+{
+	// NULL検出
+	assert(dxCommon);
+	assert(spriteRenderer);
+
+	// 引数で受け取ってメンバ変数に記録する
+	dxCommon_ = dxCommon;
+	spriteRenderer_ = spriteRenderer;
+
+	for (render::RenderPacket &packet : packets) {
+		freePackets.push_back(&packet);
+	}
+}
+
+void RenderThread::Start()
+{
+	statisticsTime = std::chrono::steady_clock::now();
+	thread = std::thread([this]() { ThreadMain(); });
+}
+
+void RenderThread::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	submittedCondition.notify_all();
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+render::RenderPacket *RenderThread::AcquirePacket()
+{
+	render::RenderPacket *packet = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		// 空きがなければ描画スレッドを待つ(この待ち時間はメインスレッドの非稼働時間)
+		auto waitBegin = std::chrono::steady_clock::now();
+		freeCondition.wait(lock, [this]() { return !freePackets.empty(); });
+		mainWaitTime += std::chrono::steady_clock::now() - waitBegin;
+
+		packet = freePackets.front();
+		freePackets.pop_front();
+	}
+
+	packet->Clear();
+	packet->frameNumber = ++frameNumber;
+
+	// 1秒ごとに重なり具合を集計する
+	++statisticsFrameCount;
+	auto now = std::chrono::steady_clock::now();
+	std::chrono::nanoseconds elapsed = now - statisticsTime;
+	if (elapsed >= std::chrono::seconds(1)) {
+		double frames = static_cast<double>(statisticsFrameCount);
+		double wall = static_cast<double>(elapsed.count());
+		double mainBusy = wall - static_cast<double>(mainWaitTime.count());
+		double renderBusy = static_cast<double>(renderBusyNanoseconds.exchange(0));
+		// それぞれのスレッドは働いているか待っているかのどちらかなので、合計が経過時間を超えた分が重なり
+		double overlap = (std::max)(mainBusy + renderBusy - wall, 0.0);
+
+		statistics.framesPerSecond = static_cast<float>(frames * 1.0e9 / wall);
+		statistics.mainBusyMilliseconds = static_cast<float>(mainBusy / frames * 1.0e-6);
+		statistics.renderBusyMilliseconds = static_cast<float>(renderBusy / frames * 1.0e-6);
+		statistics.overlapMilliseconds = static_cast<float>(overlap / frames * 1.0e-6);
+		statistics.overlapRatio = renderBusy > 0.0 ? static_cast<float>(overlap / renderBusy) : 0.0f;
+
+		statisticsFrameCount = 0;
+		mainWaitTime = std::chrono::nanoseconds(0);
+		statisticsTime = now;
+	}
+
+	return packet;
+}
+
+void RenderThread::Submit(render::RenderPacket *packet)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		submittedPackets.push_back(packet);
+	}
+	submittedCondition.notify_one();
+}
+
+void RenderThread::ThreadMain()
+{
+	// 描画スレッドはメインスレッドとフレームがずれるので、自分のアリーナは自分で巻き戻す
+	FrameArena &frameArena = FrameArena::GetThreadArena();
+	frameArena.SetName("Render");
+
+	while (true) {
+		render::RenderPacket *packet = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			submittedCondition.wait(lock, [this]() { return stop || !submittedPackets.empty(); });
+			if (submittedPackets.empty()) {
+				// 停止要求があり、描くものも残っていない
+				return;
+			}
+			packet = submittedPackets.front();
+			submittedPackets.pop_front();
+		}
+
+		auto begin = std::chrono::steady_clock::now();
+		Render(*packet);
+		renderBusyNanoseconds.fetch_add((std::chrono::steady_clock::now() - begin).count());
+		frameArena.Reset();
+
+		// 描き終えたパケットを返す
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			freePackets.push_back(packet);
+		}
+		freeCondition.notify_one();
+	}
+}
+
+void RenderThread::Render(render::RenderPacket &packet)
+{
+	// 描画スレッドの時間(PostDrawでGPUを待つ分を含む)と、GPUのパスごとの時間(PostDrawで設定される)
+	static const PerfCounters::CounterId kRenderCpu = PerfCounters::Register("cpu.renderThread");
+	static const PerfCounters::CounterId kClearGpu = PerfCounters::Register("gpu.clear", PerfCounters::Kind::Gauge);
+	static const PerfCounters::CounterId kSpriteGpu = PerfCounters::Register("gpu.sprite", PerfCounters::Kind::Gauge);
+	PerfCounters::ScopedTimer renderTimer(kRenderCpu);
+
+	// キャプチャ中ならコマンドを書き出す(そうでなければ記録の関数は何もしない)
+	render::CommandCapture *capture = render::CommandCapture::GetInstance();
+	capture->BeginFrame(packet.frameNumber);
+
+	// NextRenderFrameを待っていたコルーチンを再開する(テクスチャの転送コマンドなどはPreDrawより前に積む)
+	// テクスチャの転送はDirectXCommon::UploadTextureDataがキャプチャに記録する
+	capture->BeginPass("TextureUpload");
+	TaskScheduler::GetInstance()->RunRenderFrameBoundary();
+	capture->EndPass();
+	// 描画スレッド宛てのイベントを購読者に渡す
+	EventBus::GetInstance()->Drain(event::DrainPoint::RenderFrame);
+
+	// 描画前処理
+	capture->BeginPass("Clear");
+	dxCommon_->BeginGpuPass(kClearGpu);
+	dxCommon_->PreDraw();
+	dxCommon_->EndGpuPass();
+	capture->Clear();
+	capture->EndPass();
+
+	// スプライト
+	capture->BeginPass("Sprite");
+	dxCommon_->BeginGpuPass(kSpriteGpu);
+	spriteRenderer_->Draw(packet);
+	dxCommon_->EndGpuPass();
+	capture->EndPass();
+
+#ifdef USE_IMGUI
+	// 実際のcommandListのImGuiの描画コマンドを積む
+	if (ImDrawData *drawData = packet.imgui.GetDrawData()) {
+		capture->BeginPass("ImGui");
+		if (capture->IsRecording()) {
+			// ImGuiのバックエンドが積むコマンドは見えないので、転送量と描画の回数だけ記録する
+			static const char kImGuiVertexBuffer = 0;
+			static const char kImGuiIndexBuffer = 0;
+			capture->Upload(&kImGuiVertexBuffer, 0, nullptr, static_cast<uint32_t>(drawData->TotalVtxCount * sizeof(ImDrawVert)));
+			capture->Upload(&kImGuiIndexBuffer, 0, nullptr, static_cast<uint32_t>(drawData->TotalIdxCount * sizeof(ImDrawIdx)));
+			for (int i = 0; i < drawData->CmdListsCount; ++i) {
+				for (const ImDrawCmd &command : drawData->CmdLists[i]->CmdBuffer) {
+					capture->DrawIndexed(command.ElemCount, 1, command.IdxOffset, static_cast<int32_t>(command.VtxOffset));
+				}
+			}
+		}
+		static const PerfCounters::CounterId kImGuiGpu = PerfCounters::Register("gpu.imgui", PerfCounters::Kind::Gauge);
+		dxCommon_->BeginGpuPass(kImGuiGpu);
+		ImGui_ImplDX12_RenderDrawData(drawData, dxCommon_->GetCommandList());
+		dxCommon_->EndGpuPass();
+		capture->EndPass();
+	}
+#endif
+
+	// 描画後処理
+	capture->BeginPass("Present");
+	dxCommon_->PostDraw();
+	capture->EndPass();
+
+	capture->EndFrame();
+
+	// 転送が終わったテクスチャの中間リソースを解放
+	TextureManager::GetInstance()->ReleaseIntermediateResources();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "RenderPacket.h"
+
+class DirectXCommon;
+class SpriteRenderer;
+
+// 描画スレッド
+// メインスレッドが作った描画パケットを受け取り、コマンドの記録と実行を行う
+class RenderThread
+{
+public:
+	// 用意するパケット数(描画中1つ + 待ち2つまで)
+	static const uint32_t kPacketCount = 3;
+
+	// メインスレッドと描画スレッドの重なり具合(直近1秒間の平均)
+	struct Statistics
+	{
+		float framesPerSecond = 0.0f;
+		float mainBusyMilliseconds = 0.0f; //!< メインスレッドが1フレームで働いた時間
+		float renderBusyMilliseconds = 0.0f; //!< 描画スレッドが1フレームで働いた時間
+		float overlapMilliseconds = 0.0f; //!< 両スレッドが同時に働いていた時間
+		float overlapRatio = 0.0f; //!< 描画スレッドの稼働時間のうち、メインスレッドと重なっていた割合
+	};
+
+public: // メンバ関数
+	// 初期化
+	void Initialize(DirectXCommon *dxCommon, SpriteRenderer *spriteRenderer);
+
+	// スレッド開始
+	void Start();
+	// 投入済みのパケットを描き切ってからスレッドを終了する
+	void Stop();
+
+	/// <summary>
+	/// 書き込み用のパケットを取得する。空きがなければ描画スレッドが追いつくまで待つ
+	/// </summary>
+	render::RenderPacket *AcquirePacket();
+
+	// 書き込み終えたパケットを描画スレッドに渡す
+	void Submit(render::RenderPacket *packet);
+
+	// 統計(メインスレッドから参照する)
+	const Statistics &GetStatistics() const { return statistics; }
+
+private:
+	// 描画スレッドの処理
+	void ThreadMain();
+	// パケット1つ分を描画する
+	void Render(render::RenderPacket &packet);
+
+	DirectXCommon *dxCommon_ = nullptr;
+	SpriteRenderer *spriteRenderer_ = nullptr;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable submittedCondition;
+	std::condition_variable freeCondition;
+	bool stop = false;
+
+	std::array<render::RenderPacket, kPacketCount> packets;
+	// 空きパケット
+	std::deque<render::RenderPacket *> freePackets;
+	// 描画待ちパケット
+	std::deque<render::RenderPacket *> submittedPackets;
+	uint64_t frameNumber = 0;
+
+	// 統計用
+	// 描画スレッドの稼働時間の累計(ナノ秒)
+	std::atomic<int64_t> renderBusyNanoseconds { 0 };
+	// メインスレッドがパケットの空きを待った時間の累計
+	std::chrono::nanoseconds mainWaitTime { 0 };
+	std::chrono::steady_clock::time_point statisticsTime;
+	uint32_t statisticsFrameCount = 0;
+	Statistics statistics;
+};
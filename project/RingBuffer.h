@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// スレッド間で値を受け渡す固定長のリングバッファ(ロックを使わない)
+// 容量は2の累乗で、作成時に一度だけ確保する。満杯ならTryPushはfalseを返す(待たない)
+// 読み手は1スレッドに限る
+namespace event
+{
+	// 別スレッドが書き換える変数を別のキャッシュラインに置くための境界
+	constexpr size_t kCacheLineSize = 64;
+
+	// 書き手も1スレッドに限るリングバッファ
+	template <class T>
+	class SpscRingBuffer
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "ring buffer element must be trivially copyable");
+
+	public:
+		explicit SpscRingBuffer(uint32_t capacity)
+			: capacity_(capacity), mask_(capacity - 1), buffer_(std::make_unique<T[]>(capacity))
+		{
+			assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+		}
+
+		bool TryPush(const T &value)
+		{
+			uint64_t tail = tail_.load(std::memory_order_relaxed);
+			// 読み手の位置は満杯に見えたときだけ読み直す
+			if (tail - cachedHead_ == capacity_) {
+				cachedHead_ = head_.load(std::memory_order_acquire);
+				if (tail - cachedHead_ == capacity_) {
+					return false;
+				}
+			}
+			buffer_[tail & mask_] = value;
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool TryPop(T &value)
+		{
+			uint64_t head = head_.load(std::memory_order_relaxed);
+			if (head == cachedTail_) {
+				cachedTail_ = tail_.load(std::memory_order_acquire);
+				if (head == cachedTail_) {
+					return false;
+				}
+			}
+			value = buffer_[head & mask_];
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// これまでに書き込まれた数(読み手がここまで読めばそれ以前の値は読み切った)
+		uint64_t GetPushedCount() const { return tail_.load(std::memory_order_acquire); }
+		uint32_t GetCapacity() const { return capacity_; }
+
+	private:
+		const uint32_t capacity_;
+		const uint64_t mask_;
+		std::unique_ptr<T[]> buffer_;
+		// 書き手の書く位置と、書き手が最後に見た読み手の位置
+		alignas(kCacheLineSize) std::atomic<uint64_t> tail_ { 0 };
+		uint64_t cachedHead_ = 0;
+		// 読み手の読む位置と、読み手が最後に見た書き手の位置
+		alignas(kCacheLineSize) std::atomic<uint64_t> head_ { 0 };
+		uint64_t cachedTail_ = 0;
+	};
+
+	// 書き手が複数スレッドのリングバッファ
+	// 要素ごとの通し番号で、書き手同士は位置の取り合いだけをCASで行い、読み手は書き終わった要素だけを読む
+	template <class T>
+	class MpscRingBuffer
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "ring buffer element must be trivially copyable");
+
+	public:
+		explicit MpscRingBuffer(uint32_t capacity)
+			: capacity_(capacity), mask_(capacity - 1), cells_(std::make_unique<Cell[]>(capacity))
+		{
+			assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+			for (uint32_t i = 0; i < capacity; ++i) {
+				cells_[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		bool TryPush(const T &value)
+		{
+			uint64_t position = tail_.load(std::memory_order_relaxed);
+			Cell *cell;
+			while (true) {
+				cell = &cells_[position & mask_];
+				uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+				int64_t difference = static_cast<int64_t>(sequence - position);
+				if (difference == 0) {
+					// 空いている。他の書き手より先に位置を取れたら書く
+					if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (difference < 0) {
+					// 一周前の要素がまだ読まれていない(満杯)
+					return false;
+				} else {
+					// 他の書き手に先を越された
+					position = tail_.load(std::memory_order_relaxed);
+				}
+			}
+			cell->value = value;
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool TryPop(T &value)
+		{
+			Cell &cell = cells_[head_ & mask_];
+			// 位置を取った書き手がまだ書き終えていなければ読まない
+			if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+				return false;
+			}
+			value = cell.value;
+			// 一周後の書き手に空けたことを知らせる
+			cell.sequence.store(head_ + capacity_, std::memory_order_release);
+			++head_;
+			return true;
+		}
+
+		// これまでに書き手が位置を取った数(書き込み中のものを含む)
+		uint64_t GetPushedCount() const { return tail_.load(std::memory_order_acquire); }
+		uint32_t GetCapacity() const { return capacity_; }
+
+	private:
+		struct Cell
+		{
+			std::atomic<uint64_t> sequence;
+			T value;
+		};
+
+		const uint32_t capacity_;
+		const uint64_t mask_;
+		std::unique_ptr<Cell[]> cells_;
+		alignas(kCacheLineSize) std::atomic<uint64_t> tail_ { 0 };
+		// 読み手だけが触る
+		alignas(kCacheLineSize) uint64_t head_ = 0;
+	};
+}
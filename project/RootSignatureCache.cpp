@@ -0,0 +1,116 @@
+#include "RootSignatureCache.h"
+#include <cassert>
+#include <vector>
+
+namespace
+{
+	D3D12_SHADER_VISIBILITY ToShaderVisibility(render::ShaderStage stage)
+	{
+		switch (stage) {
+		case render::ShaderStage::Vertex: return D3D12_SHADER_VISIBILITY_VERTEX;
+		case render::ShaderStage::Pixel: return D3D12_SHADER_VISIBILITY_PIXEL;
+		default: return D3D12_SHADER_VISIBILITY_ALL;
+		}
+	}
+}
+
+void RootSignatureCache::Initialize(ID3D12Device *device)
+{
+	// 引数で受け取ってメンバ変数に記録する
+	device_ = device;
+}
+
+ID3D12RootSignature *RootSignatureCache::GetRootSignature(const render::RootSignatureLayout &layout)
+{
+	// 作るのは構成ごとに1回だけなので、ロックしたまま作って重複を防ぐ
+	std::lock_guard<std::mutex> lock(mutex_);
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> &rootSignature = rootSignatures_[layout];
+	if (!rootSignature) {
+		rootSignature = CreateRootSignature(layout);
+	}
+	return rootSignature.Get();
+}
+
+size_t RootSignatureCache::GetRootSignatureCount()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return rootSignatures_.size();
+}
+
+Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignatureCache::CreateRootSignature(const render::RootSignatureLayout &layout)
+{
+	HRESULT hr;
+
+	//----RootSignatureを生成する----
+
+	// RootSignature作成
+	D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature {};
+	descriptionRootSignature.Flags =
+		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+	//----RootParameter----
+
+	// CBVはルートに直接置き、SRVは1つずつディスクリプタテーブルにする
+	std::vector<D3D12_ROOT_PARAMETER> rootParameters(layout.parameters.size());
+	std::vector<D3D12_DESCRIPTOR_RANGE> descriptorRanges(layout.parameters.size());
+	for (size_t i = 0; i < layout.parameters.size(); ++i) {
+		const render::ShaderResourceBinding &binding = layout.parameters[i];
+		rootParameters[i].ShaderVisibility = ToShaderVisibility(binding.stage);
+		if (binding.type == render::ShaderResourceType::ConstantBuffer) {
+			assert(binding.count == 1);
+			rootParameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // CBVを使う
+			rootParameters[i].Descriptor.ShaderRegister = binding.registerIndex;
+			rootParameters[i].Descriptor.RegisterSpace = binding.space;
+		} else {
+			D3D12_DESCRIPTOR_RANGE &descriptorRange = descriptorRanges[i];
+			descriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV; // SRVを使う
+			descriptorRange.BaseShaderRegister = binding.registerIndex;
+			descriptorRange.RegisterSpace = binding.space;
+			// リフレクションでは上限の無い配列は0になる
+			descriptorRange.NumDescriptors = binding.count == 0 ? UINT_MAX : binding.count;
+			descriptorRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND; // Offsetを自動計算
+
+			rootParameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // DescriptorTableを使う
+			rootParameters[i].DescriptorTable.pDescriptorRanges = &descriptorRange;
+			rootParameters[i].DescriptorTable.NumDescriptorRanges = 1;
+		}
+	}
+	descriptionRootSignature.pParameters = rootParameters.data(); // ルートパラメータ配列へのポインタ
+	descriptionRootSignature.NumParameters = static_cast<UINT>(rootParameters.size()); // 配列の長さ
+
+	//----Sampler----
+
+	// サンプラーの設定はリフレクションでは分からないので、全てバイリニア・リピートにする
+	std::vector<D3D12_STATIC_SAMPLER_DESC> staticSamplers(layout.staticSamplers.size());
+	for (size_t i = 0; i < layout.staticSamplers.size(); ++i) {
+		const render::ShaderResourceBinding &binding = layout.staticSamplers[i];
+		staticSamplers[i].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR; // バイリニアフィルタ
+		staticSamplers[i].AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP; // 0~1の範囲外をリピート
+		staticSamplers[i].AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+		staticSamplers[i].AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+		staticSamplers[i].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER; // 比較しない
+		staticSamplers[i].MaxLOD = D3D12_FLOAT32_MAX; // ありったけのMipmapを使う
+		staticSamplers[i].ShaderRegister = binding.registerIndex;
+		staticSamplers[i].RegisterSpace = binding.space;
+		staticSamplers[i].ShaderVisibility = ToShaderVisibility(binding.stage);
+	}
+	descriptionRootSignature.pStaticSamplers = staticSamplers.data();
+	descriptionRootSignature.NumStaticSamplers = static_cast<UINT>(staticSamplers.size());
+
+	// シリアライズしてバイナリにする
+	Microsoft::WRL::ComPtr<ID3DBlob> signatureBlob = nullptr;
+	Microsoft::WRL::ComPtr<ID3DBlob> errorBlob = nullptr;
+	hr = D3D12SerializeRootSignature(&descriptionRootSignature,
+		D3D_ROOT_SIGNATURE_VERSION_1, &signatureBlob, &errorBlob);
+	if (FAILED(hr)) {
+		//Log(logStream, reinterpret_cast<char*>(errorBlob->GetBufferPointer()));
+		assert(false);
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature = nullptr;
+	hr = device_->CreateRootSignature(0,
+		signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize(),
+		IID_PPV_ARGS(&rootSignature));
+	assert(SUCCEEDED(hr));
+	return rootSignature;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <mutex>
+#include <unordered_map>
+#include <wrl.h>
+#include <d3d12.h>
+#include "RootSignatureLayout.h"
+
+// 構成ごとのルートシグネチャ
+// シェーダーのリフレクションから作った構成が同じパイプラインは、同じルートシグネチャを使う(複数のスレッドから呼べる)
+class RootSignatureCache
+{
+public: // メンバ関数
+	// 初期化
+	void Initialize(ID3D12Device *device);
+
+	// 構成に合うルートシグネチャを取得する(無ければ作る)
+	ID3D12RootSignature *GetRootSignature(const render::RootSignatureLayout &layout);
+
+	// 作ったルートシグネチャの数
+	size_t GetRootSignatureCount();
+
+private:
+	// ルートシグネチャの作成
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateRootSignature(const render::RootSignatureLayout &layout);
+
+	ID3D12Device *device_ = nullptr;
+
+	std::unordered_map<render::RootSignatureLayout, Microsoft::WRL::ComPtr<ID3D12RootSignature>, render::RootSignatureLayoutHash> rootSignatures_;
+	std::mutex mutex_;
+};
@@ -0,0 +1,139 @@
+#include "RootSignatureLayout.h"
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+namespace render
+{
+	namespace
+	{
+		constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+		constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+		uint64_t HashUint32(uint64_t hash, uint32_t value)
+		{
+			// エンディアンに依らないよう1バイトずつ混ぜる
+			for (uint32_t shift = 0; shift < 32; shift += 8) {
+				hash ^= static_cast<uint8_t>(value >> shift);
+				hash *= kFnvPrime;
+			}
+			return hash;
+		}
+
+		uint64_t HashBinding(uint64_t hash, const ShaderResourceBinding &binding)
+		{
+			hash = HashUint32(hash, static_cast<uint32_t>(binding.type));
+			hash = HashUint32(hash, binding.registerIndex);
+			hash = HashUint32(hash, binding.space);
+			hash = HashUint32(hash, binding.count);
+			return HashUint32(hash, static_cast<uint32_t>(binding.stage));
+		}
+
+		// 名前を除いた比較
+		bool IsSameBinding(const ShaderResourceBinding &a, const ShaderResourceBinding &b)
+		{
+			return a.type == b.type && a.registerIndex == b.registerIndex && a.space == b.space && a.count == b.count && a.stage == b.stage;
+		}
+
+		bool IsSameBindings(const std::vector<ShaderResourceBinding> &a, const std::vector<ShaderResourceBinding> &b)
+		{
+			return std::equal(a.begin(), a.end(), b.begin(), b.end(), IsSameBinding);
+		}
+
+		// 並びの順(種類、スペース、レジスタ、段階)
+		bool IsBindingLess(const ShaderResourceBinding &a, const ShaderResourceBinding &b)
+		{
+			return std::tie(a.type, a.space, a.registerIndex, a.stage) < std::tie(b.type, b.space, b.registerIndex, b.stage);
+		}
+	}
+
+	ShaderStage GetShaderStage(std::string_view profile)
+	{
+		if (profile.starts_with("vs_")) {
+			return ShaderStage::Vertex;
+		}
+		if (profile.starts_with("ps_")) {
+			return ShaderStage::Pixel;
+		}
+		return ShaderStage::All;
+	}
+
+	bool RootSignatureLayout::operator==(const RootSignatureLayout &other) const
+	{
+		return IsSameBindings(parameters, other.parameters) && IsSameBindings(staticSamplers, other.staticSamplers);
+	}
+
+	uint64_t RootSignatureLayout::GetHash() const
+	{
+		uint64_t hash = kFnvOffsetBasis;
+		hash = HashUint32(hash, static_cast<uint32_t>(parameters.size()));
+		for (const ShaderResourceBinding &parameter : parameters) {
+			hash = HashBinding(hash, parameter);
+		}
+		hash = HashUint32(hash, static_cast<uint32_t>(staticSamplers.size()));
+		for (const ShaderResourceBinding &sampler : staticSamplers) {
+			hash = HashBinding(hash, sampler);
+		}
+		return hash;
+	}
+
+	uint32_t RootSignatureLayout::FindParameter(std::string_view name) const
+	{
+		for (size_t i = 0; i < parameters.size(); ++i) {
+			if (parameters[i].name == name) {
+				return static_cast<uint32_t>(i);
+			}
+		}
+		return kNoSlot;
+	}
+
+	RootSignatureLayout BuildRootSignatureLayout(std::span<const ShaderResourceBinding> bindings)
+	{
+		// 複数の段階にある同じリソースをまとめる
+		std::vector<ShaderResourceBinding> merged;
+		for (const ShaderResourceBinding &binding : bindings) {
+			auto it = std::find_if(merged.begin(), merged.end(), [&](const ShaderResourceBinding &other) {
+				return other.name == binding.name && other.type == binding.type && other.registerIndex == binding.registerIndex && other.space == binding.space;
+			});
+			if (it == merged.end()) {
+				merged.push_back(binding);
+			} else if (it->stage != binding.stage) {
+				assert(it->count == binding.count);
+				it->stage = ShaderStage::All;
+			}
+		}
+		std::sort(merged.begin(), merged.end(), IsBindingLess);
+
+		RootSignatureLayout layout;
+		for (ShaderResourceBinding &binding : merged) {
+			if (binding.type == ShaderResourceType::Sampler) {
+				layout.staticSamplers.push_back(std::move(binding));
+			} else {
+				layout.parameters.push_back(std::move(binding));
+			}
+		}
+		return layout;
+	}
+
+	void RootBindingTable::Reset(uint32_t slotCount)
+	{
+		values_.assign(slotCount, kUnset);
+		updateCount_ = 0;
+		skipCount_ = 0;
+	}
+
+	bool RootBindingTable::Update(uint32_t slot, uint64_t value)
+	{
+		if (slot == RootSignatureLayout::kNoSlot) {
+			return false;
+		}
+		assert(slot < values_.size());
+		if (values_[slot] == value) {
+			++skipCount_;
+			return false;
+		}
+		values_[slot] = value;
+		++updateCount_;
+		return true;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ルートシグネチャの構成
+// シェーダーのリフレクションで得たリソースの束縛から、ルートパラメータの並びを決める。
+// 並びは束縛の内容だけで決まるので、同じリソースを使うパイプラインは同じ構成になり、ルートシグネチャを共有できる
+// ここはD3Dに依存しないので単体で確かめられる
+namespace render
+{
+	// シェーダーの段階(ルートパラメータの可視性)
+	enum class ShaderStage : uint8_t
+	{
+		Vertex,
+		Pixel,
+		All, //!< 複数の段階で同じリソースを使う
+	};
+
+	// リソースの種類
+	enum class ShaderResourceType : uint8_t
+	{
+		ConstantBuffer, //!< ルートのCBVにする
+		ShaderResource, //!< テクスチャなど。SRV1つ分のディスクリプタテーブルにする
+		Sampler, //!< 静的サンプラーにする
+	};
+
+	// シェーダーが使うリソース1つ分の束縛(リフレクションの結果)
+	struct ShaderResourceBinding
+	{
+		std::string name; //!< シェーダー内の変数名(gMaterial など)
+		ShaderResourceType type = ShaderResourceType::ConstantBuffer;
+		uint32_t registerIndex = 0;
+		uint32_t space = 0;
+		uint32_t count = 1; //!< 配列の要素数(0なら上限なし)
+		ShaderStage stage = ShaderStage::All;
+	};
+
+	// プロファイル("vs_6_0" など)から段階を求める
+	ShaderStage GetShaderStage(std::string_view profile);
+
+	struct RootSignatureLayout
+	{
+		// 使われていないスロット
+		static constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+
+		// ルートパラメータの順(静的サンプラーは含まない)
+		std::vector<ShaderResourceBinding> parameters;
+		std::vector<ShaderResourceBinding> staticSamplers;
+
+		// 構成が同じか(名前は比べない。同じ並びなら同じルートシグネチャを使える)
+		bool operator==(const RootSignatureLayout &other) const;
+
+		// 構成のハッシュ値(名前は含まない)
+		uint64_t GetHash() const;
+
+		// 変数名からルートパラメータの番号を引く(無ければkNoSlot)
+		uint32_t FindParameter(std::string_view name) const;
+	};
+
+	// unordered_map用
+	struct RootSignatureLayoutHash
+	{
+		size_t operator()(const RootSignatureLayout &layout) const { return static_cast<size_t>(layout.GetHash()); }
+	};
+
+	/// <summary>
+	/// パイプラインの全ての段階の束縛から構成を作る
+	/// 同じ名前・レジスタの束縛が複数の段階にあれば可視性をAllにして1つにまとめる。
+	/// 並びはCBV、テーブルの順で、それぞれスペース・レジスタ・段階の順
+	/// </summary>
+	RootSignatureLayout BuildRootSignatureLayout(std::span<const ShaderResourceBinding> bindings);
+
+	// 描画中のルートパラメータの値の表
+	// 前回と同じ値を設定しようとしたスロットを省き、変わったスロットだけコマンドを積めるようにする
+	class RootBindingTable
+	{
+	public:
+		// ルートシグネチャを切り替えたとき(全てのスロットを未設定に戻す)
+		void Reset(uint32_t slotCount);
+
+		/// <summary>
+		/// スロットの値を更新する
+		/// </summary>
+		/// <param name="value">GPUアドレスやディスクリプタハンドル</param>
+		/// <returns>値が変わった(コマンドを積む必要がある)ならtrue。kNoSlotなら常にfalse</returns>
+		bool Update(uint32_t slot, uint64_t value);
+
+		// Resetからの更新・省略の数(効果の確認用)
+		uint32_t GetUpdateCount() const { return updateCount_; }
+		uint32_t GetSkipCount() const { return skipCount_; }
+
+	private:
+		// 未設定を表す値
+		static constexpr uint64_t kUnset = 0xFFFFFFFFFFFFFFFFull;
+
+		std::vector<uint64_t> values_;
+		uint32_t updateCount_ = 0;
+		uint32_t skipCount_ = 0;
+	};
+}
@@ -0,0 +1,556 @@
+#include "SceneSerializer.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace ecs
+{
+	namespace
+	{
+		uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		// FNV-1aで混ぜる(8バイトずつ、端数は1バイトずつ)
+		constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+		uint64_t HashBytes(uint64_t hash, const std::byte *data, size_t size)
+		{
+			constexpr uint64_t kFnvPrime = 1099511628211ull;
+			size_t offset = 0;
+			for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+				uint64_t word;
+				std::memcpy(&word, data + offset, sizeof(word));
+				hash = (hash ^ word) * kFnvPrime;
+			}
+			for (; offset < size; ++offset) {
+				hash = (hash ^ static_cast<uint64_t>(data[offset])) * kFnvPrime;
+			}
+			return hash;
+		}
+
+		// ディレクトリの書き込み
+		class DirectoryWriter
+		{
+		public:
+			void WriteUint32(uint32_t value) { Append(&value, sizeof(value)); }
+			void WriteUint64(uint64_t value) { Append(&value, sizeof(value)); }
+			void WriteString(const std::string &text)
+			{
+				WriteUint32(static_cast<uint32_t>(text.size()));
+				Append(text.data(), text.size());
+			}
+			std::vector<std::byte> &GetBytes() { return bytes_; }
+
+		private:
+			void Append(const void *data, size_t size)
+			{
+				const std::byte *source = static_cast<const std::byte *>(data);
+				bytes_.insert(bytes_.end(), source, source + size);
+			}
+
+			std::vector<std::byte> bytes_;
+		};
+
+		// ディレクトリの読み込み(範囲外を読もうとしたら以降は全て失敗する)
+		class DirectoryReader
+		{
+		public:
+			DirectoryReader(const std::byte *data, size_t size) : data_(data), size_(size) {}
+
+			uint32_t ReadUint32()
+			{
+				uint32_t value = 0;
+				Read(&value, sizeof(value));
+				return value;
+			}
+			uint64_t ReadUint64()
+			{
+				uint64_t value = 0;
+				Read(&value, sizeof(value));
+				return value;
+			}
+			std::string ReadString()
+			{
+				uint32_t length = ReadUint32();
+				if (!valid_ || length > size_ - position_) {
+					valid_ = false;
+					return {};
+				}
+				std::string text(reinterpret_cast<const char *>(data_ + position_), length);
+				position_ += length;
+				return text;
+			}
+			bool IsValid() const { return valid_; }
+
+		private:
+			void Read(void *destination, size_t size)
+			{
+				if (!valid_ || size > size_ - position_) {
+					valid_ = false;
+					return;
+				}
+				std::memcpy(destination, data_ + position_, size);
+				position_ += size;
+			}
+
+			const std::byte *data_;
+			size_t size_;
+			size_t position_ = 0;
+			bool valid_ = true;
+		};
+
+		// アーキタイプの構成(型・オフセット・容量)が同じか
+		template <class T>
+		bool SameLayout(const T &a, const T &b)
+		{
+			return a.types == b.types && a.offsets == b.offsets && a.capacity == b.capacity;
+		}
+	}
+
+	void SceneSerializer::RegisterComponent(uint32_t typeId, const std::string &name)
+	{
+		assert(!name.empty());
+		if (names_.size() <= typeId) {
+			names_.resize(size_t(typeId) + 1);
+		}
+		names_[typeId] = name;
+	}
+
+	bool SceneSerializer::BuildDirectory(World &world, Directory &directory, std::vector<Archetype *> &archetypes) const
+	{
+		// ファイル内の型番号は最初に現れた順に振る
+		std::vector<uint32_t> fileTypes(kMaxComponentTypes, kInvalidIndex);
+		for (const std::unique_ptr<Archetype> &archetype : world.GetArchetypes()) {
+			if (archetype->GetChunkCount() == 0) {
+				continue;
+			}
+			ArchetypeEntry entry;
+			for (uint32_t typeId : archetype->GetTypeIds()) {
+				// 登録していない型は名前で対応づけられない
+				if (typeId >= names_.size() || names_[typeId].empty()) {
+					return false;
+				}
+				if (fileTypes[typeId] == kInvalidIndex) {
+					const ComponentInfo &info = GetComponentInfo(typeId);
+					fileTypes[typeId] = static_cast<uint32_t>(directory.types.size());
+					directory.types.push_back({ names_[typeId], static_cast<uint32_t>(info.size), static_cast<uint32_t>(info.alignment) });
+				}
+				entry.types.push_back(fileTypes[typeId]);
+				entry.offsets.push_back(archetype->GetComponentOffset(typeId));
+			}
+			entry.capacity = archetype->GetChunkCapacity();
+			entry.chunks.resize(archetype->GetChunkCount());
+			for (size_t c = 0; c < archetype->GetChunkCount(); ++c) {
+				const Chunk &chunk = archetype->GetChunk(c);
+				entry.chunks[c] = { 0, chunk.count, 0, HashChunk(*archetype, chunk) };
+			}
+			directory.archetypes.push_back(std::move(entry));
+			archetypes.push_back(archetype.get());
+		}
+		return true;
+	}
+
+	std::vector<std::byte> SceneSerializer::SerializeDirectory(const Directory &directory)
+	{
+		DirectoryWriter writer;
+		writer.WriteUint32(static_cast<uint32_t>(directory.types.size()));
+		for (const TypeEntry &type : directory.types) {
+			writer.WriteString(type.name);
+			writer.WriteUint32(type.size);
+			writer.WriteUint32(type.alignment);
+		}
+		writer.WriteUint32(static_cast<uint32_t>(directory.archetypes.size()));
+		for (const ArchetypeEntry &archetype : directory.archetypes) {
+			writer.WriteUint32(static_cast<uint32_t>(archetype.types.size()));
+			for (size_t i = 0; i < archetype.types.size(); ++i) {
+				writer.WriteUint32(archetype.types[i]);
+				writer.WriteUint32(archetype.offsets[i]);
+			}
+			writer.WriteUint32(archetype.capacity);
+			writer.WriteUint32(static_cast<uint32_t>(archetype.chunks.size()));
+			for (const ChunkEntry &chunk : archetype.chunks) {
+				writer.WriteUint64(chunk.fileOffset);
+				writer.WriteUint32(chunk.count);
+				writer.WriteUint64(chunk.hash);
+			}
+		}
+		return std::move(writer.GetBytes());
+	}
+
+	bool SceneSerializer::ParseDirectory(const std::byte *data, size_t size, Directory &directory)
+	{
+		DirectoryReader reader(data, size);
+		uint32_t typeCount = reader.ReadUint32();
+		if (typeCount > kMaxComponentTypes) {
+			return false;
+		}
+		directory.types.resize(typeCount);
+		for (TypeEntry &type : directory.types) {
+			type.name = reader.ReadString();
+			type.size = reader.ReadUint32();
+			type.alignment = reader.ReadUint32();
+		}
+		uint32_t archetypeCount = reader.ReadUint32();
+		// 1アーキタイプにつき最低12バイトはある
+		if (!reader.IsValid() || archetypeCount > size / 12) {
+			return false;
+		}
+		directory.archetypes.resize(archetypeCount);
+		for (ArchetypeEntry &archetype : directory.archetypes) {
+			uint32_t componentCount = reader.ReadUint32();
+			if (componentCount > kMaxComponentTypes) {
+				return false;
+			}
+			archetype.types.resize(componentCount);
+			archetype.offsets.resize(componentCount);
+			for (uint32_t i = 0; i < componentCount; ++i) {
+				archetype.types[i] = reader.ReadUint32();
+				archetype.offsets[i] = reader.ReadUint32();
+				if (archetype.types[i] >= typeCount) {
+					return false;
+				}
+			}
+			archetype.capacity = reader.ReadUint32();
+			uint32_t chunkCount = reader.ReadUint32();
+			if (!reader.IsValid() || chunkCount > size / 20) {
+				return false;
+			}
+			archetype.chunks.resize(chunkCount);
+			for (ChunkEntry &chunk : archetype.chunks) {
+				chunk.fileOffset = reader.ReadUint64();
+				chunk.count = reader.ReadUint32();
+				chunk.padding = 0;
+				chunk.hash = reader.ReadUint64();
+			}
+		}
+		return reader.IsValid();
+	}
+
+	uint64_t SceneSerializer::HashChunk(const Archetype &archetype, const Chunk &chunk)
+	{
+		// 行数より後ろは破棄したエンティティの残りなので、変わっても書き直さない
+		uint64_t hash = HashBytes(kFnvOffsetBasis, chunk.data, sizeof(Entity) * chunk.count);
+		for (uint32_t typeId : archetype.GetTypeIds()) {
+			hash = HashBytes(hash, chunk.data + archetype.GetComponentOffset(typeId), size_t(archetype.GetComponentSize(typeId)) * chunk.count);
+		}
+		return hash;
+	}
+
+	bool SceneSerializer::Save(World &world, const std::string &filePath)
+	{
+		Directory directory;
+		std::vector<Archetype *> archetypes;
+		if (!BuildDirectory(world, directory, archetypes)) {
+			return false;
+		}
+
+		// 一時ファイルに書き終えてから置き換える
+		const std::string temporaryPath = filePath + ".tmp";
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+
+		// ヘッダの領域を空けてチャンクを順に並べる
+		saveStatistics_ = {};
+		saveStatistics_.fullRewrite = true;
+		std::vector<char> headerBytes(kHeaderSize);
+		file.write(headerBytes.data(), static_cast<std::streamsize>(headerBytes.size()));
+		uint64_t offset = kHeaderSize;
+		for (size_t a = 0; a < archetypes.size(); ++a) {
+			for (size_t c = 0; c < archetypes[a]->GetChunkCount(); ++c) {
+				file.write(reinterpret_cast<const char *>(archetypes[a]->GetChunk(c).data), kChunkSize);
+				directory.archetypes[a].chunks[c].fileOffset = offset;
+				offset += kChunkSize;
+				++saveStatistics_.chunkCount;
+			}
+		}
+
+		std::vector<std::byte> directoryBytes = SerializeDirectory(directory);
+		file.write(reinterpret_cast<const char *>(directoryBytes.data()), static_cast<std::streamsize>(directoryBytes.size()));
+
+		Header header {};
+		std::memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kVersion;
+		header.chunkSize = static_cast<uint32_t>(kChunkSize);
+		header.entityIndexCount = static_cast<uint32_t>(world.GetEntityIndexCount());
+		header.directoryOffset = offset;
+		header.directorySize = directoryBytes.size();
+		header.directoryHash = HashBytes(kFnvOffsetBasis, directoryBytes.data(), directoryBytes.size());
+		file.seekp(0);
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.close();
+		if (!file) {
+			std::filesystem::remove(temporaryPath);
+			return false;
+		}
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, filePath, error);
+		if (error) {
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		saveStatistics_.writtenChunkCount = saveStatistics_.chunkCount;
+		saveStatistics_.writtenBytes = offset + directoryBytes.size();
+		return true;
+	}
+
+	bool SceneSerializer::SaveIncremental(World &world, const std::string &filePath)
+	{
+		Directory directory;
+		std::vector<Archetype *> archetypes;
+		if (!BuildDirectory(world, directory, archetypes)) {
+			return false;
+		}
+
+		// 前回のヘッダとディレクトリを読む
+		Header header {};
+		Directory previous;
+		{
+			std::ifstream file(filePath, std::ios::binary);
+			if (!file || !file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+				std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.chunkSize != kChunkSize) {
+				return Save(world, filePath);
+			}
+			std::vector<std::byte> directoryBytes(header.directorySize);
+			file.seekg(static_cast<std::streamoff>(header.directoryOffset));
+			if (!file.read(reinterpret_cast<char *>(directoryBytes.data()), static_cast<std::streamsize>(directoryBytes.size())) ||
+				HashBytes(kFnvOffsetBasis, directoryBytes.data(), directoryBytes.size()) != header.directoryHash ||
+				!ParseDirectory(directoryBytes.data(), directoryBytes.size(), previous)) {
+				return Save(world, filePath);
+			}
+		}
+
+		// 型とアーキタイプの構成が同じでなければ差分にできない
+		bool sameTypes = previous.types.size() == directory.types.size() && previous.archetypes.size() == directory.archetypes.size();
+		for (size_t t = 0; sameTypes && t < directory.types.size(); ++t) {
+			const TypeEntry &a = previous.types[t];
+			const TypeEntry &b = directory.types[t];
+			sameTypes = a.name == b.name && a.size == b.size && a.alignment == b.alignment;
+		}
+		for (size_t a = 0; sameTypes && a < directory.archetypes.size(); ++a) {
+			sameTypes = SameLayout(previous.archetypes[a], directory.archetypes[a]);
+		}
+		if (!sameTypes) {
+			return Save(world, filePath);
+		}
+
+		// 書き直すチャンクを決める。前回のヘッダが指すチャンクとディレクトリは上書きせず、
+		// 変わったチャンクと増えたチャンクは前回のディレクトリの後ろに足す(前回の場所は使われなくなる)
+		struct Write
+		{
+			const Chunk *chunk;
+			uint64_t fileOffset;
+		};
+		std::vector<Write> writes;
+		uint64_t appendOffset = AlignUp(header.directoryOffset + header.directorySize, kPageSize);
+		uint64_t deadBytes = header.deadBytes + (appendOffset - header.directoryOffset);
+		uint32_t chunkCount = 0;
+		for (size_t a = 0; a < archetypes.size(); ++a) {
+			std::vector<ChunkEntry> &chunks = directory.archetypes[a].chunks;
+			const std::vector<ChunkEntry> &previousChunks = previous.archetypes[a].chunks;
+			for (size_t c = 0; c < chunks.size(); ++c) {
+				if (c < previousChunks.size() && chunks[c].hash == previousChunks[c].hash) {
+					chunks[c].fileOffset = previousChunks[c].fileOffset;
+					continue;
+				}
+				if (c < previousChunks.size()) {
+					deadBytes += kChunkSize;
+				}
+				chunks[c].fileOffset = appendOffset;
+				writes.push_back({ &archetypes[a]->GetChunk(c), appendOffset });
+				appendOffset += kChunkSize;
+			}
+			// 減ったチャンクの領域は使われなくなる
+			if (previousChunks.size() > chunks.size()) {
+				deadBytes += (previousChunks.size() - chunks.size()) * kChunkSize;
+			}
+			chunkCount += static_cast<uint32_t>(chunks.size());
+		}
+		// 使われていない領域が半分を超えたら詰め直す
+		if (deadBytes * 2 > appendOffset) {
+			return Save(world, filePath);
+		}
+
+		std::fstream file(filePath, std::ios::binary | std::ios::in | std::ios::out);
+		if (!file) {
+			return false;
+		}
+		for (const Write &write : writes) {
+			file.seekp(static_cast<std::streamoff>(write.fileOffset));
+			file.write(reinterpret_cast<const char *>(write.chunk->data), kChunkSize);
+		}
+		std::vector<std::byte> directoryBytes = SerializeDirectory(directory);
+		file.seekp(static_cast<std::streamoff>(appendOffset));
+		file.write(reinterpret_cast<const char *>(directoryBytes.data()), static_cast<std::streamsize>(directoryBytes.size()));
+		// チャンクとディレクトリを書き終えてから、ヘッダを書き換えて新しいディレクトリに切り替える
+		file.flush();
+		if (!file) {
+			return false;
+		}
+
+		header.entityIndexCount = static_cast<uint32_t>(world.GetEntityIndexCount());
+		header.directoryOffset = appendOffset;
+		header.directorySize = directoryBytes.size();
+		header.deadBytes = deadBytes;
+		header.directoryHash = HashBytes(kFnvOffsetBasis, directoryBytes.data(), directoryBytes.size());
+		file.seekp(0);
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+		saveStatistics_ = {};
+		saveStatistics_.chunkCount = chunkCount;
+		saveStatistics_.writtenChunkCount = static_cast<uint32_t>(writes.size());
+		saveStatistics_.writtenBytes = writes.size() * kChunkSize + directoryBytes.size() + sizeof(header);
+		return static_cast<bool>(file);
+	}
+
+	bool SceneSerializer::Load(World &world, const std::string &filePath)
+	{
+		// 読み込んだエンティティは保存時の番号をそのまま使うので、空のワールドに限る
+		assert(world.GetEntityCount() == 0);
+
+		MappedFile file;
+		if (!file.Open(filePath)) {
+			return false;
+		}
+		std::span<const std::byte> bytes = file.GetBytes();
+		Header header {};
+		if (bytes.size() < kHeaderSize) {
+			return false;
+		}
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.chunkSize != kChunkSize ||
+			header.directoryOffset > bytes.size() || header.directorySize > bytes.size() - header.directoryOffset) {
+			return false;
+		}
+		// ヘッダが指すディレクトリを書き終えていなければ読まない
+		const std::byte *directoryBytes = bytes.data() + header.directoryOffset;
+		Directory directory;
+		if (HashBytes(kFnvOffsetBasis, directoryBytes, static_cast<size_t>(header.directorySize)) != header.directoryHash ||
+			!ParseDirectory(directoryBytes, static_cast<size_t>(header.directorySize), directory)) {
+			return false;
+		}
+
+		// ファイル内の型番号を実行時の型IDに対応づける
+		std::vector<uint32_t> typeIds(directory.types.size(), kInvalidIndex);
+		for (size_t t = 0; t < directory.types.size(); ++t) {
+			const TypeEntry &type = directory.types[t];
+			auto it = std::find(names_.begin(), names_.end(), type.name);
+			if (it == names_.end()) {
+				return false;
+			}
+			uint32_t typeId = static_cast<uint32_t>(it - names_.begin());
+			const ComponentInfo &info = GetComponentInfo(typeId);
+			if (info.size != type.size || info.alignment != type.alignment) {
+				return false;
+			}
+			typeIds[t] = typeId;
+		}
+
+		// 途中で失敗してワールドが読みかけにならないよう、先に全て確かめておく
+		// (チャンクの行数は実行時の容量で、詰まっていないのは最後のチャンクだけ。エンティティ番号は範囲内で重ならない)
+		std::vector<ComponentMask> masks(directory.archetypes.size(), 0);
+		std::vector<uint8_t> usedIndices(header.entityIndexCount, 0);
+		for (size_t a = 0; a < directory.archetypes.size(); ++a) {
+			const ArchetypeEntry &entry = directory.archetypes[a];
+			for (uint32_t type : entry.types) {
+				masks[a] |= ComponentMask(1) << typeIds[type];
+			}
+			// 同じ型が2回ある、同じ構成のアーキタイプが2つあるファイルは読まない
+			if (std::popcount(masks[a]) != static_cast<int>(entry.types.size()) || std::find(masks.begin(), masks.begin() + a, masks[a]) != masks.begin() + a) {
+				return false;
+			}
+			if (entry.capacity == 0 || sizeof(Entity) * uint64_t(entry.capacity) > kChunkSize) {
+				return false;
+			}
+			for (size_t i = 0; i < entry.types.size(); ++i) {
+				if (entry.offsets[i] + uint64_t(directory.types[entry.types[i]].size) * entry.capacity > kChunkSize) {
+					return false;
+				}
+			}
+			for (size_t c = 0; c < entry.chunks.size(); ++c) {
+				const ChunkEntry &chunk = entry.chunks[c];
+				bool isLast = c + 1 == entry.chunks.size();
+				if (chunk.fileOffset > bytes.size() || kChunkSize > bytes.size() - chunk.fileOffset ||
+					chunk.count == 0 || chunk.count > entry.capacity || (!isLast && chunk.count != entry.capacity)) {
+					return false;
+				}
+				for (uint32_t row = 0; row < chunk.count; ++row) {
+					Entity entity;
+					std::memcpy(&entity, bytes.data() + chunk.fileOffset + sizeof(Entity) * row, sizeof(Entity));
+					if (entity.index >= header.entityIndexCount || usedIndices[entity.index] != 0) {
+						return false;
+					}
+					usedIndices[entity.index] = 1;
+				}
+			}
+		}
+
+		for (size_t a = 0; a < directory.archetypes.size(); ++a) {
+			const ArchetypeEntry &entry = directory.archetypes[a];
+			if (entry.chunks.empty()) {
+				continue;
+			}
+			Archetype &archetype = world.GetArchetype(masks[a]);
+			// 空のワールドなのでチャンクは無い(エンティティが0になったアーキタイプはチャンクも返している)
+			assert(archetype.GetChunkCount() == 0);
+			const uint32_t capacity = archetype.GetChunkCapacity();
+
+			// 型IDの振られ方が保存時と同じならチャンクの配置も同じなので、チャンクごと1回でコピーする
+			bool sameLayout = entry.capacity == capacity;
+			for (size_t i = 0; sameLayout && i < entry.types.size(); ++i) {
+				sameLayout = entry.offsets[i] == archetype.GetComponentOffset(typeIds[entry.types[i]]);
+			}
+			if (sameLayout) {
+				for (const ChunkEntry &chunk : entry.chunks) {
+					uint32_t chunkIndex = archetype.AppendChunk(chunk.count);
+					std::memcpy(archetype.GetChunk(chunkIndex).data, bytes.data() + chunk.fileOffset, kChunkSize);
+					world.RegisterChunkEntities(archetype, chunkIndex);
+				}
+				continue;
+			}
+
+			// 配置や容量が違えば、実行時の容量でチャンクを詰め直しながら配列ごとにコピーする
+			uint64_t entityCount = 0;
+			for (const ChunkEntry &chunk : entry.chunks) {
+				entityCount += chunk.count;
+			}
+			uint32_t firstChunk = static_cast<uint32_t>(archetype.GetChunkCount());
+			for (uint64_t remaining = entityCount; remaining > 0; remaining -= (std::min)(remaining, uint64_t(capacity))) {
+				archetype.AppendChunk(static_cast<uint32_t>((std::min)(remaining, uint64_t(capacity))));
+			}
+			uint32_t destinationChunk = firstChunk;
+			uint32_t destinationRow = 0;
+			for (const ChunkEntry &chunk : entry.chunks) {
+				const std::byte *source = bytes.data() + chunk.fileOffset;
+				for (uint32_t sourceRow = 0; sourceRow < chunk.count;) {
+					uint32_t rowCount = (std::min)(chunk.count - sourceRow, capacity - destinationRow);
+					std::byte *destination = archetype.GetChunk(destinationChunk).data;
+					std::memcpy(destination + sizeof(Entity) * destinationRow, source + sizeof(Entity) * sourceRow, sizeof(Entity) * rowCount);
+					for (size_t i = 0; i < entry.types.size(); ++i) {
+						uint32_t typeId = typeIds[entry.types[i]];
+						size_t size = archetype.GetComponentSize(typeId);
+						std::memcpy(destination + archetype.GetComponentOffset(typeId) + size * destinationRow, source + entry.offsets[i] + size * sourceRow, size * rowCount);
+					}
+					sourceRow += rowCount;
+					destinationRow += rowCount;
+					if (destinationRow == capacity) {
+						++destinationChunk;
+						destinationRow = 0;
+					}
+				}
+			}
+			for (uint32_t chunkIndex = firstChunk; chunkIndex < archetype.GetChunkCount(); ++chunkIndex) {
+				world.RegisterChunkEntities(archetype, chunkIndex);
+			}
+		}
+		world.RebuildFreeIndices();
+		return true;
+	}
+}
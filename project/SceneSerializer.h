@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ECS.h"
+
+// シーン(ECSのワールド)のバイナリ保存・読み込み
+// ファイル上の並びは実行時のアーキタイプのチャンク(16KB、中はコンポーネントごとの配列)そのままで、
+// 読み込みはメモリマップしたファイルからチャンク単位のmemcpyで済む
+// 保存時はチャンクごとのハッシュ(使っている行だけ)を記録しておき、次の保存では中身の変わったチャンクだけを末尾に書き足す
+// 差分保存は前回のチャンクを上書きせず、最後にヘッダを書き換えて切り替えるので、途中で止まっても前回の内容のまま読める
+//
+// ファイルの形式(実行時のメモリ配置そのままなので、同じビルド同士で読み書きする。型のサイズが違えば読み込まない)
+//   ヘッダ(kHeaderSize): "GE3S" + uint32 バージョン + uint32 チャンクサイズ + uint32 エンティティ番号の範囲
+//                        + uint64 ディレクトリの位置・サイズ + uint64 使われていないバイト数 + uint64 ディレクトリのハッシュ
+//   チャンク: kChunkSizeずつ、ページ境界に揃えて並べる
+//   ディレクトリ(末尾): コンポーネント型(名前・サイズ・アラインメント)、アーキタイプ(型・オフセット・チャンクの位置・行数・ハッシュ)
+namespace ecs
+{
+	class SceneSerializer
+	{
+	public:
+		// 直前の保存の統計
+		struct SaveStatistics
+		{
+			uint32_t chunkCount = 0;
+			uint32_t writtenChunkCount = 0; //!< 書き込んだチャンク数(全体を書き出したときは全て)
+			uint64_t writtenBytes = 0; //!< ヘッダ・ディレクトリを含む
+			bool fullRewrite = false; //!< 差分で済まずに全体を書き出したか
+		};
+
+	public: // メンバ関数
+		/// <summary>
+		/// 保存・読み込みするコンポーネント型を登録する
+		/// ファイル内では型を名前で対応づけるので、型IDの振られる順番がビルドや実行ごとに変わってもよい
+		/// </summary>
+		template <class T>
+		void RegisterComponent(const std::string &name)
+		{
+			RegisterComponent(GetComponentTypeId<T>(), name);
+		}
+		void RegisterComponent(uint32_t typeId, const std::string &name);
+
+		/// <summary>
+		/// ワールド全体を書き出す(登録していないコンポーネントを持つアーキタイプがあれば書き出さずにfalse)
+		/// 一時ファイルに書き出してから置き換えるので、途中で止まっても元のファイルは残る
+		/// </summary>
+		bool Save(World &world, const std::string &filePath);
+
+		/// <summary>
+		/// 前回保存したファイルと比べて、変わったチャンクだけを末尾に書き足し、最後にヘッダを書き換えて切り替える
+		/// アーキタイプの構成が変わった、ファイルが無い、使われていない領域が半分を超えた場合は全体を書き出す
+		/// </summary>
+		bool SaveIncremental(World &world, const std::string &filePath);
+
+		// 読み込む(worldにはエンティティが無いこと。形式が違う、知らない型があればfalse)
+		bool Load(World &world, const std::string &filePath);
+
+		const SaveStatistics &GetLastSaveStatistics() const { return saveStatistics_; }
+
+	private:
+		// ファイルの先頭
+		static constexpr char kMagic[4] = { 'G','E','3','S' };
+		static constexpr uint32_t kVersion = 3;
+		static constexpr uint64_t kHeaderSize = 4096;
+		static constexpr uint64_t kPageSize = 4096;
+
+		// ディレクトリのチャンク1つ分
+		struct ChunkEntry
+		{
+			uint64_t fileOffset;
+			uint32_t count;
+			uint32_t padding;
+			uint64_t hash;
+		};
+		// ディレクトリのアーキタイプ1つ分
+		struct ArchetypeEntry
+		{
+			std::vector<uint32_t> types; //!< ファイル内の型番号
+			std::vector<uint32_t> offsets; //!< 型ごとのチャンク内オフセット
+			uint32_t capacity = 0;
+			std::vector<ChunkEntry> chunks;
+		};
+		// ディレクトリのコンポーネント型1つ分
+		struct TypeEntry
+		{
+			std::string name;
+			uint32_t size = 0;
+			uint32_t alignment = 0;
+		};
+		struct Directory
+		{
+			std::vector<TypeEntry> types;
+			std::vector<ArchetypeEntry> archetypes;
+		};
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t chunkSize;
+			uint32_t entityIndexCount; //!< 保存時のエンティティ番号の範囲(読み込むエンティティの番号はこれより小さい)
+			uint64_t directoryOffset;
+			uint64_t directorySize;
+			uint64_t deadBytes; //!< 差分保存で使われなくなったチャンクとディレクトリの領域
+			uint64_t directoryHash; //!< 書き終えたディレクトリのハッシュ(書きかけのファイルを読まないよう、読み込み時に確かめる)
+		};
+
+		// 書き出すアーキタイプとディレクトリを組み立てる(チャンクの位置は未設定)
+		bool BuildDirectory(World &world, Directory &directory, std::vector<Archetype *> &archetypes) const;
+		static std::vector<std::byte> SerializeDirectory(const Directory &directory);
+		static bool ParseDirectory(const std::byte *data, size_t size, Directory &directory);
+		// チャンクのハッシュ(エンティティとコンポーネントの配列のうち、使っている行だけ)
+		static uint64_t HashChunk(const Archetype &archetype, const Chunk &chunk);
+
+		// 登録した型(型IDの順)
+		std::vector<std::string> names_;
+		SaveStatistics saveStatistics_;
+	};
+}
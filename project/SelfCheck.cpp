@@ -0,0 +1,524 @@
+#include "SelfCheck.h"
+#include "Logger.h"
+#include "MathFunctions.h"
+#include "Components.h"
+#include "OcclusionCulling.h"
+#include "SceneSerializer.h"
+#include "ShaderPermutation.h"
+#include "SkeletalAnimation.h"
+#include "SpriteBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace SelfCheck
+{
+	namespace
+	{
+		// 浮動小数点の比較の許容誤差
+		constexpr float kTolerance = 1.0e-4f;
+
+		// 1つの確認の中の項目を数え、失敗した項目をログに出す
+		class Checker
+		{
+		public:
+			Checker(std::ostream &os, const char *name) : os_(os), name_(name) {}
+
+			void Expect(bool condition, const std::string &what)
+			{
+				++count_;
+				if (!condition) {
+					++failedCount_;
+					Logger::Log(os_, std::format("[SelfCheck] {} FAILED: {}", name_, what));
+				}
+			}
+
+			void ExpectNear(float actual, float expected, const std::string &what)
+			{
+				Expect(std::abs(actual - expected) <= kTolerance, std::format("{} = {:.6f} (expected {:.6f})", what, actual, expected));
+			}
+
+			// 結果をログに出して、全て通ったかを返す
+			bool Finish()
+			{
+				Logger::Log(os_, std::format("[SelfCheck] {} {} ({}/{} passed)", name_, failedCount_ == 0 ? "ok" : "FAILED", count_ - failedCount_, count_));
+				return failedCount_ == 0;
+			}
+
+		private:
+			std::ostream &os_;
+			const char *name_;
+			uint32_t count_ = 0;
+			uint32_t failedCount_ = 0;
+		};
+	}
+
+	bool RunAll(std::ostream &os)
+	{
+		Logger::Log(os, "---- SelfCheck begin ----");
+		bool passed = true;
+		passed &= CheckSkeletalAnimation(os);
+		passed &= CheckOcclusionCulling(os);
+		passed &= CheckShaderPermutation(os);
+		passed &= CheckSceneSerializer(os);
+		passed &= CheckSpriteBatch(os);
+		Logger::Log(os, std::format("---- SelfCheck end: {} ----", passed ? "all passed" : "FAILED"));
+		return passed;
+	}
+
+	bool CheckSkeletalAnimation(std::ostream &os)
+	{
+		Checker checker(os, "SkeletalAnimation");
+
+		// 5関節の鎖(ルートは原点、子は親から上に1)。回転のトラックを5本にして、SIMDの4本組と端数の両方を通す
+		constexpr uint32_t kJointCount = 5;
+		animation::Skeleton skeleton;
+		skeleton.bindPose.Resize(kJointCount);
+		for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+			skeleton.jointNames.push_back(std::format("joint{}", joint));
+			skeleton.parents.push_back(static_cast<int32_t>(joint) - 1);
+			skeleton.bindPose.SetTranslation(joint, { 0.0f, joint == 0 ? 0.0f : 1.0f, 0.0f });
+		}
+		std::vector<math::Matrix4x4> bindMatrices;
+		animation::ComputeModelMatrices(skeleton, skeleton.bindPose, bindMatrices);
+		for (const math::Matrix4x4 &bindMatrix : bindMatrices) {
+			skeleton.inverseBindMatrices.push_back(math::Inverse(bindMatrix));
+		}
+
+		// 時刻0と1の2キーのクリップ
+		// 関節1以外: Z軸回りに0度 → 90度(関節3と4は終わりのキーを符号反転した同じ回転にし、近い方を通ることを確かめる)
+		// 関節1: 90度のまま
+		// ルートの平行移動: (0,0,0) → (2,0,0)
+		const float s45 = std::sin(0.25f * 3.14159265f);
+		const float s22 = std::sin(0.125f * 3.14159265f);
+		const float c22 = std::cos(0.125f * 3.14159265f);
+		const math::Quaternion identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+		const math::Quaternion rotate90 = { 0.0f, 0.0f, s45, s45 };
+		const math::Quaternion rotate90Negated = { 0.0f, 0.0f, -s45, -s45 };
+		animation::AnimationClip clip;
+		clip.name = "check";
+		clip.duration = 1.0f;
+		auto addKey = [](animation::Track &track, float time, std::initializer_list<float> values) {
+			track.times.push_back(time);
+			uint32_t c = 0;
+			for (float value : values) {
+				track.values[c++].push_back(value);
+			}
+			};
+		for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+			animation::Track track;
+			track.joint = joint;
+			const math::Quaternion &from = joint == 1 ? rotate90 : identity;
+			const math::Quaternion &to = joint >= 3 ? rotate90Negated : rotate90;
+			addKey(track, 0.0f, { from.x, from.y, from.z, from.w });
+			addKey(track, 1.0f, { to.x, to.y, to.z, to.w });
+			clip.rotations.push_back(std::move(track));
+		}
+		animation::Track rootTrack;
+		rootTrack.joint = 0;
+		addKey(rootTrack, 0.0f, { 0.0f, 0.0f, 0.0f });
+		addKey(rootTrack, 1.0f, { 2.0f, 0.0f, 0.0f });
+		clip.translations.push_back(std::move(rootTrack));
+
+		animation::ClipCursor cursor;
+		cursor.Reset(clip);
+		animation::Pose pose = skeleton.bindPose;
+
+		// 中間: 0度と90度のnlerpは45度の回転にちょうど一致する(sin22.5, cos22.5)
+		animation::SampleClip(clip, 0.5f, cursor, pose);
+		for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+			math::Quaternion rotation = pose.GetRotation(joint);
+			float expectedZ = joint == 1 ? s45 : s22;
+			float expectedW = joint == 1 ? s45 : c22;
+			// 符号を反転したキーとの補間は、どちらの符号で返っても同じ回転
+			float sign = rotation.w < 0.0f ? -1.0f : 1.0f;
+			checker.ExpectNear(rotation.x, 0.0f, std::format("t=0.5 joint{} rotation.x", joint));
+			checker.ExpectNear(sign * rotation.z, expectedZ, std::format("t=0.5 joint{} rotation.z", joint));
+			checker.ExpectNear(sign * rotation.w, expectedW, std::format("t=0.5 joint{} rotation.w", joint));
+		}
+		checker.ExpectNear(pose.GetTranslation(0).x, 1.0f, "t=0.5 root translation.x");
+		checker.ExpectNear(pose.GetTranslation(1).y, 1.0f, "t=0.5 joint1 translation.y (no track keeps the bind pose)");
+
+		// 範囲外の時刻は端のキーに留まる
+		animation::Pose clampedPose = skeleton.bindPose;
+		animation::SampleClip(clip, 2.0f, cursor, clampedPose);
+		checker.ExpectNear(clampedPose.GetTranslation(0).x, 2.0f, "t=2 root translation.x");
+		checker.ExpectNear(clampedPose.GetRotation(0).z, s45, "t=2 root rotation.z");
+		animation::SampleClip(clip, -1.0f, cursor, clampedPose);
+		checker.ExpectNear(clampedPose.GetTranslation(0).x, 0.0f, "t=-1 root translation.x");
+		checker.ExpectNear(clampedPose.GetRotation(0).w, 1.0f, "t=-1 root rotation.w");
+
+		// 両端の姿勢を半分ずつ混ぜると、中間でサンプリングした姿勢と同じになる
+		animation::Pose startPose = skeleton.bindPose;
+		animation::Pose endPose = skeleton.bindPose;
+		animation::Pose blendedPose = skeleton.bindPose;
+		animation::SampleClip(clip, 0.0f, cursor, startPose);
+		animation::SampleClip(clip, 1.0f, cursor, endPose);
+		animation::BlendPoses(startPose, endPose, 0.5f, blendedPose);
+		for (uint32_t joint = 0; joint < kJointCount; ++joint) {
+			math::Quaternion blended = blendedPose.GetRotation(joint);
+			math::Quaternion sampled = pose.GetRotation(joint);
+			float dot = blended.x * sampled.x + blended.y * sampled.y + blended.z * sampled.z + blended.w * sampled.w;
+			checker.ExpectNear(std::abs(dot), 1.0f, std::format("blend 0.5 joint{} matches t=0.5", joint));
+		}
+		checker.ExpectNear(blendedPose.GetTranslation(0).x, 1.0f, "blend 0.5 root translation.x");
+
+		// t=0.5の姿勢でスキニングする(行ベクトルの規約で、Z軸回りの回転は(0,1)を(-sin,cos)に移す)
+		// ルート: 45度回して(1,0,0)へ。関節1: 自身で90度回してから、ルートの上1の位置へ
+		//   A (0,2,0) を関節1に全て → (-0.41421, 0, 0)、法線(1,0,0) → (-0.70711, 0.70711, 0)
+		//   B (0,2,0) を関節0と1に半分ずつ → 関節0では(-0.41421, 1.41421, 0)なので平均して(-0.41421, 0.70711, 0)
+		//     法線は(0.70711, 0.70711, 0)と(-0.70711, 0.70711, 0)の平均を正規化して(0, 1, 0)
+		std::vector<math::Matrix4x4> modelMatrices;
+		std::vector<math::Matrix4x4> skinMatrices;
+		animation::ComputeModelMatrices(skeleton, pose, modelMatrices);
+		animation::ComputeSkinMatrices(skeleton, modelMatrices, skinMatrices);
+		std::vector<animation::SkinnedVertex> vertices = {
+			{ { 0.0f, 2.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 1, 0, 0, 0 }, { 1.0f, 0.0f, 0.0f, 0.0f } },
+			{ { 0.0f, 2.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0, 1, 0, 0 }, { 0.5f, 0.5f, 0.0f, 0.0f } },
+		};
+		std::vector<math::Vector4> positions;
+		std::vector<math::Vector3> normals;
+		animation::SkinVertices(vertices, skinMatrices, positions, normals);
+		const float root2 = std::sqrt(2.0f);
+		checker.ExpectNear(positions[0].x, 1.0f - root2, "skin A position.x");
+		checker.ExpectNear(positions[0].y, 0.0f, "skin A position.y");
+		checker.ExpectNear(positions[0].w, 1.0f, "skin A position.w");
+		checker.ExpectNear(normals[0].x, -s45, "skin A normal.x");
+		checker.ExpectNear(normals[0].y, s45, "skin A normal.y");
+		checker.ExpectNear(positions[1].x, 1.0f - root2, "skin B position.x");
+		checker.ExpectNear(positions[1].y, 0.5f * root2, "skin B position.y");
+		checker.ExpectNear(positions[1].z, 0.0f, "skin B position.z");
+		checker.ExpectNear(normals[1].x, 0.0f, "skin B normal.x");
+		checker.ExpectNear(normals[1].y, 1.0f, "skin B normal.y");
+
+		return checker.Finish();
+	}
+
+	bool CheckOcclusionCulling(std::ostream &os)
+	{
+		Checker checker(os, "OcclusionCulling");
+
+		// 箱のメッシュ
+		const std::vector<math::Vector3> boxPositions = {
+			{ -0.5f,-0.5f,-0.5f }, { 0.5f,-0.5f,-0.5f }, { -0.5f,0.5f,-0.5f }, { 0.5f,0.5f,-0.5f },
+			{ -0.5f,-0.5f,0.5f }, { 0.5f,-0.5f,0.5f }, { -0.5f,0.5f,0.5f }, { 0.5f,0.5f,0.5f } };
+		const std::vector<uint32_t> boxIndices = {
+			0,2,1, 1,2,3, 4,5,6, 5,7,6, 0,1,4, 1,5,4, 2,6,3, 3,6,7, 0,4,2, 2,4,6, 1,3,5, 3,7,5 };
+
+		// 原点から+Zを見るカメラ
+		// 遮蔽物: 正面の z=10 に幅・高さ4の壁(奥の z=20 では|x|, |y| < 2 * 20 / 10.5 ≒ 3.8 が隠れる)と、斜めに回した壁
+		const math::Matrix4x4 viewProjection = math::MakePerspectiveFovMatrix(0.9f, 16.0f / 9.0f, 0.1f, 200.0f);
+		const math::Matrix4x4 walls[] = {
+			math::MakeAffineMatrix({ 4.0f, 4.0f, 1.0f }, math::Vector3 { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 10.0f }),
+			math::MakeAffineMatrix({ 3.0f, 5.0f, 1.0f }, math::Vector3 { 0.0f, 0.0f, 0.3f }, { -7.0f, 1.0f, 12.0f }) };
+		auto makeBox = [](const math::Vector3 &center, float halfSize) {
+			return render::BoundingBox { { center.x - halfSize, center.y - halfSize, center.z - halfSize }, { center.x + halfSize, center.y + halfSize, center.z + halfSize } };
+			};
+		struct Case
+		{
+			const char *name;
+			render::BoundingBox box;
+			bool visible;
+		};
+		const Case cases[] = {
+			{ "behind the wall", makeBox({ 0.0f, 0.0f, 20.0f }, 0.5f), false },
+			{ "far behind the wall", makeBox({ 1.0f, -1.0f, 60.0f }, 2.0f), false },
+			{ "in front of the wall", makeBox({ 0.0f, 0.0f, 5.0f }, 0.5f), true },
+			{ "beside the wall", makeBox({ 6.0f, 0.0f, 20.0f }, 0.5f), true },
+			{ "across the wall edge", makeBox({ 4.0f, 0.0f, 20.0f }, 0.5f), true },
+			{ "crossing the near plane", makeBox({ 0.0f, 0.0f, 0.0f }, 0.5f), true },
+		};
+		constexpr uint32_t kCaseCount = static_cast<uint32_t>(std::size(cases));
+		std::vector<render::BoundingBox> boxes;
+		for (const Case &testCase : cases) {
+			boxes.push_back(testCase.box);
+		}
+
+		// スカラー / SIMD / SIMD+ジョブ で同じフレームを処理する
+		render::OcclusionCuller culler;
+		culler.Initialize();
+		std::vector<float> referenceDepth;
+		std::vector<uint8_t> referenceVisible;
+		const char *modeNames[] = { "scalar", "simd", "simd+jobs" };
+		for (uint32_t mode = 0; mode < 3; ++mode) {
+			culler.SetUseSimd(mode != 0);
+			culler.SetUseJobs(mode == 2);
+			culler.BeginFrame(viewProjection);
+			for (const math::Matrix4x4 &wall : walls) {
+				culler.AddOccluder(boxPositions, boxIndices, wall);
+			}
+			culler.Rasterize();
+			std::vector<uint8_t> visible(kCaseCount);
+			culler.TestVisibility(boxes, visible);
+
+			std::vector<float> depth;
+			for (uint32_t y = 0; y < culler.GetHeight(); ++y) {
+				for (uint32_t x = 0; x < culler.GetWidth(); ++x) {
+					depth.push_back(culler.GetDepth(x, y));
+				}
+			}
+			if (mode == 0) {
+				for (uint32_t i = 0; i < kCaseCount; ++i) {
+					checker.Expect((visible[i] != 0) == cases[i].visible,
+						std::format("{} is {}", cases[i].name, cases[i].visible ? "visible" : "occluded"));
+				}
+				referenceDepth = std::move(depth);
+				referenceVisible = std::move(visible);
+				continue;
+			}
+			// 辺関数は同じ式で求めているので、画素の境目も含めて完全に一致する
+			uint32_t mismatchCount = 0;
+			for (size_t i = 0; i < depth.size(); ++i) {
+				mismatchCount += depth[i] != referenceDepth[i] ? 1 : 0;
+			}
+			checker.Expect(mismatchCount == 0, std::format("{} depth buffer matches scalar ({} pixels differ)", modeNames[mode], mismatchCount));
+			checker.Expect(visible == referenceVisible, std::format("{} visibility matches scalar", modeNames[mode]));
+		}
+
+		return checker.Finish();
+	}
+
+	bool CheckShaderPermutation(std::ostream &os)
+	{
+		Checker checker(os, "ShaderPermutation");
+		using render::ShaderFeature;
+		using render::ToMask;
+		const std::string psPath = "resources/shaders/Object3D.PS.hlsl";
+		const std::string vsPath = "resources/shaders/Object3D.VS.hlsl";
+		const render::ShaderFeatureMask lightingTexture = ToMask(ShaderFeature::Lighting) | ToMask(ShaderFeature::Texture);
+
+		// 使わない機能のビットは落ちる
+		render::ShaderPermutationKey vsKey = render::MakePermutationKey(vsPath, "vs_6_0", render::kAllShaderFeatures, ToMask(ShaderFeature::VertexColor));
+		checker.Expect(vsKey.features == ToMask(ShaderFeature::VertexColor), std::format("unsupported bits are masked (features = {})", vsKey.features));
+		render::ShaderPermutationKey vsKeyOther = render::MakePermutationKey(vsPath, "vs_6_0", ToMask(ShaderFeature::VertexColor) | ToMask(ShaderFeature::Lighting), ToMask(ShaderFeature::VertexColor));
+		checker.Expect(vsKey == vsKeyOther, "keys differing only in unsupported bits are equal");
+		checker.Expect(vsKey.GetHash() == vsKeyOther.GetHash(), "keys differing only in unsupported bits have equal hashes");
+		render::ShaderPermutationKey psKey = render::MakePermutationKey(psPath, "ps_6_0", lightingTexture);
+		checker.Expect(psKey.features == lightingTexture, "supported bits are kept");
+
+		// ハッシュは実行ごと・環境ごとに同じ値(別に計算したFNV-1aの値と比べる)
+		checker.Expect(psKey.GetHash() == 0x3573457927b70c9eull, std::format("pixel shader key hash = {:#018x}", psKey.GetHash()));
+		checker.Expect(vsKey.GetHash() == 0x3d6fa9b7eea76539ull, std::format("vertex shader key hash = {:#018x}", vsKey.GetHash()));
+
+		// パス・プロファイル・機能のどれが違ってもハッシュは変わる
+		const uint64_t psHash = psKey.GetHash();
+		checker.Expect(render::MakePermutationKey(vsPath, "ps_6_0", lightingTexture).GetHash() != psHash, "different path changes the hash");
+		checker.Expect(render::MakePermutationKey(psPath, "ps_6_6", lightingTexture).GetHash() != psHash, "different profile changes the hash");
+		checker.Expect(render::MakePermutationKey(psPath, "ps_6_0", ToMask(ShaderFeature::Lighting)).GetHash() != psHash, "different features change the hash");
+		// 区切りを入れているので、文字列の境目がずれても同じにならない
+		checker.Expect(render::MakePermutationKey("ab", "c", 0).GetHash() != render::MakePermutationKey("a", "bc", 0).GetHash(), "path/profile boundary changes the hash");
+
+		// 定義は無効な機能も0として全て並ぶ
+		const std::vector<std::string> lightingDefines = render::GetPermutationDefines(render::MakePermutationKey(psPath, "ps_6_0", ToMask(ShaderFeature::Lighting)));
+		checker.Expect(lightingDefines == std::vector<std::string>{ "USE_LIGHTING=1", "USE_TEXTURE=0", "USE_VERTEX_COLOR=0" }, "defines for lighting only");
+		const std::vector<std::string> vsDefines = render::GetPermutationDefines(vsKey);
+		checker.Expect(vsDefines == std::vector<std::string>{ "USE_LIGHTING=0", "USE_TEXTURE=0", "USE_VERTEX_COLOR=1" }, "defines for masked vertex color key");
+
+		const std::string name = render::GetPermutationName(psKey);
+		checker.Expect(name == "Object3D.PS.hlsl[ps_6_0|USE_LIGHTING|USE_TEXTURE]", std::format("permutation name = {}", name));
+
+		return checker.Finish();
+	}
+
+	bool CheckSceneSerializer(std::ostream &os)
+	{
+		Checker checker(os, "SceneSerializer");
+		using namespace ecs;
+
+		// 300体作り、7体に1体を破棄して番号に穴を空ける
+		constexpr uint32_t kEntityCount = 300;
+		World world;
+		std::vector<Entity> entities;
+		for (uint32_t i = 0; i < kEntityCount; ++i) {
+			entities.push_back(world.CreateEntity(
+				Transform2DComponent { { float(i), float(i) * 0.5f }, 0.0f, { 64.0f, 64.0f } },
+				ColliderComponent { { 32.0f, 32.0f }, i % 4, 0 }));
+		}
+		std::vector<Entity> aliveEntities;
+		for (uint32_t i = 0; i < kEntityCount; ++i) {
+			if (i % 7 == 0) {
+				world.DestroyEntity(entities[i]);
+			} else {
+				aliveEntities.push_back(entities[i]);
+			}
+		}
+
+		SceneSerializer serializer;
+		serializer.RegisterComponent<Transform2DComponent>("Transform2D");
+		serializer.RegisterComponent<ColliderComponent>("Collider");
+		const std::string path = (std::filesystem::temp_directory_path() / "selfcheck_scene.ge3s").string();
+		checker.Expect(serializer.Save(world, path), "save");
+
+		// 保存時と同じハンドルで、同じ値が読める
+		{
+			World loaded;
+			checker.Expect(serializer.Load(loaded, path), "load");
+			checker.Expect(loaded.GetEntityCount() == aliveEntities.size(), std::format("loaded entity count = {}", loaded.GetEntityCount()));
+			uint32_t mismatchCount = 0;
+			for (Entity entity : aliveEntities) {
+				if (!loaded.IsAlive(entity) || loaded.GetComponent<Transform2DComponent>(entity)->position.x != float(entity.index)) {
+					++mismatchCount;
+				}
+			}
+			checker.Expect(mismatchCount == 0, std::format("loaded entities keep their handles and values ({} differ)", mismatchCount));
+			// 破棄されていた番号は空きとして再利用される
+			Entity created = loaded.CreateEntity(Transform2DComponent {});
+			checker.Expect(created.index < kEntityCount && created.index % 7 == 0, std::format("new entity reuses a free index ({})", created.index));
+		}
+
+		// チャンク内のエンティティを書き換えたファイルは、ワールドに何も足さずに失敗する
+		std::vector<char> original;
+		{
+			std::ifstream file(path, std::ios::binary);
+			original.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+		auto loadPatched = [&](Entity target, Entity replacement) {
+			std::vector<char> patched = original;
+			auto it = std::search(patched.begin(), patched.end(), reinterpret_cast<const char *>(&target), reinterpret_cast<const char *>(&target) + sizeof(Entity));
+			if (it == patched.end()) {
+				return false;
+			}
+			std::memcpy(&*it, &replacement, sizeof(Entity));
+			{
+				std::ofstream file(path, std::ios::binary | std::ios::trunc);
+				file.write(patched.data(), static_cast<std::streamsize>(patched.size()));
+			}
+			World loaded;
+			bool result = serializer.Load(loaded, path);
+			return !result && loaded.GetEntityCount() == 0;
+		};
+		checker.Expect(loadPatched(aliveEntities[0], Entity { 0x7FFFFFFFu, 0 }), "out of range entity index is rejected");
+		checker.Expect(loadPatched(aliveEntities[0], aliveEntities[1]), "duplicate entity index is rejected");
+
+		// 差分保存は変わったチャンクだけを書き足す。破棄したエンティティの残り(行数より後ろ)は変化とみなさない
+		// (チャンクが1つだと書き足した分で使われない領域が半分を超えて全体を書き出すので、チャンクが複数になる数で確かめる)
+		World largeWorld;
+		std::vector<Entity> largeEntities;
+		for (uint32_t i = 0; i < kEntityCount * 10; ++i) {
+			largeEntities.push_back(largeWorld.CreateEntity(
+				Transform2DComponent { { float(i), 0.0f }, 0.0f, { 64.0f, 64.0f } },
+				ColliderComponent { { 32.0f, 32.0f }, i % 4, 0 }));
+		}
+		auto readFile = [&]() {
+			std::ifstream file(path, std::ios::binary);
+			return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		};
+		auto writeFile = [&](const std::vector<char> &bytes) {
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		};
+		auto loadedPositionX = [&](Entity entity, float &positionX) {
+			World loaded;
+			if (!serializer.Load(loaded, path) || !loaded.IsAlive(entity)) {
+				return false;
+			}
+			positionX = loaded.GetComponent<Transform2DComponent>(entity)->position.x;
+			return true;
+		};
+		checker.Expect(serializer.Save(largeWorld, path), "save before incremental save");
+		const std::vector<char> previousBytes = readFile();
+		largeWorld.DestroyEntity(largeWorld.CreateEntity(
+			Transform2DComponent { { -1.0f, -1.0f }, 0.0f, { 1.0f, 1.0f } },
+			ColliderComponent { { 1.0f, 1.0f }, 0, 0 }));
+		checker.Expect(serializer.SaveIncremental(largeWorld, path) && serializer.GetLastSaveStatistics().writtenChunkCount == 0,
+			std::format("rows past the chunk count do not dirty chunks ({} written)", serializer.GetLastSaveStatistics().writtenChunkCount));
+		const Entity moved = largeEntities[0];
+		largeWorld.GetComponent<Transform2DComponent>(moved)->position.x = 1000.0f;
+		bool incrementalSaved = serializer.SaveIncremental(largeWorld, path);
+		const SceneSerializer::SaveStatistics &statistics = serializer.GetLastSaveStatistics();
+		checker.Expect(incrementalSaved && !statistics.fullRewrite && statistics.writtenChunkCount == 1,
+			std::format("incremental save writes the changed chunk only ({} written)", statistics.writtenChunkCount));
+		float positionX = 0.0f;
+		checker.Expect(loadedPositionX(moved, positionX) && positionX == 1000.0f, "incremental save is loaded");
+
+		// ヘッダを書き換える前に止まったファイル(前回のヘッダ + 書き足した末尾)は前回の内容のまま読める
+		std::vector<char> savedBytes = readFile();
+		std::vector<char> interruptedBytes = savedBytes;
+		constexpr size_t kHeaderSize = 4096;
+		std::copy(previousBytes.begin(), previousBytes.begin() + kHeaderSize, interruptedBytes.begin());
+		writeFile(interruptedBytes);
+		checker.Expect(loadedPositionX(moved, positionX) && positionX == float(moved.index), "interrupted incremental save keeps the previous scene");
+		// ディレクトリを書き終える前に止まったファイル(ヘッダのハッシュと合わない)は読まない
+		savedBytes.back() ^= 1;
+		writeFile(savedBytes);
+		checker.Expect(!loadedPositionX(moved, positionX), "partially written directory is rejected");
+
+		std::filesystem::remove(path);
+		return checker.Finish();
+	}
+
+	bool CheckSpriteBatch(std::ostream &os)
+	{
+		Checker checker(os, "SpriteBatch");
+		using namespace render;
+
+		auto makeSprite = [](SpriteDrawMode drawMode, const math::Vector4 &sliceRect) {
+			SpriteInstance instance {};
+			instance.world = math::MakeIdentity4x4();
+			instance.uvTransform = math::MakeIdentity4x4();
+			instance.color = { 1.0f,1.0f,1.0f,1.0f };
+			instance.localRect = { 0.0f,0.0f,1.0f,1.0f };
+			instance.uvRect = { 0.0f,0.0f,1.0f,1.0f };
+			instance.drawMode = drawMode;
+			instance.sliceRect = sliceRect;
+			instance.sliceUvRect = { 0.25f,0.25f,0.25f,0.25f };
+			return instance;
+		};
+
+		// 上限を超える枚数のTiledは、上限で切っても全体を覆う(最後の四角形の右下が矩形の右下)
+		struct TiledCase
+		{
+			float x, y;
+			uint32_t quadCount;
+		};
+		const TiledCase tiledCases[] = {
+			{ 300.0f, 1.0f, kMaxSpriteQuadCount },
+			{ 1.0f, 300.0f, kMaxSpriteQuadCount },
+			{ 20.0f, 20.0f, 256 },
+			{ 2.5f, 1.0f, 3 },
+		};
+		for (const TiledCase &tiledCase : tiledCases) {
+			SpriteInstance instance = makeSprite(SpriteDrawMode::Tiled, { tiledCase.x, tiledCase.y, 0.0f, 0.0f });
+			uint32_t quadCount = GetSpriteQuadCount(instance);
+			checker.Expect(quadCount == tiledCase.quadCount, std::format("tiled {}x{} quad count = {} (expected {})", tiledCase.x, tiledCase.y, quadCount, tiledCase.quadCount));
+			std::vector<Sprite::VertexData> vertices(size_t(quadCount) * 4);
+			WriteSpriteVertices(instance, vertices.data());
+			// 四角形の頂点は 左下、左上、右下、右上 の順なので、最後から2つ目が右下
+			const math::Vector4 &bottomRight = vertices[vertices.size() - 2].position;
+			checker.ExpectNear(bottomRight.x, 1.0f, std::format("tiled {}x{} covers the right edge", tiledCase.x, tiledCase.y));
+			checker.ExpectNear(bottomRight.y, 1.0f, std::format("tiled {}x{} covers the bottom edge", tiledCase.x, tiledCase.y));
+		}
+
+		// NineSliceを上限数並べると四角形が入りきらない。入る分だけ描き、残りは描かずに数える
+		RenderPacket packet;
+		packet.spriteCamera.view = math::MakeIdentity4x4();
+		packet.spriteCamera.projection = math::MakeIdentity4x4();
+		packet.sprites.assign(SpriteBatchBuilder::kMaxSprites, makeSprite(SpriteDrawMode::NineSlice, { 0.25f,0.25f,0.25f,0.25f }));
+		SpriteBatchBuilder builder;
+		builder.Initialize();
+		std::vector<Sprite::VertexData> vertices(SpriteBatchBuilder::kVertexBufferSize / sizeof(Sprite::VertexData));
+		std::vector<uint8_t> constants(SpriteBatchBuilder::kConstantBufferSize);
+		SpriteBatchPipeline pipeline;
+		pipeline.rootSignatureId = SpriteBatchBuilder::kFirstPipelineObjectId;
+		pipeline.pipelineStateId = SpriteBatchBuilder::kFirstPipelineObjectId + 1;
+		pipeline.slotCount = 3;
+		pipeline.slots = { 0, 1, 2, RootSignatureLayout::kNoSlot };
+		NullCommandBackend backend;
+		builder.Build(packet, vertices.data(), constants.data(), backend, pipeline, pipeline);
+		const SpriteBatchBuilder::Statistics &statistics = builder.GetStatistics();
+		constexpr uint32_t kDrawnCount = SpriteBatchBuilder::kMaxQuads / 9;
+		constexpr uint32_t kDroppedCount = SpriteBatchBuilder::kMaxSprites - kDrawnCount;
+		checker.Expect(statistics.drawCount == kDrawnCount, std::format("nine-slice sprites drawn = {} (expected {})", statistics.drawCount, kDrawnCount));
+		checker.Expect(statistics.droppedSpriteCount == kDroppedCount, std::format("nine-slice sprites dropped = {} (expected {})", statistics.droppedSpriteCount, kDroppedCount));
+		checker.Expect(statistics.droppedQuadCount == kDroppedCount * 9, std::format("nine-slice quads dropped = {} (expected {})", statistics.droppedQuadCount, kDroppedCount * 9));
+		checker.Expect(backend.GetInvalidCommandCount() == 0, std::format("batch commands are valid ({} invalid)", backend.GetInvalidCommandCount()));
+
+		return checker.Finish();
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <ostream>
+
+// 動作確認
+// D3Dを使わない処理の結果を、手で求めた既知の値と比べる
+// コマンドライン引数 -selfcheck で起動したとき、またはtools/HeadlessMain.cppの check で実行し、結果をログに出す
+namespace SelfCheck
+{
+	// 全ての確認を実行し、全て通ったかを返す
+	bool RunAll(std::ostream &os);
+
+	// スケルタルアニメーション(2キーのクリップのサンプリング・nlerp・ブレンドと、スキニングした頂点・法線)
+	bool CheckSkeletalAnimation(std::ostream &os);
+
+	// ソフトウェアオクルージョンカリング(壁の奥・手前・脇の箱の判定と、スカラー・SIMD・ジョブで深度バッファと判定が一致するか)
+	bool CheckOcclusionCulling(std::ostream &os);
+
+	// シェーダーの変種のキー(使わない機能のビットを落とすか、ハッシュが固定の値か、定義と名前)
+	bool CheckShaderPermutation(std::ostream &os);
+
+	// シーンの保存・読み込み(番号に穴のあるワールドの往復、壊れたエンティティ番号のファイルを読まないか、差分保存が途中で止まっても前回の内容が読めるか)
+	bool CheckSceneSerializer(std::ostream &os);
+
+	// スプライトのバッチ(上限で切ったTiledが全体を覆うか、四角形が入りきらないスプライトを描かずに数えるか)
+	bool CheckSpriteBatch(std::ostream &os);
+}
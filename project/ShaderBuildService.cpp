@@ -0,0 +1,103 @@
+#include "ShaderBuildService.h"
+#include "ShaderCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+void ShaderBuildService::AddTask(std::vector<render::ShaderPermutationKey> shaders, TaskFunction function)
+{
+	assert(function);
+	tasks_.push_back({ std::move(shaders), std::move(function) });
+}
+
+void ShaderBuildService::Run(ShaderCache &cache, uint32_t threadCount)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	//----依存関係を組み立てる----
+
+	// 変種の重複を除き、タスクのシェーダーを変種の番号に置き換える
+	std::vector<render::ShaderPermutationKey> shaders;
+	std::unordered_map<render::ShaderPermutationKey, uint32_t, render::ShaderPermutationKeyHash> shaderIndices;
+	std::vector<std::vector<uint32_t>> taskShaders(tasks_.size());
+	for (size_t task = 0; task < tasks_.size(); ++task) {
+		for (const render::ShaderPermutationKey &key : tasks_[task].shaders) {
+			auto result = shaderIndices.emplace(key, static_cast<uint32_t>(shaders.size()));
+			if (result.second) {
+				shaders.push_back(key);
+			}
+			taskShaders[task].push_back(result.first->second);
+		}
+	}
+
+	// 変種ごとに、それを待っているタスク(同じタスクは1回だけ)
+	std::vector<std::vector<uint32_t>> dependents(shaders.size());
+	// タスクごとの、まだそろっていないシェーダーの数
+	std::unique_ptr<std::atomic<uint32_t>[]> pendingCounts = std::make_unique<std::atomic<uint32_t>[]>(tasks_.size());
+	for (size_t task = 0; task < tasks_.size(); ++task) {
+		std::vector<uint32_t> unique = taskShaders[task];
+		std::sort(unique.begin(), unique.end());
+		unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+		for (uint32_t shader : unique) {
+			dependents[shader].push_back(static_cast<uint32_t>(task));
+		}
+		pendingCounts[task].store(static_cast<uint32_t>(unique.size()), std::memory_order_relaxed);
+	}
+
+	//----コンパイルしながら、そろったタスクを実行する----
+
+	// バイナリはRunが終わるまでここで持つ(途中でキャッシュがClearされてもタスクに渡すポインタは消えない)
+	std::vector<Microsoft::WRL::ComPtr<IDxcBlob>> blobs(shaders.size());
+	auto runTask = [&](uint32_t task) {
+		std::vector<IDxcBlob *> taskBlobs;
+		taskBlobs.reserve(taskShaders[task].size());
+		for (uint32_t shader : taskShaders[task]) {
+			taskBlobs.push_back(blobs[shader].Get());
+		}
+		tasks_[task].function(taskBlobs);
+	};
+
+	// シェーダーに依存しないタスクはすぐに実行する
+	for (size_t task = 0; task < tasks_.size(); ++task) {
+		if (taskShaders[task].empty()) {
+			runTask(static_cast<uint32_t>(task));
+		}
+	}
+
+	// 各スレッドは次の変種を取ってコンパイルし、最後の依存を満たしたタスクを実行する
+	// (カウンタの減算がacq_relなので、他のスレッドが書いたblobsも見える)
+	std::atomic<uint32_t> nextShader = 0;
+	auto worker = [&]() {
+		for (uint32_t shader = nextShader.fetch_add(1); shader < shaders.size(); shader = nextShader.fetch_add(1)) {
+			blobs[shader] = cache.GetShader(shaders[shader]);
+			for (uint32_t task : dependents[shader]) {
+				if (pendingCounts[task].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					runTask(task);
+				}
+			}
+		}
+	};
+
+	// 起動時に一度だけなので、ジョブシステムではなく専用のスレッドを立てる(スレッド数を指定して計測できるように)
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threadCount = std::min(threadCount, std::max(1u, static_cast<uint32_t>(shaders.size())));
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (uint32_t i = 1; i < threadCount; ++i) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	tasks_.clear();
+	lastShaderCount_ = static_cast<uint32_t>(shaders.size());
+	lastMilliseconds_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
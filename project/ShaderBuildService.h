@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include <dxcapi.h>
+#include "ShaderPermutation.h"
+
+class ShaderCache;
+
+// 起動時のシェーダーのビルド
+// 必要な変種を重複を除いて並べ、複数のスレッドで並列にコンパイルする(コンパイラはスレッドごとに別のインスタンス)
+// PSOの生成などのタスクは依存するシェーダーを登録しておき、最後の1つがコンパイルされた時点で
+// そのシェーダーをコンパイルしたスレッドが実行するので、他のシェーダーのコンパイルと重なって進む
+class ShaderBuildService
+{
+public:
+	// タスクの処理。shadersはAddTaskで渡した順のコンパイル済みバイナリ(Runが終わるまで有効。残すならAddRefする)
+	using TaskFunction = std::function<void(std::span<IDxcBlob *const> shaders)>;
+
+public: // メンバ関数
+	/// <summary>
+	/// タスクを追加する
+	/// </summary>
+	/// <param name="shaders">タスクが依存するシェーダーの変種</param>
+	/// <param name="function">依存するシェーダーが全てそろったら呼ばれる(どのスレッドから呼ばれるかは決まらない)</param>
+	void AddTask(std::vector<render::ShaderPermutationKey> shaders, TaskFunction function);
+
+	/// <summary>
+	/// 登録したタスクを全て実行する。終わるまで戻らず、実行したタスクは取り除く
+	/// </summary>
+	/// <param name="threadCount">コンパイルするスレッドの数(呼び出したスレッドを含む。0ならCPUのスレッド数)</param>
+	void Run(ShaderCache &cache, uint32_t threadCount = 0);
+
+	// 直前のRunにかかった時間(ミリ秒)と、コンパイルした変種の数(重複を除く)
+	double GetLastMilliseconds() const { return lastMilliseconds_; }
+	uint32_t GetLastShaderCount() const { return lastShaderCount_; }
+
+private:
+	struct Task
+	{
+		std::vector<render::ShaderPermutationKey> shaders;
+		TaskFunction function;
+	};
+
+	std::vector<Task> tasks_;
+	double lastMilliseconds_ = 0.0;
+	uint32_t lastShaderCount_ = 0;
+};
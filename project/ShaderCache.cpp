@@ -0,0 +1,77 @@
+#include "ShaderCache.h"
+#include "StringUtility.h"
+#include <cassert>
+
+Microsoft::WRL::ComPtr<IDxcBlob> ShaderCache::GetShader(const render::ShaderPermutationKey &key)
+{
+	return GetEntry(key)->shader;
+}
+
+std::vector<render::ShaderResourceBinding> ShaderCache::GetBindings(const render::ShaderPermutationKey &key)
+{
+	return GetEntry(key)->bindings;
+}
+
+std::shared_ptr<const ShaderCache::Entry> ShaderCache::GetEntry(const render::ShaderPermutationKey &key)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = shaders_.find(key);
+		if (it != shaders_.end()) {
+			return it->second;
+		}
+	}
+
+	// 初めての変種なのでコンパイルする(ロックは外し、他の変種のコンパイルを止めない)
+	std::vector<std::wstring> defines;
+	for (const std::string &define : render::GetPermutationDefines(key)) {
+		defines.push_back(StringUtility::ConvertString(define));
+	}
+	std::unique_ptr<ShaderCompiler> compiler = AcquireCompiler();
+	std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+	entry->shader = compiler->Compile(
+		StringUtility::ConvertString(key.filePath), StringUtility::ConvertString(key.profile).c_str(), defines);
+	assert(entry->shader != nullptr);
+	entry->bindings = compiler->Reflect(entry->shader.Get(), render::GetShaderStage(key.profile));
+	ReleaseCompiler(std::move(compiler));
+
+	// 同じ変種を別のスレッドが先に登録していればそちらを使う(呼び出し側に返したバイナリを差し替えない)
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto result = shaders_.emplace(key, std::move(entry));
+	return result.first->second;
+}
+
+size_t ShaderCache::GetShaderCount()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return shaders_.size();
+}
+
+void ShaderCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	shaders_.clear();
+}
+
+std::unique_ptr<ShaderCompiler> ShaderCache::AcquireCompiler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!idleCompilers_.empty()) {
+			std::unique_ptr<ShaderCompiler> compiler = std::move(idleCompilers_.back());
+			idleCompilers_.pop_back();
+			return compiler;
+		}
+	}
+
+	// 全て使用中なので新しく作る(DXCのインスタンスはスレッド間で共有しない)
+	std::unique_ptr<ShaderCompiler> compiler = std::make_unique<ShaderCompiler>();
+	compiler->Initialize();
+	return compiler;
+}
+
+void ShaderCache::ReleaseCompiler(std::unique_ptr<ShaderCompiler> compiler)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	idleCompilers_.push_back(std::move(compiler));
+}
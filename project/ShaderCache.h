@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <wrl.h>
+#include <dxcapi.h>
+#include "ShaderCompiler.h"
+#include "RootSignatureLayout.h"
+#include "ShaderPermutation.h"
+
+// コンパイル済みシェーダー変種のキャッシュ
+// 要求された変種を初回だけコンパイルし、以降は同じバイナリを返す(描画スレッドや複数のスレッドから同時に呼べる)
+// コンパイル中はロックを外し、スレッドごとに空いているコンパイラを貸し出すので、別々の変種は並列にコンパイルされる
+// 返すバイナリと束縛は呼び出し側が所有を分け持つので、Clearの後も使える
+class ShaderCache
+{
+public: // メンバ関数
+	// 変種を取得する(無ければコンパイルする)
+	Microsoft::WRL::ComPtr<IDxcBlob> GetShader(const render::ShaderPermutationKey &key);
+
+	// 変種が使うリソースの束縛(リフレクションの結果。無ければコンパイルする)
+	std::vector<render::ShaderResourceBinding> GetBindings(const render::ShaderPermutationKey &key);
+
+	// キャッシュしている変種の数
+	size_t GetShaderCount();
+
+	// 全て破棄する(シェーダーファイルを書き換えた後など。取得済みのバイナリは取得した側が持ち続ける)
+	void Clear();
+
+private:
+	// コンパイル済みの変種
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<IDxcBlob> shader;
+		std::vector<render::ShaderResourceBinding> bindings;
+	};
+
+	// 変種を取得する(無ければコンパイルしてリフレクションも取る。Clearと重なっても消えないよう共有で返す)
+	std::shared_ptr<const Entry> GetEntry(const render::ShaderPermutationKey &key);
+	// 空いているコンパイラを借りる(無ければ作る)
+	std::unique_ptr<ShaderCompiler> AcquireCompiler();
+	// 使い終わったコンパイラを返す
+	void ReleaseCompiler(std::unique_ptr<ShaderCompiler> compiler);
+
+	std::unordered_map<render::ShaderPermutationKey, std::shared_ptr<const Entry>, render::ShaderPermutationKeyHash> shaders_;
+	// 空いているコンパイラ(同時にコンパイルしたスレッドの数まで増える)
+	std::vector<std::unique_ptr<ShaderCompiler>> idleCompilers_;
+	std::mutex mutex_;
+};
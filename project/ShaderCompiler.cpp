@@ -0,0 +1,136 @@
+#include "ShaderCompiler.h"
+#include <d3d12shader.h>
+#include <cassert>
+
+void ShaderCompiler::Initialize()
+{
+	HRESULT hr;
+
+	hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils_));
+	assert(SUCCEEDED(hr));
+	hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler_));
+	assert(SUCCEEDED(hr));
+
+	hr = dxcUtils_->CreateDefaultIncludeHandler(&includeHandler_);
+	assert(SUCCEEDED(hr));
+}
+
+Microsoft::WRL::ComPtr<IDxcBlob> ShaderCompiler::Compile(const std::wstring &filePath, const wchar_t *profile, const std::vector<std::wstring> &defines)
+{
+	//----hlslファイルを読み込む----
+
+	// これからシェーダーをコンパイルする旨をログに出す
+	//Log(os, ConvertString(std::format(L"Begin CompileShader, path:{}, profile:{}\n", filePath, profile)));
+	// hlslファイルを読む
+	IDxcBlobEncoding *shaderSource = nullptr;
+	HRESULT hr = dxcUtils_->LoadFile(filePath.c_str(), nullptr, &shaderSource);
+	// 読めなかったら止める
+	assert(SUCCEEDED(hr));
+	// 読み込んだファイルの内容を設定する
+	DxcBuffer shaderSourceBuffer;
+	shaderSourceBuffer.Ptr = shaderSource->GetBufferPointer();
+	shaderSourceBuffer.Size = shaderSource->GetBufferSize();
+	shaderSourceBuffer.Encoding = DXC_CP_UTF8; // UTF8の文字コードであることを通知
+
+	//----Compileする----
+
+	std::vector<LPCWSTR> arguments = {
+		filePath.c_str(), // コンパイル対象のhlslファイル名
+		L"-E",L"main", // エントリーポイントの指定。基本的にmain以外にはしない
+		L"-T",profile, // ShaderProfileの設定
+		L"-Zi",L"-Qembed_debug", // デバック用の情報を埋め込む
+		L"-Od",    // 最適化を外しておく
+		L"-Zpr",   // メモリレイアウトは行優先
+	};
+	// 変種を切り替える定義
+	for (const std::wstring &define : defines) {
+		arguments.push_back(L"-D");
+		arguments.push_back(define.c_str());
+	}
+	// 実際にShaderをコンパイルする
+	IDxcResult *shaderResult = nullptr;
+	hr = dxcCompiler_->Compile(
+		&shaderSourceBuffer,    // 読み込んだファイル
+		arguments.data(),       // コンパイルオプション
+		static_cast<UINT32>(arguments.size()), // コンパイルオプションの数
+		includeHandler_.Get(),         // includeが含まれた諸々
+		IID_PPV_ARGS(&shaderResult) // コンパイル結果
+	);
+	// コンパイルエラーではなくdxcが起動できないなど致命的な状況
+	assert(SUCCEEDED(hr));
+
+	//----警告・エラーがでていないか確認----
+
+	// 警告・エラーが出てたらログに出して止める
+	Microsoft::WRL::ComPtr<IDxcBlobUtf8> shaderError = nullptr;
+	shaderResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&shaderError), nullptr);
+	if (shaderError != nullptr && shaderError->GetStringLength() != 0) {
+		//Log(os, shaderError->GetStringPointer());
+		// 警告・エラーダメゼッタイ
+		assert(false);
+	}
+
+	//----Compile結果を受け取って返す----
+
+	// コンパイル結果から実行用のバイナリ部分を取得
+	Microsoft::WRL::ComPtr<IDxcBlob> shaderBlob = nullptr;
+	hr = shaderResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shaderBlob), nullptr);
+	assert(SUCCEEDED(hr));
+	// 成功したログを出す
+	//Log(os, ConvertString(std::format(L"Compile Succeeded, path:{}, profile:{}\n", filePath, profile)));
+	// もう使わないリソースを解放
+	shaderSource->Release();
+	shaderResult->Release();
+	// 実行用のバイナリを返却
+	return shaderBlob;
+}
+
+std::vector<render::ShaderResourceBinding> ShaderCompiler::Reflect(IDxcBlob *shader, render::ShaderStage stage)
+{
+	// コンパイル結果に含まれるリフレクション情報を読む
+	DxcBuffer shaderBuffer;
+	shaderBuffer.Ptr = shader->GetBufferPointer();
+	shaderBuffer.Size = shader->GetBufferSize();
+	shaderBuffer.Encoding = 0;
+	Microsoft::WRL::ComPtr<ID3D12ShaderReflection> reflection = nullptr;
+	HRESULT hr = dxcUtils_->CreateReflection(&shaderBuffer, IID_PPV_ARGS(&reflection));
+	assert(SUCCEEDED(hr));
+
+	D3D12_SHADER_DESC shaderDesc {};
+	hr = reflection->GetDesc(&shaderDesc);
+	assert(SUCCEEDED(hr));
+
+	// 使われていないリソースはコンパイラが取り除くので、変種ごとに必要な物だけが並ぶ
+	std::vector<render::ShaderResourceBinding> bindings;
+	for (UINT i = 0; i < shaderDesc.BoundResources; ++i) {
+		D3D12_SHADER_INPUT_BIND_DESC bindDesc {};
+		hr = reflection->GetResourceBindingDesc(i, &bindDesc);
+		assert(SUCCEEDED(hr));
+
+		render::ShaderResourceBinding binding;
+		binding.name = bindDesc.Name;
+		binding.registerIndex = bindDesc.BindPoint;
+		binding.space = bindDesc.Space;
+		binding.count = bindDesc.BindCount;
+		binding.stage = stage;
+		switch (bindDesc.Type) {
+		case D3D_SIT_CBUFFER:
+			binding.type = render::ShaderResourceType::ConstantBuffer;
+			break;
+		case D3D_SIT_TEXTURE:
+		case D3D_SIT_STRUCTURED:
+		case D3D_SIT_BYTEADDRESS:
+			binding.type = render::ShaderResourceType::ShaderResource;
+			break;
+		case D3D_SIT_SAMPLER:
+			binding.type = render::ShaderResourceType::Sampler;
+			break;
+		default:
+			// UAVなどはまだ使っていない
+			assert(false);
+			continue;
+		}
+		bindings.push_back(std::move(binding));
+	}
+	return bindings;
+}
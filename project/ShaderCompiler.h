@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <wrl.h>
+#include <dxcapi.h>
+#include "RootSignatureLayout.h"
+
+// HLSLのコンパイラ
+// DXCのインスタンスはスレッド間で共有できないので、同時にコンパイルするスレッドはそれぞれ別のShaderCompilerを使う
+class ShaderCompiler
+{
+public: // メンバ関数
+	// 初期化(DXCのインスタンスを作る)
+	void Initialize();
+
+	/// <summary>
+	/// シェーダーをコンパイルする(警告・エラーが出たら止める)
+	/// </summary>
+	/// <param name="defines">"USE_LIGHTING=1" などの定義</param>
+	Microsoft::WRL::ComPtr<IDxcBlob> Compile(const std::wstring &filePath, const wchar_t *profile, const std::vector<std::wstring> &defines = {});
+
+	// コンパイル済みのシェーダーのリフレクションから、使っているリソースの束縛を取り出す
+	std::vector<render::ShaderResourceBinding> Reflect(IDxcBlob *shader, render::ShaderStage stage);
+
+private:
+	Microsoft::WRL::ComPtr<IDxcUtils> dxcUtils_ = nullptr;
+	Microsoft::WRL::ComPtr<IDxcCompiler3> dxcCompiler_ = nullptr;
+	// 現時点でincludeはしないが、includeに対応するための設定を行っておく
+	Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler_ = nullptr;
+};
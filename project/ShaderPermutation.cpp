@@ -0,0 +1,83 @@
+#include "ShaderPermutation.h"
+#include <cassert>
+
+namespace render
+{
+	namespace
+	{
+		constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+		constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+		uint64_t HashBytes(uint64_t hash, const void *data, size_t size)
+		{
+			const uint8_t *bytes = static_cast<const uint8_t *>(data);
+			for (size_t i = 0; i < size; ++i) {
+				hash ^= bytes[i];
+				hash *= kFnvPrime;
+			}
+			return hash;
+		}
+
+		uint64_t HashString(uint64_t hash, const std::string &text)
+		{
+			hash = HashBytes(hash, text.data(), text.size());
+			// 文字列の区切り("ab" + "c" と "a" + "bc" を別の値にする)
+			const uint8_t separator = 0;
+			return HashBytes(hash, &separator, 1);
+		}
+	}
+
+	const char *GetFeatureDefine(ShaderFeature feature)
+	{
+		switch (feature) {
+		case ShaderFeature::Lighting: return "USE_LIGHTING";
+		case ShaderFeature::Texture: return "USE_TEXTURE";
+		case ShaderFeature::VertexColor: return "USE_VERTEX_COLOR";
+		default:
+			assert(false);
+			return "";
+		}
+	}
+
+	uint64_t ShaderPermutationKey::GetHash() const
+	{
+		uint64_t hash = kFnvOffsetBasis;
+		hash = HashString(hash, filePath);
+		hash = HashString(hash, profile);
+		// エンディアンに依らないよう1バイトずつ混ぜる
+		for (uint32_t shift = 0; shift < 32; shift += 8) {
+			const uint8_t byte = static_cast<uint8_t>(features >> shift);
+			hash = HashBytes(hash, &byte, 1);
+		}
+		return hash;
+	}
+
+	ShaderPermutationKey MakePermutationKey(const std::string &filePath, const std::string &profile,
+		ShaderFeatureMask features, ShaderFeatureMask supportedFeatures)
+	{
+		assert((features & ~kAllShaderFeatures) == 0);
+		return { filePath, profile, features & supportedFeatures };
+	}
+
+	std::vector<std::string> GetPermutationDefines(const ShaderPermutationKey &key)
+	{
+		std::vector<std::string> defines;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(ShaderFeature::Count); ++i) {
+			ShaderFeature feature = static_cast<ShaderFeature>(i);
+			defines.push_back(std::string(GetFeatureDefine(feature)) + (HasFeature(key.features, feature) ? "=1" : "=0"));
+		}
+		return defines;
+	}
+
+	std::string GetPermutationName(const ShaderPermutationKey &key)
+	{
+		std::string name = key.filePath.substr(key.filePath.find_last_of("/\\") + 1) + "[" + key.profile;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(ShaderFeature::Count); ++i) {
+			ShaderFeature feature = static_cast<ShaderFeature>(i);
+			if (HasFeature(key.features, feature)) {
+				name += std::string("|") + GetFeatureDefine(feature);
+			}
+		}
+		return name + "]";
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// シェーダーの変種(パーミュテーション)
+// ライティングやテクスチャなどの機能をコンパイル時の定義で切り替え、シェーダー内の動的な分岐をなくす
+// 変種はシェーダーのパス・プロファイル・機能の組(キー)で区別する。ここはD3Dに依存しないので単体で確かめられる
+namespace render
+{
+	// シェーダーの機能(ビット番号)
+	enum class ShaderFeature : uint32_t
+	{
+		Lighting, //!< USE_LIGHTING: 平行光源のハーフランバート
+		Texture, //!< USE_TEXTURE: テクスチャを貼る(無ければ白)
+		VertexColor, //!< USE_VERTEX_COLOR: 頂点カラーを掛ける(入力レイアウトにCOLORが増える)
+		Count,
+	};
+
+	// 機能の組み合わせ(ShaderFeatureのビットの集まり)
+	using ShaderFeatureMask = uint32_t;
+
+	constexpr ShaderFeatureMask ToMask(ShaderFeature feature)
+	{
+		return 1u << static_cast<uint32_t>(feature);
+	}
+	constexpr bool HasFeature(ShaderFeatureMask mask, ShaderFeature feature)
+	{
+		return (mask & ToMask(feature)) != 0;
+	}
+	// 全ての機能
+	constexpr ShaderFeatureMask kAllShaderFeatures = (1u << static_cast<uint32_t>(ShaderFeature::Count)) - 1;
+
+	// 機能を切り替える定義名(USE_LIGHTING など)
+	const char *GetFeatureDefine(ShaderFeature feature);
+
+	// 変種のキー
+	struct ShaderPermutationKey
+	{
+		std::string filePath;
+		std::string profile;
+		ShaderFeatureMask features = 0;
+
+		bool operator==(const ShaderPermutationKey &other) const
+		{
+			return features == other.features && filePath == other.filePath && profile == other.profile;
+		}
+
+		// キーのハッシュ値(FNV-1a。実行ごと・環境ごとに同じ値になる)
+		uint64_t GetHash() const;
+	};
+
+	// unordered_map用
+	struct ShaderPermutationKeyHash
+	{
+		size_t operator()(const ShaderPermutationKey &key) const { return static_cast<size_t>(key.GetHash()); }
+	};
+
+	/// <summary>
+	/// キーを作る。シェーダーが使わない機能のビットは落とすので、同じ結果になる変種は1つにまとまる
+	/// </summary>
+	/// <param name="supportedFeatures">シェーダーが参照する機能</param>
+	ShaderPermutationKey MakePermutationKey(const std::string &filePath, const std::string &profile,
+		ShaderFeatureMask features, ShaderFeatureMask supportedFeatures = kAllShaderFeatures);
+
+	// コンパイラに渡す定義("USE_LIGHTING=1" など)。無効な機能も0として全て定義する
+	std::vector<std::string> GetPermutationDefines(const ShaderPermutationKey &key);
+
+	// ログ用の変種名("Object3d.PS.hlsl[ps_6_0|USE_LIGHTING|USE_TEXTURE]" など)
+	std::string GetPermutationName(const ShaderPermutationKey &key);
+}
@@ -0,0 +1,332 @@
+#include "SkeletalAnimation.h"
+#include "FrameArena.h"
+#include "MathFunctions.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ANIMATION_SSE2
+#endif
+
+namespace animation
+{
+	namespace
+	{
+		/// <summary>
+		/// 時刻を挟むキーを探す。キャッシュしたキーか次のキーで済めば探索しない
+		/// </summary>
+		/// <param name="cursor">前回のキー位置(更新される)</param>
+		/// <returns>前のキーから次のキーへの補間係数</returns>
+		float FindKey(const std::vector<float> &times, float time, uint32_t &cursor)
+		{
+			uint32_t keyCount = static_cast<uint32_t>(times.size());
+			if (keyCount < 2 || time <= times.front()) {
+				cursor = 0;
+				return 0.0f;
+			}
+			if (time >= times.back()) {
+				cursor = keyCount - 2;
+				return 1.0f;
+			}
+
+			uint32_t key = (std::min)(cursor, keyCount - 2);
+			if (!(times[key] <= time && time < times[key + 1])) {
+				if (key + 2 < keyCount && times[key + 1] <= time && time < times[key + 2]) {
+					++key;
+				} else {
+					// 二分探索。time < times.back() なので key + 1 < keyCount になる
+					key = static_cast<uint32_t>(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+				}
+			}
+			cursor = key;
+			return (time - times[key]) / (times[key + 1] - times[key]);
+		}
+
+		// 成分ごとの配列を線形補間する(out = a + (b - a) * t)
+		// tがnullptrならweightを全要素に使う。outはaと同じ配列でもよい
+		void LerpSoA(uint32_t componentCount, const float *const *a, const float *const *b, const float *t, float weight, float *const *out, uint32_t count)
+		{
+			uint32_t i = 0;
+#ifdef ANIMATION_SSE2
+			const __m128 weights = _mm_set1_ps(weight);
+			for (; i + 4 <= count; i += 4) {
+				__m128 factor = t ? _mm_loadu_ps(t + i) : weights;
+				for (uint32_t c = 0; c < componentCount; ++c) {
+					__m128 from = _mm_loadu_ps(a[c] + i);
+					__m128 to = _mm_loadu_ps(b[c] + i);
+					_mm_storeu_ps(out[c] + i, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), factor)));
+				}
+			}
+#endif
+			for (; i < count; ++i) {
+				float factor = t ? t[i] : weight;
+				for (uint32_t c = 0; c < componentCount; ++c) {
+					out[c][i] = a[c][i] + (b[c][i] - a[c][i]) * factor;
+				}
+			}
+		}
+
+		// 成分ごとの配列のクォータニオンを正規化線形補間する(近い側を回るよう符号を揃える)
+		// tがnullptrならweightを全要素に使う。outはaと同じ配列でもよい
+		void NlerpSoA(const float *const *a, const float *const *b, const float *t, float weight, float *const *out, uint32_t count)
+		{
+			uint32_t i = 0;
+#ifdef ANIMATION_SSE2
+			const __m128 weights = _mm_set1_ps(weight);
+			const __m128 signBit = _mm_set1_ps(-0.0f);
+			for (; i + 4 <= count; i += 4) {
+				__m128 factor = t ? _mm_loadu_ps(t + i) : weights;
+				__m128 from[4];
+				__m128 to[4];
+				__m128 dot = _mm_setzero_ps();
+				for (uint32_t c = 0; c < 4; ++c) {
+					from[c] = _mm_loadu_ps(a[c] + i);
+					to[c] = _mm_loadu_ps(b[c] + i);
+					dot = _mm_add_ps(dot, _mm_mul_ps(from[c], to[c]));
+				}
+				// 内積が負なら補間先の符号を反転
+				__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit);
+
+				__m128 result[4];
+				__m128 lengthSquared = _mm_setzero_ps();
+				for (uint32_t c = 0; c < 4; ++c) {
+					__m128 target = _mm_xor_ps(to[c], flip);
+					result[c] = _mm_add_ps(from[c], _mm_mul_ps(_mm_sub_ps(target, from[c]), factor));
+					lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(result[c], result[c]));
+				}
+				__m128 length = _mm_sqrt_ps(lengthSquared);
+				for (uint32_t c = 0; c < 4; ++c) {
+					_mm_storeu_ps(out[c] + i, _mm_div_ps(result[c], length));
+				}
+			}
+#endif
+			for (; i < count; ++i) {
+				float factor = t ? t[i] : weight;
+				float dot = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+				float sign = dot < 0.0f ? -1.0f : 1.0f;
+				float result[4];
+				float lengthSquared = 0.0f;
+				for (uint32_t c = 0; c < 4; ++c) {
+					result[c] = a[c][i] + (b[c][i] * sign - a[c][i]) * factor;
+					lengthSquared += result[c] * result[c];
+				}
+				float length = std::sqrt(lengthSquared);
+				for (uint32_t c = 0; c < 4; ++c) {
+					out[c][i] = result[c] / length;
+				}
+			}
+		}
+
+		// トラック群をサンプリングして姿勢に書き込む
+		// 前後のキーをいったん成分ごとに集め、補間はまとめて行う
+		void SampleTracks(const std::vector<Track> &tracks, float time, std::vector<uint32_t> &cursors, uint32_t componentCount, std::vector<float> *poseValues)
+		{
+			uint32_t trackCount = static_cast<uint32_t>(tracks.size());
+			if (trackCount == 0) {
+				return;
+			}
+			assert(cursors.size() == trackCount);
+
+			// 前のキー、次のキー、補間係数の順に並べる(フレームアリーナから確保)
+			FrameVector<float> scratch(size_t(trackCount) * (componentCount * 2 + 1));
+			float *from[4] = {};
+			float *to[4] = {};
+			for (uint32_t c = 0; c < componentCount; ++c) {
+				from[c] = scratch.data() + size_t(c) * trackCount;
+				to[c] = scratch.data() + size_t(componentCount + c) * trackCount;
+			}
+			float *factors = scratch.data() + size_t(componentCount * 2) * trackCount;
+
+			for (uint32_t i = 0; i < trackCount; ++i) {
+				const Track &track = tracks[i];
+				assert(track.GetKeyCount() > 0);
+				factors[i] = FindKey(track.times, time, cursors[i]);
+				uint32_t key = cursors[i];
+				uint32_t next = (std::min)(key + 1, track.GetKeyCount() - 1);
+				for (uint32_t c = 0; c < componentCount; ++c) {
+					from[c][i] = track.values[c][key];
+					to[c][i] = track.values[c][next];
+				}
+			}
+
+			// 補間結果は前のキーの配列に上書きする
+			if (componentCount == 4) {
+				NlerpSoA(from, to, factors, 0.0f, from, trackCount);
+			} else {
+				LerpSoA(componentCount, from, to, factors, 0.0f, from, trackCount);
+			}
+
+			for (uint32_t i = 0; i < trackCount; ++i) {
+				uint32_t joint = tracks[i].joint;
+				for (uint32_t c = 0; c < componentCount; ++c) {
+					poseValues[c][joint] = from[c][i];
+				}
+			}
+		}
+
+		// 成分ごとの配列の先頭ポインタを集める
+		template <size_t N>
+		void GetPointers(const std::vector<float>(&values)[N], const float *(&pointers)[N])
+		{
+			for (size_t c = 0; c < N; ++c) {
+				pointers[c] = values[c].data();
+			}
+		}
+		template <size_t N>
+		void GetPointers(std::vector<float>(&values)[N], float *(&pointers)[N])
+		{
+			for (size_t c = 0; c < N; ++c) {
+				pointers[c] = values[c].data();
+			}
+		}
+	}
+
+#pragma region Pose
+
+	void Pose::Resize(uint32_t jointCount)
+	{
+		for (uint32_t c = 0; c < 3; ++c) {
+			translation[c].resize(jointCount, 0.0f);
+			scale[c].resize(jointCount, 1.0f);
+		}
+		for (uint32_t c = 0; c < 3; ++c) {
+			rotation[c].resize(jointCount, 0.0f);
+		}
+		rotation[3].resize(jointCount, 1.0f);
+	}
+
+	void Pose::SetTranslation(uint32_t joint, const math::Vector3 &value)
+	{
+		translation[0][joint] = value.x;
+		translation[1][joint] = value.y;
+		translation[2][joint] = value.z;
+	}
+
+	void Pose::SetRotation(uint32_t joint, const math::Quaternion &value)
+	{
+		rotation[0][joint] = value.x;
+		rotation[1][joint] = value.y;
+		rotation[2][joint] = value.z;
+		rotation[3][joint] = value.w;
+	}
+
+	void Pose::SetScale(uint32_t joint, const math::Vector3 &value)
+	{
+		scale[0][joint] = value.x;
+		scale[1][joint] = value.y;
+		scale[2][joint] = value.z;
+	}
+
+#pragma endregion
+
+	void ClipCursor::Reset(const AnimationClip &clip)
+	{
+		translations.assign(clip.translations.size(), 0);
+		rotations.assign(clip.rotations.size(), 0);
+		scales.assign(clip.scales.size(), 0);
+	}
+
+	void SampleClip(const AnimationClip &clip, float time, ClipCursor &cursor, Pose &pose)
+	{
+		SampleTracks(clip.translations, time, cursor.translations, 3, pose.translation);
+		SampleTracks(clip.rotations, time, cursor.rotations, 4, pose.rotation);
+		SampleTracks(clip.scales, time, cursor.scales, 3, pose.scale);
+	}
+
+	void BlendPoses(const Pose &a, const Pose &b, float weight, Pose &out)
+	{
+		assert(a.GetJointCount() == b.GetJointCount());
+		uint32_t jointCount = a.GetJointCount();
+		out.Resize(jointCount);
+
+		const float *fromTranslation[3];
+		const float *toTranslation[3];
+		float *outTranslation[3];
+		GetPointers(a.translation, fromTranslation);
+		GetPointers(b.translation, toTranslation);
+		GetPointers(out.translation, outTranslation);
+		LerpSoA(3, fromTranslation, toTranslation, nullptr, weight, outTranslation, jointCount);
+
+		const float *fromRotation[4];
+		const float *toRotation[4];
+		float *outRotation[4];
+		GetPointers(a.rotation, fromRotation);
+		GetPointers(b.rotation, toRotation);
+		GetPointers(out.rotation, outRotation);
+		NlerpSoA(fromRotation, toRotation, nullptr, weight, outRotation, jointCount);
+
+		const float *fromScale[3];
+		const float *toScale[3];
+		float *outScale[3];
+		GetPointers(a.scale, fromScale);
+		GetPointers(b.scale, toScale);
+		GetPointers(out.scale, outScale);
+		LerpSoA(3, fromScale, toScale, nullptr, weight, outScale, jointCount);
+	}
+
+	void ComputeModelMatrices(const Skeleton &skeleton, const Pose &pose, std::vector<math::Matrix4x4> &modelMatrices)
+	{
+		uint32_t jointCount = skeleton.GetJointCount();
+		assert(pose.GetJointCount() == jointCount);
+		modelMatrices.resize(jointCount);
+
+		// 親が先に並んでいるので前から順に親の行列を掛ければよい
+		for (uint32_t joint = 0; joint < jointCount; ++joint) {
+			math::Matrix4x4 local = math::MakeAffineMatrix(pose.GetScale(joint), pose.GetRotation(joint), pose.GetTranslation(joint));
+			int32_t parent = skeleton.parents[joint];
+			assert(parent < static_cast<int32_t>(joint));
+			modelMatrices[joint] = parent < 0 ? local : math::Multiply(local, modelMatrices[parent]);
+		}
+	}
+
+	void ComputeSkinMatrices(const Skeleton &skeleton, const std::vector<math::Matrix4x4> &modelMatrices, std::vector<math::Matrix4x4> &skinMatrices)
+	{
+		uint32_t jointCount = skeleton.GetJointCount();
+		assert(modelMatrices.size() == jointCount);
+		skinMatrices.resize(jointCount);
+		for (uint32_t joint = 0; joint < jointCount; ++joint) {
+			skinMatrices[joint] = math::Multiply(skeleton.inverseBindMatrices[joint], modelMatrices[joint]);
+		}
+	}
+
+	void SkinVertices(const std::vector<SkinnedVertex> &vertices, const std::vector<math::Matrix4x4> &skinMatrices,
+		std::vector<math::Vector4> &positions, std::vector<math::Vector3> &normals)
+	{
+		positions.resize(vertices.size());
+		normals.resize(vertices.size());
+
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const SkinnedVertex &vertex = vertices[i];
+			math::Vector4 position = { 0.0f,0.0f,0.0f,0.0f };
+			math::Vector3 normal = { 0.0f,0.0f,0.0f };
+
+			for (uint32_t influence = 0; influence < 4; ++influence) {
+				float weight = vertex.weights[influence];
+				if (weight == 0.0f) {
+					continue;
+				}
+				assert(vertex.joints[influence] < skinMatrices.size());
+				const math::Matrix4x4 &m = skinMatrices[vertex.joints[influence]];
+				const math::Vector4 &p = vertex.position;
+				const math::Vector3 &n = vertex.normal;
+				position.x += weight * (p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + p.w * m.m[3][0]);
+				position.y += weight * (p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + p.w * m.m[3][1]);
+				position.z += weight * (p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + p.w * m.m[3][2]);
+				position.w += weight * (p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + p.w * m.m[3][3]);
+				// 法線は平行移動を含めない
+				normal.x += weight * (n.x * m.m[0][0] + n.y * m.m[1][0] + n.z * m.m[2][0]);
+				normal.y += weight * (n.x * m.m[0][1] + n.y * m.m[1][1] + n.z * m.m[2][1]);
+				normal.z += weight * (n.x * m.m[0][2] + n.y * m.m[1][2] + n.z * m.m[2][2]);
+			}
+
+			float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+			if (length > 0.0f) {
+				normal = { normal.x / length, normal.y / length, normal.z / length };
+			}
+			positions[i] = position;
+			normals[i] = normal;
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MathTypes.h"
+
+// スケルタルアニメーション
+// キーフレームと姿勢は成分ごとの配列(SoA)で持ち、補間をSIMDでまとめて行う
+namespace animation
+{
+	// 関節ごとのローカル姿勢(平行移動・回転・拡大率を成分ごとの配列で持つ)
+	struct Pose
+	{
+		std::vector<float> translation[3];
+		std::vector<float> rotation[4];
+		std::vector<float> scale[3];
+
+		// 関節数を変える(追加分は単位姿勢)
+		void Resize(uint32_t jointCount);
+		uint32_t GetJointCount() const { return static_cast<uint32_t>(rotation[0].size()); }
+
+		// 1関節分の値
+		math::Vector3 GetTranslation(uint32_t joint) const { return { translation[0][joint], translation[1][joint], translation[2][joint] }; }
+		math::Quaternion GetRotation(uint32_t joint) const { return { rotation[0][joint], rotation[1][joint], rotation[2][joint], rotation[3][joint] }; }
+		math::Vector3 GetScale(uint32_t joint) const { return { scale[0][joint], scale[1][joint], scale[2][joint] }; }
+		void SetTranslation(uint32_t joint, const math::Vector3 &value);
+		void SetRotation(uint32_t joint, const math::Quaternion &value);
+		void SetScale(uint32_t joint, const math::Vector3 &value);
+	};
+
+	// スケルトン
+	struct Skeleton
+	{
+		std::vector<std::string> jointNames;
+		// 親の関節番号(ルートは-1)。親は必ず子より前に並べる
+		std::vector<int32_t> parents;
+		// バインドポーズのモデル空間 → 関節空間
+		std::vector<math::Matrix4x4> inverseBindMatrices;
+		// アニメーションの無い関節が使う姿勢
+		Pose bindPose;
+
+		uint32_t GetJointCount() const { return static_cast<uint32_t>(parents.size()); }
+	};
+
+	// 1関節1成分分のキーフレーム列(時刻と値を成分ごとの配列で持つ)
+	struct Track
+	{
+		uint32_t joint = 0;
+		std::vector<float> times;
+		// 平行移動・拡大率はxyzの3成分、回転はxyzwの4成分を使う
+		std::vector<float> values[4];
+
+		uint32_t GetKeyCount() const { return static_cast<uint32_t>(times.size()); }
+	};
+
+	// アニメーションクリップ
+	struct AnimationClip
+	{
+		std::string name;
+		float duration = 0.0f;
+		std::vector<Track> translations;
+		std::vector<Track> rotations;
+		std::vector<Track> scales;
+	};
+
+	// 前回サンプリングしたキーの位置(トラックごと)
+	// 時刻は少しずつ進むので、次も同じか隣のキーで済むことが多い
+	struct ClipCursor
+	{
+		std::vector<uint32_t> translations;
+		std::vector<uint32_t> rotations;
+		std::vector<uint32_t> scales;
+
+		// クリップに合わせて確保し、先頭に戻す
+		void Reset(const AnimationClip &clip);
+	};
+
+	// スキニングする頂点
+	struct SkinnedVertex
+	{
+		math::Vector4 position;
+		math::Vector3 normal;
+		uint32_t joints[4];
+		float weights[4];
+	};
+
+	/// <summary>
+	/// クリップを指定時刻でサンプリングする。トラックの無い関節・成分はposeの値のまま
+	/// </summary>
+	/// <param name="time">時刻(範囲外は端のキーに留まる)</param>
+	/// <param name="cursor">キー位置のキャッシュ(clipに合わせてResetしておく)</param>
+	void SampleClip(const AnimationClip &clip, float time, ClipCursor &cursor, Pose &pose);
+
+	// 2つの姿勢を混ぜる(weightが0でa、1でb)
+	void BlendPoses(const Pose &a, const Pose &b, float weight, Pose &out);
+
+	// ローカル姿勢からモデル空間の行列を求める
+	void ComputeModelMatrices(const Skeleton &skeleton, const Pose &pose, std::vector<math::Matrix4x4> &modelMatrices);
+
+	// スキニング行列(逆バインド行列 * モデル空間の行列)を求める
+	void ComputeSkinMatrices(const Skeleton &skeleton, const std::vector<math::Matrix4x4> &modelMatrices, std::vector<math::Matrix4x4> &skinMatrices);
+
+	// CPUでスキニングする(GPUを使わずに結果を確かめる用)
+	void SkinVertices(const std::vector<SkinnedVertex> &vertices, const std::vector<math::Matrix4x4> &skinMatrices,
+		std::vector<math::Vector4> &positions, std::vector<math::Vector3> &normals);
+}
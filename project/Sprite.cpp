@@ -1,7 +1,7 @@
 #include "Sprite.h"
 #include "SpriteCommon.h"
-#include "DirectXCommon.h"
 #include "TextureManager.h"
+#include <algorithm>
 
 using namespace math;
 
@@ -12,11 +12,7 @@ void Sprite::Initialize(SpriteCommon *spriteCommon, std::string textureFilePath)
 
 	TextureManager::GetInstance()->LoadTexture(textureFilePath);
 
-	InitializeBuffers();
-	InitializeMaterial();
-	InitializeTransformationMatrixResource();
-
-	// 単位行列を書き込んでおく
+	// テクスチャ番号を取得
 	textureIndex = TextureManager::GetInstance()->GetTextureIndexByFilePath(textureFilePath);
 
 	AdjustTextureSize();
@@ -53,23 +49,41 @@ void Sprite::Update()
 	float tex_top = textureLeftTop.y / metadata.height;
 	float tex_bottom = (textureLeftTop.y + textureSize.y) / metadata.height;
 
-	// 頂点リソースにデータを書き込む
-	// 左下
-	vertexData[0].position = { left,bottom,0.0f,1.0f };
-	vertexData[0].texcoord = { tex_left,tex_bottom };
-	vertexData[0].normal = { 0.0f,0.0f,-1.0f };
-	//左上
-	vertexData[1].position = { left,top,0.0f,1.0f };
-	vertexData[1].texcoord = { tex_left,tex_top };
-	vertexData[1].normal = { 0.0f,0.0f,-1.0f };
-	// 右下
-	vertexData[2].position = { right,bottom,0.0f,1.0f };
-	vertexData[2].texcoord = { tex_right,tex_bottom };
-	vertexData[2].normal = { 0.0f,0.0f,-1.0f };
-	// 右上
-	vertexData[3].position = { right,top,0.0f,1.0f };
-	vertexData[3].texcoord = { tex_right,tex_top };
-	vertexData[3].normal = { 0.0f,0.0f,-1.0f };
+	// 頂点とテクスチャ座標の範囲を描画データに書き込む
+	instance_.localRect = { left,top,right,bottom };
+	instance_.uvRect = { tex_left,tex_top,tex_right,tex_bottom };
+
+	// 頂点の展開は描画スレッドで行うので、ここでは割合と枚数だけを求める
+	instance_.drawMode = drawMode_;
+	instance_.sliceRect = { 0.0f,0.0f,0.0f,0.0f };
+	instance_.sliceUvRect = { 0.0f,0.0f,0.0f,0.0f };
+	if (drawMode_ == render::SpriteDrawMode::NineSlice) {
+		// 角の幅を表示サイズ・切り出しサイズに対する割合にする(ワールド行列でsize_倍されるので、角はピクセル数のまま残る)
+		float width = (std::max)(size_.x, 1.0e-3f);
+		float height = (std::max)(size_.y, 1.0e-3f);
+		float sliceLeft = nineSliceBorder_.x / width;
+		float sliceRight = nineSliceBorder_.z / width;
+		float sliceTop = nineSliceBorder_.y / height;
+		float sliceBottom = nineSliceBorder_.w / height;
+		// 表示サイズが角の合計より小さいときは、角を同じ比率で縮めて重ならないようにする
+		float horizontal = sliceLeft + sliceRight;
+		if (horizontal > 1.0f) {
+			sliceLeft /= horizontal;
+			sliceRight /= horizontal;
+		}
+		float vertical = sliceTop + sliceBottom;
+		if (vertical > 1.0f) {
+			sliceTop /= vertical;
+			sliceBottom /= vertical;
+		}
+		instance_.sliceRect = { sliceLeft,sliceTop,sliceRight,sliceBottom };
+		instance_.sliceUvRect = {
+			nineSliceBorder_.x / textureSize.x, nineSliceBorder_.y / textureSize.y,
+			nineSliceBorder_.z / textureSize.x, nineSliceBorder_.w / textureSize.y };
+	} else if (drawMode_ == render::SpriteDrawMode::Tiled) {
+		// 表示サイズに1枚が何枚入るか(端数は描画スレッドで切り詰める)
+		instance_.sliceRect = { size_.x / (textureSize.x * tileScale_.x),size_.y / (textureSize.y * tileScale_.y),0.0f,0.0f };
+	}
 
 	//size_.x += 0.1f;
 	//size_.y += 0.1f;
@@ -82,107 +96,17 @@ void Sprite::Update()
 	//	materialData->color.x -= 1.0f;
 	//}
 
+	math::Transform transform {};
 	transform.scale = { size_.x,size_.y,1.0f };
 	transform.rotate = { 0.0f,0.0f,rotation_ };
 	transform.translate = { position_.x,position_.y,0.0f };
 
-	Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
-	Matrix4x4 viewMatrix = MakeIdentity4x4();
-	Matrix4x4 projectionMatrix = MakeOrthographicMatrix(0.0f, 0.0f, float(WinApp::kClientWidth), float(WinApp::kClientHeight), 0.0f, 100.0f);
-	transformationMatrixData->WVP = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
-	transformationMatrixData->World = worldMatrix;
-}
-
-void Sprite::Draw()
-{
-	spriteCommon_->GetDxCommon()->GetCommandList()->IASetVertexBuffers(0, 1, &vertexBufferView); // VBVを設定
-	spriteCommon_->GetDxCommon()->GetCommandList()->IASetIndexBuffer(&indexBufferView); // IBVを設定
-
-	spriteCommon_->GetDxCommon()->GetCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	spriteCommon_->GetDxCommon()->GetCommandList()->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());
-	// TransformationMatrixCBufferの場所を設定
-	spriteCommon_->GetDxCommon()->GetCommandList()->SetGraphicsRootConstantBufferView(1, transformationMatrixResource->GetGPUVirtualAddress());
-
-	spriteCommon_->GetDxCommon()->GetCommandList()->SetGraphicsRootDescriptorTable(2, TextureManager::GetInstance()->GetSrvHandleGPU(textureIndex));
-	//描画!(DrawCall/ドローコール)6個のインデックスを使用し1つのインスタンスを描画。その他は当面0で良い
-	spriteCommon_->GetDxCommon()->GetCommandList()->DrawIndexedInstanced(6, 1, 0, 0, 0);
-}
-
-void Sprite::InitializeBuffers()
-{
-	// 頂点・インデックス用リソースを作成
-	vertexResource = spriteCommon_->GetDxCommon()->CreateBufferResource(sizeof(VertexData) * 4);
-	indexResource = spriteCommon_->GetDxCommon()->CreateBufferResource(sizeof(uint32_t) * 6);
-
-	// 頂点バッファビューの設定
-	// リソースの先頭のアドレスから使う
-	vertexBufferView.BufferLocation = vertexResource->GetGPUVirtualAddress();
-	// 使用するリソースのサイズは頂点6つ分のサイズ
-	vertexBufferView.SizeInBytes = sizeof(VertexData) * 4;
-	// 1頂点あたりのサイズ
-	vertexBufferView.StrideInBytes = sizeof(VertexData);
-
-	// インデックスバッファビューの設定
-	// リソースの先頭のアドレスから使う
-	indexBufferView.BufferLocation = indexResource->GetGPUVirtualAddress();
-	// 使用するリソースのサイズはインデックス6つ分のサイズ
-	indexBufferView.SizeInBytes = sizeof(uint32_t) * 6;
-	// インデックスはuint32_tとする
-	indexBufferView.Format = DXGI_FORMAT_R32_UINT;
-
-	// 頂点データをマップして書き込み
-	vertexResource->Map(0, nullptr, reinterpret_cast<void **>(&vertexData));
-	vertexData[0].position = { 0.0f,360.0f,0.0f,1.0f };
-	vertexData[0].texcoord = { 0.0f,1.0f };
-	vertexData[0].normal = { 0.0f,0.0f,-1.0f };
-
-	vertexData[1].position = { 0.0f,0.0f,0.0f,1.0f };
-	vertexData[1].texcoord = { 0.0f,0.0f };
-	vertexData[1].normal = { 0.0f,0.0f,-1.0f };
-
-	vertexData[2].position = { 640.0f,360.0f,0.0f,1.0f };
-	vertexData[2].texcoord = { 1.0f,1.0f };
-	vertexData[2].normal = { 0.0f,0.0f,-1.0f };
-
-	vertexData[3].position = { 640.0f,0.0f,0.0f,1.0f };
-	vertexData[3].texcoord = { 1.0f,0.0f };
-	vertexData[3].normal = { 0.0f,0.0f,-1.0f };
-
-	// インデックスデータをマップして書き込み
-	indexResource->Map(0, nullptr, reinterpret_cast<void **>(&indexData));
-	indexData[0] = 0;
-	indexData[1] = 1;
-	indexData[2] = 2;
-	indexData[3] = 1;
-	indexData[4] = 3;
-	indexData[5] = 2;
-}
-
-void Sprite::InitializeMaterial()
-{
-	// マテリアルリソースを作成
-	materialResource = spriteCommon_->GetDxCommon()->CreateBufferResource(sizeof(Material));
-
-	// バッファをCPUアクセス用にマップしてポインタ取得
-	materialResource->Map(0, nullptr, reinterpret_cast<void **>(&materialData));
-
-	// マテリアルデータの初期値を書き込む
-	materialData->color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
-	materialData->enableLighting = false;
-	materialData->uvTransform = MakeIdentity4x4();
-}
-
-void Sprite::InitializeTransformationMatrixResource()
-{
-	// 座標変換行列リソースを作成
-	transformationMatrixResource = spriteCommon_->GetDxCommon()->CreateBufferResource(sizeof(TransformationMatrix));
-
-	// 書き込むためのアドレスを取得
-	transformationMatrixResource->Map(0, nullptr, reinterpret_cast<void **>(&transformationMatrixData));
-	// 単位行列を書きこんでおく
-	transformationMatrixData->WVP = MakeIdentity4x4();
-	transformationMatrixData->World = MakeIdentity4x4();
+	// ビュー・プロジェクションは描画スレッドでカメラから掛ける
+	instance_.world = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
+	instance_.uvTransform = uvTransform_;
+	instance_.color = color_;
+	instance_.textureIndex = textureIndex;
+	instance_.enableLighting = false;
 }
 
 void Sprite::AdjustTextureSize()
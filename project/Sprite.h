@@ -1,13 +1,13 @@
 #pragma once
 #include <cstdint>
-#include <wrl.h>
-#include <d3d12.h>
 #include <string>
 #include "MathFunctions.h"
+#include "RenderPacket.h"
 
 class SpriteCommon;
 
 // スプライト
+// 描画データの計算だけを行い、GPUへの書き込みと描画は描画スレッド側のSpriteRendererが行う
 class Sprite
 {
 public:
@@ -23,8 +23,6 @@ public:
 	struct Material
 	{
 		math::Vector4 color;
-		int32_t enableLighting;
-		float padding[3];
 		math::Matrix4x4 uvTransform;
 	};
 
@@ -42,10 +40,11 @@ public: // メンバ関数
 	// テクスチャ差し替え
 	void ChangeTexture(std::string textureFilePath);
 
-	// 更新
+	// 更新(描画データを計算する)
 	void Update();
-	// 描画
-	void Draw();
+
+	// 描画パケットに積む描画データ
+	const render::SpriteInstance &GetRenderInstance() const { return instance_; }
 
 	// getter
 	const math::Vector2 &GetPosition() { return position_; }
@@ -55,8 +54,8 @@ public: // メンバ関数
 	float GetRotation() const { return rotation_; }
 	void SetRotation(float rotation) { this->rotation_ = rotation; }
 
-	const math::Vector4 &GetColor() const { return materialData->color; }
-	void SetColor(const math::Vector4 &color) { materialData->color = color; }
+	const math::Vector4 &GetColor() const { return color_; }
+	void SetColor(const math::Vector4 &color) { color_ = color; }
 
 	const math::Vector2 &GetSize() const { return size_; }
 	void SetSize(const math::Vector2 &size) { this->size_ = size; }
@@ -78,39 +77,30 @@ public: // メンバ関数
 	math::Vector2 GetTextureLeftTop() const { return textureLeftTop; }
 	math::Vector2 GetTextureSize() const { return textureSize; }
 
+	// 描き方(Simple、NineSlice、Tiled)
+	void SetDrawMode(render::SpriteDrawMode drawMode) { drawMode_ = drawMode; }
+	render::SpriteDrawMode GetDrawMode() const { return drawMode_; }
+
+	/// <summary>
+	/// NineSliceの角の幅を設定する
+	/// 切り出し範囲(textureLeftTop, textureSize)の各辺からのピクセル数(left, top, right, bottom)で、
+	/// 角は表示サイズによらずこのピクセル数で描く(表示サイズが角の合計より小さければ角を縮める)
+	/// </summary>
+	void SetNineSliceBorder(const math::Vector4 &border) { nineSliceBorder_ = border; }
+	const math::Vector4 &GetNineSliceBorder() const { return nineSliceBorder_; }
+
+	// Tiledの1枚の大きさを切り出しサイズに対する倍率で設定する(1なら切り出しサイズのまま並べる)
+	void SetTileScale(const math::Vector2 &tileScale) { tileScale_ = tileScale; }
+	const math::Vector2 &GetTileScale() const { return tileScale_; }
+
 private:
 	SpriteCommon *spriteCommon_ = nullptr;
 
-	// バッファリソース
-	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource;
-	Microsoft::WRL::ComPtr<ID3D12Resource> indexResource;
-	// バッファリソース内のデータを指すポインタ
-	VertexData *vertexData = nullptr;
-	uint32_t *indexData = nullptr;
-	// バッファリソースの使い道を補足するバッファビュー
-	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
-	D3D12_INDEX_BUFFER_VIEW indexBufferView;
-	void InitializeBuffers();
-
-	// バッファリソース
-	Microsoft::WRL::ComPtr<ID3D12Resource> materialResource;
-	// バッファリソース内のデータを指すポインタ
-	Material *materialData = nullptr;
-
-	void InitializeMaterial();
-
-	// バッファリソース
-	Microsoft::WRL::ComPtr<ID3D12Resource> transformationMatrixResource;
-	// バッファリソース内のデータを指すポインタ
-	TransformationMatrix *transformationMatrixData = nullptr;
-	void InitializeTransformationMatrixResource();
-
-	math::Transform transform;
-
-	Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-	Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource;
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU {};
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU {};
+	// 描画データ
+	render::SpriteInstance instance_ {};
+
+	math::Vector4 color_ = { 1.0f,1.0f,1.0f,1.0f };
+	math::Matrix4x4 uvTransform_ = math::MakeIdentity4x4();
 
 	math::Vector2 position_ = { 0.0f,0.0f };
 	float rotation_ = 0.0f;
@@ -129,6 +119,13 @@ private:
 	// テクスチャ切り出しサイズ
 	math::Vector2 textureSize = { 100.0f,100.0f };
 
+	// 描き方
+	render::SpriteDrawMode drawMode_ = render::SpriteDrawMode::Simple;
+	// NineSliceの角の幅(切り出し範囲の各辺からのピクセル数)
+	math::Vector4 nineSliceBorder_ = { 0.0f,0.0f,0.0f,0.0f };
+	// Tiledの1枚の大きさ(切り出しサイズに対する倍率)
+	math::Vector2 tileScale_ = { 1.0f,1.0f };
+
 	// テクスチャサイズをイメージに合わせる
 	void AdjustTextureSize();
 };
\ No newline at end of file
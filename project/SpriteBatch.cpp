@@ -0,0 +1,163 @@
+#include "SpriteBatch.h"
+#include "FrameArena.h"
+#include "MathFunctions.h"
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+namespace render
+{
+	void SpriteBatchBuilder::Initialize()
+	{
+		materialTable_.Initialize(sizeof(Sprite::Material), kMaxSprites);
+	}
+
+	void SpriteBatchBuilder::Build(const RenderPacket &packet, Sprite::VertexData *vertices, uint8_t *constants,
+		CommandBackend &backend, const SpriteBatchPipeline &unlitPipeline, const SpriteBatchPipeline &litPipeline)
+	{
+		uint32_t spriteCount = static_cast<uint32_t>((std::min)(packet.sprites.size(), size_t(kMaxSprites)));
+		assert(packet.sprites.size() <= kMaxSprites);
+
+		// 平行光源は先頭に1つだけ書き込む
+		*reinterpret_cast<light::DirectionalLight *>(constants) = packet.directionalLight;
+
+		math::Matrix4x4 viewProjection = math::Multiply(packet.spriteCamera.view, packet.spriteCamera.projection);
+
+		// スプライトごとのデータを書き込む
+		// マテリアルは同じ内容を1つにまとめ、新しく現れたときだけ定数バッファに書き込む
+		materialTable_.Clear();
+		FrameVector<uint32_t> materialIds(spriteCount);
+		// スプライトごとの四角形の開始位置と数(NineSlice・Tiledは複数の四角形に展開し、1回の描画で描く)
+		FrameVector<uint32_t> firstQuads(spriteCount);
+		FrameVector<uint32_t> quadCounts(spriteCount);
+		uint32_t quadTotal = 0;
+		uint32_t droppedSpriteCount = 0;
+		uint32_t droppedQuadCount = 0;
+		for (uint32_t i = 0; i < spriteCount; ++i) {
+			const SpriteInstance &instance = packet.sprites[i];
+
+			// 頂点データ(入りきらない分は描かずに数える)
+			uint32_t quadCount = GetSpriteQuadCount(instance);
+			if (quadTotal + quadCount > kMaxQuads) {
+				++droppedSpriteCount;
+				droppedQuadCount += quadCount;
+				quadCount = 0;
+			}
+			firstQuads[i] = quadTotal;
+			quadCounts[i] = quadCount;
+			if (quadCount > 0) {
+				WriteSpriteVertices(instance, vertices + quadTotal * 4);
+				quadTotal += quadCount;
+			}
+
+			// 座標変換行列
+			Sprite::TransformationMatrix *transformationMatrix = reinterpret_cast<Sprite::TransformationMatrix *>(constants + kLightSize + kTransformationMatrixSize * i);
+			transformationMatrix->WVP = math::Multiply(instance.world, viewProjection);
+			transformationMatrix->World = instance.world;
+
+			// マテリアル
+			Sprite::Material material;
+			material.color = instance.color;
+			material.uvTransform = instance.uvTransform;
+			bool added = false;
+			materialIds[i] = materialTable_.Intern(material, &added);
+			if (added) {
+				*reinterpret_cast<Sprite::Material *>(constants + kMaterialRegionOffset + kMaterialSize * materialIds[i]) = material;
+			}
+		}
+
+		// 描画順(並べ替えない場合はパケットの順)
+		FrameVector<uint32_t> drawOrder(spriteCount);
+		for (uint32_t i = 0; i < spriteCount; ++i) {
+			drawOrder[i] = i;
+		}
+		if (sortByMaterial_) {
+			// PSO、マテリアル、テクスチャの順にまとめる(同じ組の中では元の順を保つ)
+			std::stable_sort(drawOrder.begin(), drawOrder.end(), [&](uint32_t a, uint32_t b) {
+				const SpriteInstance &instanceA = packet.sprites[a];
+				const SpriteInstance &instanceB = packet.sprites[b];
+				return std::tie(instanceA.enableLighting, materialIds[a], instanceA.textureIndex) <
+					std::tie(instanceB.enableLighting, materialIds[b], instanceB.textureIndex);
+			});
+		}
+
+		// 書き込んだ範囲
+		const uint32_t vertexBytes = static_cast<uint32_t>(sizeof(Sprite::VertexData)) * 4 * quadTotal;
+		const uint32_t transformBytes = kLightSize + kTransformationMatrixSize * spriteCount;
+		const uint32_t materialBytes = kMaterialSize * materialTable_.GetMaterialCount();
+		backend.Upload(kVertexBufferId, 0, vertexBytes, { reinterpret_cast<const uint8_t *>(vertices), vertexBytes });
+		backend.Upload(kConstantBufferId, 0, transformBytes, { constants, transformBytes });
+		backend.Upload(kConstantBufferId, kMaterialRegionOffset, materialBytes, { constants + kMaterialRegionOffset, materialBytes });
+
+		statistics_ = {};
+		statistics_.spriteCount = spriteCount;
+		statistics_.materialCount = materialTable_.GetMaterialCount();
+		statistics_.materialBytesSaved = (spriteCount - materialTable_.GetMaterialCount()) * kMaterialSize;
+		statistics_.constantBufferBytes = transformBytes + materialBytes;
+		statistics_.uploadBytes = vertexBytes + statistics_.constantBufferBytes;
+		statistics_.droppedSpriteCount = droppedSpriteCount;
+		statistics_.droppedQuadCount = droppedQuadCount;
+
+		// ライティング無しの変種から始め、変わるときだけPSOを切り替える
+		const SpriteBatchPipeline *pipeline = &unlitPipeline;
+		backend.SetRootSignature(pipeline->rootSignatureId);
+		backend.SetPipelineState(pipeline->pipelineStateId);
+		bindingTable_.Reset(pipeline->slotCount);
+		backend.SetVertexBuffer(kVertexBufferId, 0, kVertexBufferSize, static_cast<uint32_t>(sizeof(Sprite::VertexData)));
+		backend.SetIndexBuffer(kIndexBufferId, kIndexBufferSize);
+
+		// 変種が使うリソースだけ、前回と違う値のときに設定する
+		auto countBind = [&](uint32_t slot, bool changed) {
+			if (changed) {
+				++statistics_.bindCount;
+			} else if (slot != RootSignatureLayout::kNoSlot) {
+				++statistics_.bindSkipCount;
+			}
+		};
+		auto bindConstantBuffer = [&](SpriteBinding binding, uint32_t offset) {
+			uint32_t slot = pipeline->GetSlot(binding);
+			bool changed = bindingTable_.Update(slot, offset);
+			if (changed) {
+				backend.SetRootConstantBuffer(slot, kConstantBufferId, offset);
+			}
+			countBind(slot, changed);
+		};
+		auto bindTexture = [&](SpriteBinding binding, uint32_t textureIndex) {
+			uint32_t slot = pipeline->GetSlot(binding);
+			bool changed = bindingTable_.Update(slot, textureIndex);
+			if (changed) {
+				backend.SetRootDescriptorTable(slot, textureIndex);
+			}
+			countBind(slot, changed);
+		};
+
+		for (uint32_t i : drawOrder) {
+			const SpriteInstance &instance = packet.sprites[i];
+			if (quadCounts[i] == 0) {
+				continue;
+			}
+
+			// ライティングの有無はシェーダー内で分岐せず、変種のPSOで切り替える
+			const SpriteBatchPipeline *nextPipeline = instance.enableLighting ? &litPipeline : &unlitPipeline;
+			if (nextPipeline != pipeline) {
+				// ルートシグネチャが変わると設定済みのパラメータは全て無効になる
+				if (nextPipeline->rootSignatureId != pipeline->rootSignatureId) {
+					backend.SetRootSignature(nextPipeline->rootSignatureId);
+					bindingTable_.Reset(nextPipeline->slotCount);
+				}
+				backend.SetPipelineState(nextPipeline->pipelineStateId);
+				pipeline = nextPipeline;
+			}
+
+			// 同じマテリアルのスプライトは同じCBVを指す(続けて描けば設定も省かれる)
+			bindConstantBuffer(SpriteBinding::Material, kMaterialRegionOffset + kMaterialSize * materialIds[i]);
+			bindConstantBuffer(SpriteBinding::TransformationMatrix, kLightSize + kTransformationMatrixSize * i);
+			bindTexture(SpriteBinding::Texture, instance.textureIndex);
+			// 平行光源は全てのスプライトで同じ(ライティングの変種に切り替えた直後だけ設定される)
+			bindConstantBuffer(SpriteBinding::DirectionalLight, 0);
+			// 頂点の開始位置をずらし、四角形の数だけインデックスを使って描画
+			backend.DrawIndexed(6 * quadCounts[i], 1, 0, static_cast<int32_t>(firstQuads[i] * 4));
+			++statistics_.drawCount;
+		}
+	}
+}
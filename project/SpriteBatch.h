@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "CommandReplay.h"
+#include "MaterialTable.h"
+#include "RenderPacket.h"
+#include "RootSignatureLayout.h"
+#include "Sprite.h"
+#include "SpriteGeometry.h"
+
+// スプライトのバッチの作成(描画スレッドのSpriteRendererと、計測用のシーンのヘッドレス描画で共通)
+// パケットのスプライトを頂点・定数バッファの並びに書き込み、描画コマンドを再生先(CommandBackend)に流す
+// D3Dに依存しないので、D3Dへの変換は再生先の側で行う(SpriteRendererはコマンドリストに積む再生先を渡す)
+namespace render
+{
+	// 定数バッファ1つ分のサイズを配置単位(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT = 256)に揃える
+	constexpr uint32_t AlignConstantBufferSize(size_t size)
+	{
+		constexpr size_t kAlignment = 256;
+		return static_cast<uint32_t>((size + kAlignment - 1) / kAlignment * kAlignment);
+	}
+
+	// スプライトが束縛するリソース
+	enum class SpriteBinding : uint32_t
+	{
+		Material, //!< gMaterial
+		TransformationMatrix, //!< gTransformationMatrix
+		Texture, //!< gTexture
+		DirectionalLight, //!< gDirectionalLight
+		Count,
+	};
+
+	// 再生先から見たパイプライン(オブジェクトIDと、リソースごとのルートパラメータ番号)
+	struct SpriteBatchPipeline
+	{
+		uint32_t rootSignatureId = 0;
+		uint32_t pipelineStateId = 0;
+		// ルートパラメータの数
+		uint32_t slotCount = 0;
+		// リソースごとのルートパラメータ番号(変種が使わないリソースはkNoSlot)
+		std::array<uint32_t, static_cast<size_t>(SpriteBinding::Count)> slots {};
+
+		uint32_t GetSlot(SpriteBinding binding) const { return slots[static_cast<size_t>(binding)]; }
+	};
+
+	class SpriteBatchBuilder
+	{
+	public:
+		// 1フレームに描画できるスプライトの最大数
+		static constexpr uint32_t kMaxSprites = 4096;
+		// 1フレームに描画できる四角形の最大数(NineSlice・Tiledのスプライトは1枚で複数使う)
+		// 入りきらないスプライトは描かず、Statisticsの droppedSpriteCount・droppedQuadCount に数える
+		static constexpr uint32_t kMaxQuads = kMaxSprites * 4;
+
+		// 定数バッファの並びは 平行光源 | 座標変換(スプライトの順) | マテリアル(重複を除いたIDの順)
+		// マテリアルの領域はスプライトの数によらず同じ位置から始める
+		static constexpr uint32_t kTransformationMatrixSize = AlignConstantBufferSize(sizeof(Sprite::TransformationMatrix));
+		static constexpr uint32_t kMaterialSize = AlignConstantBufferSize(sizeof(Sprite::Material));
+		static constexpr uint32_t kLightSize = AlignConstantBufferSize(sizeof(light::DirectionalLight));
+		static constexpr uint32_t kMaterialRegionOffset = kLightSize + kTransformationMatrixSize * kMaxSprites;
+
+		// 1フレーム分のバッファの大きさ(バイト)
+		static constexpr uint32_t kVertexBufferSize = static_cast<uint32_t>(sizeof(Sprite::VertexData)) * 4 * kMaxQuads;
+		static constexpr uint32_t kConstantBufferSize = kMaterialRegionOffset + kMaterialSize * kMaxSprites;
+		// 全スプライト共通のインデックスバッファ(四角形を1スプライトの上限まで並べたもの)
+		static constexpr uint32_t kIndexBufferSize = static_cast<uint32_t>(sizeof(uint32_t)) * 6 * kMaxSpriteQuadCount;
+
+		// 再生先でのバッファのID(パイプラインのIDはkFirstPipelineObjectId以降を使う)
+		enum BufferId : uint32_t
+		{
+			kVertexBufferId,
+			kIndexBufferId,
+			kConstantBufferId,
+			kFirstPipelineObjectId,
+		};
+
+		// 直前のフレームの統計
+		struct Statistics
+		{
+			uint32_t spriteCount = 0;
+			uint32_t materialCount = 0; //!< 重複を除いたマテリアルの数(= マテリアルのCBVの数)
+			uint32_t materialBytesSaved = 0; //!< 重複除去で書き込まずに済んだ定数バッファのバイト数
+			uint32_t bindCount = 0; //!< 積んだルートパラメータの設定
+			uint32_t bindSkipCount = 0; //!< 前回と同じ値なので省いた設定
+			uint32_t drawCount = 0; //!< 描画コール数
+			uint32_t uploadBytes = 0; //!< 頂点・定数バッファに書き込んだバイト数
+			uint32_t constantBufferBytes = 0; //!< uploadBytesのうち定数バッファの分
+			uint32_t droppedSpriteCount = 0; //!< 四角形が入りきらずに描かなかったスプライト
+			uint32_t droppedQuadCount = 0; //!< 描かなかったスプライトの四角形の数
+		};
+
+	public: // メンバ関数
+		// 初期化
+		void Initialize();
+
+		// 描画順をPSO・マテリアル・テクスチャで並べ替えるか(同じ深度で重なるスプライトは前後が変わりうる)
+		void SetSortByMaterial(bool sortByMaterial) { sortByMaterial_ = sortByMaterial; }
+
+		/// <summary>
+		/// パケット内のスプライトをバッファに書き込み、描画コマンドを再生先に流す
+		/// 書き込んだ範囲はUploadとして、パイプラインは unlitPipeline から始めてライティングの有無で切り替える
+		/// </summary>
+		/// <param name="vertices">頂点の書き込み先(kVertexBufferSizeバイト)</param>
+		/// <param name="constants">定数の書き込み先(kConstantBufferSizeバイト)</param>
+		void Build(const RenderPacket &packet, Sprite::VertexData *vertices, uint8_t *constants,
+			CommandBackend &backend, const SpriteBatchPipeline &unlitPipeline, const SpriteBatchPipeline &litPipeline);
+
+		const Statistics &GetStatistics() const { return statistics_; }
+
+	private:
+		// 設定済みのルートパラメータ(変わったスロットだけ設定し直す)
+		RootBindingTable bindingTable_;
+		// フレーム内のマテリアル(同じ色・UV変換のスプライトは1つのCBVを共有する)
+		MaterialTable materialTable_;
+		bool sortByMaterial_ = false;
+		Statistics statistics_;
+	};
+}
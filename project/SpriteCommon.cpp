@@ -1,108 +1,112 @@
 #include "SpriteCommon.h"
 #include "DirectXCommon.h"
+#include "PerfCounters.h"
+#include "ShaderBuildService.h"
+#include <cassert>
 
-void SpriteCommon::Initialize(DirectXCommon *dxCommon)
+void SpriteCommon::Initialize(DirectXCommon *dxCommon, uint32_t shaderBuildThreadCount, std::span<const render::ShaderFeatureMask> prebuildFeatures)
 {
 	// 引数で受け取ってメンバ変数に記録する
 	dxCommon_ = dxCommon;
+	rootSignatureCache_.Initialize(dxCommon->GetDevice());
+
+	// スプライトが使う変種は先に作っておき、描画中にコンパイルが走らないようにする
+	// シェーダーは並列にコンパイルし、パイプラインは必要なシェーダーがそろった変種から作る
+	ShaderBuildService buildService;
+	for (render::ShaderFeatureMask features : prebuildFeatures) {
+		buildService.AddTask({ GetVertexShaderKey(features), GetPixelShaderKey(features) },
+			[this, features](std::span<IDxcBlob *const>) {
+				// シェーダーとリフレクションはキャッシュに入っている
+				Pipeline pipeline = CreatePipeline(features);
+				std::lock_guard<std::mutex> lock(pipelineMutex_);
+				pipelines_.emplace(features, std::move(pipeline));
+			});
+	}
+	buildService.Run(shaderCache_, shaderBuildThreadCount);
+	buildMilliseconds_ = buildService.GetLastMilliseconds();
+	buildShaderCount_ = buildService.GetLastShaderCount();
+}
 
-	CreateGraphicsPipelineState();
+size_t SpriteCommon::GetPipelineCount()
+{
+	std::lock_guard<std::mutex> lock(pipelineMutex_);
+	return pipelines_.size();
 }
 
 void SpriteCommon::SetupCommonDrawing()
 {
 
+	const Pipeline &pipeline = GetPipeline(kUnlitFeatures);
+
     // 1. ルートシグネチャをセット
-	dxCommon_->GetCommandList()->SetGraphicsRootSignature(rootSignature.Get());
+	dxCommon_->GetCommandList()->SetGraphicsRootSignature(pipeline.rootSignature);
 
     // 2. パイプラインステートオブジェクトをセット
-	dxCommon_->GetCommandList()->SetPipelineState(graphicsPipelineState.Get());
+	dxCommon_->GetCommandList()->SetPipelineState(pipeline.pipelineState.Get());
 
     // 3. プリミティブトポロジーをセット（三角形リストが一般的）
 	dxCommon_->GetCommandList()->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	static const PerfCounters::CounterId kRootSignatureBinds = PerfCounters::Register("render.rootSignatureBinds");
+	static const PerfCounters::CounterId kPipelineStateBinds = PerfCounters::Register("render.pipelineStateBinds");
+	PerfCounters::Add(kRootSignatureBinds);
+	PerfCounters::Add(kPipelineStateBinds);
 }
 
-void SpriteCommon::CreateRootSignature()
+const SpriteCommon::Pipeline &SpriteCommon::GetPipeline(render::ShaderFeatureMask features)
 {
-	HRESULT hr;
+	std::lock_guard<std::mutex> lock(pipelineMutex_);
+	Pipeline &pipeline = pipelines_[features];
+	if (!pipeline.pipelineState) {
+		pipeline = CreatePipeline(features);
+	}
+	return pipeline;
+}
 
-	//----RootSignatureを生成する----
-
-	// RootSignature作成
-	D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature {};
-	descriptionRootSignature.Flags =
-		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-	//----DescriptorRange----
-	D3D12_DESCRIPTOR_RANGE descriptorRange[1] = {};
-	descriptorRange[0].BaseShaderRegister = 0; // 0から始まる
-	descriptorRange[0].NumDescriptors = 1; // 数は1つ
-	descriptorRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV; // SRVを使う
-	descriptorRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND; // Offsetを自動計算
-
-	//----RootParameter----
-
-	// RootParameter作成。PixelShaderのMaterialとVertexShaderのTransform
-	D3D12_ROOT_PARAMETER rootParameters[4] = {};
-	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // CBVを使う
-	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; // PixelShaderで使う
-	rootParameters[0].Descriptor.ShaderRegister = 0; // レジスタ番号0とバインド
-
-	rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // CBVを使う
-	rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; // VertexShaderで使う
-	rootParameters[1].Descriptor.ShaderRegister = 0; // レジスタ番号0を使う
-
-	rootParameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // DescriptorTableを使う
-	rootParameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; // PixelShaderで使う
-	rootParameters[2].DescriptorTable.pDescriptorRanges = descriptorRange;
-	rootParameters[2].DescriptorTable.NumDescriptorRanges = _countof(descriptorRange); // Tableで利用する数
-
-	rootParameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV; // CBVを使う
-	rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; // PixelShaderで使う
-	rootParameters[3].Descriptor.ShaderRegister = 1; // レジスタ番号1を使う
-
-	descriptionRootSignature.pParameters = rootParameters; // ルートパラメータ配列へのポインタ
-	descriptionRootSignature.NumParameters = _countof(rootParameters); // 配列の長さ
-
-	//----Sampler----
-	D3D12_STATIC_SAMPLER_DESC staticSamplers[1] = {};
-	staticSamplers[0].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR; // バイリニアフィルタ
-	staticSamplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP; // 0~1の範囲外をリピート
-	staticSamplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-	staticSamplers[0].AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-	staticSamplers[0].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER; // 比較しない
-	staticSamplers[0].MaxLOD = D3D12_FLOAT32_MAX; // ありったけのMipmapを使う
-	staticSamplers[0].ShaderRegister = 0; // レジスタ番号0を使う
-	staticSamplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; // PixelShaderで使う
-	descriptionRootSignature.pStaticSamplers = staticSamplers;
-	descriptionRootSignature.NumStaticSamplers = _countof(staticSamplers);
-
-	// シリアライズしてバイナリにする
-	Microsoft::WRL::ComPtr<ID3DBlob> signatureBlob = nullptr;
-	Microsoft::WRL::ComPtr<ID3DBlob> errorBlob = nullptr;
-	hr = D3D12SerializeRootSignature(&descriptionRootSignature,
-		D3D_ROOT_SIGNATURE_VERSION_1, &signatureBlob, &errorBlob);
-	if (FAILED(hr)) {
-		//Log(logStream, reinterpret_cast<char*>(errorBlob->GetBufferPointer()));
-		assert(false);
+SpriteCommon::Pipeline SpriteCommon::CreatePipeline(render::ShaderFeatureMask features)
+{
+	render::ShaderPermutationKey vertexShaderKey = GetVertexShaderKey(features);
+	render::ShaderPermutationKey pixelShaderKey = GetPixelShaderKey(features);
+
+	// 全ての段階のリフレクションからルートシグネチャの構成を決める(同じ構成なら作らずに共有する)
+	std::vector<render::ShaderResourceBinding> bindings = shaderCache_.GetBindings(vertexShaderKey);
+	std::vector<render::ShaderResourceBinding> pixelShaderBindings = shaderCache_.GetBindings(pixelShaderKey);
+	bindings.insert(bindings.end(), pixelShaderBindings.begin(), pixelShaderBindings.end());
+	render::RootSignatureLayout layout = render::BuildRootSignatureLayout(bindings);
+
+	Pipeline pipeline;
+	pipeline.rootSignature = rootSignatureCache_.GetRootSignature(layout);
+	pipeline.pipelineState = CreateGraphicsPipelineState(features, pipeline.rootSignature,
+		shaderCache_.GetShader(vertexShaderKey).Get(), shaderCache_.GetShader(pixelShaderKey).Get());
+
+	// 描画時に使う、リソースごとのルートパラメータ番号の表
+	static const char *const kBindingNames[] = { "gMaterial", "gTransformationMatrix", "gTexture", "gDirectionalLight" };
+	static_assert(_countof(kBindingNames) == static_cast<size_t>(Binding::Count));
+	pipeline.slotCount = static_cast<uint32_t>(layout.parameters.size());
+	for (size_t i = 0; i < pipeline.slots.size(); ++i) {
+		pipeline.slots[i] = layout.FindParameter(kBindingNames[i]);
 	}
+	return pipeline;
+}
 
-	hr = dxCommon_->GetDevice()->CreateRootSignature(0,
-		signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize(),
-		IID_PPV_ARGS(&rootSignature));
-	assert(SUCCEEDED(hr));
+render::ShaderPermutationKey SpriteCommon::GetVertexShaderKey(render::ShaderFeatureMask features)
+{
+	return render::MakePermutationKey("resources/shaders/Object3D.VS.hlsl", "vs_6_0", features, render::ToMask(render::ShaderFeature::VertexColor));
 }
 
-void SpriteCommon::CreateGraphicsPipelineState()
+render::ShaderPermutationKey SpriteCommon::GetPixelShaderKey(render::ShaderFeatureMask features)
 {
-	HRESULT hr;
+	return render::MakePermutationKey("resources/shaders/Object3D.PS.hlsl", "ps_6_0", features);
+}
 
-    CreateRootSignature();
+Microsoft::WRL::ComPtr<ID3D12PipelineState> SpriteCommon::CreateGraphicsPipelineState(render::ShaderFeatureMask features, ID3D12RootSignature *rootSignature, IDxcBlob *vertexShaderBlob, IDxcBlob *pixelShaderBlob)
+{
+	HRESULT hr;
 
 	//----InputLayoutの設定を行う----
 
-	// InputLayout
-	D3D12_INPUT_ELEMENT_DESC inputElementDescs[3] = {};
+	// InputLayout(頂点カラーの変種だけCOLORが増える)
+	D3D12_INPUT_ELEMENT_DESC inputElementDescs[4] = {};
 	inputElementDescs[0].SemanticName = "POSITION";
 	inputElementDescs[0].SemanticIndex = 0;
 	inputElementDescs[0].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
@@ -118,9 +122,14 @@ void SpriteCommon::CreateGraphicsPipelineState()
 	inputElementDescs[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
 	inputElementDescs[2].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
 
+	inputElementDescs[3].SemanticName = "COLOR";
+	inputElementDescs[3].SemanticIndex = 0;
+	inputElementDescs[3].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	inputElementDescs[3].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+
 	D3D12_INPUT_LAYOUT_DESC inputLayoutDesc {};
 	inputLayoutDesc.pInputElementDescs = inputElementDescs;
-	inputLayoutDesc.NumElements = _countof(inputElementDescs);
+	inputLayoutDesc.NumElements = render::HasFeature(features, render::ShaderFeature::VertexColor) ? 4 : 3;
 
 	//----BlendStateの設定を行う----
 
@@ -139,19 +148,16 @@ void SpriteCommon::CreateGraphicsPipelineState()
 	// 三角形の中を塗りつぶす
 	rasterizerDesc.FillMode = D3D12_FILL_MODE_SOLID;
 
-	//----ShaderをCompileする----
+	//----Shader----
 
-	// Shaderをコンパイルする
-	Microsoft::WRL::ComPtr<IDxcBlob> vertexShaderBlob = dxCommon_->CompileShader(L"resources/shaders/Object3D.VS.hlsl", L"vs_6_0");
+	// 機能に合うShaderの変種(ShaderCacheでコンパイル済みの物を受け取る)
 	assert(vertexShaderBlob != nullptr);
-
-	Microsoft::WRL::ComPtr<IDxcBlob> pixelShaderBlob = dxCommon_->CompileShader(L"resources/shaders/Object3D.PS.hlsl", L"ps_6_0");
 	assert(pixelShaderBlob != nullptr);
 
 	//----PSOを生成する----
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDesc {};
-	graphicsPipelineStateDesc.pRootSignature = rootSignature.Get(); // RootSignature
+	graphicsPipelineStateDesc.pRootSignature = rootSignature; // RootSignature
 	graphicsPipelineStateDesc.InputLayout = inputLayoutDesc; // InputLayout
 	graphicsPipelineStateDesc.VS = { vertexShaderBlob->GetBufferPointer(),
 	vertexShaderBlob->GetBufferSize() }; // VertexShader
@@ -184,7 +190,9 @@ void SpriteCommon::CreateGraphicsPipelineState()
 	graphicsPipelineStateDesc.DepthStencilState = depthStencilDesc;
 	graphicsPipelineStateDesc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> graphicsPipelineState = nullptr;
 	hr = dxCommon_->GetDevice()->CreateGraphicsPipelineState(&graphicsPipelineStateDesc,
 		IID_PPV_ARGS(&graphicsPipelineState));
 	assert(SUCCEEDED(hr));
+	return graphicsPipelineState;
 }
\ No newline at end of file
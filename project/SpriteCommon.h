@@ -1,29 +1,83 @@
 #pragma once
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <unordered_map>
 #include <wrl.h>
 #include <d3d12.h>
+#include "RootSignatureCache.h"
+#include "ShaderCache.h"
+#include "ShaderPermutation.h"
+#include "SpriteBatch.h"
 
 class DirectXCommon;
 
 // スプライト共通部
 class SpriteCommon
 {
+public:
+	// スプライトが束縛するリソース(並びはバッチの作成と共通)
+	using Binding = render::SpriteBinding;
+
+	// 変種ごとのパイプライン
+	// ルートシグネチャはシェーダーのリフレクションから作り、構成が同じ変種どうしで共有する
+	struct Pipeline
+	{
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+		ID3D12RootSignature *rootSignature = nullptr;
+		// ルートパラメータの数
+		uint32_t slotCount = 0;
+		// リソースごとのルートパラメータ番号(変種が使わないリソースはkNoSlot)
+		std::array<uint32_t, static_cast<size_t>(Binding::Count)> slots {};
+
+		uint32_t GetSlot(Binding binding) const { return slots[static_cast<size_t>(binding)]; }
+	};
+
 public: // メンバ関数
-	// 初期化
-	void Initialize(DirectXCommon *dxCommon);
+	/// <summary>
+	/// 初期化
+	/// </summary>
+	/// <param name="shaderBuildThreadCount">起動時にシェーダーをコンパイルするスレッドの数(0ならCPUのスレッド数)</param>
+	/// <param name="prebuildFeatures">起動時にパイプラインまで作っておく機能の組み合わせ</param>
+	void Initialize(DirectXCommon *dxCommon, uint32_t shaderBuildThreadCount = 0, std::span<const render::ShaderFeatureMask> prebuildFeatures = kPrebuildFeatures);
 
 	DirectXCommon *GetDxCommon() const { return dxCommon_; }
 
-	// 共通描画設定
+	// 起動時のビルド(シェーダーのコンパイルとパイプラインの生成)にかかった時間(ミリ秒)と、コンパイルした変種の数
+	double GetBuildMilliseconds() const { return buildMilliseconds_; }
+	uint32_t GetBuildShaderCount() const { return buildShaderCount_; }
+	// 作ったパイプラインとルートシグネチャの数
+	size_t GetPipelineCount();
+	size_t GetRootSignatureCount() { return rootSignatureCache_.GetRootSignatureCount(); }
+
+	// 共通描画設定(ルートシグネチャとPSOはテクスチャのみの変種。ライティングする物はGetPipelineで切り替える)
 	void SetupCommonDrawing();
 
+	// 機能の組み合わせに合うパイプラインを取得する(無ければシェーダーの変種をコンパイルして作る)
+	const Pipeline &GetPipeline(render::ShaderFeatureMask features);
+
+	// スプライトが使う変種
+	static constexpr render::ShaderFeatureMask kUnlitFeatures = render::ToMask(render::ShaderFeature::Texture);
+	static constexpr render::ShaderFeatureMask kLitFeatures = kUnlitFeatures | render::ToMask(render::ShaderFeature::Lighting);
+	static constexpr render::ShaderFeatureMask kPrebuildFeatures[] = { kUnlitFeatures, kLitFeatures };
+
 private:
-	Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature = nullptr;
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> graphicsPipelineState = nullptr;
+	// シェーダー変種と、構成ごとのルートシグネチャと、機能の組み合わせごとのパイプライン
+	ShaderCache shaderCache_;
+	RootSignatureCache rootSignatureCache_;
+	std::unordered_map<render::ShaderFeatureMask, Pipeline> pipelines_;
+	std::mutex pipelineMutex_;
 
-	// ルードシグネチャの作成
-	void CreateRootSignature();
+	// パイプラインの作成(シェーダーはキャッシュから取り、無ければコンパイルする)
+	Pipeline CreatePipeline(render::ShaderFeatureMask features);
+	// 機能の組み合わせで使うシェーダーの変種(頂点シェーダーが見るのは頂点カラーだけなので、他の組み合わせでは共有される)
+	static render::ShaderPermutationKey GetVertexShaderKey(render::ShaderFeatureMask features);
+	static render::ShaderPermutationKey GetPixelShaderKey(render::ShaderFeatureMask features);
 	// グラフィックスパイプラインの生成
-	void CreateGraphicsPipelineState();
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> CreateGraphicsPipelineState(render::ShaderFeatureMask features, ID3D12RootSignature *rootSignature, IDxcBlob *vertexShaderBlob, IDxcBlob *pixelShaderBlob);
 
 	DirectXCommon *dxCommon_;
+	double buildMilliseconds_ = 0.0;
+	uint32_t buildShaderCount_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "SpriteGeometry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Tiledで並べる枚数(端数は切り上げ)。上限を超えるときは1枚を大きくして減らす
+	void GetTileGrid(const render::SpriteInstance &instance, float &tileCountX, float &tileCountY, uint32_t &columns, uint32_t &rows)
+	{
+		tileCountX = (std::max)(instance.sliceRect.x, 1.0e-3f);
+		tileCountY = (std::max)(instance.sliceRect.y, 1.0e-3f);
+		columns = static_cast<uint32_t>((std::min)(std::ceil(tileCountX), float(render::kMaxSpriteQuadCount)));
+		rows = static_cast<uint32_t>((std::min)(std::ceil(tileCountY), float(render::kMaxSpriteQuadCount)));
+		// 上限で切った向きは、切った枚数で全体を覆うようにする
+		if (float(columns) < tileCountX) {
+			tileCountX = float(columns);
+		}
+		if (float(rows) < tileCountY) {
+			tileCountY = float(rows);
+		}
+		while (columns * rows > render::kMaxSpriteQuadCount) {
+			// 多い方の向きから減らす
+			if (columns >= rows) {
+				tileCountX = float(columns - 1);
+				--columns;
+			} else {
+				tileCountY = float(rows - 1);
+				--rows;
+			}
+		}
+	}
+
+	float Lerp(float a, float b, float t)
+	{
+		return a + (b - a) * t;
+	}
+
+	// 四角形1枚分(左下、左上、右下、右上)
+	void WriteQuad(Sprite::VertexData *vertices, float left, float top, float right, float bottom, float u0, float v0, float u1, float v1)
+	{
+		vertices[0] = { { left,bottom,0.0f,1.0f },{ u0,v1 },{ 0.0f,0.0f,-1.0f } };
+		vertices[1] = { { left,top,0.0f,1.0f },{ u0,v0 },{ 0.0f,0.0f,-1.0f } };
+		vertices[2] = { { right,bottom,0.0f,1.0f },{ u1,v1 },{ 0.0f,0.0f,-1.0f } };
+		vertices[3] = { { right,top,0.0f,1.0f },{ u1,v0 },{ 0.0f,0.0f,-1.0f } };
+	}
+}
+
+namespace render
+{
+	uint32_t GetSpriteQuadCount(const SpriteInstance &instance)
+	{
+		switch (instance.drawMode) {
+		case SpriteDrawMode::NineSlice:
+			return 9;
+		case SpriteDrawMode::Tiled:
+		{
+			float tileCountX, tileCountY;
+			uint32_t columns, rows;
+			GetTileGrid(instance, tileCountX, tileCountY, columns, rows);
+			return columns * rows;
+		}
+		default:
+			return 1;
+		}
+	}
+
+	uint32_t WriteSpriteVertices(const SpriteInstance &instance, Sprite::VertexData *vertices)
+	{
+		const math::Vector4 &rect = instance.localRect;
+		const math::Vector4 &uv = instance.uvRect;
+
+		switch (instance.drawMode) {
+		case SpriteDrawMode::NineSlice:
+		{
+			// 縦横それぞれ4本の線で9枚に分ける。割合で持つので、フリップで左右が入れ替わっていても同じ計算でよい
+			const math::Vector4 &slice = instance.sliceRect;
+			const math::Vector4 &sliceUv = instance.sliceUvRect;
+			const float xs[4] = { rect.x, Lerp(rect.x, rect.z, slice.x), Lerp(rect.x, rect.z, 1.0f - slice.z), rect.z };
+			const float ys[4] = { rect.y, Lerp(rect.y, rect.w, slice.y), Lerp(rect.y, rect.w, 1.0f - slice.w), rect.w };
+			const float us[4] = { uv.x, Lerp(uv.x, uv.z, sliceUv.x), Lerp(uv.x, uv.z, 1.0f - sliceUv.z), uv.z };
+			const float vs[4] = { uv.y, Lerp(uv.y, uv.w, sliceUv.y), Lerp(uv.y, uv.w, 1.0f - sliceUv.w), uv.w };
+			for (uint32_t row = 0; row < 3; ++row) {
+				for (uint32_t column = 0; column < 3; ++column) {
+					WriteQuad(vertices + (row * 3 + column) * 4, xs[column], ys[row], xs[column + 1], ys[row + 1], us[column], vs[row], us[column + 1], vs[row + 1]);
+				}
+			}
+			return 9;
+		}
+		case SpriteDrawMode::Tiled:
+		{
+			// 1枚ごとに切り出し範囲全体を貼り、右端・下端の端数の1枚はテクスチャも同じ割合だけ切り詰める
+			float tileCountX, tileCountY;
+			uint32_t columns, rows;
+			GetTileGrid(instance, tileCountX, tileCountY, columns, rows);
+			Sprite::VertexData *quad = vertices;
+			for (uint32_t row = 0; row < rows; ++row) {
+				float y0 = float(row) / tileCountY;
+				float y1 = (std::min)(float(row + 1) / tileCountY, 1.0f);
+				float v1 = Lerp(uv.y, uv.w, (y1 - y0) * tileCountY);
+				for (uint32_t column = 0; column < columns; ++column) {
+					float x0 = float(column) / tileCountX;
+					float x1 = (std::min)(float(column + 1) / tileCountX, 1.0f);
+					float u1 = Lerp(uv.x, uv.z, (x1 - x0) * tileCountX);
+					WriteQuad(quad, Lerp(rect.x, rect.z, x0), Lerp(rect.y, rect.w, y0), Lerp(rect.x, rect.z, x1), Lerp(rect.y, rect.w, y1), uv.x, uv.y, u1, v1);
+					quad += 4;
+				}
+			}
+			return columns * rows;
+		}
+		default:
+			WriteQuad(vertices, rect.x, rect.y, rect.z, rect.w, uv.x, uv.y, uv.z, uv.w);
+			return 1;
+		}
+	}
+
+	void WriteSpriteIndices(uint32_t quadCount, uint32_t *indices)
+	{
+		for (uint32_t i = 0; i < quadCount; ++i) {
+			uint32_t base = i * 4;
+			indices[i * 6 + 0] = base + 0;
+			indices[i * 6 + 1] = base + 1;
+			indices[i * 6 + 2] = base + 2;
+			indices[i * 6 + 3] = base + 1;
+			indices[i * 6 + 4] = base + 3;
+			indices[i * 6 + 5] = base + 2;
+		}
+	}
+}
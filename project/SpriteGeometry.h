@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include "RenderPacket.h"
+#include "Sprite.h"
+
+// スプライトの頂点の作成(描画スレッドのバッチ作成と、計測用のシーンで共通)
+// スプライトは四角形(4頂点)の並びに展開する。Simpleは1枚、NineSliceは9枚、Tiledは並べる枚数分
+// 四角形の頂点の並びは全て同じ(左下、左上、右下、右上)なので、インデックスは四角形の数だけ同じ形を並べたものを共有できる
+namespace render
+{
+	// 1スプライトの四角形の上限(Tiledで超える場合は、1枚を大きくして収める)
+	constexpr uint32_t kMaxSpriteQuadCount = 256;
+
+	// スプライトを展開したときの四角形の数
+	uint32_t GetSpriteQuadCount(const SpriteInstance &instance);
+
+	/// <summary>
+	/// スプライトの頂点を書き込み、四角形の数を返す
+	/// </summary>
+	/// <param name="vertices">書き込み先(GetSpriteQuadCount * 4 頂点分)</param>
+	uint32_t WriteSpriteVertices(const SpriteInstance &instance, Sprite::VertexData *vertices);
+
+	// 四角形quadCount枚分のインデックス(6 * quadCount個)を書き込む
+	void WriteSpriteIndices(uint32_t quadCount, uint32_t *indices);
+}
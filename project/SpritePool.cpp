@@ -0,0 +1,72 @@
+#include "SpritePool.h"
+#include <cassert>
+
+SpriteHandle SpritePool::Create()
+{
+	// スロットを確保。空きがなければ末尾に足し、スラブが埋まっていればスラブも足す
+	SpriteHandle handle {};
+	if (!freeSlots.empty()) {
+		handle.index = freeSlots.back();
+		freeSlots.pop_back();
+		// 前の持ち主の状態を消す
+		GetSprite(handle.index) = Sprite();
+	} else {
+		handle.index = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+		if (handle.index >= GetCapacity()) {
+			slabs.push_back(std::make_unique<Slab>());
+		}
+	}
+
+	Slot &slot = slots[handle.index];
+	slot.alive = true;
+	slot.liveIndex = static_cast<uint32_t>(liveSlots.size());
+	liveSlots.push_back(handle.index);
+	handle.generation = slot.generation;
+	return handle;
+}
+
+void SpritePool::Destroy(SpriteHandle handle)
+{
+	// 破棄済みのハンドルの二重破棄チェック
+	assert(IsValid(handle));
+	if (!IsValid(handle)) {
+		return;
+	}
+
+	// 世代を進めて古いハンドルを無効にする
+	Slot &slot = slots[handle.index];
+	slot.alive = false;
+	++slot.generation;
+	freeSlots.push_back(handle.index);
+
+	// 詰めた配列からは末尾のもので穴を埋めて外す
+	uint32_t last = liveSlots.back();
+	liveSlots[slot.liveIndex] = last;
+	slots[last].liveIndex = slot.liveIndex;
+	liveSlots.pop_back();
+}
+
+bool SpritePool::IsValid(SpriteHandle handle) const
+{
+	return handle.index < slots.size() &&
+		slots[handle.index].alive &&
+		slots[handle.index].generation == handle.generation;
+}
+
+Sprite *SpritePool::Get(SpriteHandle handle)
+{
+	if (!IsValid(handle)) {
+		return nullptr;
+	}
+	return &GetSprite(handle.index);
+}
+
+void SpritePool::Clear()
+{
+	// 末尾から破棄すれば穴埋めの移動が起きない
+	while (!liveSlots.empty()) {
+		uint32_t index = liveSlots.back();
+		Destroy({ index, slots[index].generation });
+	}
+}
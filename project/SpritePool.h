@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Sprite.h"
+
+// スプライトのハンドル(スロット番号 + 世代番号)
+struct SpriteHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool operator==(const SpriteHandle &other) const = default;
+};
+
+// スプライトのプール
+// 実体はキャッシュラインに揃えたスラブにまとめて確保し、空きスロットを使い回して生成・破棄をO(1)で行う
+// スラブは解放しないため、Getで得たポインタはそのハンドルを破棄するまで有効
+// 生きているスロットの番号は詰めた配列でも持ち、走査は破棄を繰り返した後でも生きている数だけで済む
+class SpritePool
+{
+public:
+	// スラブ1つに入るスプライト数
+	static const uint32_t kSlabSize = 64;
+
+public: // メンバ関数
+	// 生成(初期化は呼び出し側で行う)
+	SpriteHandle Create();
+	// 破棄
+	void Destroy(SpriteHandle handle);
+	// ハンドルが生きているか
+	bool IsValid(SpriteHandle handle) const;
+
+	// ハンドルから実体を取得(無効なハンドルならnullptr)
+	Sprite *Get(SpriteHandle handle);
+
+	// 生きているスプライト数
+	uint32_t GetCount() const { return static_cast<uint32_t>(liveSlots.size()); }
+	// 確保済みのスロット数
+	uint32_t GetCapacity() const { return static_cast<uint32_t>(slabs.size()) * kSlabSize; }
+
+	// 生きているスプライトを走査する(順番は詰めた配列の順。破棄すると末尾のものがその位置に来る)
+	template <class F>
+	void ForEach(F &&func)
+	{
+		for (uint32_t index : liveSlots) {
+			func(GetSprite(index));
+		}
+	}
+
+	// 全て破棄する(確保したスラブは残す)
+	void Clear();
+
+private:
+	// キャッシュラインに揃えたスラブ
+	struct alignas(64) Slab
+	{
+		Sprite sprites[kSlabSize];
+	};
+
+	// スロット(ハンドルの指す先)
+	struct Slot
+	{
+		uint32_t generation = 0;
+		bool alive = false;
+		// liveSlotsの中での位置(生きている間だけ有効)
+		uint32_t liveIndex = 0;
+	};
+
+	Sprite &GetSprite(uint32_t index) { return slabs[index / kSlabSize]->sprites[index % kSlabSize]; }
+
+	std::vector<std::unique_ptr<Slab>> slabs;
+	std::vector<Slot> slots;
+	// 空きスロット(最後に空いたものから使い回す)
+	std::vector<uint32_t> freeSlots;
+	// 生きているスロットの番号を詰めたもの
+	std::vector<uint32_t> liveSlots;
+};
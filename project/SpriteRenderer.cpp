@@ -0,0 +1,200 @@
+#include "SpriteRenderer.h"
+#include "CommandCapture.h"
+#include "SpriteCommon.h"
+#include "SpriteGeometry.h"
+#include "DirectXCommon.h"
+#include "TextureManager.h"
+#include "PerfCounters.h"
+
+using namespace math;
+
+namespace
+{
+	using render::SpriteBatchBuilder;
+	static_assert(SpriteBatchBuilder::kTransformationMatrixSize % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0);
+	static_assert(SpriteBatchBuilder::kMaterialSize % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0);
+	static_assert(SpriteBatchBuilder::kLightSize % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0);
+
+	// バッチのオブジェクトID(バッファの後ろにルートシグネチャ2つ、PSO2つ)
+	enum ObjectId : uint32_t
+	{
+		kUnlitRootSignatureId = SpriteBatchBuilder::kFirstPipelineObjectId,
+		kLitRootSignatureId,
+		kUnlitPipelineStateId,
+		kLitPipelineStateId,
+		kObjectIdEnd,
+	};
+
+	// バッチのコマンドをコマンドリストに積む再生先(キャプチャ中ならキャプチャにも同じコマンドを書き出す)
+	class CommandListBackend : public render::CommandBackend
+	{
+	public:
+		CommandListBackend(ID3D12GraphicsCommandList *commandList, render::CommandCapture *capture)
+			: commandList_(commandList), capture_(capture) {}
+
+		// オブジェクトIDとD3Dのオブジェクトの対応
+		void SetBuffers(ID3D12Resource *vertexResource, ID3D12Resource *indexResource, ID3D12Resource *constantResource)
+		{
+			buffers_[SpriteBatchBuilder::kVertexBufferId] = vertexResource;
+			buffers_[SpriteBatchBuilder::kIndexBufferId] = indexResource;
+			buffers_[SpriteBatchBuilder::kConstantBufferId] = constantResource;
+		}
+		void SetPipeline(uint32_t rootSignatureId, ID3D12RootSignature *rootSignature, uint32_t pipelineStateId, ID3D12PipelineState *pipelineState)
+		{
+			rootSignatures_[rootSignatureId - SpriteBatchBuilder::kFirstPipelineObjectId] = rootSignature;
+			pipelineStates_[pipelineStateId - SpriteBatchBuilder::kFirstPipelineObjectId] = pipelineState;
+		}
+
+		void SetRootSignature(uint32_t objectId) override
+		{
+			ID3D12RootSignature *rootSignature = rootSignatures_[objectId - SpriteBatchBuilder::kFirstPipelineObjectId];
+			commandList_->SetGraphicsRootSignature(rootSignature);
+			capture_->SetRootSignature(rootSignature);
+			++rootSignatureBindCount;
+		}
+		void SetPipelineState(uint32_t objectId) override
+		{
+			ID3D12PipelineState *pipelineState = pipelineStates_[objectId - SpriteBatchBuilder::kFirstPipelineObjectId];
+			commandList_->SetPipelineState(pipelineState);
+			capture_->SetPipelineState(pipelineState);
+			++pipelineStateBindCount;
+		}
+		void SetRootConstantBuffer(uint32_t slot, uint32_t bufferId, uint32_t offset) override
+		{
+			commandList_->SetGraphicsRootConstantBufferView(slot, buffers_[bufferId]->GetGPUVirtualAddress() + offset);
+			capture_->SetRootConstantBuffer(slot, buffers_[bufferId], offset);
+			++constantBufferBindCount;
+		}
+		void SetRootDescriptorTable(uint32_t slot, uint32_t descriptorIndex) override
+		{
+			commandList_->SetGraphicsRootDescriptorTable(slot, TextureManager::GetInstance()->GetSrvHandleGPU(descriptorIndex));
+			capture_->SetRootDescriptorTable(slot, descriptorIndex);
+			++descriptorTableBindCount;
+		}
+		void SetVertexBuffer(uint32_t bufferId, uint32_t offset, uint32_t size, uint32_t stride) override
+		{
+			D3D12_VERTEX_BUFFER_VIEW vertexBufferView {};
+			vertexBufferView.BufferLocation = buffers_[bufferId]->GetGPUVirtualAddress() + offset;
+			vertexBufferView.SizeInBytes = size;
+			vertexBufferView.StrideInBytes = stride;
+			commandList_->IASetVertexBuffers(0, 1, &vertexBufferView);
+			capture_->SetVertexBuffer(buffers_[bufferId], offset, size, stride);
+		}
+		void SetIndexBuffer(uint32_t bufferId, uint32_t size) override
+		{
+			D3D12_INDEX_BUFFER_VIEW indexBufferView {};
+			indexBufferView.BufferLocation = buffers_[bufferId]->GetGPUVirtualAddress();
+			indexBufferView.SizeInBytes = size;
+			indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+			commandList_->IASetIndexBuffer(&indexBufferView);
+			capture_->SetIndexBuffer(buffers_[bufferId], size);
+		}
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex) override
+		{
+			commandList_->DrawIndexedInstanced(indexCount, instanceCount, startIndex, static_cast<INT>(baseVertex), 0);
+			capture_->DrawIndexed(indexCount, instanceCount, startIndex, baseVertex);
+		}
+		void Upload(uint32_t bufferId, uint32_t offset, uint32_t size, std::span<const uint8_t> data) override
+		{
+			// 中身は書き込み済み。キャプチャ中だけ記録する(アップロードバッファを読み戻す遅さは許容する)
+			if (capture_->IsRecording()) {
+				capture_->Upload(buffers_[bufferId], offset, data.data(), size);
+			}
+		}
+
+		// 積んだ設定の数(性能カウンタ用)
+		uint32_t rootSignatureBindCount = 0;
+		uint32_t pipelineStateBindCount = 0;
+		uint32_t constantBufferBindCount = 0;
+		uint32_t descriptorTableBindCount = 0;
+
+	private:
+		ID3D12GraphicsCommandList *commandList_;
+		render::CommandCapture *capture_;
+		ID3D12Resource *buffers_[SpriteBatchBuilder::kFirstPipelineObjectId] = {};
+		ID3D12RootSignature *rootSignatures_[kObjectIdEnd - SpriteBatchBuilder::kFirstPipelineObjectId] = {};
+		ID3D12PipelineState *pipelineStates_[kObjectIdEnd - SpriteBatchBuilder::kFirstPipelineObjectId] = {};
+	};
+
+	// スプライト共通部のパイプラインを、バッチから見たIDとルートパラメータ番号に置き換える
+	render::SpriteBatchPipeline MakeBatchPipeline(const SpriteCommon::Pipeline &pipeline, uint32_t rootSignatureId, uint32_t pipelineStateId)
+	{
+		render::SpriteBatchPipeline batchPipeline;
+		batchPipeline.rootSignatureId = rootSignatureId;
+		batchPipeline.pipelineStateId = pipelineStateId;
+		batchPipeline.slotCount = pipeline.slotCount;
+		batchPipeline.slots = pipeline.slots;
+		return batchPipeline;
+	}
+}
+
+void SpriteRenderer::Initialize(SpriteCommon *spriteCommon)
+{
+	// 引数で受け取ってメンバ変数に記録する
+	spriteCommon_ = spriteCommon;
+	DirectXCommon *dxCommon = spriteCommon_->GetDxCommon();
+
+	// インデックスは全スプライトで共通。頂点はBaseVertexLocationでずらし、四角形の数だけインデックスを使う
+	indexResource = dxCommon->CreateBufferResource(SpriteBatchBuilder::kIndexBufferSize);
+
+	uint32_t *indexData = nullptr;
+	indexResource->Map(0, nullptr, reinterpret_cast<void **>(&indexData));
+	render::WriteSpriteIndices(render::kMaxSpriteQuadCount, indexData);
+	indexResource->Unmap(0, nullptr);
+
+	// フレームごとの頂点・定数バッファ(マップしたままにしておく)
+	for (FrameResource &frame : frames) {
+		frame.vertexResource = dxCommon->CreateBufferResource(SpriteBatchBuilder::kVertexBufferSize);
+		frame.vertexResource->Map(0, nullptr, reinterpret_cast<void **>(&frame.vertexData));
+
+		frame.constantResource = dxCommon->CreateBufferResource(SpriteBatchBuilder::kConstantBufferSize);
+		frame.constantResource->Map(0, nullptr, reinterpret_cast<void **>(&frame.constantData));
+	}
+
+	batchBuilder_.Initialize();
+}
+
+void SpriteRenderer::Draw(const render::RenderPacket &packet)
+{
+	ID3D12GraphicsCommandList *commandList = spriteCommon_->GetDxCommon()->GetCommandList();
+	FrameResource &frame = frames[frameIndex];
+	frameIndex = (frameIndex + 1) % kFrameCount;
+
+	// ライティング無しとありの変種(ルートシグネチャが同じなら同じIDにして、切り替えで設定し直さない)
+	const SpriteCommon::Pipeline &unlitPipeline = spriteCommon_->GetPipeline(SpriteCommon::kUnlitFeatures);
+	const SpriteCommon::Pipeline &litPipeline = spriteCommon_->GetPipeline(SpriteCommon::kLitFeatures);
+	const uint32_t litRootSignatureId = litPipeline.rootSignature == unlitPipeline.rootSignature ? kUnlitRootSignatureId : kLitRootSignatureId;
+
+	CommandListBackend backend(commandList, render::CommandCapture::GetInstance());
+	backend.SetBuffers(frame.vertexResource.Get(), indexResource.Get(), frame.constantResource.Get());
+	backend.SetPipeline(kUnlitRootSignatureId, unlitPipeline.rootSignature, kUnlitPipelineStateId, unlitPipeline.pipelineState.Get());
+	backend.SetPipeline(litRootSignatureId, litPipeline.rootSignature, kLitPipelineStateId, litPipeline.pipelineState.Get());
+
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	batchBuilder_.Build(packet, frame.vertexData, frame.constantData, backend,
+		MakeBatchPipeline(unlitPipeline, kUnlitRootSignatureId, kUnlitPipelineStateId),
+		MakeBatchPipeline(litPipeline, litRootSignatureId, kLitPipelineStateId));
+
+	const Statistics &statistics = batchBuilder_.GetStatistics();
+	totalDrawCount_ += statistics.drawCount;
+	totalUploadBytes_ += statistics.uploadBytes;
+	totalDroppedQuadCount_ += statistics.droppedQuadCount;
+
+	// フレームごとの性能カウンタ
+	static const PerfCounters::CounterId kDrawCalls = PerfCounters::Register("render.drawCalls");
+	static const PerfCounters::CounterId kUploadBytes = PerfCounters::Register("render.uploadBytes");
+	static const PerfCounters::CounterId kConstantBufferBytes = PerfCounters::Register("render.cbvBytesWritten");
+	static const PerfCounters::CounterId kRootSignatureBinds = PerfCounters::Register("render.rootSignatureBinds");
+	static const PerfCounters::CounterId kPipelineStateBinds = PerfCounters::Register("render.pipelineStateBinds");
+	static const PerfCounters::CounterId kConstantBufferBinds = PerfCounters::Register("render.cbvBinds");
+	static const PerfCounters::CounterId kDescriptorTableBinds = PerfCounters::Register("render.descriptorTableBinds");
+	static const PerfCounters::CounterId kDroppedQuads = PerfCounters::Register("render.droppedQuads");
+	PerfCounters::Add(kDrawCalls, statistics.drawCount);
+	PerfCounters::Add(kUploadBytes, statistics.uploadBytes);
+	PerfCounters::Add(kConstantBufferBytes, statistics.constantBufferBytes);
+	PerfCounters::Add(kRootSignatureBinds, backend.rootSignatureBindCount);
+	PerfCounters::Add(kPipelineStateBinds, backend.pipelineStateBindCount);
+	PerfCounters::Add(kConstantBufferBinds, backend.constantBufferBindCount);
+	PerfCounters::Add(kDescriptorTableBinds, backend.descriptorTableBindCount);
+	PerfCounters::Add(kDroppedQuads, statistics.droppedQuadCount);
+}
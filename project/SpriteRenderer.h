@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <wrl.h>
+#include <d3d12.h>
+#include "Sprite.h"
+#include "RenderPacket.h"
+#include "SpriteBatch.h"
+
+class SpriteCommon;
+
+// スプライト描画(描画スレッド専用)
+// 描画パケットのスプライトをフレームごとのアップロードバッファに書き込み、コマンドを積む
+// バッファの並びとコマンドの順はSpriteBatchBuilderが決め、ここではそれをコマンドリストに積む
+class SpriteRenderer
+{
+public:
+	// 1フレームに描画できるスプライトの最大数
+	static const uint32_t kMaxSprites = render::SpriteBatchBuilder::kMaxSprites;
+	// 1フレームに描画できる四角形の最大数(NineSlice・Tiledのスプライトは1枚で複数使う)
+	static const uint32_t kMaxQuads = render::SpriteBatchBuilder::kMaxQuads;
+	// フレームごとのバッファ数
+	static const uint32_t kFrameCount = 2;
+
+public: // メンバ関数
+	// 初期化
+	void Initialize(SpriteCommon *spriteCommon);
+
+	// パケット内のスプライトを描画する
+	void Draw(const render::RenderPacket &packet);
+
+	// 描画順をPSO・マテリアル・テクスチャで並べ替えるか(同じ深度で重なるスプライトは前後が変わりうる。描画開始前に設定する)
+	void SetSortByMaterial(bool sortByMaterial) { batchBuilder_.SetSortByMaterial(sortByMaterial); }
+
+	// 直前のフレームの統計(描画スレッドから読む)
+	using Statistics = render::SpriteBatchBuilder::Statistics;
+	const Statistics &GetStatistics() const { return batchBuilder_.GetStatistics(); }
+
+	// 初期化からの描画コール数・書き込んだバイト数の累計(描画スレッドを止めてから読む)
+	uint64_t GetTotalDrawCount() const { return totalDrawCount_; }
+	uint64_t GetTotalUploadBytes() const { return totalUploadBytes_; }
+	// バッチに入りきらずに描かなかった四角形の数の累計(描画スレッドを止めてから読む)
+	uint64_t GetTotalDroppedQuadCount() const { return totalDroppedQuadCount_; }
+
+private:
+	// フレームごとのリソース
+	struct FrameResource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource;
+		Sprite::VertexData *vertexData = nullptr;
+		Microsoft::WRL::ComPtr<ID3D12Resource> constantResource;
+		uint8_t *constantData = nullptr;
+	};
+
+	SpriteCommon *spriteCommon_ = nullptr;
+
+	// 全スプライト共通のインデックスバッファ(四角形を1スプライトの上限まで並べたもの)
+	Microsoft::WRL::ComPtr<ID3D12Resource> indexResource;
+
+	std::array<FrameResource, kFrameCount> frames;
+	uint32_t frameIndex = 0;
+
+	// バッファへの書き込みとコマンドの順
+	render::SpriteBatchBuilder batchBuilder_;
+	uint64_t totalDrawCount_ = 0;
+	uint64_t totalUploadBytes_ = 0;
+	uint64_t totalDroppedQuadCount_ = 0;
+};
@@ -0,0 +1,156 @@
+#include "Task.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace task_detail
+{
+	std::coroutine_handle<> PromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<>) noexcept
+	{
+		// 完了を書き込んだ後は、待っている側がいなければ所有者がいつ破棄してもよいので、必要なものは先に読んでおく
+		PromiseBase *current = promise;
+		bool notifyScheduler = current->notifyScheduler_;
+		if (current->state_.exchange(kDone, std::memory_order_acq_rel) == kAwaited) {
+			// 待っている側は再開されるまで破棄しないので、ここではまだ読める
+			return current->continuation_;
+		}
+		if (notifyScheduler) {
+			TaskScheduler::GetInstance()->NotifyCompleted();
+		}
+		return std::noop_coroutine();
+	}
+}
+
+TaskScheduler *TaskScheduler::instance = nullptr;
+
+TaskScheduler *TaskScheduler::GetInstance()
+{
+	if (instance == nullptr) {
+		instance = new TaskScheduler;
+	}
+	return instance;
+}
+
+void TaskScheduler::Finalize()
+{
+	{
+		std::lock_guard<std::mutex> lock(ioMutex);
+		stop = true;
+	}
+	ioCondition.notify_all();
+	if (ioThread.joinable()) {
+		ioThread.join();
+	}
+	// 終了時にまだ待っているタスクは再開待ちの一覧から指されているので、破棄せずに手放す
+	for (Task<void> &task : spawnedTasks) {
+		if (!task.IsDone()) {
+			task.handle_ = {};
+		}
+	}
+	delete instance;
+	instance = nullptr;
+}
+
+void TaskScheduler::Initialize()
+{
+	ioThread = std::thread(&TaskScheduler::IoThreadMain, this);
+}
+
+void TaskScheduler::Enqueue(ResumeOn resumeOn, std::coroutine_handle<> handle)
+{
+	switch (resumeOn) {
+	case ResumeOn::JobSystem:
+		JobSystem::GetInstance()->Submit([handle]() { handle.resume(); });
+		break;
+	case ResumeOn::IoThread:
+		{
+			std::lock_guard<std::mutex> lock(ioMutex);
+			ioQueue.push_back(handle);
+		}
+		ioCondition.notify_one();
+		break;
+	case ResumeOn::MainFrame:
+		{
+			// RunUntilCompleteで待っていれば起こす
+			std::lock_guard<std::mutex> lock(mutex);
+			mainFrameQueue.push_back(handle);
+			mainCondition.notify_all();
+		}
+		break;
+	case ResumeOn::RenderFrame:
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			renderFrameQueue.push_back(handle);
+		}
+		break;
+	}
+}
+
+void TaskScheduler::Spawn(Task<void> task)
+{
+	task.Start();
+	if (task.IsDone()) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(spawnedMutex);
+	spawnedTasks.push_back(std::move(task));
+}
+
+void TaskScheduler::RunFrameBoundary()
+{
+	std::vector<std::coroutine_handle<>> handles;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		handles.swap(mainFrameQueue);
+	}
+	ResumeAll(handles);
+
+	// 完了したSpawnのタスクを破棄する
+	std::lock_guard<std::mutex> lock(spawnedMutex);
+	std::erase_if(spawnedTasks, [](const Task<void> &task) { return task.IsDone(); });
+}
+
+void TaskScheduler::RunRenderFrameBoundary()
+{
+	std::vector<std::coroutine_handle<>> handles;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		handles.swap(renderFrameQueue);
+	}
+	ResumeAll(handles);
+}
+
+void TaskScheduler::NotifyCompleted()
+{
+	// RunUntilCompleteが完了を確かめてから眠るまでの間に通知が抜けないよう、ロックしてから通知する
+	std::lock_guard<std::mutex> lock(mutex);
+	mainCondition.notify_all();
+}
+
+void TaskScheduler::IoThreadMain()
+{
+	// I/Oスレッドはフレームと関係なく動くので、フレームアリーナはResetAllの対象にしない
+	// コルーチンが中断をまたいで一時データを持つことがあるため、ここでもまとめては巻き戻さない(後に確保した分から返せば再利用される)
+	FrameArena::GetThreadArena().SetName("Io");
+
+	while (true) {
+		std::coroutine_handle<> handle;
+		{
+			std::unique_lock<std::mutex> lock(ioMutex);
+			ioCondition.wait(lock, [this]() { return stop || !ioQueue.empty(); });
+			if (stop) {
+				return;
+			}
+			handle = ioQueue.front();
+			ioQueue.pop_front();
+		}
+		handle.resume();
+	}
+}
+
+void TaskScheduler::ResumeAll(std::vector<std::coroutine_handle<>> &handles)
+{
+	for (std::coroutine_handle<> handle : handles) {
+		handle.resume();
+	}
+}
@@ -0,0 +1,339 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// C++20のコルーチンによる非同期処理
+// Task<T>は呼ばれた時点では走らず、co_awaitされる(またはStartする)と走り出す
+// 途中でTaskSchedulerの待ち(SwitchToJobSystem、SwitchToIoThread、NextFrame、NextRenderFrame)を
+// co_awaitすると、そのスレッド・タイミングで続きが再開する
+//
+//   Task<uint32_t> LoadLevel()
+//   {
+//       uint32_t texture = co_await TextureManager::GetInstance()->LoadAsync("resources/textures/uvChecker.png");
+//       // LoadAsyncはメインスレッドのフレームの境界で再開するので、ここからはゲームの状態を触ってよい
+//       co_return texture;
+//   }
+
+class TaskScheduler;
+
+template <class T>
+class Task;
+
+namespace task_detail
+{
+	// 全てのTaskの約束事の共通部分
+	class PromiseBase
+	{
+	public:
+		// 状態(完了と待ち始めが別スレッドで同時に起きうるのでatomicで受け渡す)
+		enum State : uint8_t
+		{
+			kRunning, //!< 未完了で、誰も待っていない
+			kAwaited, //!< 未完了で、continuationが待っている
+			kDone, //!< 完了
+		};
+
+		// 終了時に待っている側を再開する
+		struct FinalAwaiter
+		{
+			bool await_ready() noexcept { return false; }
+			// 待っている側がいればそのまま切り替え、いなければ呼び出し元に戻る
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) noexcept;
+			void await_resume() noexcept {}
+
+			PromiseBase *promise;
+		};
+
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		FinalAwaiter final_suspend() noexcept { return { this }; }
+		// 例外は使わないので、投げられたら終了する
+		void unhandled_exception() noexcept { std::terminate(); }
+
+		bool IsDone() const { return state_.load(std::memory_order_acquire) == kDone; }
+
+		/// <summary>
+		/// 完了したらcontinuationを再開するよう登録する
+		/// 既に完了していればfalse(呼び出し側がそのまま続ける)
+		/// </summary>
+		bool SetContinuation(std::coroutine_handle<> continuation)
+		{
+			continuation_ = continuation;
+			uint8_t expected = kRunning;
+			return state_.compare_exchange_strong(expected, kAwaited, std::memory_order_acq_rel);
+		}
+
+		// 完了時にTaskSchedulerへ知らせる(RunUntilComplete用)
+		void SetNotifyScheduler() { notifyScheduler_ = true; }
+
+	private:
+		std::atomic<uint8_t> state_ { kRunning };
+		std::coroutine_handle<> continuation_;
+		bool notifyScheduler_ = false;
+	};
+
+	template <class T>
+	class Promise : public PromiseBase
+	{
+	public:
+		Task<T> get_return_object();
+		template <class U>
+		void return_value(U &&value) { value_.emplace(std::forward<U>(value)); }
+		T &GetValue() { return *value_; }
+
+	private:
+		std::optional<T> value_;
+	};
+
+	template <>
+	class Promise<void> : public PromiseBase
+	{
+	public:
+		Task<void> get_return_object();
+		void return_void() {}
+		void GetValue() {}
+	};
+}
+
+// コルーチンの戻り値の型
+template <class T = void>
+class Task
+{
+public:
+	using promise_type = task_detail::Promise<T>;
+	using Handle = std::coroutine_handle<promise_type>;
+
+	// co_awaitしたときの待ち
+	struct Awaiter
+	{
+		bool await_ready() const { return task->IsDone(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation)
+		{
+			if (!task->started_) {
+				// 走っていなければ、完了後の再開先を決めてから走らせる
+				task->started_ = true;
+				task->handle_.promise().SetContinuation(continuation);
+				return task->handle_;
+			}
+			// 別スレッドで走っている。登録より先に完了していたらそのまま続ける
+			if (!task->handle_.promise().SetContinuation(continuation)) {
+				return continuation;
+			}
+			return std::noop_coroutine();
+		}
+
+		Task *task;
+	};
+	// 結果を取り出す待ち
+	struct ValueAwaiter : Awaiter
+	{
+		T await_resume()
+		{
+			if constexpr (!std::is_void_v<T>) {
+				return std::move(this->task->handle_.promise().GetValue());
+			}
+		}
+	};
+	// 完了を待つだけの待ち(結果はGetResultで取り出す)
+	struct ReadyAwaiter : Awaiter
+	{
+		void await_resume() {}
+	};
+
+public: // メンバ関数
+	Task() = default;
+	explicit Task(Handle handle) : handle_(handle) {}
+	Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})), started_(std::exchange(other.started_, false)) {}
+	Task &operator=(Task &&other) noexcept
+	{
+		if (this != &other) {
+			Destroy();
+			handle_ = std::exchange(other.handle_, {});
+			started_ = std::exchange(other.started_, false);
+		}
+		return *this;
+	}
+	Task(const Task &) = delete;
+	Task &operator=(const Task &) = delete;
+	~Task() { Destroy(); }
+
+	/// <summary>
+	/// co_awaitせずに、呼び出し元スレッドで最初の待ちまで走らせる
+	/// 後からco_awaitしてもよいが、完了するまでTaskを破棄してはならない
+	/// </summary>
+	void Start()
+	{
+		assert(handle_ && !started_);
+		started_ = true;
+		handle_.resume();
+	}
+
+	bool IsValid() const { return static_cast<bool>(handle_); }
+	bool IsDone() const { return handle_ && handle_.promise().IsDone(); }
+
+	// 結果(完了していること)
+	decltype(auto) GetResult()
+	{
+		assert(IsDone());
+		return handle_.promise().GetValue();
+	}
+
+	// co_awaitの結果は戻り値(所有権はムーブする)
+	ValueAwaiter operator co_await() { return { { this } }; }
+	// 完了を待つだけ(Startしたタスクをまとめて待つとき用)
+	ReadyAwaiter WhenReady() { return { { this } }; }
+
+private:
+	friend class TaskScheduler;
+
+	void Destroy()
+	{
+		if (handle_) {
+			// 走っている途中のコルーチンは破棄できない
+			assert(!started_ || handle_.promise().IsDone());
+			handle_.destroy();
+			handle_ = {};
+		}
+	}
+
+	Handle handle_;
+	bool started_ = false;
+};
+
+namespace task_detail
+{
+	template <class T>
+	Task<T> Promise<T>::get_return_object() { return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+	inline Task<void> Promise<void>::get_return_object() { return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this)); }
+}
+
+// コルーチンの再開先(ジョブシステム、I/Oスレッド、メイン・描画スレッドのフレームの境界)
+class TaskScheduler
+{
+public:
+	// 再開するスレッド・タイミング
+	enum class ResumeOn
+	{
+		JobSystem, //!< ジョブシステムのワーカー
+		IoThread, //!< ファイルの読み込みなど、待ちの長い処理用の専用スレッド
+		MainFrame, //!< メインスレッドの次のフレームの先頭(RunFrameBoundary)
+		RenderFrame, //!< 描画スレッドの次のフレームの先頭(RunRenderFrameBoundary。D3Dのコマンドを積める)
+	};
+
+	// 指定先で再開する待ち
+	struct ResumeAwaiter
+	{
+		bool await_ready() const { return false; }
+		void await_suspend(std::coroutine_handle<> handle) const { scheduler->Enqueue(resumeOn, handle); }
+		void await_resume() const {}
+
+		TaskScheduler *scheduler;
+		ResumeOn resumeOn;
+	};
+
+public: // メンバ関数
+	// シングルトンインスタンスの取得
+	static TaskScheduler *GetInstance();
+	// 終了(I/Oスレッドを止める。待っているコルーチンは再開しない。ジョブシステムより先に呼ぶ)
+	void Finalize();
+
+	// 初期化(I/Oスレッドを立てる。ジョブシステムは初期化済みであること)
+	void Initialize();
+
+	// 以下をco_awaitすると、それぞれの再開先で続きが走る
+	ResumeAwaiter SwitchToJobSystem() { return { this, ResumeOn::JobSystem }; }
+	ResumeAwaiter SwitchToIoThread() { return { this, ResumeOn::IoThread }; }
+	ResumeAwaiter NextFrame() { return { this, ResumeOn::MainFrame }; }
+	ResumeAwaiter NextRenderFrame() { return { this, ResumeOn::RenderFrame }; }
+
+	// 待っているコルーチンを再開先に渡す
+	void Enqueue(ResumeOn resumeOn, std::coroutine_handle<> handle);
+
+	/// <summary>
+	/// 結果を待たずに走らせる(完了したらRunFrameBoundaryで破棄する)
+	/// </summary>
+	void Spawn(Task<void> task);
+
+	/// <summary>
+	/// メインスレッドのフレームの境界。NextFrameで待っているコルーチンを再開する(毎フレームの先頭で呼ぶ)
+	/// この中で再びNextFrameを待ったものは次のフレームに回る
+	/// </summary>
+	void RunFrameBoundary();
+	// 描画スレッドのフレームの境界(描画の先頭で呼ぶ)
+	void RunRenderFrameBoundary();
+
+	/// <summary>
+	/// タスクを走らせて完了まで待つ(メインスレッドから呼ぶ)
+	/// 待っている間もNextFrameで待っているコルーチンは再開するので、起動処理やツールから使える
+	/// </summary>
+	template <class T>
+	T RunUntilComplete(Task<T> task);
+
+	// 完了したタスクがあることをRunUntilCompleteに知らせる
+	void NotifyCompleted();
+
+private:
+	static TaskScheduler *instance;
+
+	TaskScheduler() = default;
+	~TaskScheduler() = default;
+	TaskScheduler(TaskScheduler &) = delete;
+	TaskScheduler &operator=(TaskScheduler &) = delete;
+
+private:
+	// I/Oスレッドの処理
+	void IoThreadMain();
+	// 待ちの一覧を取り出して順に再開する
+	static void ResumeAll(std::vector<std::coroutine_handle<>> &handles);
+
+	// I/Oスレッド
+	std::thread ioThread;
+	std::mutex ioMutex;
+	std::condition_variable ioCondition;
+	std::deque<std::coroutine_handle<>> ioQueue;
+	bool stop = false;
+
+	// フレームの境界で再開するもの
+	std::mutex mutex;
+	std::condition_variable mainCondition;
+	std::vector<std::coroutine_handle<>> mainFrameQueue;
+	std::vector<std::coroutine_handle<>> renderFrameQueue;
+
+	// Spawnしたタスク
+	std::mutex spawnedMutex;
+	std::vector<Task<void>> spawnedTasks;
+};
+
+template <class T>
+T TaskScheduler::RunUntilComplete(Task<T> task)
+{
+	task.handle_.promise().SetNotifyScheduler();
+	task.Start();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		mainCondition.wait(lock, [&]() { return task.IsDone() || !mainFrameQueue.empty(); });
+		if (task.IsDone()) {
+			break;
+		}
+		std::vector<std::coroutine_handle<>> handles;
+		handles.swap(mainFrameQueue);
+		lock.unlock();
+		ResumeAll(handles);
+		lock.lock();
+	}
+	lock.unlock();
+
+	if constexpr (!std::is_void_v<T>) {
+		return std::move(task.GetResult());
+	}
+}
@@ -1,7 +1,12 @@
 #include "TextureManager.h"
 #include "DirectXCommon.h"
+#include "EngineEvents.h"
+#include "EventBus.h"
+#include "PerfCounters.h"
 #include "StringUtility.h"
 #include <cassert>
+#include <fstream>
+#include <iterator>
 
 using namespace StringUtility;
 
@@ -30,18 +35,69 @@ void TextureManager::Initialize() {
 void TextureManager::LoadTexture(const std::string &filePath) {
 
 	// 読み込み済みテクスチャを検索
+	uint32_t textureIndex = 0;
+	if (FindTexture(filePath, textureIndex)) {
+		// 読み込み済みなら早期return
+		return;
+	}
+
+	AddTexture(filePath, DecodeTexture(filePath));
+}
+
+Task<uint32_t> TextureManager::LoadAsync(std::string filePath) {
+
+	uint32_t textureIndex = 0;
+	if (FindTexture(filePath, textureIndex)) {
+		// 読み込み済みなら待たずに返す
+		co_return textureIndex;
+	}
+
+	TaskScheduler *scheduler = TaskScheduler::GetInstance();
+
+	// ファイルの読み込みはI/Oスレッドで行う
+	co_await scheduler->SwitchToIoThread();
+	std::vector<char> fileData;
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		assert(file);
+		fileData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// デコードとミップマップの作成はワーカーで行う
+	co_await scheduler->SwitchToJobSystem();
+	// WICはスレッドごとにCOMの初期化が要る
+	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	assert(SUCCEEDED(hr));
+	DirectX::ScratchImage mipImages = DecodeTextureMemory(fileData.data(), fileData.size());
+	CoUninitialize();
+
+	// 転送コマンドは描画スレッドがそのフレームのコマンドを積む前に積む
+	co_await scheduler->NextRenderFrame();
+	AddTexture(filePath, std::move(mipImages));
+	FindTexture(filePath, textureIndex);
+	EventBus::GetInstance()->Publish(TextureLoadedEvent { textureIndex });
+
+	// 呼び出し元はメインスレッドのフレームの先頭で再開する
+	co_await scheduler->NextFrame();
+	co_return textureIndex;
+}
+
+bool TextureManager::FindTexture(const std::string &filePath, uint32_t &textureIndex) {
+
+	std::lock_guard<std::mutex> lock(mutex);
 	auto it = std::find_if(
 		textureDatas.begin(),
 		textureDatas.end(),
 		[&](TextureData &textureData) { return textureData.filePath == filePath; }
 	);
-	if (it != textureDatas.end()) {
-		// 読み込み済みなら早期return
-		return;
+	if (it == textureDatas.end()) {
+		return false;
 	}
+	textureIndex = static_cast<uint32_t>(std::distance(textureDatas.begin(), it));
+	return true;
+}
 
-	// テクスチャ枚数上限チェック
-	assert(textureDatas.size() + kSRVIndexTop < dxCommon_->kMaxSRVCount);
+DirectX::ScratchImage TextureManager::DecodeTexture(const std::string &filePath) {
 
 	// テクスチャファイルを読んでプログラムで扱えるようにする
 	DirectX::ScratchImage image {};
@@ -49,11 +105,47 @@ void TextureManager::LoadTexture(const std::string &filePath) {
 	HRESULT hr = DirectX::LoadFromWICFile(filePathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
 	assert(SUCCEEDED(hr));
 
+	return GenerateMipMaps(image);
+}
+
+DirectX::ScratchImage TextureManager::DecodeTextureMemory(const void *data, size_t size) {
+
+	// メモリ上のファイルの中身を読んでプログラムで扱えるようにする
+	DirectX::ScratchImage image {};
+	HRESULT hr = DirectX::LoadFromWICMemory(data, size, DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+	assert(SUCCEEDED(hr));
+
+	return GenerateMipMaps(image);
+}
+
+DirectX::ScratchImage TextureManager::GenerateMipMaps(const DirectX::ScratchImage &image) {
+
 	// ミップマップの作成
 	DirectX::ScratchImage mipImages {};
-	hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
+	HRESULT hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
 	assert(SUCCEEDED(hr));
 
+	return mipImages;
+}
+
+void TextureManager::AddTexture(const std::string &filePath, DirectX::ScratchImage &&mipImages) {
+
+	// 非同期の読み込みでは描画スレッドから追加されるので、検索と排他する
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// 読み込み済みなら何もしない
+	auto it = std::find_if(
+		textureDatas.begin(),
+		textureDatas.end(),
+		[&](TextureData &textureData) { return textureData.filePath == filePath; }
+	);
+	if (it != textureDatas.end()) {
+		return;
+	}
+
+	// テクスチャ枚数上限チェック
+	assert(textureDatas.size() + kSRVIndexTop < dxCommon_->kMaxSRVCount);
+
 	// テクスチャデータを追加
 	textureDatas.resize(textureDatas.size() + 1);
 	// 追加したテクスチャデータの参照を取得する
@@ -78,6 +170,19 @@ void TextureManager::LoadTexture(const std::string &filePath) {
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	srvDesc.Texture2D.MipLevels = UINT(textureData.metadata.mipLevels);
 	dxCommon_->GetDevice()->CreateShaderResourceView(textureData.resource.Get(), &srvDesc, textureData.srvHandleCPU);
+
+	// GPU上の大きさはアラインメントの分だけピクセルデータより大きい
+	D3D12_RESOURCE_DESC resourceDesc = textureData.resource->GetDesc();
+	uint64_t allocationBytes = dxCommon_->GetDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+	uint64_t memoryBytes = textureMemoryBytes.load(std::memory_order_relaxed) + allocationBytes;
+	textureMemoryBytes.store(memoryBytes, std::memory_order_relaxed);
+
+	static const PerfCounters::CounterId kTexturesLoaded = PerfCounters::Register("texture.loaded");
+	static const PerfCounters::CounterId kTextureUploadBytes = PerfCounters::Register("texture.uploadBytes");
+	static const PerfCounters::CounterId kTextureMemoryBytes = PerfCounters::Register("texture.memoryBytes", PerfCounters::Kind::Gauge);
+	PerfCounters::Add(kTexturesLoaded);
+	PerfCounters::Add(kTextureUploadBytes, static_cast<int64_t>(mipImages.GetPixelsSize()));
+	PerfCounters::Set(kTextureMemoryBytes, static_cast<int64_t>(memoryBytes));
 }
 
 void TextureManager::ReleaseIntermediateResources()
@@ -90,14 +195,9 @@ void TextureManager::ReleaseIntermediateResources()
 uint32_t TextureManager::GetTextureIndexByFilePath(const std::string &filePath)
 {
 	// 読み込む済みテクスチャデータを検索
-	auto it = std::find_if(
-		textureDatas.begin(),
-		textureDatas.end(),
-		[&](TextureData &textureData) { return textureData.filePath == filePath; }
-	);
-	if (it != textureDatas.end()) {
+	uint32_t textureIndex = 0;
+	if (FindTexture(filePath, textureIndex)) {
 		// 読み込み済みなら要素番号を返す
-		uint32_t textureIndex = static_cast<uint32_t>(std::distance(textureDatas.begin(), it));
 		return textureIndex;
 	}
 
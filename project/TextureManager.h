@@ -1,5 +1,8 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 #include <string>
+#include "Task.h"
 #include "externals/DirectXTex/DirectXTex.h"
 #include "externals/DirectXTex/d3dx12.h"
 
@@ -23,6 +26,26 @@ public:
 	/// <param name="filePath">テクスチャファイルのパス</param>
 	void LoadTexture(const std::string &filePath);
 
+	/// <summary>
+	/// テクスチャファイルを非同期に読み込み、SRVの番号を返す
+	/// ファイルはI/Oスレッド、デコードはワーカー、転送は描画スレッドのフレームの先頭で行い、
+	/// メインスレッドのフレームの先頭で再開する(読み込み済みならすぐに返す)
+	/// </summary>
+	Task<uint32_t> LoadAsync(std::string filePath);
+
+	/// <summary>
+	/// テクスチャファイルを読み込んでミップマップを作る(D3Dを使わないので、どのスレッドから呼んでもよい)
+	/// WICを使うため、呼び出し元スレッドでCOMを初期化しておくこと
+	/// </summary>
+	static DirectX::ScratchImage DecodeTexture(const std::string &filePath);
+	// メモリ上のテクスチャファイルの中身から作る(DecodeTextureと同じくCOMの初期化が要る)
+	static DirectX::ScratchImage DecodeTextureMemory(const void *data, size_t size);
+
+	/// <summary>
+	/// デコード済みのテクスチャを登録し、GPUへの転送コマンドを積む(読み込み済みなら何もしない)
+	/// </summary>
+	void AddTexture(const std::string &filePath, DirectX::ScratchImage &&mipImages);
+
 	void ReleaseIntermediateResources();
 
 	// SRVインデックスの開始番号
@@ -36,6 +59,9 @@ public:
 	// メタデータを取得
 	const DirectX::TexMetadata &GetMetaData(uint32_t textureIndex);
 
+	// 読み込んだテクスチャがGPUメモリに占めるバイト数の合計
+	uint64_t GetTextureMemoryBytes() const { return textureMemoryBytes.load(std::memory_order_relaxed); }
+
 private:
 	static TextureManager *instance;
 
@@ -45,6 +71,11 @@ private:
 	TextureManager &operator=(TextureManager &) = delete;
 
 private:
+	// 読み込み済みのテクスチャを検索する
+	bool FindTexture(const std::string &filePath, uint32_t &textureIndex);
+	// ミップマップの作成
+	static DirectX::ScratchImage GenerateMipMaps(const DirectX::ScratchImage &image);
+
 	// テクスチャ1枚分のデータ
 	struct TextureData {
 		std::string filePath;
@@ -56,7 +87,12 @@ private:
 	};
 
 	// テクスチャデータ
+	// Initializeで上限まで確保しておくので、追加しても要素は移動しない
 	std::vector<TextureData> textureDatas;
+	// textureDatasへの追加と検索の排他
+	std::mutex mutex;
+	// テクスチャのGPUメモリの合計(描画スレッドで加算し、メインスレッドで読む)
+	std::atomic<uint64_t> textureMemoryBytes { 0 };
 
 	DirectXCommon *dxCommon_ = nullptr;
 
@@ -0,0 +1,197 @@
+#include "TimerWheel.h"
+#include <cassert>
+
+TimerWheel::CallbackId TimerWheel::RegisterCallback(Callback callback)
+{
+	callbacks_.push_back(std::move(callback));
+	return static_cast<CallbackId>(callbacks_.size() - 1);
+}
+
+TimerHandle TimerWheel::Schedule(uint32_t delayTicks, CallbackId callback, uint64_t userData, uint32_t intervalTicks)
+{
+	assert(callback < callbacks_.size());
+
+	// ノードを確保。空きがなければ末尾に足す
+	uint32_t index;
+	if (!freeNodes_.empty()) {
+		index = freeNodes_.back();
+		freeNodes_.pop_back();
+	} else {
+		index = static_cast<uint32_t>(nodes_.size());
+		nodes_.emplace_back();
+	}
+
+	Node &node = nodes_[index];
+	// currentTickは次に処理するティックなので、1ティック後はcurrentTickで満了する
+	node.expireTick = currentTick_ + (delayTicks > 0 ? delayTicks - 1 : 0);
+	node.userData = userData;
+	node.interval = intervalTicks;
+	node.callback = callback;
+	node.active = true;
+	Link(index);
+	++activeCount_;
+	return { index, node.generation };
+}
+
+bool TimerWheel::Cancel(TimerHandle handle)
+{
+	if (!IsActive(handle)) {
+		return false;
+	}
+	// 満了処理中で取り出し済みなら繋がっていない(世代が進むので呼ばれない)
+	if (nodes_[handle.index].slot != kUnlinked) {
+		Unlink(handle.index);
+	}
+	Release(handle.index);
+	return true;
+}
+
+bool TimerWheel::IsActive(TimerHandle handle) const
+{
+	return handle.index < nodes_.size() &&
+		nodes_[handle.index].active &&
+		nodes_[handle.index].generation == handle.generation;
+}
+
+uint64_t TimerWheel::GetRemainingTicks(TimerHandle handle) const
+{
+	if (!IsActive(handle)) {
+		return 0;
+	}
+	return nodes_[handle.index].expireTick - currentTick_ + 1;
+}
+
+void TimerWheel::Advance(uint32_t tickCount)
+{
+	// タイマーが無ければ時刻だけ進める(カスケードするものも無い)
+	if (activeCount_ == 0) {
+		currentTick_ += tickCount;
+		return;
+	}
+	for (uint32_t i = 0; i < tickCount; ++i) {
+		Step();
+	}
+}
+
+void TimerWheel::Clear()
+{
+	for (uint32_t index = 0; index < nodes_.size(); ++index) {
+		if (nodes_[index].active) {
+			Release(index);
+		}
+	}
+	heads_.fill(kInvalidIndex);
+}
+
+void TimerWheel::Link(uint32_t index)
+{
+	Node &node = nodes_[index];
+	assert(node.expireTick >= currentTick_);
+
+	// 満了までの近さで段を決める(段levelはkSlotCount^(level+1)ティック先まで)
+	uint64_t delta = node.expireTick - currentTick_;
+	uint32_t level = 0;
+	while (level + 1 < kLevelCount && delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+		++level;
+	}
+	// 最上段にも収まらないほど先なら、最上段の一番遠いスロットに入れておく(下ろすときに入れ直す)
+	uint64_t tick = node.expireTick;
+	constexpr uint64_t kMaxDelta = (uint64_t(1) << (kSlotBits * kLevelCount)) - 1;
+	if (delta > kMaxDelta) {
+		tick = currentTick_ + kMaxDelta;
+	}
+
+	uint32_t slot = level * kSlotCount + static_cast<uint32_t>((tick >> (kSlotBits * level)) & (kSlotCount - 1));
+	node.slot = slot;
+	node.prev = kInvalidIndex;
+	node.next = heads_[slot];
+	if (node.next != kInvalidIndex) {
+		nodes_[node.next].prev = index;
+	}
+	heads_[slot] = index;
+}
+
+void TimerWheel::Unlink(uint32_t index)
+{
+	Node &node = nodes_[index];
+	if (node.prev != kInvalidIndex) {
+		nodes_[node.prev].next = node.next;
+	} else {
+		heads_[node.slot] = node.next;
+	}
+	if (node.next != kInvalidIndex) {
+		nodes_[node.next].prev = node.prev;
+	}
+	node.slot = kUnlinked;
+}
+
+void TimerWheel::Release(uint32_t index)
+{
+	Node &node = nodes_[index];
+	node.active = false;
+	node.slot = kUnlinked;
+	++node.generation;
+	freeNodes_.push_back(index);
+	--activeCount_;
+}
+
+uint32_t TimerWheel::Cascade(uint32_t level)
+{
+	uint32_t slotIndex = static_cast<uint32_t>((currentTick_ >> (kSlotBits * level)) & (kSlotCount - 1));
+	uint32_t slot = level * kSlotCount + slotIndex;
+	uint32_t index = heads_[slot];
+	heads_[slot] = kInvalidIndex;
+	// 今の時刻から見た近さで入れ直す(下の段へ移る)
+	while (index != kInvalidIndex) {
+		uint32_t next = nodes_[index].next;
+		Link(index);
+		index = next;
+	}
+	return slotIndex;
+}
+
+void TimerWheel::Step()
+{
+	// 最下段が一周したら、上の段の今の時刻に当たるスロットを下ろす(その段も一周していればさらに上も)
+	uint32_t slotIndex = static_cast<uint32_t>(currentTick_ & (kSlotCount - 1));
+	if (slotIndex == 0) {
+		for (uint32_t level = 1; level < kLevelCount; ++level) {
+			if (Cascade(level) != 0) {
+				break;
+			}
+		}
+	}
+
+	// 最下段のスロットのタイマーは全てこのティックで満了する。まとめて取り出してから呼ぶ
+	expired_.clear();
+	uint32_t index = heads_[slotIndex];
+	heads_[slotIndex] = kInvalidIndex;
+	while (index != kInvalidIndex) {
+		Node &node = nodes_[index];
+		node.slot = kUnlinked;
+		expired_.push_back({ index, node.generation });
+		index = node.next;
+	}
+	// コールバックの中で登録されたものが次のティックで満了するよう、先に時刻を進める
+	++currentTick_;
+
+	for (size_t i = 0; i < expired_.size(); ++i) {
+		TimerHandle handle = expired_[i];
+		// 先に呼んだコールバックで取り消されていれば飛ばす
+		if (!IsActive(handle)) {
+			continue;
+		}
+		// コールバック中の登録でnodes_が伸びるので、参照は持ち越さない
+		Node &node = nodes_[handle.index];
+		CallbackId callback = node.callback;
+		uint64_t userData = node.userData;
+		if (node.interval > 0) {
+			// 繰り返すものは次の満了時刻で繋ぎ直す(コールバックの中で取り消せる)
+			node.expireTick += node.interval;
+			Link(handle.index);
+		} else {
+			Release(handle.index);
+		}
+		callbacks_[callback](handle, userData);
+	}
+}
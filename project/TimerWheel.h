@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// タイマーのハンドル(ノード番号 + 世代番号)
+struct TimerHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool operator==(const TimerHandle &other) const = default;
+};
+
+// 階層タイミングホイールによるゲーム内タイマー(クールダウン、遅延再生、出現など)
+// 時間の単位はティック(シミュレーションの1ステップ)で、満了の近さで段を分けたリングのスロットに入れておく
+// 登録・取り消しはO(1)、ティックごとに満了したスロットをまとめて取り出してコールバックを呼ぶ
+// 上の段のスロットは下の段が一周するたびに1つずつ下ろす(カスケード)
+//
+// コールバックは関数の表に一度だけ登録し、タイマーは表の番号と任意の64bit値(エンティティなど)だけを持つ
+class TimerWheel
+{
+public:
+	// コールバックの番号
+	using CallbackId = uint32_t;
+	// 満了時に呼ばれる処理(userDataは登録時に渡した値)
+	using Callback = std::function<void(TimerHandle handle, uint64_t userData)>;
+
+	// 1段のスロット数(ビット数)
+	static constexpr uint32_t kSlotBits = 8;
+	static constexpr uint32_t kSlotCount = 1u << kSlotBits;
+	// 段数(kSlotCount^kLevelCountティック先まで。それより先は最上段に入れておき、下ろすときに入れ直す)
+	static constexpr uint32_t kLevelCount = 4;
+
+public: // メンバ関数
+	// コールバックを登録して番号を返す
+	CallbackId RegisterCallback(Callback callback);
+
+	/// <summary>
+	/// タイマーを登録する
+	/// </summary>
+	/// <param name="delayTicks">満了までのティック数(1なら次のAdvanceで1ティック進めたとき。0も1として扱う)</param>
+	/// <param name="intervalTicks">0より大きければ満了後にこの間隔で繰り返す</param>
+	TimerHandle Schedule(uint32_t delayTicks, CallbackId callback, uint64_t userData = 0, uint32_t intervalTicks = 0);
+	// 取り消す(満了済み・取り消し済みならfalse)
+	bool Cancel(TimerHandle handle);
+	// 満了待ちか(繰り返しのタイマーは取り消すまで満了待ちのまま)
+	bool IsActive(TimerHandle handle) const;
+	// 満了までの残りティック数(無効なハンドルなら0)
+	uint64_t GetRemainingTicks(TimerHandle handle) const;
+
+	/// <summary>
+	/// tickCountティック進め、満了したタイマーのコールバックを呼ぶ
+	/// コールバックの中でタイマーを登録・取り消ししてもよい。同じティックで満了したもの同士の順番は決まらない
+	/// </summary>
+	void Advance(uint32_t tickCount = 1);
+
+	// 全て取り消す(コールバックの表は残す)
+	void Clear();
+
+	// 満了待ちのタイマー数
+	uint32_t GetActiveCount() const { return activeCount_; }
+	// 次に処理するティック
+	uint64_t GetCurrentTick() const { return currentTick_; }
+
+private:
+	static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+	// ノードがどのスロットにも繋がっていない(未使用、または満了処理中)
+	static constexpr uint32_t kUnlinked = UINT32_MAX;
+
+	// タイマー1つ分(スロットごとの双方向リストのノード)
+	struct Node
+	{
+		uint64_t expireTick = 0;
+		uint64_t userData = 0;
+		uint32_t interval = 0;
+		CallbackId callback = 0;
+		uint32_t next = kInvalidIndex;
+		uint32_t prev = kInvalidIndex;
+		uint32_t slot = kUnlinked; //!< 繋がっているスロット(段 * kSlotCount + 番号)
+		uint32_t generation = 0;
+		bool active = false;
+	};
+
+	// 満了時刻に応じたスロットに繋ぐ
+	void Link(uint32_t index);
+	// スロットから外す
+	void Unlink(uint32_t index);
+	// ノードを空きに戻す(世代を進めて古いハンドルを無効にする)
+	void Release(uint32_t index);
+	// 上の段のスロットを下の段へ下ろし、下ろしたスロットの番号を返す
+	uint32_t Cascade(uint32_t level);
+	// 1ティック分の満了処理
+	void Step();
+
+	static std::array<uint32_t, kLevelCount * kSlotCount> MakeEmptyHeads()
+	{
+		std::array<uint32_t, kLevelCount * kSlotCount> heads;
+		heads.fill(kInvalidIndex);
+		return heads;
+	}
+
+	std::vector<Node> nodes_;
+	std::vector<uint32_t> freeNodes_;
+	// スロットごとのリストの先頭
+	std::array<uint32_t, kLevelCount * kSlotCount> heads_ = MakeEmptyHeads();
+	// コールバック中に登録されても要素が移動しないようdequeで持つ
+	std::deque<Callback> callbacks_;
+	// 満了したタイマーをまとめて取り出す作業用(番号と世代)
+	std::vector<TimerHandle> expired_;
+	uint64_t currentTick_ = 0;
+	uint32_t activeCount_ = 0;
+};
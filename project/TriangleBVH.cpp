@@ -0,0 +1,870 @@
+#include "TriangleBVH.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TRIANGLE_BVH_SSE2
+#endif
+
+namespace mesh
+{
+	namespace
+	{
+		// SAHの分割候補を探すビンの数
+		constexpr uint32_t kBinCount = 16;
+		// 葉に入れる三角形の最大数(三角形ブロック1つ分)
+		constexpr uint32_t kMaxLeafSize = 4;
+		// 上の階層はこの三角形数以下になるまで分割し、その先の部分木はジョブごとに並列に作る
+		constexpr uint32_t kSubtreeSize = 16 * 1024;
+		// これより多い範囲はビンへの振り分けも並列に行う
+		constexpr uint32_t kBinningGroupSize = 64 * 1024;
+		// ジョブ1つで処理する三角形・レイの束の数
+		constexpr uint32_t kPrepareGroupSize = 32 * 1024;
+		constexpr uint32_t kPacketGroupSize = 64;
+		// 走査スタックの深さ(ノード1つで最大3つ積む)
+		constexpr uint32_t kStackSize = 256;
+		// 空いた子の境界(どのレイとも当たらないように子の参照でも弾く)
+		constexpr float kEmptyBound = 1.0e30f;
+
+		struct Bounds
+		{
+			float min[3] = { kEmptyBound, kEmptyBound, kEmptyBound };
+			float max[3] = { -kEmptyBound, -kEmptyBound, -kEmptyBound };
+
+			void Grow(const std::array<float, 3> &point)
+			{
+				for (int axis = 0; axis < 3; ++axis) {
+					min[axis] = (std::min)(min[axis], point[axis]);
+					max[axis] = (std::max)(max[axis], point[axis]);
+				}
+			}
+			void Grow(const Bounds &other)
+			{
+				for (int axis = 0; axis < 3; ++axis) {
+					min[axis] = (std::min)(min[axis], other.min[axis]);
+					max[axis] = (std::max)(max[axis], other.max[axis]);
+				}
+			}
+			float SurfaceArea() const
+			{
+				float x = max[0] - min[0];
+				float y = max[1] - min[1];
+				float z = max[2] - min[2];
+				return x < 0.0f ? 0.0f : 2.0f * (x * y + y * z + z * x);
+			}
+		};
+
+		// 構築中の二分木のノード
+		struct BuildNode
+		{
+			Bounds bounds;
+			uint32_t first = 0; //!< 葉: 三角形番号列の先頭 / 内部: 左の子(右の子はその次)
+			uint32_t count = 0; //!< 葉の三角形数(0なら内部ノード)
+		};
+
+		struct Bin
+		{
+			Bounds bounds;
+			uint32_t count = 0;
+		};
+		// 3軸分のビン
+		struct BinSet
+		{
+			Bin bins[3][kBinCount];
+
+			void Merge(const BinSet &other)
+			{
+				for (int axis = 0; axis < 3; ++axis) {
+					for (uint32_t b = 0; b < kBinCount; ++b) {
+						bins[axis][b].bounds.Grow(other.bins[axis][b].bounds);
+						bins[axis][b].count += other.bins[axis][b].count;
+					}
+				}
+			}
+		};
+
+		// 上の階層を作り終えた後に、並列に作る部分木
+		struct SubtreeTask
+		{
+			uint32_t node;
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		// SAHでの二分木の構築
+		// ビンへの振り分けと部分木の構築を並列にしても、min/maxと整数の数え上げしか行わないので結果は変わらない
+		class Builder
+		{
+		public:
+			Builder(std::span<const math::Vector3> positions, std::span<const uint32_t> indices, bool parallel)
+				: positions_(positions), indices_(indices), parallel_(parallel)
+			{
+				uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+				triangleBounds_.resize(triangleCount);
+				centroids_.resize(triangleCount);
+				ids_.resize(triangleCount);
+				Run(triangleCount, kPrepareGroupSize, [this](uint32_t begin, uint32_t end) {
+					for (uint32_t t = begin; t < end; ++t) {
+						Bounds bounds;
+						for (uint32_t corner = 0; corner < 3; ++corner) {
+							const math::Vector3 &p = positions_[indices_[t * 3 + corner]];
+							bounds.Grow(std::array<float, 3> { p.x, p.y, p.z });
+						}
+						triangleBounds_[t] = bounds;
+						for (int axis = 0; axis < 3; ++axis) {
+							centroids_[t][axis] = (bounds.min[axis] + bounds.max[axis]) * 0.5f;
+						}
+						ids_[t] = t;
+					}
+					});
+			}
+
+			// 二分木を作る(nodes[0]がルート)
+			void Build(std::vector<BuildNode> &nodes)
+			{
+				nodes.clear();
+				nodes.emplace_back();
+				uint32_t triangleCount = static_cast<uint32_t>(ids_.size());
+				nodes[0].bounds = ComputeBounds(0, triangleCount);
+
+				// 上の階層
+				std::vector<SubtreeTask> tasks;
+				BuildTop(nodes, 0, 0, triangleCount, tasks);
+
+				// 部分木はそれぞれ別の配列に作り、順番に繋げる
+				std::vector<std::vector<BuildNode>> subtrees(tasks.size());
+				Run(static_cast<uint32_t>(tasks.size()), 1, [&](uint32_t begin, uint32_t end) {
+					for (uint32_t i = begin; i < end; ++i) {
+						subtrees[i].push_back(nodes[tasks[i].node]);
+						Split(subtrees[i], 0, tasks[i].begin, tasks[i].end);
+					}
+					});
+				for (size_t i = 0; i < tasks.size(); ++i) {
+					// 部分木の0番(ルート)は上の階層のノードに置き換え、それ以外は末尾に並べる
+					uint32_t offset = static_cast<uint32_t>(nodes.size()) - 1;
+					for (size_t n = 1; n < subtrees[i].size(); ++n) {
+						BuildNode node = subtrees[i][n];
+						if (node.count == 0) {
+							node.first += offset;
+						}
+						nodes.push_back(node);
+					}
+					BuildNode root = subtrees[i][0];
+					if (root.count == 0) {
+						root.first += offset;
+					}
+					nodes[tasks[i].node] = root;
+				}
+			}
+
+			const std::vector<uint32_t> &GetIds() const { return ids_; }
+
+		private:
+			// 全体を一度に処理するか、ジョブに分けて処理するか
+			template <class Func>
+			void Run(uint32_t count, uint32_t groupSize, const Func &func)
+			{
+				if (parallel_ && count > groupSize) {
+					JobSystem::GetInstance()->ParallelFor(count, groupSize, func);
+				} else if (count > 0) {
+					func(0, count);
+				}
+			}
+
+			Bounds ComputeBounds(uint32_t begin, uint32_t end) const
+			{
+				Bounds bounds;
+				for (uint32_t i = begin; i < end; ++i) {
+					bounds.Grow(triangleBounds_[ids_[i]]);
+				}
+				return bounds;
+			}
+
+			void BuildTop(std::vector<BuildNode> &nodes, uint32_t nodeIndex, uint32_t begin, uint32_t end, std::vector<SubtreeTask> &tasks)
+			{
+				if (end - begin <= kSubtreeSize) {
+					tasks.push_back({ nodeIndex, begin, end });
+					return;
+				}
+				uint32_t left = SplitOnce(nodes, nodeIndex, begin, end);
+				uint32_t middle = begin + nodes[left].count;
+				nodes[left].count = 0;
+				nodes[left + 1].count = 0;
+				BuildTop(nodes, left, begin, middle, tasks);
+				BuildTop(nodes, left + 1, middle, end, tasks);
+			}
+
+			void Split(std::vector<BuildNode> &nodes, uint32_t nodeIndex, uint32_t begin, uint32_t end)
+			{
+				if (end - begin <= kMaxLeafSize) {
+					nodes[nodeIndex].first = begin;
+					nodes[nodeIndex].count = end - begin;
+					return;
+				}
+				uint32_t left = SplitOnce(nodes, nodeIndex, begin, end);
+				uint32_t middle = begin + nodes[left].count;
+				Split(nodes, left, begin, middle);
+				Split(nodes, left + 1, middle, end);
+			}
+
+			/// <summary>
+			/// ノードを2つに分け、子を2つ追加する
+			/// </summary>
+			/// <returns>左の子の番号(子のcountには仮に三角形数を入れて返す)</returns>
+			uint32_t SplitOnce(std::vector<BuildNode> &nodes, uint32_t nodeIndex, uint32_t begin, uint32_t end)
+			{
+				// 重心の範囲
+				Bounds centroidBounds;
+				for (uint32_t i = begin; i < end; ++i) {
+					centroidBounds.Grow(centroids_[ids_[i]]);
+				}
+
+				// ビンに振り分ける
+				float binScale[3];
+				for (int axis = 0; axis < 3; ++axis) {
+					float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+					binScale[axis] = extent > 0.0f ? float(kBinCount) / extent : 0.0f;
+				}
+				auto getBin = [&](uint32_t triangle, int axis) {
+					float offset = (centroids_[triangle][axis] - centroidBounds.min[axis]) * binScale[axis];
+					return (std::min)(static_cast<uint32_t>(offset), kBinCount - 1);
+				};
+				auto fillBins = [&](uint32_t first, uint32_t last, BinSet &binSet) {
+					for (uint32_t i = first; i < last; ++i) {
+						uint32_t triangle = ids_[i];
+						for (int axis = 0; axis < 3; ++axis) {
+							Bin &bin = binSet.bins[axis][getBin(triangle, axis)];
+							bin.bounds.Grow(triangleBounds_[triangle]);
+							++bin.count;
+						}
+					}
+				};
+				uint32_t count = end - begin;
+				BinSet binSet;
+				if (count <= kBinningGroupSize) {
+					fillBins(begin, end, binSet);
+				} else {
+					// グループごとのビンを作ってから順に合わせる
+					std::vector<BinSet> groupBinSets((count + kBinningGroupSize - 1) / kBinningGroupSize);
+					Run(count, kBinningGroupSize, [&](uint32_t first, uint32_t last) {
+						for (uint32_t group = first / kBinningGroupSize; group * kBinningGroupSize < last; ++group) {
+							fillBins(begin + group * kBinningGroupSize, (std::min)(begin + (group + 1) * kBinningGroupSize, end), groupBinSets[group]);
+						}
+						});
+					for (const BinSet &groupBinSet : groupBinSets) {
+						binSet.Merge(groupBinSet);
+					}
+				}
+
+				// 分割面ごとのコスト(左右の表面積 * 三角形数)
+				int bestAxis = -1;
+				uint32_t bestSplit = 0;
+				float bestCost = 0.0f;
+				Bounds bestLeft;
+				Bounds bestRight;
+				for (int axis = 0; axis < 3; ++axis) {
+					if (binScale[axis] == 0.0f) {
+						continue;
+					}
+					const Bin (&bins)[kBinCount] = binSet.bins[axis];
+					// 右側の累積を先に求める
+					Bounds rightBounds[kBinCount];
+					uint32_t rightCounts[kBinCount] = {};
+					Bounds accumulated;
+					uint32_t accumulatedCount = 0;
+					for (uint32_t b = kBinCount - 1; b > 0; --b) {
+						accumulated.Grow(bins[b].bounds);
+						accumulatedCount += bins[b].count;
+						rightBounds[b] = accumulated;
+						rightCounts[b] = accumulatedCount;
+					}
+					accumulated = Bounds {};
+					accumulatedCount = 0;
+					for (uint32_t b = 1; b < kBinCount; ++b) {
+						accumulated.Grow(bins[b - 1].bounds);
+						accumulatedCount += bins[b - 1].count;
+						if (accumulatedCount == 0 || rightCounts[b] == 0) {
+							continue;
+						}
+						float cost = accumulated.SurfaceArea() * float(accumulatedCount) + rightBounds[b].SurfaceArea() * float(rightCounts[b]);
+						if (bestAxis < 0 || cost < bestCost) {
+							bestAxis = axis;
+							bestSplit = b;
+							bestCost = cost;
+							bestLeft = accumulated;
+							bestRight = rightBounds[b];
+						}
+					}
+				}
+
+				uint32_t middle;
+				if (bestAxis >= 0) {
+					uint32_t *split = std::partition(ids_.data() + begin, ids_.data() + end, [&](uint32_t triangle) {
+						return getBin(triangle, bestAxis) < bestSplit;
+						});
+					middle = static_cast<uint32_t>(split - ids_.data());
+				} else {
+					// 重心が全て同じ位置にあるので、数で半分に分ける
+					middle = begin + count / 2;
+					bestLeft = ComputeBounds(begin, middle);
+					bestRight = ComputeBounds(middle, end);
+				}
+
+				uint32_t left = static_cast<uint32_t>(nodes.size());
+				nodes.resize(nodes.size() + 2);
+				nodes[nodeIndex].first = left;
+				nodes[nodeIndex].count = 0;
+				nodes[left].bounds = bestLeft;
+				nodes[left].count = middle - begin;
+				nodes[left + 1].bounds = bestRight;
+				nodes[left + 1].count = end - middle;
+				return left;
+			}
+
+			std::span<const math::Vector3> positions_;
+			std::span<const uint32_t> indices_;
+			bool parallel_;
+
+			std::vector<Bounds> triangleBounds_;
+			std::vector<std::array<float, 3>> centroids_;
+			// 三角形番号の並び(葉は連続する範囲を持つ)
+			std::vector<uint32_t> ids_;
+		};
+
+		// 向きの成分が0のときに逆数が無限大になり、0 * 無限大でNaNが出るのを避ける
+		float SafeInverse(float value)
+		{
+			constexpr float kMinimum = 1.0e-20f;
+			return 1.0f / (std::abs(value) < kMinimum ? std::copysign(kMinimum, value) : value);
+		}
+
+		// 4つ並んだ値から、maskの立っている最小のものを選ぶ
+		uint32_t SelectNearest(const float (&values)[4], int mask)
+		{
+			uint32_t nearest = 0;
+			float nearestValue = 0.0f;
+			bool found = false;
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				if ((mask & (1 << lane)) && (!found || values[lane] < nearestValue)) {
+					nearest = lane;
+					nearestValue = values[lane];
+					found = true;
+				}
+			}
+			return nearest;
+		}
+
+		// 走査スタックの要素
+		struct StackEntry
+		{
+			uint32_t child;
+			float distance; //!< AABBに入る距離(これより近い交差が見つかっていれば飛ばせる)
+		};
+
+		// 当たった子を遠い順に積む(近いものから取り出される)
+		void PushSorted(StackEntry *stack, uint32_t &stackSize, StackEntry (&entries)[4], uint32_t count)
+		{
+			for (uint32_t i = 1; i < count; ++i) {
+				StackEntry entry = entries[i];
+				uint32_t j = i;
+				for (; j > 0 && entries[j - 1].distance < entry.distance; --j) {
+					entries[j] = entries[j - 1];
+				}
+				entries[j] = entry;
+			}
+			assert(stackSize + count <= kStackSize);
+			for (uint32_t i = 0; i < count; ++i) {
+				stack[stackSize++] = entries[i];
+			}
+		}
+	}
+
+	void TriangleBVH::Build(std::span<const math::Vector3> positions, std::span<const uint32_t> indices, bool parallel)
+	{
+		assert(indices.size() % 3 == 0);
+		nodes_.clear();
+		blocks_.clear();
+		triangleCount_ = static_cast<uint32_t>(indices.size() / 3);
+		boundsMin_ = { 0.0f,0.0f,0.0f };
+		boundsMax_ = { 0.0f,0.0f,0.0f };
+		if (triangleCount_ == 0) {
+			return;
+		}
+
+		Builder builder(positions, indices, parallel);
+		std::vector<BuildNode> binaryNodes;
+		builder.Build(binaryNodes);
+		const std::vector<uint32_t> &ids = builder.GetIds();
+		boundsMin_ = { binaryNodes[0].bounds.min[0], binaryNodes[0].bounds.min[1], binaryNodes[0].bounds.min[2] };
+		boundsMax_ = { binaryNodes[0].bounds.max[0], binaryNodes[0].bounds.max[1], binaryNodes[0].bounds.max[2] };
+
+		// 二分木を、子を4つ持つノードに畳む
+		// 子のうち表面積の最も大きい内部ノードを、その子2つで置き換えることを4つになるまで繰り返す
+		nodes_.reserve(binaryNodes.size() / 2 + 1);
+		blocks_.reserve((triangleCount_ + kMaxLeafSize - 1) / kMaxLeafSize * 2);
+		auto makeBlock = [&](const BuildNode &leaf) {
+			TriangleBlock block {};
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				block.ids[lane] = RayHit::kNone;
+			}
+			for (uint32_t lane = 0; lane < leaf.count; ++lane) {
+				uint32_t triangle = ids[leaf.first + lane];
+				const math::Vector3 &p0 = positions[indices[triangle * 3 + 0]];
+				const math::Vector3 &p1 = positions[indices[triangle * 3 + 1]];
+				const math::Vector3 &p2 = positions[indices[triangle * 3 + 2]];
+				block.v0x[lane] = p0.x; block.v0y[lane] = p0.y; block.v0z[lane] = p0.z;
+				block.e1x[lane] = p1.x - p0.x; block.e1y[lane] = p1.y - p0.y; block.e1z[lane] = p1.z - p0.z;
+				block.e2x[lane] = p2.x - p0.x; block.e2y[lane] = p2.y - p0.y; block.e2z[lane] = p2.z - p0.z;
+				block.ids[lane] = triangle;
+			}
+			blocks_.push_back(block);
+			return kLeafFlag | static_cast<uint32_t>(blocks_.size() - 1);
+		};
+		auto collapse = [&](auto &self, uint32_t binaryIndex) -> uint32_t {
+			uint32_t nodeIndex = static_cast<uint32_t>(nodes_.size());
+			nodes_.emplace_back();
+
+			uint32_t children[4];
+			uint32_t childCount = 0;
+			if (binaryNodes[binaryIndex].count > 0) {
+				// ルートが葉(三角形が4つ以下)
+				children[childCount++] = binaryIndex;
+			} else {
+				children[childCount++] = binaryNodes[binaryIndex].first;
+				children[childCount++] = binaryNodes[binaryIndex].first + 1;
+			}
+			while (childCount < 4) {
+				int largest = -1;
+				float largestArea = -1.0f;
+				for (uint32_t i = 0; i < childCount; ++i) {
+					const BuildNode &child = binaryNodes[children[i]];
+					if (child.count == 0 && child.bounds.SurfaceArea() > largestArea) {
+						largest = static_cast<int>(i);
+						largestArea = child.bounds.SurfaceArea();
+					}
+				}
+				if (largest < 0) {
+					break;
+				}
+				uint32_t opened = binaryNodes[children[largest]].first;
+				children[largest] = opened;
+				children[childCount++] = opened + 1;
+			}
+
+			Node node {};
+			for (uint32_t i = 0; i < 4; ++i) {
+				if (i >= childCount) {
+					node.minX[i] = node.minY[i] = node.minZ[i] = kEmptyBound;
+					node.maxX[i] = node.maxY[i] = node.maxZ[i] = -kEmptyBound;
+					node.children[i] = kEmptyChild;
+					continue;
+				}
+				const BuildNode &child = binaryNodes[children[i]];
+				node.minX[i] = child.bounds.min[0]; node.minY[i] = child.bounds.min[1]; node.minZ[i] = child.bounds.min[2];
+				node.maxX[i] = child.bounds.max[0]; node.maxY[i] = child.bounds.max[1]; node.maxZ[i] = child.bounds.max[2];
+				node.children[i] = child.count > 0 ? makeBlock(child) : self(self, children[i]);
+			}
+			// 再帰の間にnodes_が伸びるので、最後に番号で書き込む
+			nodes_[nodeIndex] = node;
+			return nodeIndex;
+		};
+		collapse(collapse, 0);
+	}
+
+	bool TriangleBVH::Intersect(const Ray &ray, RayHit &hit) const
+	{
+		hit = RayHit {};
+		hit.distance = ray.maxDistance;
+		if (nodes_.empty()) {
+			return false;
+		}
+#ifdef TRIANGLE_BVH_SSE2
+		if (useSimd_) {
+			return TraverseSimd<false>(ray, hit);
+		}
+#endif
+		return TraverseScalar<false>(ray, hit);
+	}
+
+	bool TriangleBVH::IsOccluded(const Ray &ray) const
+	{
+		if (nodes_.empty()) {
+			return false;
+		}
+		RayHit hit;
+		hit.distance = ray.maxDistance;
+#ifdef TRIANGLE_BVH_SSE2
+		if (useSimd_) {
+			return TraverseSimd<true>(ray, hit);
+		}
+#endif
+		return TraverseScalar<true>(ray, hit);
+	}
+
+	void TriangleBVH::IntersectPacket(const Ray (&rays)[4], RayHit (&hits)[4]) const
+	{
+		for (uint32_t i = 0; i < 4; ++i) {
+			hits[i] = RayHit {};
+			hits[i].distance = rays[i].maxDistance;
+		}
+		if (nodes_.empty()) {
+			return;
+		}
+#ifdef TRIANGLE_BVH_SSE2
+		if (useSimd_) {
+			TraversePacketSimd(rays, hits);
+			return;
+		}
+#endif
+		TraversePacketScalar(rays, hits);
+	}
+
+	void TriangleBVH::IntersectBatch(std::span<const Ray> rays, std::span<RayHit> hits, bool usePackets, bool parallel) const
+	{
+		assert(hits.size() >= rays.size());
+		uint32_t packetCount = static_cast<uint32_t>(rays.size() / 4);
+		auto process = [&](uint32_t begin, uint32_t end) {
+			for (uint32_t packet = begin; packet < end; ++packet) {
+				const Ray *first = rays.data() + size_t(packet) * 4;
+				RayHit *firstHit = hits.data() + size_t(packet) * 4;
+				if (usePackets) {
+					IntersectPacket(*reinterpret_cast<const Ray(*)[4]>(first), *reinterpret_cast<RayHit(*)[4]>(firstHit));
+				} else {
+					for (uint32_t i = 0; i < 4; ++i) {
+						Intersect(first[i], firstHit[i]);
+					}
+				}
+			}
+		};
+		if (parallel && packetCount > kPacketGroupSize) {
+			JobSystem::GetInstance()->ParallelFor(packetCount, kPacketGroupSize, process);
+		} else {
+			process(0, packetCount);
+		}
+		// 4本に満たない残り
+		for (size_t i = size_t(packetCount) * 4; i < rays.size(); ++i) {
+			Intersect(rays[i], hits[i]);
+		}
+	}
+
+	template <bool kAnyHit>
+	bool TriangleBVH::TraverseScalar(const Ray &ray, RayHit &hit) const
+	{
+		const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+		const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+		const float inverse[3] = { SafeInverse(direction[0]), SafeInverse(direction[1]), SafeInverse(direction[2]) };
+		bool found = false;
+
+		StackEntry stack[kStackSize];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = { 0, 0.0f };
+		while (stackSize > 0) {
+			StackEntry entry = stack[--stackSize];
+			if (entry.distance > hit.distance) {
+				continue;
+			}
+
+			if (entry.child & kLeafFlag) {
+				// Möller–Trumboreで三角形と判定する
+				const TriangleBlock &block = blocks_[entry.child & ~kLeafFlag];
+				for (uint32_t lane = 0; lane < 4; ++lane) {
+					const float e1[3] = { block.e1x[lane], block.e1y[lane], block.e1z[lane] };
+					const float e2[3] = { block.e2x[lane], block.e2y[lane], block.e2z[lane] };
+					const float p[3] = {
+						direction[1] * e2[2] - direction[2] * e2[1],
+						direction[2] * e2[0] - direction[0] * e2[2],
+						direction[0] * e2[1] - direction[1] * e2[0] };
+					float determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+					if (determinant == 0.0f) {
+						continue;
+					}
+					float inverseDeterminant = 1.0f / determinant;
+					const float s[3] = { origin[0] - block.v0x[lane], origin[1] - block.v0y[lane], origin[2] - block.v0z[lane] };
+					float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverseDeterminant;
+					if (!(u >= 0.0f && u <= 1.0f)) {
+						continue;
+					}
+					const float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+					float v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverseDeterminant;
+					if (!(v >= 0.0f && u + v <= 1.0f)) {
+						continue;
+					}
+					float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverseDeterminant;
+					if (t > 0.0f && t < hit.distance) {
+						hit.distance = t;
+						hit.triangle = block.ids[lane];
+						hit.u = u;
+						hit.v = v;
+						found = true;
+						if constexpr (kAnyHit) {
+							return true;
+						}
+					}
+				}
+				continue;
+			}
+
+			// 4つの子のAABBと判定する(スラブ法)
+			const Node &node = nodes_[entry.child];
+			StackEntry entries[4];
+			uint32_t entryCount = 0;
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				if (node.children[lane] == kEmptyChild) {
+					continue;
+				}
+				const float min[3] = { node.minX[lane], node.minY[lane], node.minZ[lane] };
+				const float max[3] = { node.maxX[lane], node.maxY[lane], node.maxZ[lane] };
+				float enter = 0.0f;
+				float exit = hit.distance;
+				for (int axis = 0; axis < 3; ++axis) {
+					float t0 = (min[axis] - origin[axis]) * inverse[axis];
+					float t1 = (max[axis] - origin[axis]) * inverse[axis];
+					enter = (std::max)(enter, (std::min)(t0, t1));
+					exit = (std::min)(exit, (std::max)(t0, t1));
+				}
+				if (enter <= exit) {
+					entries[entryCount++] = { node.children[lane], enter };
+				}
+			}
+			PushSorted(stack, stackSize, entries, entryCount);
+		}
+		return found;
+	}
+
+	void TriangleBVH::TraversePacketScalar(const Ray (&rays)[4], RayHit (&hits)[4]) const
+	{
+		for (uint32_t i = 0; i < 4; ++i) {
+			TraverseScalar<false>(rays[i], hits[i]);
+		}
+	}
+
+#ifdef TRIANGLE_BVH_SSE2
+	namespace
+	{
+		__m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+	}
+
+	template <bool kAnyHit>
+	bool TriangleBVH::TraverseSimd(const Ray &ray, RayHit &hit) const
+	{
+		const __m128 originX = _mm_set1_ps(ray.origin.x);
+		const __m128 originY = _mm_set1_ps(ray.origin.y);
+		const __m128 originZ = _mm_set1_ps(ray.origin.z);
+		const __m128 directionX = _mm_set1_ps(ray.direction.x);
+		const __m128 directionY = _mm_set1_ps(ray.direction.y);
+		const __m128 directionZ = _mm_set1_ps(ray.direction.z);
+		const __m128 inverseX = _mm_set1_ps(SafeInverse(ray.direction.x));
+		const __m128 inverseY = _mm_set1_ps(SafeInverse(ray.direction.y));
+		const __m128 inverseZ = _mm_set1_ps(SafeInverse(ray.direction.z));
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		bool found = false;
+
+		StackEntry stack[kStackSize];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = { 0, 0.0f };
+		while (stackSize > 0) {
+			StackEntry entry = stack[--stackSize];
+			if (entry.distance > hit.distance) {
+				continue;
+			}
+
+			if (entry.child & kLeafFlag) {
+				// 4つの三角形をまとめてMöller–Trumboreで判定する
+				const TriangleBlock &block = blocks_[entry.child & ~kLeafFlag];
+				const __m128 e1x = _mm_load_ps(block.e1x), e1y = _mm_load_ps(block.e1y), e1z = _mm_load_ps(block.e1z);
+				const __m128 e2x = _mm_load_ps(block.e2x), e2y = _mm_load_ps(block.e2y), e2z = _mm_load_ps(block.e2z);
+				__m128 px = _mm_sub_ps(_mm_mul_ps(directionY, e2z), _mm_mul_ps(directionZ, e2y));
+				__m128 py = _mm_sub_ps(_mm_mul_ps(directionZ, e2x), _mm_mul_ps(directionX, e2z));
+				__m128 pz = _mm_sub_ps(_mm_mul_ps(directionX, e2y), _mm_mul_ps(directionY, e2x));
+				__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+				__m128 inverseDeterminant = _mm_div_ps(one, determinant);
+				__m128 sx = _mm_sub_ps(originX, _mm_load_ps(block.v0x));
+				__m128 sy = _mm_sub_ps(originY, _mm_load_ps(block.v0y));
+				__m128 sz = _mm_sub_ps(originZ, _mm_load_ps(block.v0z));
+				__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDeterminant);
+				__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+				__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+				__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+				__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qx), _mm_mul_ps(directionY, qy)), _mm_mul_ps(directionZ, qz)), inverseDeterminant);
+				__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDeterminant);
+				__m128 mask = _mm_cmpneq_ps(determinant, zero);
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+				mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+				mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, zero));
+				mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(hit.distance)));
+				int hitMask = _mm_movemask_ps(mask);
+				if (hitMask != 0) {
+					if constexpr (kAnyHit) {
+						return true;
+					}
+					alignas(16) float distances[4];
+					alignas(16) float us[4];
+					alignas(16) float vs[4];
+					_mm_store_ps(distances, t);
+					_mm_store_ps(us, u);
+					_mm_store_ps(vs, v);
+					uint32_t lane = SelectNearest(distances, hitMask);
+					hit.distance = distances[lane];
+					hit.triangle = block.ids[lane];
+					hit.u = us[lane];
+					hit.v = vs[lane];
+					found = true;
+				}
+				continue;
+			}
+
+			// 4つの子のAABBをまとめて判定する(スラブ法)
+			const Node &node = nodes_[entry.child];
+			__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), originX), inverseX);
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), originX), inverseX);
+			__m128 enter = _mm_max_ps(zero, _mm_min_ps(t0, t1));
+			__m128 exit = _mm_min_ps(_mm_set1_ps(hit.distance), _mm_max_ps(t0, t1));
+			t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), originY), inverseY);
+			t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), originY), inverseY);
+			enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+			exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+			t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), originZ), inverseZ);
+			t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), originZ), inverseZ);
+			enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+			exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+			int hitMask = _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+			if (hitMask == 0) {
+				continue;
+			}
+			alignas(16) float enters[4];
+			_mm_store_ps(enters, enter);
+			StackEntry entries[4];
+			uint32_t entryCount = 0;
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				if ((hitMask & (1 << lane)) && node.children[lane] != kEmptyChild) {
+					entries[entryCount++] = { node.children[lane], enters[lane] };
+				}
+			}
+			PushSorted(stack, stackSize, entries, entryCount);
+		}
+		return found;
+	}
+
+	void TriangleBVH::TraversePacketSimd(const Ray (&rays)[4], RayHit (&hits)[4]) const
+	{
+		// 4本のレイを成分ごとに並べる
+		const __m128 originX = _mm_setr_ps(rays[0].origin.x, rays[1].origin.x, rays[2].origin.x, rays[3].origin.x);
+		const __m128 originY = _mm_setr_ps(rays[0].origin.y, rays[1].origin.y, rays[2].origin.y, rays[3].origin.y);
+		const __m128 originZ = _mm_setr_ps(rays[0].origin.z, rays[1].origin.z, rays[2].origin.z, rays[3].origin.z);
+		const __m128 directionX = _mm_setr_ps(rays[0].direction.x, rays[1].direction.x, rays[2].direction.x, rays[3].direction.x);
+		const __m128 directionY = _mm_setr_ps(rays[0].direction.y, rays[1].direction.y, rays[2].direction.y, rays[3].direction.y);
+		const __m128 directionZ = _mm_setr_ps(rays[0].direction.z, rays[1].direction.z, rays[2].direction.z, rays[3].direction.z);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 inverseX = _mm_setr_ps(SafeInverse(rays[0].direction.x), SafeInverse(rays[1].direction.x), SafeInverse(rays[2].direction.x), SafeInverse(rays[3].direction.x));
+		const __m128 inverseY = _mm_setr_ps(SafeInverse(rays[0].direction.y), SafeInverse(rays[1].direction.y), SafeInverse(rays[2].direction.y), SafeInverse(rays[3].direction.y));
+		const __m128 inverseZ = _mm_setr_ps(SafeInverse(rays[0].direction.z), SafeInverse(rays[1].direction.z), SafeInverse(rays[2].direction.z), SafeInverse(rays[3].direction.z));
+		__m128 distance = _mm_setr_ps(hits[0].distance, hits[1].distance, hits[2].distance, hits[3].distance);
+		__m128 hitU = zero;
+		__m128 hitV = zero;
+		// 当たった三角形番号はfloatのビット列として持つ
+		__m128 hitTriangle = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		StackEntry stack[kStackSize];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = { 0, 0.0f };
+		while (stackSize > 0) {
+			StackEntry entry = stack[--stackSize];
+			alignas(16) float distances[4];
+			_mm_store_ps(distances, distance);
+			if (entry.distance > (std::max)((std::max)(distances[0], distances[1]), (std::max)(distances[2], distances[3]))) {
+				continue;
+			}
+
+			if (entry.child & kLeafFlag) {
+				// 三角形1つずつ、4本のレイとまとめて判定する
+				const TriangleBlock &block = blocks_[entry.child & ~kLeafFlag];
+				for (uint32_t lane = 0; lane < 4 && block.ids[lane] != RayHit::kNone; ++lane) {
+					const __m128 e1x = _mm_set1_ps(block.e1x[lane]), e1y = _mm_set1_ps(block.e1y[lane]), e1z = _mm_set1_ps(block.e1z[lane]);
+					const __m128 e2x = _mm_set1_ps(block.e2x[lane]), e2y = _mm_set1_ps(block.e2y[lane]), e2z = _mm_set1_ps(block.e2z[lane]);
+					__m128 px = _mm_sub_ps(_mm_mul_ps(directionY, e2z), _mm_mul_ps(directionZ, e2y));
+					__m128 py = _mm_sub_ps(_mm_mul_ps(directionZ, e2x), _mm_mul_ps(directionX, e2z));
+					__m128 pz = _mm_sub_ps(_mm_mul_ps(directionX, e2y), _mm_mul_ps(directionY, e2x));
+					__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+					__m128 inverseDeterminant = _mm_div_ps(one, determinant);
+					__m128 sx = _mm_sub_ps(originX, _mm_set1_ps(block.v0x[lane]));
+					__m128 sy = _mm_sub_ps(originY, _mm_set1_ps(block.v0y[lane]));
+					__m128 sz = _mm_sub_ps(originZ, _mm_set1_ps(block.v0z[lane]));
+					__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDeterminant);
+					__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+					__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+					__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+					__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qx), _mm_mul_ps(directionY, qy)), _mm_mul_ps(directionZ, qz)), inverseDeterminant);
+					__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDeterminant);
+					__m128 mask = _mm_cmpneq_ps(determinant, zero);
+					mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+					mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+					mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+					mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, zero));
+					mask = _mm_and_ps(mask, _mm_cmplt_ps(t, distance));
+					distance = Select(mask, t, distance);
+					hitU = Select(mask, u, hitU);
+					hitV = Select(mask, v, hitV);
+					hitTriangle = Select(mask, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(block.ids[lane]))), hitTriangle);
+				}
+				continue;
+			}
+
+			// 子1つずつ、4本のレイとまとめて判定する
+			const Node &node = nodes_[entry.child];
+			StackEntry entries[4];
+			uint32_t entryCount = 0;
+			for (uint32_t lane = 0; lane < 4 && node.children[lane] != kEmptyChild; ++lane) {
+				__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minX[lane]), originX), inverseX);
+				__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxX[lane]), originX), inverseX);
+				__m128 enter = _mm_max_ps(zero, _mm_min_ps(t0, t1));
+				__m128 exit = _mm_min_ps(distance, _mm_max_ps(t0, t1));
+				t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minY[lane]), originY), inverseY);
+				t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxY[lane]), originY), inverseY);
+				enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+				exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+				t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minZ[lane]), originZ), inverseZ);
+				t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxZ[lane]), originZ), inverseZ);
+				enter = _mm_max_ps(enter, _mm_min_ps(t0, t1));
+				exit = _mm_min_ps(exit, _mm_max_ps(t0, t1));
+				__m128 mask = _mm_cmple_ps(enter, exit);
+				int hitMask = _mm_movemask_ps(mask);
+				if (hitMask == 0) {
+					continue;
+				}
+				// 当たったレイのうち最も近い入口の距離で並べる
+				alignas(16) float enters[4];
+				_mm_store_ps(enters, enter);
+				entries[entryCount++] = { node.children[lane], enters[SelectNearest(enters, hitMask)] };
+			}
+			PushSorted(stack, stackSize, entries, entryCount);
+		}
+
+		alignas(16) float distances[4];
+		alignas(16) float us[4];
+		alignas(16) float vs[4];
+		alignas(16) uint32_t triangles[4];
+		_mm_store_ps(distances, distance);
+		_mm_store_ps(us, hitU);
+		_mm_store_ps(vs, hitV);
+		_mm_store_si128(reinterpret_cast<__m128i *>(triangles), _mm_castps_si128(hitTriangle));
+		for (uint32_t i = 0; i < 4; ++i) {
+			if (triangles[i] != RayHit::kNone) {
+				hits[i].distance = distances[i];
+				hits[i].triangle = triangles[i];
+				hits[i].u = us[i];
+				hits[i].v = vs[i];
+			}
+		}
+	}
+#endif
+}
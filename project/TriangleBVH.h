@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "MathTypes.h"
+
+namespace mesh
+{
+	// レイ
+	struct Ray
+	{
+		math::Vector3 origin;
+		math::Vector3 direction; //!< 正規化しなくてよい(距離はdirectionの長さ単位になる)
+		float maxDistance = 1.0e30f;
+	};
+
+	// レイと三角形の交差結果
+	struct RayHit
+	{
+		static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+		float distance = 1.0e30f;
+		uint32_t triangle = kNone; //!< 三角形番号(インデックス / 3)。当たらなければkNone
+		float u = 0.0f; //!< 重心座標(頂点1の重み)
+		float v = 0.0f; //!< 重心座標(頂点2の重み)
+
+		bool IsHit() const { return triangle != kNone; }
+	};
+
+	// 三角形メッシュのBVH(レイとの交差判定用)
+	// SAH(表面積ヒューリスティック)で二分木を作り、子を4つずつ持つノードに畳んで保持する
+	// ノードは4つの子のAABBを成分ごとに並べた1ノード2キャッシュライン、葉は三角形4つを同じ形で並べたブロックで、
+	// 1本のレイなら4つのAABB・4つの三角形を、4本のレイの束なら1つのAABB・三角形を4本同時にSIMDで判定する
+	class TriangleBVH
+	{
+	public:
+		/// <summary>
+		/// 構築する(頂点・インデックスは複製して三角形ブロックに詰めるので、呼び出し後は不要)
+		/// </summary>
+		/// <param name="indices">三角形リストのインデックス</param>
+		/// <param name="parallel">ジョブシステムで並列に構築するか(結果はどちらでも同じ)</param>
+		void Build(std::span<const math::Vector3> positions, std::span<const uint32_t> indices, bool parallel = true);
+
+		// 最も近い交差を求める(ray.maxDistanceより遠いものは無視する)。当たらなければhitはIsHitがfalseになる
+		bool Intersect(const Ray &ray, RayHit &hit) const;
+
+		// 何かに当たるか(視線の通りの判定などで、最も近いものを探さない)
+		bool IsOccluded(const Ray &ray) const;
+
+		// 4本のレイをまとめて判定する(向きの揃ったレイ向け)
+		void IntersectPacket(const Ray (&rays)[4], RayHit (&hits)[4]) const;
+
+		/// <summary>
+		/// 多数のレイを判定する。4本ずつの束に分け、ジョブシステムで並列に処理する
+		/// </summary>
+		/// <param name="usePackets">束で判定するか(falseなら1本ずつ)</param>
+		void IntersectBatch(std::span<const Ray> rays, std::span<RayHit> hits, bool usePackets = true, bool parallel = true) const;
+
+		// SIMDで判定するか(比較計測用)
+		void SetUseSimd(bool useSimd) { useSimd_ = useSimd; }
+
+		uint32_t GetNodeCount() const { return static_cast<uint32_t>(nodes_.size()); }
+		uint32_t GetTriangleCount() const { return triangleCount_; }
+		// メッシュ全体のAABB
+		const math::Vector3 &GetBoundsMin() const { return boundsMin_; }
+		const math::Vector3 &GetBoundsMax() const { return boundsMax_; }
+
+	private:
+		// 子の参照の最上位ビットが立っていれば葉(下位ビットは三角形ブロック番号)
+		static constexpr uint32_t kLeafFlag = 0x80000000u;
+		static constexpr uint32_t kEmptyChild = 0xFFFFFFFFu;
+
+		// 子を4つ持つノード(子のAABBは成分ごとの配列)
+		struct alignas(64) Node
+		{
+			float minX[4];
+			float minY[4];
+			float minZ[4];
+			float maxX[4];
+			float maxY[4];
+			float maxZ[4];
+			uint32_t children[4];
+		};
+
+		// 三角形4つ分(頂点0と2辺を成分ごとの配列で持つ。空きは辺が0で決して当たらない)
+		struct alignas(16) TriangleBlock
+		{
+			float v0x[4], v0y[4], v0z[4];
+			float e1x[4], e1y[4], e1z[4];
+			float e2x[4], e2y[4], e2z[4];
+			uint32_t ids[4];
+		};
+
+		template <bool kAnyHit>
+		bool TraverseScalar(const Ray &ray, RayHit &hit) const;
+		template <bool kAnyHit>
+		bool TraverseSimd(const Ray &ray, RayHit &hit) const;
+		void TraversePacketScalar(const Ray (&rays)[4], RayHit (&hits)[4]) const;
+		void TraversePacketSimd(const Ray (&rays)[4], RayHit (&hits)[4]) const;
+
+		std::vector<Node> nodes_;
+		std::vector<TriangleBlock> blocks_;
+		uint32_t triangleCount_ = 0;
+		math::Vector3 boundsMin_ = { 0.0f,0.0f,0.0f };
+		math::Vector3 boundsMax_ = { 0.0f,0.0f,0.0f };
+		bool useSimd_ = true;
+	};
+}
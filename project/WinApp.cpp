@@ -1,4 +1,6 @@
 #include "WinApp.h"
+#include "EngineEvents.h"
+#include "EventBus.h"
 
 #include "externals/imgui/imgui.h"
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -22,6 +24,11 @@ LRESULT CALLBACK WinApp::WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM l
 		// osに対して、アプリの終了を伝える
 		PostQuitMessage(0);
 		return 0;
+
+		// クライアント領域の大きさが変わった
+		case WM_SIZE:
+		EventBus::GetInstance()->Publish(WindowResizedEvent { LOWORD(lparam), HIWORD(lparam) });
+		break;
 	}
 
 	// 標準のメッセージ処理を行う
@@ -5,6 +5,10 @@
 #include <fstream>
 #include <chrono>
 #include <numbers>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <memory>
 
 #include <strsafe.h>
 #include <DbgHelp.h>
@@ -15,9 +19,31 @@
 #include "D3DResourceLeakChecker.h"
 #include "SpriteCommon.h"
 #include "Sprite.h"
+#include "SpritePool.h"
 #include "MathFunctions.h"
 #include "Light.h"
 #include "TextureManager.h"
+#include "JobSystem.h"
+#include "Task.h"
+#include "EventBus.h"
+#include "EngineEvents.h"
+#include "ECS.h"
+#include "Components.h"
+#include "GameSystems.h"
+#include "Benchmark.h"
+#include "SelfCheck.h"
+#include "InitGraph.h"
+#include "BenchmarkScene.h"
+#include "GameLoop.h"
+#include "TimerWheel.h"
+#include "PerfCounters.h"
+#include "PerfOverlay.h"
+#include "FrameArena.h"
+#include "SpriteRenderer.h"
+#include "RenderThread.h"
+#include "Logger.h"
+#include "CommandCapture.h"
+#include "CommandReplay.h"
 
 #pragma comment(lib,"dxguid.lib")
 #pragma comment(lib,"dxcompiler.lib")
@@ -181,6 +207,9 @@ void SoundPlayWave(IXAudio2 *xAudio2, const SoundData &soundData) {
 	// 波形データの再生
 	result = pSourceVoice->SubmitSourceBuffer(&buf);
 	result = pSourceVoice->Start();
+
+	static const PerfCounters::CounterId kVoicesStarted = PerfCounters::Register("audio.voicesStarted");
+	PerfCounters::Add(kVoicesStarted);
 }
 
 #pragma region SystemBase
@@ -341,7 +370,7 @@ static LONG WINAPI ExportDump(EXCEPTION_POINTERS *exception) {
 //#pragma endregion
 
 // Windowsアプリでのエントリーポイント（main関数）
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR lpCmdLine, int) {
 
 	// 誰も補捉しなかった場合に(Unhandled)、補捉する関数を登録
 	SetUnhandledExceptionFilter(ExportDump);
@@ -367,53 +396,198 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 #pragma endregion
 
-#pragma region ウィンドウを作ろう
+	// 性能カウンタはワーカーが加算し始める前に作っておく
+	PerfCounters::GetInstance();
+	// ジョブシステムの初期化
+	JobSystem::GetInstance()->Initialize();
+	FrameArena::GetThreadArena().SetName("Main");
+	// コルーチンの再開先(I/Oスレッド、フレームの境界)の初期化
+	TaskScheduler::GetInstance()->Initialize();
+
+#pragma region ベンチマーク
+
+	// -benchmark 指定時は計測だけ行って終了する
+	if (std::string(lpCmdLine).find("-benchmark") != std::string::npos) {
+		Benchmark::RunAll(logStream);
+		FrameArena::Report(logStream);
+		TaskScheduler::GetInstance()->Finalize();
+		JobSystem::GetInstance()->Finalize();
+		PerfCounters::GetInstance()->Finalize();
+		return 0;
+	}
 
-	// ポインタ
-	WinApp *winApp = nullptr;
+	// -selfcheck 指定時は動作確認だけ行って終了する
+	if (std::string(lpCmdLine).find("-selfcheck") != std::string::npos) {
+		bool passed = SelfCheck::RunAll(logStream);
+		TaskScheduler::GetInstance()->Finalize();
+		JobSystem::GetInstance()->Finalize();
+		PerfCounters::GetInstance()->Finalize();
+		return passed ? 0 : 1;
+	}
 
-	// WindowsAPIの初期化
-	winApp = new WinApp();
-	winApp->Initialize();
+	// -replay <ファイル> 指定時はキャプチャを再生して集計だけ行い終了する(D3Dは使わない。tools/HeadlessMain.cppの replay と同じ)
+	// 空白を含むパスは "" で囲む
+	std::string commandLine(lpCmdLine);
+	if (size_t position = commandLine.find("-replay "); position != std::string::npos) {
+		std::istringstream arguments(commandLine.substr(position + std::strlen("-replay ")));
+		std::string capturePath;
+		arguments >> std::quoted(capturePath);
+		bool valid = render::ReplayCaptureFile(capturePath, logStream);
+		TaskScheduler::GetInstance()->Finalize();
+		JobSystem::GetInstance()->Finalize();
+		PerfCounters::GetInstance()->Finalize();
+		return valid ? 0 : 1;
+	}
 
-#pragma endregion
+	// -scene <設定> 指定時はデモの代わりに計測用のシーンを回し、結果をJSONに書き出して終了する
+	// -headless も指定すればD3Dを使わず、描画コマンドはNullCommandBackendに流す
+	Benchmark::SceneSettings sceneSettings;
+	bool runScene = false;
+	if (size_t position = commandLine.find("-scene "); position != std::string::npos) {
+		std::istringstream arguments(commandLine.substr(position + std::strlen("-scene ")));
+		std::string sceneText;
+		arguments >> sceneText;
+		runScene = Benchmark::ParseSceneSettings(sceneText, sceneSettings);
+		if (!runScene) {
+			Logger::Log(logStream, "[Scene] invalid settings: " + sceneText);
+		}
+		sceneSettings.headless = commandLine.find("-headless") != std::string::npos;
+	}
+	if (runScene && sceneSettings.headless) {
+		Benchmark::SceneResult sceneResult = Benchmark::RunSceneHeadless(sceneSettings);
+		Benchmark::LogSceneResult(sceneResult, logStream);
+		Benchmark::WriteSceneResult(sceneResult, sceneSettings.outputPath);
+		TaskScheduler::GetInstance()->Finalize();
+		JobSystem::GetInstance()->Finalize();
+		PerfCounters::GetInstance()->Finalize();
+		return 0;
+	}
 
-	D3DResourceLeakChecker leakCheck;
+#pragma endregion
 
-#pragma region DirectX
+#pragma region 起動処理
 
 	// ポインタ
-	DirectXCommon *dxCommon = nullptr;
+	WinApp *winApp = new WinApp();
 
-	// DirectXの初期化
-	dxCommon = new DirectXCommon();
-	dxCommon->Initialize(winApp);
-
-#pragma endregion
-
-	TextureManager::GetInstance()->SetDirectXCommon(dxCommon);
-	// テクスチャマネージャの初期化
-	TextureManager::GetInstance()->Initialize();
-
-#pragma region 基盤システムの初期化
+	D3DResourceLeakChecker leakCheck;
 
-	SpriteCommon *spriteCommon = nullptr;
-	// スプライト共通部の初期化
-	spriteCommon = new SpriteCommon;
-	spriteCommon->Initialize(dxCommon);
+	DirectXCommon *dxCommon = new DirectXCommon();
+	SpriteCommon *spriteCommon = new SpriteCommon;
+	// スプライト描画(描画スレッドで使う)
+	SpriteRenderer *spriteRenderer = new SpriteRenderer;
+	// 描画スレッド
+	RenderThread *renderThread = new RenderThread;
+	// 入力
+	Input *input = new Input();
 
-#pragma endregion
-
-#pragma region 最初のシーンの初期化
+	// 音声
+	Microsoft::WRL::ComPtr<IXAudio2> xAudio2;
+	IXAudio2MasteringVoice *masterVoice = nullptr;
+	SoundData soundData1 {};
 
 	std::vector<std::string> textures = {
 	"resources/textures/uvChecker.png",
 	"resources/textures/monsterball.png"
 	};
+	std::vector<DirectX::ScratchImage> decodedTextures(textures.size());
+
+	// スレッド間のイベントのチャンネル(ウィンドウの生成中にも出るので、起動処理より前に作る)
+	EventBus::GetInstance()->CreateChannel<WindowResizedEvent>(16, event::DrainPoint::MainFrame, event::ProducerMode::Single);
+	EventBus::GetInstance()->CreateChannel<TextureLoadedEvent>(64, event::DrainPoint::MainFrame, event::ProducerMode::Single);
+	EventBus::GetInstance()->Subscribe<WindowResizedEvent>([&logStream](std::span<const WindowResizedEvent> events) {
+		// 同じフレームに複数来たら最後の大きさだけでよい
+		Logger::Log(logStream, std::format("[Event] window resized {}x{}", events.back().width, events.back().height));
+		});
+	EventBus::GetInstance()->Subscribe<TextureLoadedEvent>([&logStream](std::span<const TextureLoadedEvent> events) {
+		for (const TextureLoadedEvent &loaded : events) {
+			Logger::Log(logStream, std::format("[Event] texture loaded index:{}", loaded.textureIndex));
+		}
+		});
+
+	// 各サブシステムの初期化を依存関係つきで登録し、互いに依存しないもの
+	// (WAVの読み込み、テクスチャのデコード、シェーダーのコンパイル)は並列に走らせる
+	// ウィンドウ・デバイス・入力・音声のエンジンはウィンドウのスレッド(メインスレッド)で行う
+	InitGraph initGraph;
+	InitGraph::TaskId windowTask = initGraph.AddTask("Window", {}, [&]() {
+		// WindowsAPIの初期化
+		winApp->Initialize();
+		}, InitGraph::Affinity::MainThread);
+	InitGraph::TaskId deviceTask = initGraph.AddTask("Device", { windowTask }, [&]() {
+		// DirectXの初期化(デバイス、スワップチェーン、デスクリプタヒープ、ImGui)
+		dxCommon->Initialize(winApp);
+		}, InitGraph::Affinity::MainThread);
+
+	// テクスチャのデコードは1枚ずつ並列に行い、転送はデバイスができてからまとめて積む
+	std::vector<InitGraph::TaskId> textureDependencies = { deviceTask };
+	for (size_t i = 0; i < textures.size(); ++i) {
+		textureDependencies.push_back(initGraph.AddTask("TextureDecode " + textures[i], {}, [&, i]() {
+			// WICはスレッドごとにCOMの初期化が要る
+			HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+			assert(SUCCEEDED(hr));
+			decodedTextures[i] = TextureManager::DecodeTexture(textures[i]);
+			CoUninitialize();
+			}));
+	}
+	initGraph.AddTask("TextureUpload", textureDependencies, [&]() {
+		TextureManager::GetInstance()->SetDirectXCommon(dxCommon);
+		// テクスチャマネージャの初期化
+		TextureManager::GetInstance()->Initialize();
+		for (size_t i = 0; i < textures.size(); ++i) {
+			TextureManager::GetInstance()->AddTexture(textures[i], std::move(decodedTextures[i]));
+		}
+		});
+
+	// スプライト共通部の初期化(シェーダーのコンパイルとPSOの生成。シェーダーはキャッシュが持つコンパイラを使う)
+	InitGraph::TaskId spritePipelineTask = initGraph.AddTask("SpritePipeline", { deviceTask }, [&]() {
+		spriteCommon->Initialize(dxCommon);
+		});
+	initGraph.AddTask("SpriteRenderer", { spritePipelineTask }, [&]() {
+		spriteRenderer->Initialize(spriteCommon);
+		renderThread->Initialize(dxCommon, spriteRenderer);
+		});
+
+	initGraph.AddTask("Audio", { windowTask }, [&]() {
+		// XAudio2のエンジンは終了まで使うので、COMを終了まで初期化したままのメインスレッド(WinAppが初期化する)で作る
+		// XAudioエンジンのインスタンスを生成
+		HRESULT hr = XAudio2Create(&xAudio2, 0, XAUDIO2_DEFAULT_PROCESSOR);
+		assert(SUCCEEDED(hr));
+		// マスターボイスを生成
+		hr = xAudio2->CreateMasteringVoice(&masterVoice);
+		assert(SUCCEEDED(hr));
+		}, InitGraph::Affinity::MainThread);
+	initGraph.AddTask("WaveLoad", {}, [&]() {
+		// 音声読み込み
+		soundData1 = SoundLoadWave("resources/audio/Alarm02.wav");
+		});
+
+	initGraph.AddTask("Input", { windowTask }, [&]() {
+		// 入力の初期化
+		input->Initialize(winApp);
+		}, InitGraph::Affinity::MainThread);
+
+	initGraph.Run();
+	// 各タスクの時刻と、起動時間を決めたタスクの連なり
+	initGraph.Report(logStream);
+
+	// -shaderbuild 指定時は、デバイスができた後にシェーダーのビルド(PSOの生成まで)をスレッド数を変えて計測し、ループに入らず終了する
+	const bool shaderBuildBenchmark = commandLine.find("-shaderbuild") != std::string::npos;
+	if (shaderBuildBenchmark) {
+		for (uint32_t threadCount : { 1u, 4u, 8u }) {
+			Benchmark::RunShaderBuild(logStream, dxCommon, threadCount);
+		}
+	}
+
+#pragma endregion
+
+#pragma region 最初のシーンの初期化
 
-	std::vector<Sprite *>sprites;
+	// スプライトの実体はプールに詰めて持ち、エンティティはハンドルで参照する
+	SpritePool spritePool;
+	std::vector<SpriteHandle> spriteHandles;
 	for (uint32_t i = 0; i < 6; ++i) {
-		Sprite *sprite = new Sprite();
+		SpriteHandle handle = spritePool.Create();
+		Sprite *sprite = spritePool.Get(handle);
 		// 2つの画像を交互に割り当てるために、i % 2でインデックスを切り替え
 		std::string &textureFile = textures[i % 2];
 		sprite->Initialize(spriteCommon, textureFile);
@@ -423,38 +597,37 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		sprite->SetTextureSize({ 64.0f, 64.0f });
 		sprite->SetSize({ 64.0f, 64.0f });
 		sprite->SetPosition({ 100.0f + i * 200.0f, 100.0f });
-		sprites.push_back(sprite);
+		spriteHandles.push_back(handle);
 	}
 
-#pragma endregion
+	// スプライトをエンティティとしてワールドに登録する
+	ecs::World world;
+	ecs::SystemScheduler scheduler;
+	ecs::RegisterSpriteSystems(scheduler);
 
-#pragma region 音楽
+	std::vector<ecs::Entity> entities;
+	for (SpriteHandle handle : spriteHandles) {
+		Sprite *sprite = spritePool.Get(handle);
+		ecs::Transform2DComponent transform {};
+		transform.position = sprite->GetPosition();
+		transform.rotation = sprite->GetRotation();
+		transform.size = sprite->GetSize();
 
-	Microsoft::WRL::ComPtr<IXAudio2> xAudio2;
-	IXAudio2MasteringVoice *masterVoice;
-
-	// XAudioエンジンのインスタンスを生成
-	HRESULT result = XAudio2Create(&xAudio2, 0, XAUDIO2_DEFAULT_PROCESSOR);
+		ecs::SpriteComponent spriteComponent {};
+		spriteComponent.sprite = handle;
 
-	// マスターボイスを生成
-	result = xAudio2->CreateMasteringVoice(&masterVoice);
+		ecs::ColliderComponent collider {};
+		collider.halfSize = { transform.size.x * 0.5f, transform.size.y * 0.5f };
 
-	// 音声読み込み
-	SoundData soundData1 = SoundLoadWave("resources/audio/Alarm02.wav");
-
-	// 音楽再生
-	SoundPlayWave(xAudio2.Get(), soundData1);
+		entities.push_back(world.CreateEntity(transform, ecs::PreviousTransform2DComponent { transform }, spriteComponent, collider));
+	}
 
 #pragma endregion
 
-#pragma region 入力デバイス
-
-	// ポインタ
-	Input *input = nullptr;
+#pragma region 音楽
 
-	// 入力の初期化
-	input = new Input();
-	input->Initialize(winApp);
+	// 音楽再生
+	SoundPlayWave(xAudio2.Get(), soundData1);
 
 #pragma endregion
 
@@ -862,8 +1035,64 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 #pragma region メインループ
 
+	// シミュレーションは60Hz固定、描画はディスプレイのリフレッシュレートで行う
+	GameLoop gameLoop;
+	gameLoop.Initialize(1.0f / 60.0f);
+	// ゲーム内タイマー(1ティック = シミュレーション1ステップ)
+	TimerWheel gameTimers;
+	// 性能のオーバーレイ(F1で表示を切り替える)
+	PerfOverlay perfOverlay;
+	perfOverlay.Initialize(dxCommon);
+	// メインスレッドの区間の時間
+	static const PerfCounters::CounterId kSimulationCpu = PerfCounters::Register("cpu.simulation");
+	static const PerfCounters::CounterId kImGuiCpu = PerfCounters::Register("cpu.imgui");
+	static const PerfCounters::CounterId kPacketWaitCpu = PerfCounters::Register("cpu.waitRenderThread");
+	static const PerfCounters::CounterId kPacketBuildCpu = PerfCounters::Register("cpu.buildPacket");
+
+	// 平行光源
+	DirectionalLight directionalLight { { 1.0f,1.0f,1.0f,1.0f },{ 0.0f,-1.0f,0.0f },1.0f };
+
+	// -capture <ファイル> [フレーム数] 指定時は最初のフレームから描画コマンドを書き出す(空白を含むパスは "" で囲む)
+	render::CommandCapture *commandCapture = render::CommandCapture::GetInstance();
+	if (size_t position = commandLine.find("-capture "); position != std::string::npos) {
+		std::istringstream arguments(commandLine.substr(position + std::strlen("-capture ")));
+		std::string capturePath;
+		uint32_t captureFrameCount = 0;
+		arguments >> std::quoted(capturePath);
+		if (!(arguments >> captureFrameCount)) {
+			captureFrameCount = 60;
+		}
+		commandCapture->Start(capturePath, captureFrameCount);
+	}
+
+	// テクスチャの転送コマンドを積み終えてから描画スレッドを開始する
+	// 以降コマンドリストは描画スレッドだけが触る
+	renderThread->Start();
+
+	// 計測用のシーン(スプライトとパーティクルの合計が1フレームに描ける数に収まるように減らす)
+	std::unique_ptr<Benchmark::StressScene> stressScene;
+	Benchmark::SceneResult sceneResult;
+	std::chrono::steady_clock::time_point sceneFrameTime = std::chrono::steady_clock::now();
+	// 性能カウンタのフレーム時間の起点
+	std::chrono::steady_clock::time_point counterFrameTime = std::chrono::steady_clock::now();
+	// フレームアリーナが溢れた回数(最初のフレームを除く)
+	uint64_t arenaFrameCount = 0;
+	uint64_t steadyArenaOverflowCount = 0;
+	static const PerfCounters::CounterId kActiveVoices = PerfCounters::Register("audio.activeVoices", PerfCounters::Kind::Gauge);
+	if (runScene) {
+		sceneSettings.particleCount = (std::min)(sceneSettings.particleCount, SpriteRenderer::kMaxSprites);
+		sceneSettings.spriteCount = (std::min)(sceneSettings.spriteCount, SpriteRenderer::kMaxSprites - sceneSettings.particleCount);
+		const uint32_t sceneTextures[] = {
+			TextureManager::GetInstance()->GetTextureIndexByFilePath("resources/textures/uvChecker.png"),
+			TextureManager::GetInstance()->GetTextureIndexByFilePath("resources/textures/monsterball.png") };
+		stressScene = std::make_unique<Benchmark::StressScene>();
+		stressScene->Initialize(sceneSettings, sceneTextures, { float(WinApp::kClientWidth), float(WinApp::kClientHeight) });
+		sceneResult.settings = sceneSettings;
+		sceneResult.frameMilliseconds.reserve(sceneSettings.frameCount);
+	}
+
 	// ウィンドウの×ボタンが押されるまでループ
-	while (true) {
+	while (!shaderBuildBenchmark) {
 
 		// Windowsのメッセージ処理
 		if (winApp->ProcessMessage()) {
@@ -871,10 +1100,44 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			break;
 		}
 
+		// 前のフレームでNextFrameを待っていたコルーチンを再開する(非同期の読み込みの続きなど)
+		TaskScheduler::GetInstance()->RunFrameBoundary();
+		// 他のスレッドから届いたイベントを購読者に渡す
+		EventBus::GetInstance()->Drain(event::DrainPoint::MainFrame);
+
+		// 計測用のシーンは決まったフレーム数を回したら終了する(入力・ImGuiは使わない)
+		if (stressScene) {
+			if (sceneResult.frameMilliseconds.size() >= sceneSettings.frameCount) {
+				break;
+			}
+			render::RenderPacket *packet = nullptr;
+			{
+				std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+				packet = renderThread->AcquirePacket();
+				sceneResult.zoneMilliseconds[static_cast<size_t>(Benchmark::SceneZone::Render)] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+			}
+			stressScene->Update(*packet, sceneResult);
+			renderThread->Submit(packet);
+			uint64_t arenaOverflowCount = FrameArena::ResetAll();
+			if (!sceneResult.frameMilliseconds.empty()) {
+				sceneResult.arenaOverflowCount += arenaOverflowCount;
+			}
+
+			// フレーム時間は前のフレームの終わりからの間隔(描画スレッドを待った時間を含む)
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			sceneResult.frameMilliseconds.push_back(std::chrono::duration<double, std::milli>(now - sceneFrameTime).count());
+			sceneFrameTime = now;
+			PerfCounters::GetInstance()->EndFrame(sceneResult.frameMilliseconds.back());
+			continue;
+		}
+
 		// ゲームの処理
 
 		// 入力の更新
 		input->Update();
+		if (input->TriggerKey(DIK_F1)) {
+			perfOverlay.ToggleVisible();
+		}
 
 		/*if (input->PushKey(DIK_W))
 		{
@@ -908,13 +1171,24 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	#pragma region 更新: 2D Object (Sprite)
 
-		for (uint32_t i = 0; i < sprites.size(); ++i) {
-			sprites[i]->Update();
+		// 蓄積した時間分だけ固定ステップでシミュレーションを進める
+		// 読み書きの競合しないシステムは並列に実行される
+		uint32_t simulationSteps = gameLoop.BeginFrame();
+		{
+			PerfCounters::ScopedTimer simulationTimer(kSimulationCpu);
+			for (uint32_t step = 0; step < simulationSteps; ++step) {
+				scheduler.Run(world, gameLoop.GetFixedDeltaTime());
+				gameTimers.Advance();
+			}
+
+			// 直前2回のシミュレーション結果を補間して描画用に反映する
+			ecs::SyncSprites(world, spritePool, gameLoop.GetAlpha());
 		}
 
 	#pragma endregion
 
 	#ifdef USE_IMGUI
+		std::chrono::steady_clock::time_point imguiStart = std::chrono::steady_clock::now();
 		// フレームの開始
 		ImGui_ImplDX12_NewFrame();
 		ImGui_ImplWin32_NewFrame();
@@ -925,27 +1199,36 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		ImGui::Begin("Settings");
 
 		static int current = 0;
-		ImGui::SliderInt("Sprite Index", &current, 0, static_cast<int>(sprites.size()) - 1);
-
-		Sprite *sprite = sprites[current];
-
-		Vector2 size = sprite->GetSize();
-		float rotation = sprite->GetRotation();
-		Vector2 position = sprite->GetPosition();
-		Vector4 color = sprite->GetColor();
-
-		ImGui::DragFloat2("S", &size.x, 1.0f, 0.0f, 1000.0f);
-		ImGui::SliderAngle("R", &rotation);
-		ImGui::DragFloat2("T", &position.x, 1.0f);
-		ImGui::ColorEdit3("Color", &color.x);
-
-		// 変更を反映
-		sprite->SetSize(size);
-		sprite->SetRotation(rotation);
-		sprite->SetPosition(position);
-		sprite->SetColor(color);
+		ImGui::SliderInt("Sprite Index", &current, 0, static_cast<int>(entities.size()) - 1);
+
+		ecs::Transform2DComponent *transform = world.GetComponent<ecs::Transform2DComponent>(entities[current]);
+		ecs::SpriteComponent *spriteComponent = world.GetComponent<ecs::SpriteComponent>(entities[current]);
+		ecs::ColliderComponent *collider = world.GetComponent<ecs::ColliderComponent>(entities[current]);
+
+		ImGui::DragFloat2("S", &transform->size.x, 1.0f, 0.0f, 1000.0f);
+		ImGui::SliderAngle("R", &transform->rotation);
+		ImGui::DragFloat2("T", &transform->position.x, 1.0f);
+		ImGui::ColorEdit3("Color", &spriteComponent->color.x);
+		ImGui::Text("Hit : %u", collider->hitCount);
+
+		ImGui::Separator();
+		ImGui::Text("Simulation : %.1f steps/s", gameLoop.GetSimulationStepsPerSecond());
+		ImGui::Text("Render : %.1f frames/s", gameLoop.GetRenderFramesPerSecond());
+		ImGui::Text("Dropped : %.2f s", gameLoop.GetDroppedSeconds());
+
+		const RenderThread::Statistics &renderStatistics = renderThread->GetStatistics();
+		ImGui::Text("Main thread : %.2f ms", renderStatistics.mainBusyMilliseconds);
+		ImGui::Text("Render thread : %.2f ms", renderStatistics.renderBusyMilliseconds);
+		ImGui::Text("Overlap : %.2f ms (%.0f%%)", renderStatistics.overlapMilliseconds, renderStatistics.overlapRatio * 100.0f);
+		bool showPerfOverlay = perfOverlay.IsVisible();
+		if (ImGui::Checkbox("Performance (F1)", &showPerfOverlay)) {
+			perfOverlay.SetVisible(showPerfOverlay);
+		}
 
 		ImGui::End();
+
+		// 非表示なら何もしない
+		perfOverlay.Draw();
 	#endif
 
 		//#pragma region ワールド・ビュー・プロジェクション行列計算: 3D Object (ModelData)
@@ -990,15 +1273,21 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	#ifdef USE_IMGUI
 		// ImGuiの内部コマンドを生成する
 		ImGui::Render();
+		PerfCounters::Add(kImGuiCpu, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - imguiStart).count());
 	#endif
 
-	#pragma region 画面をクリアする
+	#pragma region 描画パケットの作成
 
-		// DirectXの描画準備。全ての描画に共通のグラフィックスコマンドを積む
-		dxCommon->PreDraw();
+		// 描画スレッドに渡すパケットを取得。描画が遅れて空きがなければここで待つ
+		std::chrono::steady_clock::time_point packetWaitStart = std::chrono::steady_clock::now();
+		render::RenderPacket *packet = renderThread->AcquirePacket();
+		std::chrono::steady_clock::time_point packetBuildStart = std::chrono::steady_clock::now();
+		PerfCounters::Add(kPacketWaitCpu, std::chrono::duration_cast<std::chrono::microseconds>(packetBuildStart - packetWaitStart).count());
 
-		// Spriteの描画準備。Spriteの描画に共通のグラフィックスコマンドを積む
-		spriteCommon->SetupCommonDrawing();
+		// スプライト用カメラ
+		packet->spriteCamera.view = MakeIdentity4x4();
+		packet->spriteCamera.projection = MakeOrthographicMatrix(0.0f, 0.0f, float(WinApp::kClientWidth), float(WinApp::kClientHeight), 0.0f, 100.0f);
+		packet->directionalLight = directionalLight;
 
 		//#pragma region 描画: 3D Object (ModelData)
 
@@ -1064,21 +1353,36 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	#pragma region 描画: 2D Object (Sprite)
 
-		for (uint32_t i = 0; i < sprites.size(); ++i) {
-			sprites[i]->Draw();
-		}
+		ecs::CollectSprites(world, spritePool, packet->sprites);
 
 	#pragma endregion
 
 	#ifdef USE_IMGUI
-		// 実際のcommandListのImGuiの描画コマンドを積む
-		ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), dxCommon->GetCommandList());
+		// ImGuiの描画データは次のNewFrameで書き換わるので複製して渡す
+		packet->imgui.Capture(ImGui::GetDrawData());
 	#endif
 
-		// 描画後処理
-		dxCommon->PostDraw();
+		PerfCounters::Add(kPacketBuildCpu, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - packetBuildStart).count());
 
-		TextureManager::GetInstance()->ReleaseIntermediateResources();
+		// 描画スレッドに渡す。以降このパケットには触らない
+		renderThread->Submit(packet);
+
+		// フレーム内の一時データをまとめて巻き戻す(ジョブは全て完了している)
+		// 最初のフレーム以降にヒープから確保していたら、アリーナの容量が足りていない
+		uint64_t arenaOverflowCount = FrameArena::ResetAll();
+		if (arenaFrameCount++ > 0) {
+			steadyArenaOverflowCount += arenaOverflowCount;
+		}
+
+		// 1フレーム分の性能カウンタを締める(描画スレッドの分は集めた時点までが入る)
+		{
+			XAUDIO2_PERFORMANCE_DATA audioPerformance {};
+			xAudio2->GetPerformanceData(&audioPerformance);
+			PerfCounters::Set(kActiveVoices, audioPerformance.ActiveSourceVoiceCount);
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			PerfCounters::GetInstance()->EndFrame(std::chrono::duration<double, std::milli>(now - counterFrameTime).count());
+			counterFrameTime = now;
+		}
 
 	#pragma endregion
 	}
@@ -1087,6 +1391,37 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 #pragma region Object解放
 
+	// 描画スレッドの終了(投入済みのパケットは描き切る)
+	renderThread->Stop();
+	{
+		const RenderThread::Statistics &renderStatistics = renderThread->GetStatistics();
+		Logger::Log(logStream, std::format("RenderThread main:{:.2f}ms render:{:.2f}ms overlap:{:.2f}ms ({:.0f}%)",
+			renderStatistics.mainBusyMilliseconds, renderStatistics.renderBusyMilliseconds,
+			renderStatistics.overlapMilliseconds, renderStatistics.overlapRatio * 100.0f));
+	}
+	delete renderThread;
+	renderThread = nullptr;
+	// 計測用のシーンの結果(描画コール数・アップロード量は描画スレッドを止めてから読む)
+	if (stressScene) {
+		sceneResult.drawCallCount = spriteRenderer->GetTotalDrawCount();
+		sceneResult.uploadBytes = spriteRenderer->GetTotalUploadBytes();
+		sceneResult.droppedQuadCount = spriteRenderer->GetTotalDroppedQuadCount();
+		Benchmark::LogSceneResult(sceneResult, logStream);
+		Benchmark::WriteSceneResult(sceneResult, sceneSettings.outputPath);
+		stressScene.reset();
+	}
+	// 描画コマンドのキャプチャの終了
+	commandCapture->Finalize();
+	commandCapture = nullptr;
+
+	// フレームアリーナの最大使用量(容量見直しの目安)
+	FrameArena::Report(logStream);
+	Logger::Log(logStream, std::format("FrameArena heap allocations after the first frame: {}", steadyArenaOverflowCount));
+
+	// 直近のフレームの性能カウンタを書き出す
+	PerfCounters::GetInstance()->ExportCsv(std::string("logs/telemetry_") + dateString + ".csv");
+	PerfCounters::GetInstance()->ExportJson(std::string("logs/telemetry_") + dateString + ".json");
+
 	// テクスチャマネージャの終了
 	TextureManager::GetInstance()->Finalize();
 
@@ -1098,12 +1433,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	ImGui::DestroyContext();
 #endif
 
-	for (uint32_t i = 0; i < sprites.size(); ++i) {
-		delete sprites[i];
-	}
-	sprites.clear();
+	spritePool.Clear();
+	delete spriteRenderer;
 	delete spriteCommon;
 
+	// コルーチンの再開先の終了(ジョブシステムより先に止める)
+	TaskScheduler::GetInstance()->Finalize();
+	// ジョブシステムの終了
+	JobSystem::GetInstance()->Finalize();
+	// 性能カウンタの終了(カウンタを加算するスレッドを全て止めた後)
+	PerfCounters::GetInstance()->Finalize();
+
 	// 入力解放
 	delete input;
 	input = nullptr;
@@ -1116,6 +1456,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// WindowsAPIの終了処理
 	winApp->Finalize();
 
+	// イベントバスの終了(イベントを出すスレッドとウィンドウを全て止めた後)
+	EventBus::GetInstance()->Finalize();
+
 	// WindowsAPI解放
 	delete winApp;
 	winApp = nullptr;
@@ -3,7 +3,6 @@
 struct Material
 {
     float32_t4 color;
-    int32_t enableLighting;
     float32_t4x4 uvTransform;
 };
 
@@ -28,23 +27,24 @@ PixelShaderOutput main(VertexShaderOutput input)
 {
     PixelShaderOutput output;
     
+#if USE_TEXTURE
     float4 transformedUV = mul(float32_t4(input.texcoord, 0.0f, 1.0f), gMaterial.uvTransform);
     float32_t4 textureColor = gTexture.Sample(gSampler, transformedUV.xy);
+#else
+    float32_t4 textureColor = float32_t4(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
     output.color = gMaterial.color * textureColor;
-    
-    if (gMaterial.enableLighting != 0)
-    { // Lightingする場合
-        
-        // half lambert
-        float NdotL = dot(normalize(input.normal), -gDirectionalLight.direction);
-        float cos = pow(NdotL * 0.5f + 0.5f, 2.0f);
-        
-        output.color = gMaterial.color * textureColor * gDirectionalLight.color * cos * gDirectionalLight.intensity;
-    }
-    else
-    { // Lightingしない場合。前回までと同じ演算
-        output.color = gMaterial.color * textureColor;
-    }
+
+#if USE_VERTEX_COLOR
+    output.color *= input.color;
+#endif
+
+#if USE_LIGHTING
+    // half lambert
+    float NdotL = dot(normalize(input.normal), -gDirectionalLight.direction);
+    float cos = pow(NdotL * 0.5f + 0.5f, 2.0f);
+    output.color *= gDirectionalLight.color * cos * gDirectionalLight.intensity;
+#endif
     
     return output;
 }
\ No newline at end of file
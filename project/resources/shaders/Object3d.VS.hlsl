@@ -13,6 +13,9 @@ struct VertexShaderInput
     float32_t4 positon : POSITION0;
     float32_t2 texcoord : TEXCOORD0;
     float32_t3 normal : NORMAL0;
+#if USE_VERTEX_COLOR
+    float32_t4 color : COLOR0;
+#endif
 };
 
 VertexShaderOutput main(VertexShaderInput input)
@@ -21,5 +24,8 @@ VertexShaderOutput main(VertexShaderInput input)
     output.position = mul(input.positon, gTransformationMatrix.WVP);
     output.texcoord = input.texcoord;
     output.normal = normalize(mul(input.normal, (float32_t3x3) gTransformationMatrix.World));
+#if USE_VERTEX_COLOR
+    output.color = input.color;
+#endif
     return output;
 }
\ No newline at end of file
@@ -1,6 +1,20 @@
+// 変種を切り替える定義(ShaderPermutationから全て渡される。単体でコンパイルしたときは無効)
+#ifndef USE_LIGHTING
+#define USE_LIGHTING 0
+#endif
+#ifndef USE_TEXTURE
+#define USE_TEXTURE 0
+#endif
+#ifndef USE_VERTEX_COLOR
+#define USE_VERTEX_COLOR 0
+#endif
+
 struct VertexShaderOutput
 {
     float32_t4 position : SV_POSITION;
     float32_t2 texcoord : TEXCOORD0;
     float32_t3 normal : NORMAL0;
-};
\ No newline at end of file
+#if USE_VERTEX_COLOR
+    float32_t4 color : COLOR0;
+#endif
+};
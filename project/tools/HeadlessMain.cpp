@@ -0,0 +1,110 @@
+#include "Benchmark.h"
+#include "BenchmarkScene.h"
+#include "CommandReplay.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "PerfCounters.h"
+#include "SelfCheck.h"
+#include "Task.h"
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ヘッドレスの実行ファイル(D3D・DXCを使わない処理をWindows以外でも動かす。ゲーム本体のビルドには含めない)
+//
+//   headless check                  動作確認(SelfCheck)を実行する。1つでも失敗すれば終了コードは1
+//   headless benchmark              D3D・DXCを使わない全ての計測(Benchmark::RunAll)
+//   headless lights [ライト数...]   クラスタへのライト割り当ての計測(省略時は1k, 4k, 16k, 64k)
+//   headless replay <ファイル>      描画コマンドのキャプチャを再生して集計する(WinMainの -replay と同じ)
+//   headless scene <設定>           計測用のシーンをNullCommandBackendで回す(WinMainの -scene <設定> -headless と同じ)
+//
+// ビルド例(projectディレクトリで。<format>が使えるC++20のコンパイラ):
+//   g++ -std=c++20 -O2 -I. tools/HeadlessMain.cpp Benchmark.cpp BenchmarkScene.cpp CommandCapture.cpp
+//       CommandReplay.cpp ECS.cpp EventBus.cpp FrameArena.cpp GlbModel.cpp JobSystem.cpp Json.cpp
+//       LightCulling.cpp Logger.cpp MappedFile.cpp MaterialTable.cpp MathFunctions.cpp MeshProcessing.cpp
+//       OcclusionCulling.cpp PerfCounters.cpp RenderPacket.cpp RootSignatureLayout.cpp SceneSerializer.cpp
+//       SelfCheck.cpp ShaderPermutation.cpp SkeletalAnimation.cpp SpriteBatch.cpp SpriteGeometry.cpp SpritePool.cpp Task.cpp
+//       TimerWheel.cpp TriangleBVH.cpp -pthread -o headless
+
+namespace
+{
+	// 引数の数値の並び(無ければ既定値)
+	std::vector<uint32_t> ParseCounts(int argc, char *argv[], int first, std::vector<uint32_t> defaults)
+	{
+		std::vector<uint32_t> counts;
+		for (int i = first; i < argc; ++i) {
+			std::string_view text(argv[i]);
+			uint32_t count = 0;
+			auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), count);
+			if (error != std::errc() || end != text.data() + text.size() || count == 0) {
+				std::cerr << "invalid count: " << text << "\n";
+				return {};
+			}
+			counts.push_back(count);
+		}
+		return counts.empty() ? defaults : counts;
+	}
+
+	void PrintUsage()
+	{
+		std::cerr << "usage: headless check\n";
+		std::cerr << "       headless benchmark\n";
+		std::cerr << "       headless lights [lightCount...]\n";
+		std::cerr << "       headless replay <captureFile>\n";
+		std::cerr << "       headless scene <settings>\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		PrintUsage();
+		return 1;
+	}
+	std::string_view command(argv[1]);
+
+	// WinMainと同じ順に初期化する
+	PerfCounters::GetInstance();
+	JobSystem::GetInstance()->Initialize();
+	FrameArena::GetThreadArena().SetName("Main");
+	TaskScheduler::GetInstance()->Initialize();
+
+	int exitCode = 0;
+	if (command == "check") {
+		exitCode = SelfCheck::RunAll(std::cout) ? 0 : 1;
+	} else if (command == "benchmark") {
+		Benchmark::RunAll(std::cout);
+		FrameArena::Report(std::cout);
+	} else if (command == "lights") {
+		std::vector<uint32_t> counts = ParseCounts(argc, argv, 2, { 1024u, 4096u, 16384u, 65536u });
+		for (uint32_t count : counts) {
+			Benchmark::RunLightBinning(std::cout, count);
+		}
+		exitCode = counts.empty() ? 1 : 0;
+	} else if (command == "replay" && argc == 3) {
+		exitCode = render::ReplayCaptureFile(argv[2], std::cout) ? 0 : 1;
+	} else if (command == "scene" && argc == 3) {
+		Benchmark::SceneSettings settings;
+		if (Benchmark::ParseSceneSettings(argv[2], settings)) {
+			settings.headless = true;
+			Benchmark::SceneResult result = Benchmark::RunSceneHeadless(settings);
+			Benchmark::LogSceneResult(result, std::cout);
+			Benchmark::WriteSceneResult(result, settings.outputPath);
+			exitCode = result.invalidCommandCount == 0 ? 0 : 1;
+		} else {
+			std::cerr << "invalid scene settings: " << argv[2] << "\n";
+			exitCode = 1;
+		}
+	} else {
+		PrintUsage();
+		exitCode = 1;
+	}
+
+	TaskScheduler::GetInstance()->Finalize();
+	JobSystem::GetInstance()->Finalize();
+	PerfCounters::GetInstance()->Finalize();
+	return exitCode;
+}